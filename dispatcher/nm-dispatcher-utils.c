@@ -581,3 +581,68 @@ done:
 	g_ptr_array_add (items, NULL);
 	return (char **) g_ptr_array_free (g_steal_pointer (&items), FALSE);
 }
+
+/*****************************************************************************/
+
+/**
+ * nm_dispatcher_utils_schedule_next:
+ * @lanes_waiting: the lanes of the queued requests, in the order in which
+ *   the requests were received. The lane of a request is the name of the
+ *   interface it is about. Requests that are not bound to an interface
+ *   (like hostname or connectivity-change) have a %NULL lane.
+ * @n_waiting: the number of entries in @lanes_waiting.
+ * @lanes_running: (allow-none): the set of lanes that have a running
+ *   request.
+ * @unbound_running: whether a request without lane is running.
+ * @n_running: the number of running requests.
+ * @max_parallel: the maximum number of requests to run at the same time.
+ *
+ * Requests for the same interface are run in the order in which they
+ * were received, while requests for different interfaces may run
+ * concurrently. Requests without interface are ordered against all
+ * other requests: they only start when no other request is running, and
+ * no request queued after them starts before they complete.
+ *
+ * With @max_parallel of 1, requests are run strictly in order.
+ *
+ * Returns: the index in @lanes_waiting of the request that can be started
+ *   next, or -1 if no request can be started right now.
+ */
+gssize
+nm_dispatcher_utils_schedule_next (const char *const*lanes_waiting,
+                                   guint n_waiting,
+                                   GHashTable *lanes_running,
+                                   gboolean unbound_running,
+                                   guint n_running,
+                                   guint max_parallel)
+{
+	guint i;
+
+	nm_assert (max_parallel > 0);
+	nm_assert (!unbound_running || n_running == 1);
+
+	if (   n_running >= max_parallel
+	    || unbound_running)
+		return -1;
+
+	for (i = 0; i < n_waiting; i++) {
+		const char *lane = lanes_waiting[i];
+
+		if (!lane) {
+			if (   i == 0
+			    && n_running == 0)
+				return 0;
+			return -1;
+		}
+
+		/* a lane can be skipped only because it has a running request.
+		 * Hence, later requests with the same lane are skipped too. */
+		if (   lanes_running
+		    && g_hash_table_contains (lanes_running, lane))
+			continue;
+
+		return i;
+	}
+
+	return -1;
+}
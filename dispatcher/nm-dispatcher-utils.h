@@ -39,5 +39,12 @@ nm_dispatcher_utils_construct_envp (const char *action,
                                     char **out_iface,
                                     const char **out_error_message);
 
+gssize nm_dispatcher_utils_schedule_next (const char *const*lanes_waiting,
+                                          guint n_waiting,
+                                          GHashTable *lanes_running,
+                                          gboolean unbound_running,
+                                          guint n_running,
+                                          guint max_parallel);
+
 #endif  /* __NETWORKMANAGER_DISPATCHER_UTILS_H__ */
 
@@ -41,6 +41,7 @@
 static GMainLoop *loop = NULL;
 static gboolean debug = FALSE;
 static gboolean persist = FALSE;
+static int max_parallel = 1;
 static guint quit_id;
 static guint request_id_counter = 0;
 
@@ -52,8 +53,15 @@ typedef struct {
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
+	/* requests with "wait" scripts that are not yet running. */
 	GQueue *requests_waiting;
+
+	/* the running requests, indexed by their lane (the interface name).
+	 * A request without interface is tracked as @request_unbound. */
+	GHashTable *lanes_running;
+	Request *request_unbound;
+	guint num_requests_running;
+
 	int num_requests_pending;
 } Handler;
 
@@ -93,6 +101,7 @@ static void
 handler_init (Handler *h)
 {
 	h->requests_waiting = g_queue_new ();
+	h->lanes_running = g_hash_table_new (nm_str_hash, g_str_equal);
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -133,6 +142,9 @@ struct Request {
 	guint idx;
 	int num_scripts_done;
 	int num_scripts_nowait;
+
+	/* whether the request is running its "wait" scripts. */
+	bool running:1;
 };
 
 /*****************************************************************************/
@@ -226,45 +238,97 @@ quit_timeout_reschedule (void)
 	}
 }
 
+static const char *
+request_get_lane (const Request *request)
+{
+	return request->iface && request->iface[0] ? request->iface : NULL;
+}
+
+static void
+request_set_running (Request *request, gboolean running)
+{
+	Handler *h = request->handler;
+	const char *lane = request_get_lane (request);
+
+	nm_assert (request->running != (!!running));
+
+	request->running = running;
+	if (running) {
+		h->num_requests_running++;
+		if (lane)
+			g_hash_table_insert (h->lanes_running, (char *) lane, request);
+		else
+			h->request_unbound = request;
+	} else {
+		nm_assert (h->num_requests_running > 0);
+		h->num_requests_running--;
+		if (lane) {
+			if (!g_hash_table_remove (h->lanes_running, lane))
+				nm_assert_not_reached ();
+		} else {
+			nm_assert (h->request_unbound == request);
+			h->request_unbound = NULL;
+		}
+	}
+}
+
+static void complete_request (Request *request);
+
 /**
- * next_request:
- *
+ * schedule_requests:
  * @h: the handler
- * @request: (allow-none): the request to set as next. If %NULL, dequeue the next
- * waiting request. Otherwise, try to set the given request.
  *
- * Sets the currently active request (@current_request). The current request
- * is a request that has at least on "wait" script, because requests that only
- * consist of "no-wait" scripts are handled right away and not enqueued to
- * @requests_waiting nor set as @current_request.
+ * Starts the waiting requests that may run now. A request is waiting, if it
+ * has at least one "wait" script. Requests that only consist of "no-wait"
+ * scripts are handled right away and never enqueued to @requests_waiting.
  *
- * Returns: %TRUE, if there was currently not request in process and it set
- * a new request as current.
+ * Requests for the same interface run one after another, in the order in
+ * which they were received. Requests for different interfaces run
+ * concurrently, up to @max_parallel at a time.
  */
-static gboolean
-next_request (Handler *h, Request *request)
+static void
+schedule_requests (Handler *h)
 {
-	if (request) {
-		if (h->current_request) {
-			g_queue_push_tail (h->requests_waiting, request);
-			return FALSE;
-		}
-	} else {
-		/* when calling next_request() without explicit @request, we always
-		 * forcefully clear @current_request. That one is certainly
-		 * handled already. */
-		h->current_request = NULL;
+	gs_free const char **lanes = NULL;
+	guint n_waiting;
+	GList *iter;
+	guint i;
 
-		request = g_queue_pop_head (h->requests_waiting);
-		if (!request)
-			return FALSE;
-	}
+	n_waiting = g_queue_get_length (h->requests_waiting);
+	if (n_waiting == 0)
+		return;
 
-	_LOG_R_I (request, "start running ordered scripts...");
+	lanes = g_new (const char *, n_waiting);
+	for (iter = h->requests_waiting->head, i = 0; iter; iter = iter->next, i++)
+		lanes[i] = request_get_lane (iter->data);
+
+	while (TRUE) {
+		Request *request;
+		gssize idx;
+
+		idx = nm_dispatcher_utils_schedule_next (lanes,
+		                                         n_waiting,
+		                                         h->lanes_running,
+		                                         !!h->request_unbound,
+		                                         h->num_requests_running,
+		                                         max_parallel);
+		if (idx < 0)
+			return;
 
-	h->current_request = request;
+		request = g_queue_pop_nth (h->requests_waiting, idx);
+		n_waiting--;
+		memmove (&lanes[idx], &lanes[idx + 1], sizeof (lanes[0]) * (n_waiting - idx));
 
-	return TRUE;
+		_LOG_R_I (request, "start running ordered scripts...");
+
+		request_set_running (request, TRUE);
+
+		if (!dispatch_one_script (request)) {
+			/* If that fails, we might be already finished with the
+			 * request. Try complete_request(). */
+			complete_request (request);
+		}
+	}
 }
 
 /**
@@ -305,14 +369,15 @@ complete_request (Request *request)
 
 	_LOG_R_D (request, "completed (%u scripts)", request->scripts->len);
 
-	if (handler->current_request == request)
-		handler->current_request = NULL;
+	if (request->running)
+		request_set_running (request, FALSE);
 
 	request_free (request);
 
 	g_assert_cmpuint (handler->num_requests_pending, >, 0);
 	if (--handler->num_requests_pending <= 0) {
-		nm_assert (!handler->current_request && !g_queue_peek_head (handler->requests_waiting));
+		nm_assert (   handler->num_requests_running == 0
+		           && !g_queue_peek_head (handler->requests_waiting));
 		quit_timeout_reschedule ();
 	}
 }
@@ -325,65 +390,31 @@ complete_script (ScriptInfo *script)
 	gboolean wait = script->wait;
 
 	request = script->request;
+	handler = request->handler;
+
+	nm_assert (!wait || request->running);
 
 	if (wait) {
 		/* for "wait" scripts, try to schedule the next blocking script.
 		 * If that is successful, return (as we must wait for its completion). */
 		if (dispatch_one_script (request))
 			return;
+	} else if (   request->running
+	           && request->num_scripts_nowait == 0) {
+		/* this was the last "no-wait" script of a running request.
+		 * The "wait" scripts of the request can start now. */
+		if (dispatch_one_script (request))
+			return;
 	}
 
-	handler = request->handler;
-
-	nm_assert (!wait || handler->current_request == request);
-
 	/* Try to complete the request. @request will be possibly free'd,
-	 * making @script and @request a dangling pointer. */
+	 * making @script and @request a dangling pointer. If this completed
+	 * a running request, it makes room for the next ones. Note that
+	 * "no-wait" scripts of a request that is not running don't block
+	 * other requests. */
 	complete_request (request);
 
-	if (!wait) {
-		/* this was a "no-wait" script. We either completed the request,
-		 * or there is nothing to do. Especially, there is no need to
-		 * queue the next_request() -- because no-wait scripts don't block
-		 * requests. However, if this was the last "no-wait" script and
-		 * there are "wait" scripts ready to run, launch them.
-		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
-
-			if (dispatch_one_script (handler->current_request))
-				return;
-
-			complete_request (handler->current_request);
-		} else
-			return;
-	} else {
-		/* if the script is a "wait" script, we already tried above to
-		 * dispatch the next script. As we didn't do that, it means we
-		 * just completed the last script of @request and we can continue
-		 * with the next request...
-		 *
-		 * Also, it cannot be that there is another request currently being
-		 * processed because only requests with "wait" scripts can become
-		 * @current_request. As there can only be one "wait" script running
-		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
-	}
-
-	while (next_request (handler, NULL)) {
-		request = handler->current_request;
-
-		if (dispatch_one_script (request))
-			return;
-
-		/* Try to complete the request. It will be either completed
-		 * now, or when all pending "no-wait" scripts return. */
-		complete_request (request);
-
-		/* We can immediately start next_request(), because our current
-		 * @request has obviously no more "wait" scripts either.
-		 * Repeat... */
-	}
+	schedule_requests (handler);
 }
 
 static void
@@ -575,29 +606,203 @@ dispatch_one_script (Request *request)
 	return FALSE;
 }
 
-static GSList *
-find_scripts (const char *str_action)
+static gboolean
+script_must_wait (const char *path)
+{
+	gs_free char *link = NULL;
+	gs_free char *dir = NULL;
+	gs_free char *real = NULL;
+	char *tmp;
+
+	link = g_file_read_link (path, NULL);
+	if (link) {
+		if (!g_path_is_absolute (link)) {
+			dir = g_path_get_dirname (path);
+			tmp = g_build_path ("/", dir, link, NULL);
+			g_free (link);
+			g_free (dir);
+			link = tmp;
+		}
+
+		dir = g_path_get_dirname (link);
+		real = realpath (dir, NULL);
+
+		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+/* The scripts of each dispatcher directory are scanned once and kept in
+ * a sorted index, together with the result of the permission checks and
+ * whether they are "wait" scripts. A file monitor on the directories
+ * invalidates the index whenever an entry is added, removed, replaced
+ * or its attributes change.
+ *
+ * Symlinks that point outside of the monitored directories are the
+ * exception: changes to their targets are not noticed, hence their
+ * permissions are checked again on each use. */
+
+typedef struct {
+	char *path;
+	bool wait:1;
+	bool revalidate:1;
+} ScriptEntry;
+
+typedef struct {
+	const char *dirname;
+	GFileMonitor *monitor;
+	/* the sorted list of ScriptEntry, or %NULL if it needs to be rescanned. */
+	GArray *scripts;
+} ScriptDir;
+
+enum {
+	SCRIPT_DIR_DEFAULT,
+	SCRIPT_DIR_PRE_UP,
+	SCRIPT_DIR_PRE_DOWN,
+
+	/* not a directory with scripts, but the target of symlinks
+	 * to "no-wait" scripts. */
+	SCRIPT_DIR_NO_WAIT,
+
+	_SCRIPT_DIR_NUM,
+};
+
+static ScriptDir script_dirs[_SCRIPT_DIR_NUM] = {
+	[SCRIPT_DIR_DEFAULT]  = { .dirname = NMD_SCRIPT_DIR_DEFAULT,  },
+	[SCRIPT_DIR_PRE_UP]   = { .dirname = NMD_SCRIPT_DIR_PRE_UP,   },
+	[SCRIPT_DIR_PRE_DOWN] = { .dirname = NMD_SCRIPT_DIR_PRE_DOWN, },
+	[SCRIPT_DIR_NO_WAIT]  = { .dirname = NMD_SCRIPT_DIR_NO_WAIT,  },
+};
+
+static void
+script_entry_clear (gpointer ptr)
+{
+	g_free (((ScriptEntry *) ptr)->path);
+}
+
+static int
+script_entry_cmp (gconstpointer a, gconstpointer b)
+{
+	return strcmp (((const ScriptEntry *) a)->path,
+	               ((const ScriptEntry *) b)->path);
+}
+
+static void
+script_dirs_invalidate (void)
+{
+	guint i;
+
+	for (i = 0; i < _SCRIPT_DIR_NUM; i++) {
+		if (script_dirs[i].scripts) {
+			g_debug ("find-scripts: invalidate index of '%s'", script_dirs[i].dirname);
+			g_clear_pointer (&script_dirs[i].scripts, g_array_unref);
+		}
+	}
+}
+
+static void
+script_dir_changed_cb (GFileMonitor *monitor,
+                       GFile *file,
+                       GFile *other_file,
+                       GFileMonitorEvent event_type,
+                       gpointer user_data)
+{
+	/* a change in any directory can affect symlinks in the other ones
+	 * (pre-up.d and pre-down.d link to dispatcher.d, "no-wait" scripts link
+	 * to no-wait.d). Just drop the index of all directories. */
+	script_dirs_invalidate ();
+}
+
+static gboolean
+script_dirs_monitor (void)
+{
+	static gboolean initialized = FALSE;
+	static gboolean monitored = FALSE;
+	guint i;
+
+	if (initialized)
+		return monitored;
+	initialized = TRUE;
+
+	for (i = 0; i < _SCRIPT_DIR_NUM; i++) {
+		gs_unref_object GFile *file = NULL;
+		GError *error = NULL;
+
+		file = g_file_new_for_path (script_dirs[i].dirname);
+		script_dirs[i].monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, &error);
+		if (!script_dirs[i].monitor) {
+			g_message ("find-scripts: cannot monitor directory '%s' (%s). Rescan the scripts for each request",
+			           script_dirs[i].dirname, error->message);
+			g_error_free (error);
+			while (i-- > 0)
+				g_clear_object (&script_dirs[i].monitor);
+			return FALSE;
+		}
+	}
+
+	for (i = 0; i < _SCRIPT_DIR_NUM; i++) {
+		g_signal_connect (script_dirs[i].monitor, "changed",
+		                  G_CALLBACK (script_dir_changed_cb), NULL);
+	}
+
+	monitored = TRUE;
+	return TRUE;
+}
+
+static void
+script_dirs_clear (void)
+{
+	guint i;
+
+	for (i = 0; i < _SCRIPT_DIR_NUM; i++) {
+		if (script_dirs[i].monitor) {
+			g_signal_handlers_disconnect_by_func (script_dirs[i].monitor, script_dir_changed_cb, NULL);
+			g_file_monitor_cancel (script_dirs[i].monitor);
+			g_clear_object (&script_dirs[i].monitor);
+		}
+	}
+	script_dirs_invalidate ();
+}
+
+static gboolean
+script_is_monitored_link (const char *path)
+{
+	gs_free char *real = NULL;
+	gs_free char *dir = NULL;
+	guint i;
+
+	real = realpath (path, NULL);
+	if (!real)
+		return FALSE;
+
+	dir = g_path_get_dirname (real);
+	for (i = 0; i < _SCRIPT_DIR_NUM; i++) {
+		if (nm_streq (dir, script_dirs[i].dirname))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static GArray *
+script_dir_scan (const char *dirname)
 {
 	GDir *dir;
 	const char *filename;
-	GSList *sorted = NULL;
+	GArray *scripts;
 	GError *error = NULL;
-	const char *dirname;
 
-	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
-	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_UP;
-	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
-	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_DOWN;
-	else
-		dirname = NMD_SCRIPT_DIR_DEFAULT;
+	scripts = g_array_new (FALSE, FALSE, sizeof (ScriptEntry));
+	g_array_set_clear_func (scripts, script_entry_clear);
 
 	if (!(dir = g_dir_open (dirname, 0, &error))) {
 		g_message ("find-scripts: Failed to open dispatcher directory '%s': %s",
 		           dirname, error->message);
 		g_error_free (error);
-		return NULL;
+		return scripts;
 	}
 
 	while ((filename = g_dir_read_name (dir))) {
@@ -619,43 +824,55 @@ find_scripts (const char *str_action)
 		else if (!check_permissions (&st, &err_msg))
 			g_warning ("find-scripts: Cannot execute '%s': %s", path, err_msg);
 		else {
-			/* success */
-			sorted = g_slist_insert_sorted (sorted, path, (GCompareFunc) g_strcmp0);
+			ScriptEntry entry = {
+				.path = path,
+				.wait = script_must_wait (path),
+			};
+			struct stat lst;
+
+			if (   lstat (path, &lst) == 0
+			    && S_ISLNK (lst.st_mode)
+			    && !script_is_monitored_link (path))
+				entry.revalidate = TRUE;
+
+			g_array_append_val (scripts, entry);
 			path = NULL;
 		}
 		g_free (path);
 	}
 	g_dir_close (dir);
 
-	return sorted;
+	g_array_sort (scripts, script_entry_cmp);
+	return scripts;
 }
 
-static gboolean
-script_must_wait (const char *path)
+static GArray *
+find_scripts (const char *str_action)
 {
-	gs_free char *link = NULL;
-	gs_free char *dir = NULL;
-	gs_free char *real = NULL;
-	char *tmp;
+	ScriptDir *script_dir;
 
-	link = g_file_read_link (path, NULL);
-	if (link) {
-		if (!g_path_is_absolute (link)) {
-			dir = g_path_get_dirname (path);
-			tmp = g_build_path ("/", dir, link, NULL);
-			g_free (link);
-			g_free (dir);
-			link = tmp;
-		}
+	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
+	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
+		script_dir = &script_dirs[SCRIPT_DIR_PRE_UP];
+	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
+	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
+		script_dir = &script_dirs[SCRIPT_DIR_PRE_DOWN];
+	else
+		script_dir = &script_dirs[SCRIPT_DIR_DEFAULT];
 
-		dir = g_path_get_dirname (link);
-		real = realpath (dir, NULL);
+	if (!script_dirs_monitor ()) {
+		/* without monitoring the directories, we cannot know when the
+		 * index becomes stale. Always rescan. */
+		return script_dir_scan (script_dir->dirname);
+	}
 
-		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
-			return FALSE;
+	if (!script_dir->scripts) {
+		script_dir->scripts = script_dir_scan (script_dir->dirname);
+		g_debug ("find-scripts: indexed %u scripts in '%s'",
+		         script_dir->scripts->len, script_dir->dirname);
 	}
 
-	return TRUE;
+	return g_array_ref (script_dir->scripts);
 }
 
 static gboolean
@@ -679,8 +896,7 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gpointer user_data)
 {
 	Handler *h = user_data;
-	GSList *sorted_scripts = NULL;
-	GSList *iter;
+	gs_unref_array GArray *sorted_scripts = NULL;
 	Request *request;
 	char **p;
 	guint i, num_nowait = 0;
@@ -712,17 +928,31 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	                                                    &request->iface,
 	                                                    &error_message);
 
-	request->scripts = g_ptr_array_new_full (5, script_info_free);
-	for (iter = sorted_scripts; iter; iter = g_slist_next (iter)) {
+	request->scripts = g_ptr_array_new_full (sorted_scripts->len, script_info_free);
+	for (i = 0; i < sorted_scripts->len; i++) {
+		const ScriptEntry *entry = &g_array_index (sorted_scripts, ScriptEntry, i);
 		ScriptInfo *s;
 
+		if (entry->revalidate) {
+			struct stat st;
+			const char *err_msg = NULL;
+
+			if (stat (entry->path, &st) != 0) {
+				g_warning ("find-scripts: Failed to stat '%s': %d", entry->path, errno);
+				continue;
+			}
+			if (!check_permissions (&st, &err_msg)) {
+				g_warning ("find-scripts: Cannot execute '%s': %s", entry->path, err_msg);
+				continue;
+			}
+		}
+
 		s = g_slice_new0 (ScriptInfo);
 		s->request = request;
-		s->script = iter->data;
-		s->wait = script_must_wait (s->script);
+		s->script = g_strdup (entry->path);
+		s->wait = entry->wait;
 		g_ptr_array_add (request->scripts, s);
 	}
-	g_slist_free (sorted_scripts);
 
 	_LOG_R_I (request, "new request (%u scripts)", request->scripts->len);
 	if (   _LOG_R_D_enabled (request)
@@ -760,35 +990,17 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 
 	if (num_nowait < request->scripts->len) {
-		/* The request has at least one wait script.
-		 * Try next_request() to schedule the request for
-		 * execution. This either enqueues the request or
-		 * sets it as h->current_request. */
-		if (next_request (h, request)) {
-			/* @request is now @current_request. Go ahead and
-			 * schedule the first wait script. */
-			if (!dispatch_one_script (request)) {
-				/* If that fails, we might be already finished with the
-				 * request. Try complete_request(). */
-				complete_request (request);
-
-				if (next_request (h, NULL)) {
-					/* As @request was successfully scheduled as next_request(), there is no
-					 * other request in queue that can be scheduled afterwards. Assert against
-					 * that, but call next_request() to clear current_request. */
-					g_assert_not_reached ();
-				}
-			}
-		}
+		/* The request has at least one wait script. Enqueue it
+		 * and start it, if no earlier request blocks it. */
+		g_queue_push_tail (h->requests_waiting, request);
+		schedule_requests (h);
 	} else {
 		/* The request contains only no-wait scripts. Try to complete
 		 * the request right away (we might have failed to schedule any
 		 * of the scripts). It will be either completed now, or later
 		 * when the pending scripts return.
-		 * We don't enqueue it to h->requests_waiting.
-		 * There is no need to handle next_request(), because @request is
-		 * not the current request anyway and does not interfere with requests
-		 * that have any "wait" scripts. */
+		 * We don't enqueue it to h->requests_waiting, because it does
+		 * not interfere with requests that have any "wait" scripts. */
 		complete_request (request);
 	}
 
@@ -898,6 +1110,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "max-parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Run requests for up to N different interfaces at the same time (default: 1)", "N" },
 		{ NULL }
 	};
 
@@ -913,6 +1126,11 @@ main (int argc, char **argv)
 
 	g_option_context_free (opt_ctx);
 
+	if (max_parallel < 1) {
+		g_warning ("Invalid value for --max-parallel: %d", max_parallel);
+		return 1;
+	}
+
 	g_unix_signal_add (SIGTERM, signal_handler, GINT_TO_POINTER (SIGTERM));
 	g_unix_signal_add (SIGINT, signal_handler, GINT_TO_POINTER (SIGINT));
 
@@ -961,6 +1179,8 @@ main (int argc, char **argv)
 	g_main_loop_run (loop);
 
 	g_queue_free (handler->requests_waiting);
+	g_hash_table_unref (handler->lanes_running);
+	script_dirs_clear ();
 	g_object_unref (handler);
 
 	if (!debug)
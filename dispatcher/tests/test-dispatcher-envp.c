@@ -650,6 +650,126 @@ test_up_empty_vpn_iface (void)
 
 /*****************************************************************************/
 
+typedef struct {
+	const char *lane;
+	bool completed;
+} FakeRequest;
+
+static void
+_test_schedule (guint max_parallel, guint n_requests)
+{
+	static const char *const ifaces[] = { "eth0", "eth1", "eth2", "wlan0", "virbr0", "tun0", };
+	gs_free FakeRequest *requests = g_new0 (FakeRequest, n_requests);
+	gs_free const char **lanes_waiting = g_new (const char *, n_requests);
+	gs_free guint *waiting = g_new (guint, n_requests);
+	gs_free guint *running = g_new (guint, n_requests);
+	gs_unref_hashtable GHashTable *lanes_running = g_hash_table_new (nm_str_hash, g_str_equal);
+	gboolean unbound_running = FALSE;
+	guint n_waiting = 0;
+	guint n_running = 0;
+	guint n_received = 0;
+	guint n_started = 0;
+	guint n_completed = 0;
+	guint i;
+
+	/* fake requests. Some of them are not bound to an interface,
+	 * like "hostname" or "connectivity-change". */
+	for (i = 0; i < n_requests; i++) {
+		if (nmtst_get_rand_int () % 10 == 0)
+			requests[i].lane = NULL;
+		else
+			requests[i].lane = ifaces[nmtst_get_rand_int () % G_N_ELEMENTS (ifaces)];
+	}
+
+	while (n_completed < n_requests) {
+		gssize idx;
+
+		/* either a new request arrives, or a running one completes. */
+		if (   n_received < n_requests
+		    && (   n_running == 0
+		        || nmtst_get_rand_bool ())) {
+			waiting[n_waiting] = n_received;
+			lanes_waiting[n_waiting] = requests[n_received].lane;
+			n_waiting++;
+			n_received++;
+		} else {
+			FakeRequest *r;
+
+			g_assert_cmpint (n_running, >, 0);
+			i = nmtst_get_rand_int () % n_running;
+			r = &requests[running[i]];
+			r->completed = TRUE;
+			n_completed++;
+			if (r->lane) {
+				if (!g_hash_table_remove (lanes_running, r->lane))
+					g_assert_not_reached ();
+			} else {
+				g_assert (unbound_running);
+				unbound_running = FALSE;
+			}
+			running[i] = running[--n_running];
+		}
+
+		while ((idx = nm_dispatcher_utils_schedule_next (lanes_waiting,
+		                                                 n_waiting,
+		                                                 lanes_running,
+		                                                 unbound_running,
+		                                                 n_running,
+		                                                 max_parallel)) >= 0) {
+			guint k = waiting[idx];
+			FakeRequest *r = &requests[k];
+
+			g_assert_cmpint (idx, <, n_waiting);
+			g_assert_cmpint (n_running, <, max_parallel);
+
+			/* all earlier requests for the same interface, and all earlier
+			 * requests without interface must be completed. An unbound
+			 * request requires all earlier requests to be completed. */
+			for (i = 0; i < k; i++) {
+				if (requests[i].completed)
+					continue;
+				g_assert (r->lane);
+				g_assert (requests[i].lane);
+				g_assert_cmpstr (requests[i].lane, !=, r->lane);
+			}
+			if (!r->lane)
+				g_assert_cmpint (n_running, ==, 0);
+
+			if (max_parallel == 1)
+				g_assert_cmpint (k, ==, n_started);
+
+			n_started++;
+			running[n_running++] = k;
+			if (r->lane) {
+				if (!g_hash_table_add (lanes_running, (char *) r->lane))
+					g_assert_not_reached ();
+			} else
+				unbound_running = TRUE;
+
+			n_waiting--;
+			memmove (&waiting[idx], &waiting[idx + 1], sizeof (waiting[0]) * (n_waiting - idx));
+			memmove (&lanes_waiting[idx], &lanes_waiting[idx + 1], sizeof (lanes_waiting[0]) * (n_waiting - idx));
+		}
+
+		/* if nothing runs, nothing may wait. */
+		if (n_running == 0)
+			g_assert_cmpint (n_waiting, ==, 0);
+	}
+
+	g_assert_cmpint (n_started, ==, n_requests);
+}
+
+static void
+test_schedule (void)
+{
+	_test_schedule (1, 300);
+	_test_schedule (2, 300);
+	_test_schedule (4, 300);
+	_test_schedule (64, 300);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -666,6 +786,8 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/dispatcher/up_empty_vpn_iface", test_up_empty_vpn_iface);
 
+	g_test_add_func ("/dispatcher/schedule", test_schedule);
+
 	return g_test_run ();
 }
 
@@ -2213,6 +2213,7 @@ nm_connection_is_virtual (NMConnection *connection)
 	    || !strcmp (type, NM_SETTING_OVS_INTERFACE_SETTING_NAME)
 	    || !strcmp (type, NM_SETTING_OVS_PORT_SETTING_NAME)
 	    || !strcmp (type, NM_SETTING_VXLAN_SETTING_NAME)
+	    || !strcmp (type, NM_SETTING_WIREGUARD_SETTING_NAME)
 	    || !strcmp (type, NM_SETTING_CONTRAIL_VROUTER_SETTING_NAME))
 		return TRUE;
 
@@ -2763,6 +2764,22 @@ nm_connection_get_setting_wimax (NMConnection *connection)
 	return _connection_get_setting_check (connection, NM_TYPE_SETTING_WIMAX);
 }
 
+/**
+ * nm_connection_get_setting_wireguard:
+ * @connection: the #NMConnection
+ *
+ * A shortcut to return any #NMSettingWireGuard the connection might contain.
+ *
+ * Returns: (transfer none): an #NMSettingWireGuard if the connection contains one, otherwise %NULL
+ *
+ * Since: 1.14
+ **/
+NMSettingWireGuard *
+nm_connection_get_setting_wireguard (NMConnection *connection)
+{
+	return _connection_get_setting_check (connection, NM_TYPE_SETTING_WIREGUARD);
+}
+
 /**
  * nm_connection_get_setting_wired:
  * @connection: the #NMConnection
@@ -76,6 +76,7 @@
 #include "nm-setting-vpn.h"
 #include "nm-setting-vxlan.h"
 #include "nm-setting-wimax.h"
+#include "nm-setting-wireguard.h"
 #include "nm-setting-wired.h"
 #include "nm-setting-wireless-security.h"
 #include "nm-setting-wireless.h"
@@ -238,6 +239,20 @@ GHashTable *_nm_ip_route_get_attributes_direct (NMIPRoute *route);
 NMSriovVF *_nm_utils_sriov_vf_from_strparts (const char *index, const char *detail, GError **error);
 gboolean _nm_sriov_vf_attribute_validate_all (const NMSriovVF *vf, GError **error);
 
+#define NM_WIREGUARD_PUBLIC_KEY_LEN 32
+
+gboolean _nm_utils_wireguard_decode_key (const char *base64_key,
+                                         gsize required_key_len,
+                                         guint8 *out_key);
+gboolean _nm_utils_wireguard_parse_endpoint (const char *endpoint,
+                                             int *out_addr_family,
+                                             NMIPAddr *out_addr,
+                                             guint16 *out_port);
+gboolean _nm_utils_wireguard_parse_allowed_ip (const char *allowed_ip,
+                                               int *out_addr_family,
+                                               NMIPAddr *out_addr,
+                                               guint8 *out_prefix);
+
 static inline void
 _nm_auto_ip_route_unref (NMIPRoute **v)
 {
@@ -444,6 +459,8 @@ typedef enum {
 
 NMBondMode _nm_setting_bond_mode_from_string (const char *str);
 gboolean _nm_setting_bond_option_supported (const char *option, NMBondMode mode);
+gboolean _nm_setting_bond_option_to_uint (const char *name, const char *value, guint32 *out_value);
+const char *_nm_setting_bond_option_from_uint (const char *name, guint32 value);
 
 /*****************************************************************************/
 
@@ -162,6 +162,149 @@ sriov_vfs_parser (KeyfileReaderInfo *info, NMSetting *setting, const char *key)
 	              NULL);
 }
 
+typedef struct {
+	guint idx;
+	NMWireGuardPeer *peer;
+} WireGuardPeerEntry;
+
+static int
+_wireguard_peer_entry_cmp (gconstpointer a, gconstpointer b)
+{
+	const WireGuardPeerEntry *entry_a = a;
+	const WireGuardPeerEntry *entry_b = b;
+
+	NM_CMP_FIELD (entry_a, entry_b, idx);
+	return 0;
+}
+
+/* each peer is stored as "peer.<N>=public-key=KEY endpoint=ADDR:PORT
+ * persistent-keepalive=SECS allowed-ips=ADDR/PREFIX,...", with
+ * everything but the public key optional. */
+static NMWireGuardPeer *
+_wireguard_peer_from_str (const char *str, GError **error)
+{
+	NMWireGuardPeer *peer;
+	gs_strfreev char **tokens = NULL;
+	guint i, j;
+
+	peer = nm_wireguard_peer_new ();
+
+	tokens = g_strsplit_set (str, " \t", -1);
+	for (i = 0; tokens[i]; i++) {
+		const char *name = tokens[i];
+		char *value;
+
+		if (!name[0])
+			continue;
+
+		value = strchr (tokens[i], '=');
+		if (!value) {
+			g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_FAILED,
+			             _("missing value for '%s'"), name);
+			goto fail;
+		}
+		*(value++) = '\0';
+
+		if (nm_streq (name, NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY))
+			nm_wireguard_peer_set_public_key (peer, value);
+		else if (nm_streq (name, NM_WIREGUARD_PEER_ATTR_ENDPOINT))
+			nm_wireguard_peer_set_endpoint (peer, value);
+		else if (nm_streq (name, NM_WIREGUARD_PEER_ATTR_PERSISTENT_KEEPALIVE)) {
+			gint64 keepalive;
+
+			keepalive = _nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXUINT16, -1);
+			if (keepalive < 0) {
+				g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_FAILED,
+				             _("invalid persistent keepalive '%s'"), value);
+				goto fail;
+			}
+			nm_wireguard_peer_set_persistent_keepalive (peer, keepalive);
+		} else if (nm_streq (name, NM_WIREGUARD_PEER_ATTR_ALLOWED_IPS)) {
+			gs_strfreev char **allowed_ips = NULL;
+
+			allowed_ips = g_strsplit (value, ",", -1);
+			for (j = 0; allowed_ips[j]; j++) {
+				if (allowed_ips[j][0])
+					nm_wireguard_peer_append_allowed_ip (peer, allowed_ips[j]);
+			}
+		} else {
+			g_set_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_FAILED,
+			             _("unknown attribute '%s'"), name);
+			goto fail;
+		}
+	}
+
+	if (!nm_wireguard_peer_get_public_key (peer)) {
+		g_set_error_literal (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_FAILED,
+		                     _("missing public key"));
+		goto fail;
+	}
+
+	return peer;
+
+fail:
+	nm_wireguard_peer_unref (peer);
+	return NULL;
+}
+
+static void
+wireguard_peers_parser (KeyfileReaderInfo *info, NMSetting *setting, const char *key)
+{
+	const char *setting_name = nm_setting_get_name (setting);
+	gs_unref_ptrarray GPtrArray *peers = NULL;
+	gs_unref_array GArray *entries = NULL;
+	gs_strfreev char **keys = NULL;
+	gsize n_keys = 0;
+	guint i;
+
+	keys = nm_keyfile_plugin_kf_get_keys (info->keyfile, setting_name, &n_keys, NULL);
+	if (!keys || n_keys == 0)
+		return;
+
+	entries = g_array_new (FALSE, FALSE, sizeof (WireGuardPeerEntry));
+
+	for (i = 0; i < n_keys; i++) {
+		gs_free_error GError *err = NULL;
+		gs_free char *value = NULL;
+		WireGuardPeerEntry entry;
+		gint64 idx;
+
+		if (!g_str_has_prefix (keys[i], "peer."))
+			continue;
+
+		idx = _nm_utils_ascii_str_to_int64 (&keys[i][NM_STRLEN ("peer.")], 10, 0, G_MAXUINT, -1);
+		if (idx < 0)
+			continue;
+
+		value = nm_keyfile_plugin_kf_get_string (info->keyfile,
+		                                         setting_name,
+		                                         keys[i],
+		                                         NULL);
+		entry.idx = idx;
+		entry.peer = _wireguard_peer_from_str (value ?: "", &err);
+		if (!entry.peer) {
+			if (!handle_warn (info, keys[i], NM_KEYFILE_WARN_SEVERITY_WARN,
+			                  _("invalid WireGuard peer: %s"),
+			                  err->message))
+				break;
+			continue;
+		}
+		g_array_append_val (entries, entry);
+	}
+
+	g_array_sort (entries, _wireguard_peer_entry_cmp);
+
+	peers = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_wireguard_peer_unref);
+	for (i = 0; i < entries->len; i++)
+		g_ptr_array_add (peers, g_array_index (entries, WireGuardPeerEntry, i).peer);
+
+	if (peers->len > 0) {
+		g_object_set (G_OBJECT (setting),
+		              key, peers,
+		              NULL);
+	}
+}
+
 static void
 read_array_of_uint (GKeyFile *file,
                     NMSetting *setting,
@@ -1595,6 +1738,53 @@ sriov_vfs_writer (KeyfileWriterInfo *info,
 	}
 }
 
+static void
+wireguard_peers_writer (KeyfileWriterInfo *info,
+                        NMSetting *setting,
+                        const char *key,
+                        const GValue *value)
+{
+	GPtrArray *peers;
+	guint i, j;
+
+	peers = g_value_get_boxed (value);
+	if (!peers)
+		return;
+
+	for (i = 0; i < peers->len; i++) {
+		const NMWireGuardPeer *peer = peers->pdata[i];
+		nm_auto_free_gstring GString *str = NULL;
+		guint n_allowed_ips;
+		char kf_key[32];
+
+		str = g_string_new (NULL);
+		g_string_append_printf (str, "%s=%s",
+		                        NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY,
+		                        nm_wireguard_peer_get_public_key (peer));
+		if (nm_wireguard_peer_get_endpoint (peer)) {
+			g_string_append_printf (str, " %s=%s",
+			                        NM_WIREGUARD_PEER_ATTR_ENDPOINT,
+			                        nm_wireguard_peer_get_endpoint (peer));
+		}
+		if (nm_wireguard_peer_get_persistent_keepalive (peer) != 0) {
+			g_string_append_printf (str, " %s=%u",
+			                        NM_WIREGUARD_PEER_ATTR_PERSISTENT_KEEPALIVE,
+			                        (guint) nm_wireguard_peer_get_persistent_keepalive (peer));
+		}
+		n_allowed_ips = nm_wireguard_peer_get_allowed_ips_len (peer);
+		for (j = 0; j < n_allowed_ips; j++) {
+			g_string_append (str, j == 0 ? " " NM_WIREGUARD_PEER_ATTR_ALLOWED_IPS "=" : ",");
+			g_string_append (str, nm_wireguard_peer_get_allowed_ip (peer, j));
+		}
+
+		nm_sprintf_buf (kf_key, "peer.%u", i);
+		nm_keyfile_plugin_kf_set_string (info->keyfile,
+		                                 nm_setting_get_name (setting),
+		                                 kf_key,
+		                                 str->str);
+	}
+}
+
 static void
 write_array_of_uint (GKeyFile *file,
                      NMSetting *setting,
@@ -2437,6 +2627,15 @@ static const ParseInfoSetting *const parse_infos[_NM_META_SETTING_TYPE_NUM] = {
 			),
 		),
 	),
+	PARSE_INFO_SETTING (NM_META_SETTING_TYPE_WIREGUARD,
+		PARSE_INFO_PROPERTIES (
+			PARSE_INFO_PROPERTY (NM_SETTING_WIREGUARD_PEERS,
+				.parser_no_check_key = TRUE,
+				.parser        = wireguard_peers_parser,
+				.writer        = wireguard_peers_writer,
+			),
+		),
+	),
 };
 
 static const ParseInfoProperty *
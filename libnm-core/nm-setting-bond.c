@@ -485,6 +485,79 @@ _nm_setting_bond_get_option_type (NMSettingBond *setting, const char *name)
 	g_assert_not_reached ();
 }
 
+static const BondDefault *
+_get_default (const char *name)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (defaults); i++) {
+		if (nm_streq0 (defaults[i].opt, name))
+			return &defaults[i];
+	}
+	return NULL;
+}
+
+/**
+ * _nm_setting_bond_option_to_uint:
+ * @name: the name of an option of type %NM_BOND_OPTION_TYPE_INT or
+ *   %NM_BOND_OPTION_TYPE_BOTH
+ * @value: the value of the option
+ * @out_value: (out): the numeric value as understood by kernel
+ *
+ * The named values of a %NM_BOND_OPTION_TYPE_BOTH option are listed
+ * in the order of their numeric value in kernel.
+ *
+ * Returns: %TRUE if @value could be converted.
+ */
+gboolean
+_nm_setting_bond_option_to_uint (const char *name, const char *value, guint32 *out_value)
+{
+	const BondDefault *def;
+	gint64 v;
+	guint i;
+
+	def = _get_default (name);
+	if (   !def
+	    || !value
+	    || !NM_IN_SET (def->opt_type, NM_BOND_OPTION_TYPE_INT, NM_BOND_OPTION_TYPE_BOTH))
+		return FALSE;
+
+	if (def->opt_type == NM_BOND_OPTION_TYPE_BOTH) {
+		for (i = 0; i < G_N_ELEMENTS (def->list) && def->list[i]; i++) {
+			if (nm_streq (def->list[i], value)) {
+				*out_value = i;
+				return TRUE;
+			}
+		}
+	}
+
+	v = _nm_utils_ascii_str_to_int64 (value, 10, def->min, def->max, -1);
+	if (v < 0)
+		return FALSE;
+	*out_value = v;
+	return TRUE;
+}
+
+/**
+ * _nm_setting_bond_option_from_uint:
+ * @name: the name of an option of type %NM_BOND_OPTION_TYPE_BOTH
+ * @value: the numeric value as reported by kernel
+ *
+ * Returns: the name of @value, or %NULL if there is none.
+ */
+const char *
+_nm_setting_bond_option_from_uint (const char *name, guint32 value)
+{
+	const BondDefault *def;
+
+	def = _get_default (name);
+	if (   !def
+	    || def->opt_type != NM_BOND_OPTION_TYPE_BOTH
+	    || value >= G_N_ELEMENTS (def->list))
+		return NULL;
+	return def->list[value];
+}
+
 NMBondMode
 _nm_setting_bond_mode_from_string (const char *str)
 {
@@ -0,0 +1,1103 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-setting-wireguard.h"
+
+#include "nm-setting-private.h"
+#include "nm-utils-private.h"
+#include "nm-core-internal.h"
+#include "nm-utils/nm-secret-utils.h"
+
+/**
+ * SECTION:nm-setting-wireguard
+ * @short_description: Describes connection properties for WireGuard interfaces
+ * @include: nm-setting-wireguard.h
+ *
+ * The #NMSettingWireGuard object is a #NMSetting subclass that describes properties
+ * necessary for connection to WireGuard interfaces.
+ **/
+
+/**
+ * NMSettingWireGuard:
+ *
+ * WireGuard Settings
+ *
+ * Since: 1.14
+ */
+struct _NMSettingWireGuard {
+	NMSetting parent;
+	char *private_key;
+	GPtrArray *peers;
+	NMSettingSecretFlags private_key_flags;
+	guint32 fwmark;
+	guint16 listen_port;
+};
+
+struct _NMSettingWireGuardClass {
+	NMSettingClass parent;
+};
+
+G_DEFINE_TYPE (NMSettingWireGuard, nm_setting_wireguard, NM_TYPE_SETTING)
+
+NM_GOBJECT_PROPERTIES_DEFINE (NMSettingWireGuard,
+	PROP_PRIVATE_KEY,
+	PROP_PRIVATE_KEY_FLAGS,
+	PROP_LISTEN_PORT,
+	PROP_FWMARK,
+	PROP_PEERS,
+);
+
+/*****************************************************************************/
+
+/**
+ * _nm_utils_wireguard_decode_key:
+ * @base64_key: the key in base64 encoding
+ * @required_key_len: the expected length of the binary key
+ * @out_key: (allow-none): on success, the decoded key. Must be
+ *   @required_key_len bytes large.
+ *
+ * Returns: %TRUE if @base64_key is a valid key of @required_key_len bytes.
+ */
+gboolean
+_nm_utils_wireguard_decode_key (const char *base64_key,
+                                gsize required_key_len,
+                                guint8 *out_key)
+{
+	gs_free guint8 *bin = NULL;
+	gsize len;
+
+	if (!base64_key)
+		return FALSE;
+
+	/* the base64 encoding of a key has a fixed length. Check that first, so that
+	 * we don't try to decode arbitrary input. */
+	if (strlen (base64_key) != ((required_key_len + 2) / 3) * 4)
+		return FALSE;
+
+	bin = g_base64_decode (base64_key, &len);
+	if (len != required_key_len) {
+		if (bin)
+			nm_explicit_bzero (bin, len);
+		return FALSE;
+	}
+
+	if (out_key)
+		memcpy (out_key, bin, len);
+	nm_explicit_bzero (bin, len);
+	return TRUE;
+}
+
+/**
+ * _nm_utils_wireguard_parse_endpoint:
+ * @endpoint: the endpoint in the form "ADDR:PORT" or "[ADDR6]:PORT"
+ * @out_addr_family: (allow-none): the address family of the endpoint
+ * @out_addr: (allow-none): the address of the endpoint
+ * @out_port: (allow-none): the port of the endpoint
+ *
+ * Only literal IP addresses are supported. The endpoint is passed
+ * as is to the kernel, and NetworkManager does not resolve host names
+ * for it.
+ *
+ * Returns: %TRUE if @endpoint is valid.
+ */
+gboolean
+_nm_utils_wireguard_parse_endpoint (const char *endpoint,
+                                    int *out_addr_family,
+                                    NMIPAddr *out_addr,
+                                    guint16 *out_port)
+{
+	gs_free char *addrstr = NULL;
+	const char *colon;
+	NMIPAddr addr;
+	gint64 port;
+	int addr_family;
+
+	if (!endpoint)
+		return FALSE;
+
+	colon = strrchr (endpoint, ':');
+	if (!colon || colon == endpoint)
+		return FALSE;
+
+	if (endpoint[0] == '[') {
+		if (colon[-1] != ']')
+			return FALSE;
+		addr_family = AF_INET6;
+		addrstr = g_strndup (&endpoint[1], colon - endpoint - 2);
+	} else {
+		addr_family = AF_INET;
+		addrstr = g_strndup (endpoint, colon - endpoint);
+	}
+
+	if (!nm_utils_parse_inaddr_bin (addr_family, addrstr, &addr))
+		return FALSE;
+
+	port = _nm_utils_ascii_str_to_int64 (&colon[1], 10, 1, G_MAXUINT16, -1);
+	if (port == -1)
+		return FALSE;
+
+	NM_SET_OUT (out_addr_family, addr_family);
+	if (out_addr)
+		*out_addr = addr;
+	NM_SET_OUT (out_port, port);
+	return TRUE;
+}
+
+/**
+ * _nm_utils_wireguard_parse_allowed_ip:
+ * @allowed_ip: the allowed IP in the form "ADDR[/PREFIX]"
+ * @out_addr_family: (allow-none): the address family
+ * @out_addr: (allow-none): the address
+ * @out_prefix: (allow-none): the prefix length. If the allowed IP
+ *   has no prefix, it is the full address length.
+ *
+ * Returns: %TRUE if @allowed_ip is valid.
+ */
+gboolean
+_nm_utils_wireguard_parse_allowed_ip (const char *allowed_ip,
+                                      int *out_addr_family,
+                                      NMIPAddr *out_addr,
+                                      guint8 *out_prefix)
+{
+	NMIPAddr addr = { };
+	int addr_family;
+	int prefix;
+
+	if (!allowed_ip)
+		return FALSE;
+
+	addr_family = strchr (allowed_ip, ':') ? AF_INET6 : AF_INET;
+	if (!nm_utils_parse_inaddr_prefix_bin (addr_family, allowed_ip, &addr, &prefix))
+		return FALSE;
+
+	if (prefix == -1)
+		prefix = addr_family == AF_INET ? 32 : 128;
+
+	NM_SET_OUT (out_addr_family, addr_family);
+	if (out_addr)
+		*out_addr = addr;
+	NM_SET_OUT (out_prefix, prefix);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+G_DEFINE_BOXED_TYPE (NMWireGuardPeer, nm_wireguard_peer, nm_wireguard_peer_dup, nm_wireguard_peer_unref)
+
+struct _NMWireGuardPeer {
+	guint refcount;
+	char *public_key;
+	char *endpoint;
+	GPtrArray *allowed_ips;
+	guint16 persistent_keepalive;
+};
+
+/**
+ * nm_wireguard_peer_new:
+ *
+ * Creates a new #NMWireGuardPeer object.
+ *
+ * Returns: (transfer full): the new #NMWireGuardPeer object.
+ *
+ * Since: 1.14
+ **/
+NMWireGuardPeer *
+nm_wireguard_peer_new (void)
+{
+	NMWireGuardPeer *peer;
+
+	peer = g_slice_new0 (NMWireGuardPeer);
+	peer->refcount = 1;
+	peer->allowed_ips = g_ptr_array_new_with_free_func (g_free);
+	return peer;
+}
+
+/**
+ * nm_wireguard_peer_ref:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Increases the reference count of the object.
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_ref (NMWireGuardPeer *peer)
+{
+	g_return_if_fail (peer);
+	g_return_if_fail (peer->refcount > 0);
+
+	peer->refcount++;
+}
+
+/**
+ * nm_wireguard_peer_unref:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Decreases the reference count of the object.  If the reference count
+ * reaches zero, the object will be destroyed.
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_unref (NMWireGuardPeer *peer)
+{
+	g_return_if_fail (peer);
+	g_return_if_fail (peer->refcount > 0);
+
+	peer->refcount--;
+	if (peer->refcount == 0) {
+		g_free (peer->public_key);
+		g_free (peer->endpoint);
+		g_ptr_array_unref (peer->allowed_ips);
+		g_slice_free (NMWireGuardPeer, peer);
+	}
+}
+
+/**
+ * nm_wireguard_peer_dup:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Creates a copy of @peer.
+ *
+ * Returns: (transfer full): a copy of @peer
+ *
+ * Since: 1.14
+ **/
+NMWireGuardPeer *
+nm_wireguard_peer_dup (const NMWireGuardPeer *peer)
+{
+	NMWireGuardPeer *copy;
+	guint i;
+
+	g_return_val_if_fail (peer, NULL);
+	g_return_val_if_fail (peer->refcount > 0, NULL);
+
+	copy = nm_wireguard_peer_new ();
+	copy->public_key = g_strdup (peer->public_key);
+	copy->endpoint = g_strdup (peer->endpoint);
+	copy->persistent_keepalive = peer->persistent_keepalive;
+	for (i = 0; i < peer->allowed_ips->len; i++)
+		g_ptr_array_add (copy->allowed_ips, g_strdup (peer->allowed_ips->pdata[i]));
+	return copy;
+}
+
+/**
+ * nm_wireguard_peer_equal:
+ * @peer: the #NMWireGuardPeer
+ * @other: the #NMWireGuardPeer to compare @peer to.
+ *
+ * Determines if two #NMWireGuardPeer objects have the same public key,
+ * endpoint, keepalive interval and allowed IPs (in the same order).
+ *
+ * Returns: %TRUE if the objects contain the same values, %FALSE
+ *    if they do not.
+ *
+ * Since: 1.14
+ **/
+gboolean
+nm_wireguard_peer_equal (const NMWireGuardPeer *peer, const NMWireGuardPeer *other)
+{
+	guint i;
+
+	g_return_val_if_fail (peer, FALSE);
+	g_return_val_if_fail (peer->refcount > 0, FALSE);
+	g_return_val_if_fail (other, FALSE);
+	g_return_val_if_fail (other->refcount > 0, FALSE);
+
+	if (peer == other)
+		return TRUE;
+
+	if (   !nm_streq0 (peer->public_key, other->public_key)
+	    || !nm_streq0 (peer->endpoint, other->endpoint)
+	    || peer->persistent_keepalive != other->persistent_keepalive
+	    || peer->allowed_ips->len != other->allowed_ips->len)
+		return FALSE;
+
+	for (i = 0; i < peer->allowed_ips->len; i++) {
+		if (!nm_streq (peer->allowed_ips->pdata[i], other->allowed_ips->pdata[i]))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * nm_wireguard_peer_get_public_key:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Returns: the public key of the peer in base64 encoding.
+ *
+ * Since: 1.14
+ **/
+const char *
+nm_wireguard_peer_get_public_key (const NMWireGuardPeer *peer)
+{
+	g_return_val_if_fail (peer, NULL);
+
+	return peer->public_key;
+}
+
+/**
+ * nm_wireguard_peer_set_public_key:
+ * @peer: the #NMWireGuardPeer
+ * @public_key: (allow-none): the public key in base64 encoding
+ *
+ * Sets the public key of the peer. The public key identifies
+ * the peer and is mandatory.
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_set_public_key (NMWireGuardPeer *peer, const char *public_key)
+{
+	g_return_if_fail (peer);
+
+	g_free (peer->public_key);
+	peer->public_key = g_strdup (public_key);
+}
+
+/**
+ * nm_wireguard_peer_get_endpoint:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Returns: the endpoint of the peer, or %NULL if it has none.
+ *
+ * Since: 1.14
+ **/
+const char *
+nm_wireguard_peer_get_endpoint (const NMWireGuardPeer *peer)
+{
+	g_return_val_if_fail (peer, NULL);
+
+	return peer->endpoint;
+}
+
+/**
+ * nm_wireguard_peer_set_endpoint:
+ * @peer: the #NMWireGuardPeer
+ * @endpoint: (allow-none): the endpoint in the form "ADDR:PORT"
+ *   or "[ADDR6]:PORT". Host names are not supported.
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_set_endpoint (NMWireGuardPeer *peer, const char *endpoint)
+{
+	g_return_if_fail (peer);
+
+	g_free (peer->endpoint);
+	peer->endpoint = g_strdup (endpoint);
+}
+
+/**
+ * nm_wireguard_peer_get_persistent_keepalive:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Returns: the persistent keepalive interval in seconds, or 0
+ *   if it is disabled.
+ *
+ * Since: 1.14
+ **/
+guint16
+nm_wireguard_peer_get_persistent_keepalive (const NMWireGuardPeer *peer)
+{
+	g_return_val_if_fail (peer, 0);
+
+	return peer->persistent_keepalive;
+}
+
+/**
+ * nm_wireguard_peer_set_persistent_keepalive:
+ * @peer: the #NMWireGuardPeer
+ * @persistent_keepalive: the keepalive interval in seconds, or 0 to disable it
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_set_persistent_keepalive (NMWireGuardPeer *peer, guint16 persistent_keepalive)
+{
+	g_return_if_fail (peer);
+
+	peer->persistent_keepalive = persistent_keepalive;
+}
+
+/**
+ * nm_wireguard_peer_get_allowed_ips_len:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Returns: the number of allowed IPs of the peer
+ *
+ * Since: 1.14
+ **/
+guint
+nm_wireguard_peer_get_allowed_ips_len (const NMWireGuardPeer *peer)
+{
+	g_return_val_if_fail (peer, 0);
+
+	return peer->allowed_ips->len;
+}
+
+/**
+ * nm_wireguard_peer_get_allowed_ip:
+ * @peer: the #NMWireGuardPeer
+ * @idx: the index of the allowed IP
+ *
+ * Returns: the allowed IP at index @idx, in the form "ADDR[/PREFIX]"
+ *
+ * Since: 1.14
+ **/
+const char *
+nm_wireguard_peer_get_allowed_ip (const NMWireGuardPeer *peer, guint idx)
+{
+	g_return_val_if_fail (peer, NULL);
+	g_return_val_if_fail (idx < peer->allowed_ips->len, NULL);
+
+	return peer->allowed_ips->pdata[idx];
+}
+
+/**
+ * nm_wireguard_peer_append_allowed_ip:
+ * @peer: the #NMWireGuardPeer
+ * @allowed_ip: the allowed IP in the form "ADDR[/PREFIX]"
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_append_allowed_ip (NMWireGuardPeer *peer, const char *allowed_ip)
+{
+	g_return_if_fail (peer);
+	g_return_if_fail (allowed_ip);
+
+	g_ptr_array_add (peer->allowed_ips, g_strdup (allowed_ip));
+}
+
+/**
+ * nm_wireguard_peer_clear_allowed_ips:
+ * @peer: the #NMWireGuardPeer
+ *
+ * Removes all allowed IPs of the peer.
+ *
+ * Since: 1.14
+ **/
+void
+nm_wireguard_peer_clear_allowed_ips (NMWireGuardPeer *peer)
+{
+	g_return_if_fail (peer);
+
+	g_ptr_array_set_size (peer->allowed_ips, 0);
+}
+
+static gboolean
+_peer_verify (const NMWireGuardPeer *peer, GError **error)
+{
+	guint i;
+
+	if (!peer->public_key) {
+		g_set_error_literal (error,
+		                     NM_CONNECTION_ERROR,
+		                     NM_CONNECTION_ERROR_MISSING_PROPERTY,
+		                     _("peer has no public key"));
+		return FALSE;
+	}
+	if (!_nm_utils_wireguard_decode_key (peer->public_key, NM_WIREGUARD_PUBLIC_KEY_LEN, NULL)) {
+		g_set_error (error,
+		             NM_CONNECTION_ERROR,
+		             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		             _("invalid public key '%s'"),
+		             peer->public_key);
+		return FALSE;
+	}
+	if (   peer->endpoint
+	    && !_nm_utils_wireguard_parse_endpoint (peer->endpoint, NULL, NULL, NULL)) {
+		g_set_error (error,
+		             NM_CONNECTION_ERROR,
+		             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		             _("invalid endpoint '%s'"),
+		             peer->endpoint);
+		return FALSE;
+	}
+	for (i = 0; i < peer->allowed_ips->len; i++) {
+		const char *allowed_ip = peer->allowed_ips->pdata[i];
+
+		if (!_nm_utils_wireguard_parse_allowed_ip (allowed_ip, NULL, NULL, NULL)) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("invalid allowed IP '%s'"),
+			             allowed_ip);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_setting_wireguard_new:
+ *
+ * Creates a new #NMSettingWireGuard object with default values.
+ *
+ * Returns: (transfer full): the new empty #NMSettingWireGuard object
+ *
+ * Since: 1.14
+ **/
+NMSetting *
+nm_setting_wireguard_new (void)
+{
+	return (NMSetting *) g_object_new (NM_TYPE_SETTING_WIREGUARD, NULL);
+}
+
+/**
+ * nm_setting_wireguard_get_private_key:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Returns: the #NMSettingWireGuard:private-key property of the setting
+ *
+ * Since: 1.14
+ **/
+const char *
+nm_setting_wireguard_get_private_key (NMSettingWireGuard *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), NULL);
+
+	return setting->private_key;
+}
+
+/**
+ * nm_setting_wireguard_get_private_key_flags:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Returns: the #NMSettingSecretFlags pertaining to the
+ *   #NMSettingWireGuard:private-key
+ *
+ * Since: 1.14
+ **/
+NMSettingSecretFlags
+nm_setting_wireguard_get_private_key_flags (NMSettingWireGuard *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), NM_SETTING_SECRET_FLAG_NONE);
+
+	return setting->private_key_flags;
+}
+
+/**
+ * nm_setting_wireguard_get_listen_port:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Returns: the #NMSettingWireGuard:listen-port property of the setting
+ *
+ * Since: 1.14
+ **/
+guint16
+nm_setting_wireguard_get_listen_port (NMSettingWireGuard *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), 0);
+
+	return setting->listen_port;
+}
+
+/**
+ * nm_setting_wireguard_get_fwmark:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Returns: the #NMSettingWireGuard:fwmark property of the setting
+ *
+ * Since: 1.14
+ **/
+guint32
+nm_setting_wireguard_get_fwmark (NMSettingWireGuard *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), 0);
+
+	return setting->fwmark;
+}
+
+/**
+ * nm_setting_wireguard_get_peers_len:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Returns: the number of configured peers
+ *
+ * Since: 1.14
+ **/
+guint
+nm_setting_wireguard_get_peers_len (NMSettingWireGuard *setting)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), 0);
+
+	return setting->peers->len;
+}
+
+/**
+ * nm_setting_wireguard_get_peer:
+ * @setting: the #NMSettingWireGuard
+ * @idx: index number of the peer to return
+ *
+ * Returns: (transfer none): the peer at index @idx
+ *
+ * Since: 1.14
+ **/
+NMWireGuardPeer *
+nm_setting_wireguard_get_peer (NMSettingWireGuard *setting, guint idx)
+{
+	g_return_val_if_fail (NM_IS_SETTING_WIREGUARD (setting), NULL);
+	g_return_val_if_fail (idx < setting->peers->len, NULL);
+
+	return setting->peers->pdata[idx];
+}
+
+/**
+ * nm_setting_wireguard_append_peer:
+ * @setting: the #NMSettingWireGuard
+ * @peer: the peer to add
+ *
+ * Appends a new peer to the setting. The given peer is duplicated
+ * internally and is not changed by this function.
+ *
+ * Since: 1.14
+ **/
+void
+nm_setting_wireguard_append_peer (NMSettingWireGuard *setting, NMWireGuardPeer *peer)
+{
+	g_return_if_fail (NM_IS_SETTING_WIREGUARD (setting));
+	g_return_if_fail (peer);
+	g_return_if_fail (peer->refcount > 0);
+
+	g_ptr_array_add (setting->peers, nm_wireguard_peer_dup (peer));
+	_notify (setting, PROP_PEERS);
+}
+
+/**
+ * nm_setting_wireguard_remove_peer:
+ * @setting: the #NMSettingWireGuard
+ * @idx: index number of the peer
+ *
+ * Removes the peer at index @idx.
+ *
+ * Since: 1.14
+ **/
+void
+nm_setting_wireguard_remove_peer (NMSettingWireGuard *setting, guint idx)
+{
+	g_return_if_fail (NM_IS_SETTING_WIREGUARD (setting));
+	g_return_if_fail (idx < setting->peers->len);
+
+	g_ptr_array_remove_index (setting->peers, idx);
+	_notify (setting, PROP_PEERS);
+}
+
+/**
+ * nm_setting_wireguard_clear_peers:
+ * @setting: the #NMSettingWireGuard
+ *
+ * Removes all configured peers.
+ *
+ * Since: 1.14
+ **/
+void
+nm_setting_wireguard_clear_peers (NMSettingWireGuard *setting)
+{
+	g_return_if_fail (NM_IS_SETTING_WIREGUARD (setting));
+
+	if (setting->peers->len != 0) {
+		g_ptr_array_set_size (setting->peers, 0);
+		_notify (setting, PROP_PEERS);
+	}
+}
+
+/*****************************************************************************/
+
+static GVariant *
+peers_to_dbus (NMSetting *setting, const char *property)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (setting);
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+
+	for (i = 0; i < self->peers->len; i++) {
+		NMWireGuardPeer *peer = self->peers->pdata[i];
+		GVariantBuilder peer_builder;
+
+		g_variant_builder_init (&peer_builder, G_VARIANT_TYPE_VARDICT);
+		if (peer->public_key) {
+			g_variant_builder_add (&peer_builder, "{sv}", NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY,
+			                       g_variant_new_string (peer->public_key));
+		}
+		if (peer->endpoint) {
+			g_variant_builder_add (&peer_builder, "{sv}", NM_WIREGUARD_PEER_ATTR_ENDPOINT,
+			                       g_variant_new_string (peer->endpoint));
+		}
+		if (peer->persistent_keepalive) {
+			g_variant_builder_add (&peer_builder, "{sv}", NM_WIREGUARD_PEER_ATTR_PERSISTENT_KEEPALIVE,
+			                       g_variant_new_uint32 (peer->persistent_keepalive));
+		}
+		if (peer->allowed_ips->len) {
+			g_variant_builder_add (&peer_builder, "{sv}", NM_WIREGUARD_PEER_ATTR_ALLOWED_IPS,
+			                       g_variant_new_strv ((const char *const *) peer->allowed_ips->pdata,
+			                                           peer->allowed_ips->len));
+		}
+		g_variant_builder_add (&builder, "a{sv}", &peer_builder);
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+static gboolean
+peers_from_dbus (NMSetting *setting,
+                 GVariant *connection_dict,
+                 const char *property,
+                 GVariant *value,
+                 NMSettingParseFlags parse_flags,
+                 GError **error)
+{
+	gs_unref_ptrarray GPtrArray *peers = NULL;
+	GVariantIter peer_iter;
+	GVariant *peer_var;
+
+	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("aa{sv}")), FALSE);
+
+	peers = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_wireguard_peer_unref);
+	g_variant_iter_init (&peer_iter, value);
+	while (g_variant_iter_next (&peer_iter, "@a{sv}", &peer_var)) {
+		NMWireGuardPeer *peer;
+		const char *str;
+		guint32 u32;
+		gs_free const char **allowed_ips = NULL;
+
+		peer = nm_wireguard_peer_new ();
+		if (g_variant_lookup (peer_var, NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY, "&s", &str))
+			peer->public_key = g_strdup (str);
+		if (g_variant_lookup (peer_var, NM_WIREGUARD_PEER_ATTR_ENDPOINT, "&s", &str))
+			peer->endpoint = g_strdup (str);
+		if (g_variant_lookup (peer_var, NM_WIREGUARD_PEER_ATTR_PERSISTENT_KEEPALIVE, "u", &u32))
+			peer->persistent_keepalive = MIN (u32, G_MAXUINT16);
+		if (g_variant_lookup (peer_var, NM_WIREGUARD_PEER_ATTR_ALLOWED_IPS, "^a&s", &allowed_ips)) {
+			const char *const *iter;
+
+			for (iter = allowed_ips; *iter; iter++)
+				g_ptr_array_add (peer->allowed_ips, g_strdup (*iter));
+		}
+		g_ptr_array_add (peers, peer);
+		g_variant_unref (peer_var);
+	}
+
+	g_object_set (setting, NM_SETTING_WIREGUARD_PEERS, peers, NULL);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+verify (NMSetting *setting, NMConnection *connection, GError **error)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (setting);
+	gs_unref_hashtable GHashTable *h = NULL;
+	guint i;
+
+	if (!connection || !nm_connection_get_interface_name (connection)) {
+		g_set_error (error,
+		             NM_CONNECTION_ERROR,
+		             NM_CONNECTION_ERROR_MISSING_PROPERTY,
+		             _("property is missing"));
+		g_prefix_error (error, "%s.%s: ", NM_SETTING_CONNECTION_SETTING_NAME,
+		                NM_SETTING_CONNECTION_INTERFACE_NAME);
+		return FALSE;
+	}
+
+	if (self->peers->len)
+		h = g_hash_table_new (nm_str_hash, g_str_equal);
+
+	for (i = 0; i < self->peers->len; i++) {
+		NMWireGuardPeer *peer = self->peers->pdata[i];
+		gs_free_error GError *local = NULL;
+
+		if (!_peer_verify (peer, &local)) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("invalid peer %u: %s"),
+			             i, local->message);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_WIREGUARD_SETTING_NAME,
+			                NM_SETTING_WIREGUARD_PEERS);
+			return FALSE;
+		}
+
+		if (!nm_g_hash_table_add (h, peer->public_key)) {
+			g_set_error (error,
+			             NM_CONNECTION_ERROR,
+			             NM_CONNECTION_ERROR_INVALID_PROPERTY,
+			             _("duplicate peer '%s'"),
+			             peer->public_key);
+			g_prefix_error (error, "%s.%s: ", NM_SETTING_WIREGUARD_SETTING_NAME,
+			                NM_SETTING_WIREGUARD_PEERS);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+verify_secrets (NMSetting *setting, NMConnection *connection, GError **error)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (setting);
+
+	if (   self->private_key
+	    && !_nm_utils_wireguard_decode_key (self->private_key, NM_WIREGUARD_PUBLIC_KEY_LEN, NULL)) {
+		g_set_error_literal (error,
+		                     NM_CONNECTION_ERROR,
+		                     NM_CONNECTION_ERROR_INVALID_PROPERTY,
+		                     _("invalid private key"));
+		g_prefix_error (error, "%s.%s: ", NM_SETTING_WIREGUARD_SETTING_NAME,
+		                NM_SETTING_WIREGUARD_PRIVATE_KEY);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static GPtrArray *
+need_secrets (NMSetting *setting)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (setting);
+	GPtrArray *secrets = NULL;
+
+	if (   !self->private_key
+	    && !NM_FLAGS_HAS (self->private_key_flags, NM_SETTING_SECRET_FLAG_NOT_REQUIRED)) {
+		secrets = g_ptr_array_sized_new (1);
+		g_ptr_array_add (secrets, NM_SETTING_WIREGUARD_PRIVATE_KEY);
+	}
+
+	return secrets;
+}
+
+static gboolean
+compare_property (NMSetting *setting,
+                  NMSetting *other,
+                  const GParamSpec *prop_spec,
+                  NMSettingCompareFlags flags)
+{
+	NMSettingWireGuard *a = NM_SETTING_WIREGUARD (setting);
+	NMSettingWireGuard *b = NM_SETTING_WIREGUARD (other);
+	guint i;
+
+	if (nm_streq (prop_spec->name, NM_SETTING_WIREGUARD_PEERS)) {
+		if (a->peers->len != b->peers->len)
+			return FALSE;
+		for (i = 0; i < a->peers->len; i++) {
+			if (!nm_wireguard_peer_equal (a->peers->pdata[i], b->peers->pdata[i]))
+				return FALSE;
+		}
+		return TRUE;
+	}
+
+	return NM_SETTING_CLASS (nm_setting_wireguard_parent_class)->compare_property (setting, other, prop_spec, flags);
+}
+
+/*****************************************************************************/
+
+static void
+get_property (GObject *object, guint prop_id,
+              GValue *value, GParamSpec *pspec)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (object);
+
+	switch (prop_id) {
+	case PROP_PRIVATE_KEY:
+		g_value_set_string (value, self->private_key);
+		break;
+	case PROP_PRIVATE_KEY_FLAGS:
+		g_value_set_flags (value, self->private_key_flags);
+		break;
+	case PROP_LISTEN_PORT:
+		g_value_set_uint (value, self->listen_port);
+		break;
+	case PROP_FWMARK:
+		g_value_set_uint (value, self->fwmark);
+		break;
+	case PROP_PEERS:
+		g_value_take_boxed (value, _nm_utils_copy_array (self->peers,
+		                                                 (NMUtilsCopyFunc) nm_wireguard_peer_dup,
+		                                                 (GDestroyNotify) nm_wireguard_peer_unref));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (object);
+
+	switch (prop_id) {
+	case PROP_PRIVATE_KEY:
+		nm_free_secret (self->private_key);
+		self->private_key = g_value_dup_string (value);
+		break;
+	case PROP_PRIVATE_KEY_FLAGS:
+		self->private_key_flags = g_value_get_flags (value);
+		break;
+	case PROP_LISTEN_PORT:
+		self->listen_port = g_value_get_uint (value);
+		break;
+	case PROP_FWMARK:
+		self->fwmark = g_value_get_uint (value);
+		break;
+	case PROP_PEERS:
+		g_ptr_array_unref (self->peers);
+		self->peers = _nm_utils_copy_array (g_value_get_boxed (value),
+		                                    (NMUtilsCopyFunc) nm_wireguard_peer_dup,
+		                                    (GDestroyNotify) nm_wireguard_peer_unref);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
+}
+
+/*****************************************************************************/
+
+static void
+nm_setting_wireguard_init (NMSettingWireGuard *setting)
+{
+	setting->peers = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_wireguard_peer_unref);
+}
+
+static void
+finalize (GObject *object)
+{
+	NMSettingWireGuard *self = NM_SETTING_WIREGUARD (object);
+
+	nm_free_secret (self->private_key);
+	g_ptr_array_unref (self->peers);
+
+	G_OBJECT_CLASS (nm_setting_wireguard_parent_class)->finalize (object);
+}
+
+static void
+nm_setting_wireguard_class_init (NMSettingWireGuardClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	NMSettingClass *setting_class = NM_SETTING_CLASS (klass);
+	GArray *properties_override = _nm_sett_info_property_override_create_array ();
+
+	object_class->get_property     = get_property;
+	object_class->set_property     = set_property;
+	object_class->finalize         = finalize;
+
+	setting_class->verify           = verify;
+	setting_class->verify_secrets   = verify_secrets;
+	setting_class->need_secrets     = need_secrets;
+	setting_class->compare_property = compare_property;
+
+	/**
+	 * NMSettingWireGuard:private-key:
+	 *
+	 * The 256 bit private key of the interface in base64 encoding.
+	 *
+	 * Since: 1.14
+	 **/
+	obj_properties[PROP_PRIVATE_KEY] =
+	    g_param_spec_string (NM_SETTING_WIREGUARD_PRIVATE_KEY, "", "",
+	                         NULL,
+	                         G_PARAM_READWRITE |
+	                         NM_SETTING_PARAM_SECRET |
+	                         G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMSettingWireGuard:private-key-flags:
+	 *
+	 * Flags indicating how to handle the #NMSettingWireGuard:private-key
+	 * property.
+	 *
+	 * Since: 1.14
+	 **/
+	obj_properties[PROP_PRIVATE_KEY_FLAGS] =
+	    g_param_spec_flags (NM_SETTING_WIREGUARD_PRIVATE_KEY_FLAGS, "", "",
+	                        NM_TYPE_SETTING_SECRET_FLAGS,
+	                        NM_SETTING_SECRET_FLAG_NONE,
+	                        G_PARAM_READWRITE |
+	                        G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMSettingWireGuard:listen-port:
+	 *
+	 * The UDP port to listen on. If 0, a port is chosen randomly
+	 * when the interface comes up.
+	 *
+	 * Since: 1.14
+	 **/
+	obj_properties[PROP_LISTEN_PORT] =
+	    g_param_spec_uint (NM_SETTING_WIREGUARD_LISTEN_PORT, "", "",
+	                       0, G_MAXUINT16, 0,
+	                       G_PARAM_READWRITE |
+	                       NM_SETTING_PARAM_INFERRABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMSettingWireGuard:fwmark:
+	 *
+	 * The firewall mark for outgoing packets of the interface, or 0
+	 * to not set a mark.
+	 *
+	 * Since: 1.14
+	 **/
+	obj_properties[PROP_FWMARK] =
+	    g_param_spec_uint (NM_SETTING_WIREGUARD_FWMARK, "", "",
+	                       0, G_MAXUINT32, 0,
+	                       G_PARAM_READWRITE |
+	                       NM_SETTING_PARAM_INFERRABLE |
+	                       G_PARAM_STATIC_STRINGS);
+
+	/**
+	 * NMSettingWireGuard:peers: (type GPtrArray(NMWireGuardPeer))
+	 *
+	 * Array of peers.
+	 *
+	 * On D-Bus, each peer is a dictionary with the keys "public-key"
+	 * (mandatory), "endpoint", "persistent-keepalive" and "allowed-ips".
+	 * The public key is in base64 encoding. The endpoint is in the form
+	 * "ADDR:PORT" or "[ADDR6]:PORT" and the allowed IPs are a list of
+	 * "ADDR[/PREFIX]" strings.
+	 *
+	 * Since: 1.14
+	 **/
+	obj_properties[PROP_PEERS] =
+	    g_param_spec_boxed (NM_SETTING_WIREGUARD_PEERS, "", "",
+	                        G_TYPE_PTR_ARRAY,
+	                        G_PARAM_READWRITE |
+	                        NM_SETTING_PARAM_INFERRABLE |
+	                        G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
+
+	_properties_override_add_override (properties_override,
+	                                   obj_properties[PROP_PEERS],
+	                                   G_VARIANT_TYPE ("aa{sv}"),
+	                                   peers_to_dbus,
+	                                   peers_from_dbus,
+	                                   NULL);
+
+	_nm_setting_class_commit_full (setting_class, NM_META_SETTING_TYPE_WIREGUARD,
+	                               NULL, properties_override);
+}
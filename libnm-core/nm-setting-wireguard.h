@@ -0,0 +1,111 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program. If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#ifndef __NM_SETTING_WIREGUARD_H__
+#define __NM_SETTING_WIREGUARD_H__
+
+#if !defined (__NETWORKMANAGER_H_INSIDE__) && !defined (NETWORKMANAGER_COMPILATION)
+#error "Only <NetworkManager.h> can be included directly."
+#endif
+
+#include "nm-setting.h"
+
+G_BEGIN_DECLS
+
+#define NM_TYPE_SETTING_WIREGUARD            (nm_setting_wireguard_get_type ())
+#define NM_SETTING_WIREGUARD(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_SETTING_WIREGUARD, NMSettingWireGuard))
+#define NM_SETTING_WIREGUARD_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NM_TYPE_SETTING_WIREGUARD, NMSettingWireGuardClass))
+#define NM_IS_SETTING_WIREGUARD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), NM_TYPE_SETTING_WIREGUARD))
+#define NM_IS_SETTING_WIREGUARD_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_SETTING_WIREGUARD))
+#define NM_SETTING_WIREGUARD_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_SETTING_WIREGUARD, NMSettingWireGuardClass))
+
+#define NM_SETTING_WIREGUARD_SETTING_NAME      "wireguard"
+
+#define NM_SETTING_WIREGUARD_PRIVATE_KEY       "private-key"
+#define NM_SETTING_WIREGUARD_PRIVATE_KEY_FLAGS "private-key-flags"
+#define NM_SETTING_WIREGUARD_LISTEN_PORT       "listen-port"
+#define NM_SETTING_WIREGUARD_FWMARK            "fwmark"
+#define NM_SETTING_WIREGUARD_PEERS             "peers"
+
+#define NM_WIREGUARD_PEER_ATTR_PUBLIC_KEY           "public-key"
+#define NM_WIREGUARD_PEER_ATTR_ENDPOINT             "endpoint"
+#define NM_WIREGUARD_PEER_ATTR_PERSISTENT_KEEPALIVE "persistent-keepalive"
+#define NM_WIREGUARD_PEER_ATTR_ALLOWED_IPS          "allowed-ips"
+
+typedef struct _NMSettingWireGuardClass NMSettingWireGuardClass;
+typedef struct _NMWireGuardPeer NMWireGuardPeer;
+
+NM_AVAILABLE_IN_1_14
+GType nm_wireguard_peer_get_type (void);
+
+NM_AVAILABLE_IN_1_14
+NMWireGuardPeer *nm_wireguard_peer_new (void);
+NM_AVAILABLE_IN_1_14
+NMWireGuardPeer *nm_wireguard_peer_dup (const NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_ref (NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_unref (NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+gboolean nm_wireguard_peer_equal (const NMWireGuardPeer *peer, const NMWireGuardPeer *other);
+
+NM_AVAILABLE_IN_1_14
+const char *nm_wireguard_peer_get_public_key (const NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_set_public_key (NMWireGuardPeer *peer, const char *public_key);
+NM_AVAILABLE_IN_1_14
+const char *nm_wireguard_peer_get_endpoint (const NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_set_endpoint (NMWireGuardPeer *peer, const char *endpoint);
+NM_AVAILABLE_IN_1_14
+guint16 nm_wireguard_peer_get_persistent_keepalive (const NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_set_persistent_keepalive (NMWireGuardPeer *peer, guint16 persistent_keepalive);
+NM_AVAILABLE_IN_1_14
+guint nm_wireguard_peer_get_allowed_ips_len (const NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+const char *nm_wireguard_peer_get_allowed_ip (const NMWireGuardPeer *peer, guint idx);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_append_allowed_ip (NMWireGuardPeer *peer, const char *allowed_ip);
+NM_AVAILABLE_IN_1_14
+void nm_wireguard_peer_clear_allowed_ips (NMWireGuardPeer *peer);
+
+NM_AVAILABLE_IN_1_14
+GType nm_setting_wireguard_get_type (void);
+NM_AVAILABLE_IN_1_14
+NMSetting *nm_setting_wireguard_new (void);
+
+NM_AVAILABLE_IN_1_14
+const char *nm_setting_wireguard_get_private_key (NMSettingWireGuard *setting);
+NM_AVAILABLE_IN_1_14
+NMSettingSecretFlags nm_setting_wireguard_get_private_key_flags (NMSettingWireGuard *setting);
+NM_AVAILABLE_IN_1_14
+guint16 nm_setting_wireguard_get_listen_port (NMSettingWireGuard *setting);
+NM_AVAILABLE_IN_1_14
+guint32 nm_setting_wireguard_get_fwmark (NMSettingWireGuard *setting);
+
+NM_AVAILABLE_IN_1_14
+guint nm_setting_wireguard_get_peers_len (NMSettingWireGuard *setting);
+NM_AVAILABLE_IN_1_14
+NMWireGuardPeer *nm_setting_wireguard_get_peer (NMSettingWireGuard *setting, guint idx);
+NM_AVAILABLE_IN_1_14
+void nm_setting_wireguard_append_peer (NMSettingWireGuard *setting, NMWireGuardPeer *peer);
+NM_AVAILABLE_IN_1_14
+void nm_setting_wireguard_remove_peer (NMSettingWireGuard *setting, guint idx);
+NM_AVAILABLE_IN_1_14
+void nm_setting_wireguard_clear_peers (NMSettingWireGuard *setting);
+
+G_END_DECLS
+
+#endif /* __NM_SETTING_WIREGUARD_H__ */
@@ -1131,14 +1131,113 @@ _nm_setting_verify_secret_string (const char *str,
 	return TRUE;
 }
 
+/* Compares plain properties directly on their GValue, without converting
+ * them to GVariant first. Returns %FALSE if @property has a custom D-Bus
+ * representation or a type that is not handled here. Otherwise, the result
+ * is the same as comparing the D-Bus values with nm_property_compare(). */
 static gboolean
-compare_property (NMSetting *setting,
-                  NMSetting *other,
-                  const GParamSpec *prop_spec,
-                  NMSettingCompareFlags flags)
+_property_equal_typed (NMSetting *setting,
+                       NMSetting *other,
+                       const NMSettInfoProperty *property,
+                       gboolean *out_equal)
 {
-	const NMSettInfoProperty *property;
+	const GParamSpec *prop_spec = property->param_spec;
+	GValue value1 = G_VALUE_INIT;
+	GValue value2 = G_VALUE_INIT;
+	GType gtype;
+	gboolean equal;
+
+	if (   !prop_spec
+	    || property->get_func
+	    || property->to_dbus
+	    || property->dbus_type)
+		return FALSE;
+
+	gtype = prop_spec->value_type;
+	if (   !NM_IN_SET (gtype, G_TYPE_BOOLEAN,
+	                          G_TYPE_UCHAR,
+	                          G_TYPE_INT,
+	                          G_TYPE_UINT,
+	                          G_TYPE_INT64,
+	                          G_TYPE_UINT64,
+	                          G_TYPE_STRING,
+	                          G_TYPE_STRV,
+	                          G_TYPE_BYTES)
+	    && !G_TYPE_IS_ENUM (gtype)
+	    && !G_TYPE_IS_FLAGS (gtype))
+		return FALSE;
+
+	g_value_init (&value1, gtype);
+	g_value_init (&value2, gtype);
+	g_object_get_property (G_OBJECT (setting), prop_spec->name, &value1);
+	g_object_get_property (G_OBJECT (other), prop_spec->name, &value2);
+
+	if (gtype == G_TYPE_BOOLEAN)
+		equal = (!g_value_get_boolean (&value1) == !g_value_get_boolean (&value2));
+	else if (gtype == G_TYPE_UCHAR)
+		equal = (g_value_get_uchar (&value1) == g_value_get_uchar (&value2));
+	else if (gtype == G_TYPE_INT)
+		equal = (g_value_get_int (&value1) == g_value_get_int (&value2));
+	else if (gtype == G_TYPE_UINT)
+		equal = (g_value_get_uint (&value1) == g_value_get_uint (&value2));
+	else if (gtype == G_TYPE_INT64)
+		equal = (g_value_get_int64 (&value1) == g_value_get_int64 (&value2));
+	else if (gtype == G_TYPE_UINT64)
+		equal = (g_value_get_uint64 (&value1) == g_value_get_uint64 (&value2));
+	else if (G_TYPE_IS_ENUM (gtype))
+		equal = (g_value_get_enum (&value1) == g_value_get_enum (&value2));
+	else if (G_TYPE_IS_FLAGS (gtype))
+		equal = (g_value_get_flags (&value1) == g_value_get_flags (&value2));
+	else if (gtype == G_TYPE_STRING) {
+		const char *str1 = g_value_get_string (&value1);
+		const char *str2 = g_value_get_string (&value2);
+
+		equal = nm_streq0 (str1, str2);
+		if (   !equal
+		    && (!str1 || !str2)
+		    && nm_streq0 (str1 ?: str2, "")) {
+			/* A %NULL string that is not the default is sent as "" on D-Bus. */
+			equal = !g_param_value_defaults ((GParamSpec *) prop_spec, str1 ? &value2 : &value1);
+		}
+	} else if (gtype == G_TYPE_STRV) {
+		const char *const*strv1 = g_value_get_boxed (&value1);
+		const char *const*strv2 = g_value_get_boxed (&value2);
+
+		if (!strv1 || !strv2)
+			equal = (strv1 == strv2);
+		else {
+			for (; *strv1 && *strv2; strv1++, strv2++) {
+				if (!nm_streq (*strv1, *strv2))
+					break;
+			}
+			equal = (!*strv1 && !*strv2);
+		}
+	} else {
+		GBytes *bytes1 = g_value_get_boxed (&value1);
+		GBytes *bytes2 = g_value_get_boxed (&value2);
+
+		if (!bytes1 || !bytes2)
+			equal = (bytes1 == bytes2);
+		else
+			equal = g_bytes_equal (bytes1, bytes2);
+	}
+
+	g_value_unset (&value1);
+	g_value_unset (&value2);
+
+	*out_equal = equal;
+	return TRUE;
+}
+
+static gboolean
+_compare_property_info (NMSetting *setting,
+                        NMSetting *other,
+                        const NMSettInfoProperty *property,
+                        NMSettingCompareFlags flags)
+{
+	const GParamSpec *prop_spec = property->param_spec;
 	GVariant *value1, *value2;
+	gboolean equal;
 	int cmp;
 
 	/* Handle compare flags */
@@ -1169,8 +1268,8 @@ compare_property (NMSetting *setting,
 			return TRUE;
 	}
 
-	property = _nm_sett_info_property_get (NM_SETTING_GET_CLASS (setting), prop_spec->name);
-	g_return_val_if_fail (property != NULL, FALSE);
+	if (_property_equal_typed (setting, other, property, &equal))
+		return equal;
 
 	value1 = get_property_for_dbus (setting, property, TRUE);
 	value2 = get_property_for_dbus (other, property, TRUE);
@@ -1185,6 +1284,35 @@ compare_property (NMSetting *setting,
 	return cmp == 0;
 }
 
+static gboolean
+compare_property (NMSetting *setting,
+                  NMSetting *other,
+                  const GParamSpec *prop_spec,
+                  NMSettingCompareFlags flags)
+{
+	const NMSettInfoProperty *property;
+
+	property = _nm_sett_info_property_get (NM_SETTING_GET_CLASS (setting), prop_spec->name);
+	g_return_val_if_fail (property != NULL, FALSE);
+
+	return _compare_property_info (setting, other, property, flags);
+}
+
+static gboolean
+_compare_property (NMSetting *setting,
+                   NMSetting *other,
+                   const NMSettInfoProperty *property,
+                   NMSettingCompareFlags flags)
+{
+	NMSettingClass *klass = NM_SETTING_GET_CLASS (setting);
+
+	/* skip the by-name lookup of the property info, unless the subclass
+	 * overrides compare_property(). */
+	if (klass->compare_property == compare_property)
+		return _compare_property_info (setting, other, property, flags);
+	return klass->compare_property (setting, other, property->param_spec, flags);
+}
+
 /**
  * nm_setting_compare:
  * @a: a #NMSetting
@@ -1203,8 +1331,6 @@ nm_setting_compare (NMSetting *a,
                     NMSettingCompareFlags flags)
 {
 	const NMSettInfoSetting *sett_info;
-	GParamSpec **property_specs;
-	guint n_property_specs;
 	int same = TRUE;
 	guint i;
 
@@ -1228,9 +1354,12 @@ nm_setting_compare (NMSetting *a,
 	}
 
 	/* And now all properties */
-	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
-	for (i = 0; i < n_property_specs && same; i++) {
-		GParamSpec *prop_spec = property_specs[i];
+	for (i = 0; i < sett_info->property_infos_len && same; i++) {
+		const NMSettInfoProperty *property = &sett_info->property_infos[i];
+		GParamSpec *prop_spec = property->param_spec;
+
+		if (!prop_spec)
+			continue;
 
 		/* Fuzzy compare ignores secrets and properties defined with the FUZZY_IGNORE flag */
 		if (   NM_FLAGS_HAS (flags, NM_SETTING_COMPARE_FLAG_FUZZY)
@@ -1249,9 +1378,8 @@ nm_setting_compare (NMSetting *a,
 		    && NM_FLAGS_HAS (prop_spec->flags, NM_SETTING_PARAM_SECRET))
 			continue;
 
-		same = NM_SETTING_GET_CLASS (a)->compare_property (a, b, prop_spec, flags);
+		same = _compare_property (a, b, property, flags);
 	}
-	g_free (property_specs);
 
 	return same;
 }
@@ -1442,15 +1570,14 @@ nm_setting_diff (NMSetting *a,
 			}
 		}
 	} else {
-		gs_free GParamSpec **property_specs = NULL;
-		guint n_property_specs;
-
-		property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
-
-		for (i = 0; i < n_property_specs; i++) {
-			GParamSpec *prop_spec = property_specs[i];
+		for (i = 0; i < sett_info->property_infos_len; i++) {
+			const NMSettInfoProperty *property = &sett_info->property_infos[i];
+			GParamSpec *prop_spec = property->param_spec;
 			NMSettingDiffResult r = NM_SETTING_DIFF_RESULT_UNKNOWN;
 
+			if (!prop_spec)
+				continue;
+
 			/* Handle compare flags */
 			if (!should_compare_prop (a, prop_spec->name, flags, prop_spec->flags))
 				continue;
@@ -1462,7 +1589,7 @@ nm_setting_diff (NMSetting *a,
 			if (b) {
 				gboolean different;
 
-				different = !NM_SETTING_GET_CLASS (a)->compare_property (a, b, prop_spec, flags);
+				different = !_compare_property (a, b, property, flags);
 				if (different) {
 					gboolean a_is_default, b_is_default;
 					GValue value = G_VALUE_INIT;
@@ -3222,6 +3222,64 @@ test_setting_compare_wireless_cloned_mac_address (void)
 	g_clear_object (&new);
 }
 
+static void
+test_setting_compare_perf (void)
+{
+	const guint N = 10000;
+	gs_unref_ptrarray GPtrArray *connections = NULL;
+	gint64 t_start, t_compare, t_diff;
+	guint i;
+
+	if (nmtst_test_quick ()) {
+		g_test_skip ("Skip long running test");
+		return;
+	}
+
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < N; i++) {
+		gs_free char *id = g_strdup_printf ("perf-%u", i);
+		NMConnection *a, *b;
+		NMSettingIPConfig *s_ip4;
+
+		a = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+		nmtst_connection_normalize (a);
+		s_ip4 = nm_connection_get_setting_ip4_config (a);
+		g_object_set (s_ip4,
+		              NM_SETTING_IP_CONFIG_DHCP_HOSTNAME, id,
+		              NM_SETTING_IP_CONFIG_ROUTE_METRIC, (gint64) i,
+		              NULL);
+		nm_setting_ip_config_add_dns (s_ip4, "192.0.2.1");
+		nm_setting_ip_config_add_dns_search (s_ip4, "example.com");
+
+		b = nmtst_connection_duplicate_and_normalize (a);
+		g_ptr_array_add (connections, a);
+		g_ptr_array_add (connections, b);
+	}
+
+	t_start = g_get_monotonic_time ();
+	for (i = 0; i < N; i++) {
+		g_assert (nm_connection_compare (connections->pdata[2 * i],
+		                                 connections->pdata[2 * i + 1],
+		                                 NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+	t_compare = g_get_monotonic_time () - t_start;
+
+	t_start = g_get_monotonic_time ();
+	for (i = 0; i < N; i++) {
+		gs_unref_hashtable GHashTable *diffs = NULL;
+
+		g_assert (nm_connection_diff (connections->pdata[2 * i],
+		                              connections->pdata[(2 * i + 3) % (2 * N)],
+		                              NM_SETTING_COMPARE_FLAG_EXACT,
+		                              &diffs) == FALSE);
+		g_assert (diffs);
+	}
+	t_diff = g_get_monotonic_time () - t_start;
+
+	g_test_message ("compare %u connection pairs: %" G_GINT64_FORMAT " usec, diff: %" G_GINT64_FORMAT " usec",
+	                N, t_compare, t_diff);
+}
+
 static void
 test_setting_compare_timestamp (void)
 {
@@ -7261,6 +7319,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_to_dbus_transform", test_setting_to_dbus_transform);
 	g_test_add_func ("/core/general/test_setting_to_dbus_enum", test_setting_to_dbus_enum);
 	g_test_add_func ("/core/general/test_setting_compare_id", test_setting_compare_id);
+	g_test_add_func ("/core/general/test_setting_compare_perf", test_setting_compare_perf);
 	g_test_add_func ("/core/general/test_setting_compare_addresses", test_setting_compare_addresses);
 	g_test_add_func ("/core/general/test_setting_compare_routes", test_setting_compare_routes);
 	g_test_add_func ("/core/general/test_setting_compare_wired_cloned_mac_address", test_setting_compare_wired_cloned_mac_address);
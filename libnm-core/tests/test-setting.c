@@ -32,6 +32,7 @@
 #include "nm-setting-team.h"
 #include "nm-setting-team-port.h"
 #include "nm-setting-tc-config.h"
+#include "nm-setting-wireguard.h"
 #include "nm-setting-dummy.h"
 #include "nm-connection.h"
 #include "nm-simple-connection.h"
@@ -1944,6 +1945,289 @@ test_tc_config_dbus (void)
 
 /*****************************************************************************/
 
+#define WG_KEY_1 "BRAbJjE8R1JdaHN+iZSfqrXAy9bh7PcCDRgjLjlET1o="
+#define WG_KEY_2 "KjVAS1ZhbHeCjZijrrnEz9rl8PsGERwnMj1IU15pdH8="
+#define WG_KEY_3 "T1plcHuGkZynsr3I097p9P8KFSArNkFMV2JteIOOmaQ="
+
+static NMWireGuardPeer *
+_wg_peer_new (const char *public_key,
+              const char *endpoint,
+              guint16 persistent_keepalive,
+              const char *const *allowed_ips)
+{
+	NMWireGuardPeer *peer;
+
+	peer = nm_wireguard_peer_new ();
+	nm_wireguard_peer_set_public_key (peer, public_key);
+	nm_wireguard_peer_set_endpoint (peer, endpoint);
+	nm_wireguard_peer_set_persistent_keepalive (peer, persistent_keepalive);
+	for (; allowed_ips && *allowed_ips; allowed_ips++)
+		nm_wireguard_peer_append_allowed_ip (peer, *allowed_ips);
+	return peer;
+}
+
+static void
+_wg_set_peer (NMSettingWireGuard *s_wg, NMWireGuardPeer *peer)
+{
+	nm_setting_wireguard_clear_peers (s_wg);
+	nm_setting_wireguard_append_peer (s_wg, peer);
+	nm_wireguard_peer_unref (peer);
+}
+
+static NMConnection *
+_wg_connection_new (NMSettingWireGuard **out_s_wg)
+{
+	NMConnection *con;
+	NMSettingConnection *s_con;
+	NMSettingWireGuard *s_wg;
+
+	con = nmtst_create_minimal_connection ("Test WireGuard",
+	                                       NULL,
+	                                       NM_SETTING_WIREGUARD_SETTING_NAME,
+	                                       &s_con);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, "wg0",
+	              NULL);
+
+	s_wg = nm_connection_get_setting_wireguard (con);
+	g_assert (s_wg);
+	g_object_set (s_wg,
+	              NM_SETTING_WIREGUARD_PRIVATE_KEY, WG_KEY_1,
+	              NM_SETTING_WIREGUARD_LISTEN_PORT, 51820,
+	              NM_SETTING_WIREGUARD_FWMARK, 0x42,
+	              NULL);
+
+	nmtst_connection_normalize (con);
+	*out_s_wg = s_wg;
+	return con;
+}
+
+static void
+test_wireguard_verify (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	NMSettingWireGuard *s_wg;
+	NMSettingConnection *s_con;
+	GError *error = NULL;
+	gboolean success;
+
+	con = _wg_connection_new (&s_wg);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2,
+	                                  "192.0.2.1:51820",
+	                                  25,
+	                                  (const char *const[]) { "10.0.0.0/24", "10.0.1.1", "fd00::/64", NULL }));
+	nm_setting_wireguard_append_peer (s_wg, nm_setting_wireguard_get_peer (s_wg, 0));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+	nm_setting_wireguard_remove_peer (s_wg, 1);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2, "[2001:db8::1]:51820", 0, NULL));
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	_wg_set_peer (s_wg, _wg_peer_new (NULL, NULL, 0, NULL));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+
+	_wg_set_peer (s_wg, _wg_peer_new ("not-a-key", NULL, 0, NULL));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+
+	/* host names are not resolved. */
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2, "example.com:51820", 0, NULL));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2, "192.0.2.1", 0, NULL));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2, NULL, 0, (const char *const[]) { "10.0.0.0/33", NULL }));
+	nmtst_assert_connection_unnormalizable (con, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_INVALID_PROPERTY);
+
+	nm_setting_wireguard_clear_peers (s_wg);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	/* the interface name is mandatory. */
+	s_con = nm_connection_get_setting_connection (con);
+	g_object_set (s_con, NM_SETTING_CONNECTION_INTERFACE_NAME, NULL, NULL);
+	success = nm_setting_verify (NM_SETTING (s_wg), con, &error);
+	nmtst_assert_error (error, NM_CONNECTION_ERROR, NM_CONNECTION_ERROR_MISSING_PROPERTY, NULL);
+	g_assert (!success);
+	g_clear_error (&error);
+}
+
+static void
+test_wireguard_dbus (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_variant GVariant *dbus = NULL;
+	gs_unref_variant GVariant *dbus_no_secrets = NULL;
+	gs_unref_variant GVariant *wg_dbus = NULL;
+	gs_unref_variant GVariant *peers = NULL;
+	gs_unref_variant GVariant *peers_expected = NULL;
+	NMSettingWireGuard *s_wg;
+	NMSettingWireGuard *s_wg2;
+	NMWireGuardPeer *peer;
+	GError *error = NULL;
+	gboolean success;
+
+	con = _wg_connection_new (&s_wg);
+	peer = _wg_peer_new (WG_KEY_2,
+	                     "192.0.2.1:51820",
+	                     25,
+	                     (const char *const[]) { "10.0.0.0/24", "fd00::/64", NULL });
+	nm_setting_wireguard_append_peer (s_wg, peer);
+	nm_wireguard_peer_unref (peer);
+	peer = _wg_peer_new (WG_KEY_3, NULL, 0, NULL);
+	nm_setting_wireguard_append_peer (s_wg, peer);
+	nm_wireguard_peer_unref (peer);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	dbus = nm_connection_to_dbus (con, NM_CONNECTION_SERIALIZE_ALL);
+	wg_dbus = g_variant_lookup_value (dbus, NM_SETTING_WIREGUARD_SETTING_NAME, G_VARIANT_TYPE_VARDICT);
+	g_assert (wg_dbus);
+
+	peers = g_variant_lookup_value (wg_dbus, NM_SETTING_WIREGUARD_PEERS, G_VARIANT_TYPE ("aa{sv}"));
+	peers_expected = g_variant_ref_sink (g_variant_new_parsed ("[{'public-key':           <'"WG_KEY_2"'>,"
+	                                                           "  'endpoint':             <'192.0.2.1:51820'>,"
+	                                                           "  'persistent-keepalive': <uint32 25>,"
+	                                                           "  'allowed-ips':          <['10.0.0.0/24', 'fd00::/64']>},"
+	                                                           " {'public-key':           <'"WG_KEY_3"'>}]"));
+	g_assert (g_variant_equal (peers, peers_expected));
+
+	/* the private key is only serialized with the secrets. */
+	dbus_no_secrets = nm_connection_to_dbus (con, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_clear_pointer (&wg_dbus, g_variant_unref);
+	wg_dbus = g_variant_lookup_value (dbus_no_secrets, NM_SETTING_WIREGUARD_SETTING_NAME, G_VARIANT_TYPE_VARDICT);
+	g_assert (wg_dbus);
+	g_assert (!g_variant_lookup (wg_dbus, NM_SETTING_WIREGUARD_PRIVATE_KEY, "&s", NULL));
+	g_assert (g_variant_lookup (wg_dbus, NM_SETTING_WIREGUARD_PEERS, "@aa{sv}", NULL));
+
+	con2 = nm_simple_connection_new ();
+	success = nm_connection_replace_settings (con2, dbus, &error);
+	nmtst_assert_success (success, error);
+	nmtst_assert_connection_equals (con, FALSE, con2, FALSE);
+
+	s_wg2 = nm_connection_get_setting_wireguard (con2);
+	g_assert (s_wg2);
+	g_assert_cmpint (nm_setting_wireguard_get_peers_len (s_wg2), ==, 2);
+	g_assert_cmpstr (nm_wireguard_peer_get_public_key (nm_setting_wireguard_get_peer (s_wg2, 0)), ==, WG_KEY_2);
+	g_assert_cmpint (nm_wireguard_peer_get_persistent_keepalive (nm_setting_wireguard_get_peer (s_wg2, 0)), ==, 25);
+	g_assert_cmpint (nm_wireguard_peer_get_allowed_ips_len (nm_setting_wireguard_get_peer (s_wg2, 0)), ==, 2);
+	g_assert_cmpstr (nm_wireguard_peer_get_allowed_ip (nm_setting_wireguard_get_peer (s_wg2, 0), 1), ==, "fd00::/64");
+	g_assert_cmpint (nm_wireguard_peer_get_allowed_ips_len (nm_setting_wireguard_get_peer (s_wg2, 1)), ==, 0);
+}
+
+static void
+test_wireguard_keyfile (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	gs_unref_keyfile GKeyFile *keyfile = NULL;
+	gs_free char *value = NULL;
+	NMSettingWireGuard *s_wg;
+	NMSettingWireGuard *s_wg2;
+	NMWireGuardPeer *peer;
+	GError *error = NULL;
+
+	con = _wg_connection_new (&s_wg);
+	peer = _wg_peer_new (WG_KEY_2,
+	                     "192.0.2.1:51820",
+	                     25,
+	                     (const char *const[]) { "10.0.0.0/24", "fd00::/64", NULL });
+	nm_setting_wireguard_append_peer (s_wg, peer);
+	nm_wireguard_peer_unref (peer);
+	peer = _wg_peer_new (WG_KEY_3, "[fd01::1]:51820", 0, NULL);
+	nm_setting_wireguard_append_peer (s_wg, peer);
+	nm_wireguard_peer_unref (peer);
+	nmtst_assert_connection_verifies_without_normalization (con);
+
+	keyfile = nm_keyfile_write (con, NULL, NULL, &error);
+	nmtst_assert_success (keyfile, error);
+
+	value = g_key_file_get_string (keyfile, NM_SETTING_WIREGUARD_SETTING_NAME, "peer.0", NULL);
+	g_assert_cmpstr (value, ==, "public-key="WG_KEY_2" endpoint=192.0.2.1:51820 persistent-keepalive=25 allowed-ips=10.0.0.0/24,fd00::/64");
+	nm_clear_g_free (&value);
+	value = g_key_file_get_string (keyfile, NM_SETTING_WIREGUARD_SETTING_NAME, "peer.1", NULL);
+	g_assert_cmpstr (value, ==, "public-key="WG_KEY_3" endpoint=[fd01::1]:51820");
+
+	con2 = nm_keyfile_read (keyfile,
+	                        "wireguard-keyfile-name",
+	                        NULL,
+	                        NULL,
+	                        NULL,
+	                        &error);
+	nmtst_assert_success (con2, error);
+	nmtst_connection_normalize (con2);
+	nmtst_assert_connection_equals (con, FALSE, con2, FALSE);
+
+	/* peers are ordered by their index, not by their position in the file. */
+	g_key_file_remove_key (keyfile, NM_SETTING_WIREGUARD_SETTING_NAME, "peer.0", NULL);
+	g_key_file_set_string (keyfile, NM_SETTING_WIREGUARD_SETTING_NAME, "peer.7", "public-key="WG_KEY_2);
+	g_clear_object (&con2);
+	con2 = nm_keyfile_read (keyfile,
+	                        "wireguard-keyfile-name",
+	                        NULL,
+	                        NULL,
+	                        NULL,
+	                        &error);
+	nmtst_assert_success (con2, error);
+	s_wg2 = nm_connection_get_setting_wireguard (con2);
+	g_assert (s_wg2);
+	g_assert_cmpint (nm_setting_wireguard_get_peers_len (s_wg2), ==, 2);
+	g_assert_cmpstr (nm_wireguard_peer_get_public_key (nm_setting_wireguard_get_peer (s_wg2, 0)), ==, WG_KEY_3);
+	g_assert_cmpstr (nm_wireguard_peer_get_public_key (nm_setting_wireguard_get_peer (s_wg2, 1)), ==, WG_KEY_2);
+	g_assert_cmpstr (nm_wireguard_peer_get_endpoint (nm_setting_wireguard_get_peer (s_wg2, 1)), ==, NULL);
+}
+
+static void
+test_wireguard_compare (void)
+{
+	gs_unref_object NMConnection *con = NULL;
+	gs_unref_object NMConnection *con2 = NULL;
+	NMSettingWireGuard *s_wg;
+	NMSettingWireGuard *s_wg2;
+
+	con = _wg_connection_new (&s_wg);
+	_wg_set_peer (s_wg, _wg_peer_new (WG_KEY_2,
+	                                  "192.0.2.1:51820",
+	                                  25,
+	                                  (const char *const[]) { "10.0.0.0/24", "fd00::/64", NULL }));
+
+	con2 = nmtst_clone_connection (con);
+	s_wg2 = nm_connection_get_setting_wireguard (con2);
+	g_assert (nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* the allowed IPs are compared in order. */
+	_wg_set_peer (s_wg2, _wg_peer_new (WG_KEY_2,
+	                                   "192.0.2.1:51820",
+	                                   25,
+	                                   (const char *const[]) { "fd00::/64", "10.0.0.0/24", NULL }));
+	g_assert (!nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+
+	_wg_set_peer (s_wg2, _wg_peer_new (WG_KEY_2,
+	                                   "192.0.2.1:51820",
+	                                   0,
+	                                   (const char *const[]) { "10.0.0.0/24", "fd00::/64", NULL }));
+	g_assert (!nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+
+	_wg_set_peer (s_wg2, _wg_peer_new (WG_KEY_2,
+	                                   "192.0.2.1:51820",
+	                                   25,
+	                                   (const char *const[]) { "10.0.0.0/24", "fd00::/64", NULL }));
+	g_assert (nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+
+	nm_setting_wireguard_clear_peers (s_wg2);
+	g_assert (!nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* the private key is a secret. */
+	_wg_set_peer (s_wg2, nm_wireguard_peer_dup (nm_setting_wireguard_get_peer (s_wg, 0)));
+	g_object_set (s_wg2, NM_SETTING_WIREGUARD_PRIVATE_KEY, WG_KEY_3, NULL);
+	g_assert (!nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (nm_setting_compare (NM_SETTING (s_wg), NM_SETTING (s_wg2), NM_SETTING_COMPARE_FLAG_IGNORE_SECRETS));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1989,6 +2273,11 @@ main (int argc, char **argv)
 	g_test_add_func ("/libnm/settings/tc_config/setting/duplicates", test_tc_config_setting_duplicates);
 	g_test_add_func ("/libnm/settings/tc_config/dbus", test_tc_config_dbus);
 
+	g_test_add_func ("/libnm/settings/wireguard/verify", test_wireguard_verify);
+	g_test_add_func ("/libnm/settings/wireguard/dbus", test_wireguard_dbus);
+	g_test_add_func ("/libnm/settings/wireguard/keyfile", test_wireguard_keyfile);
+	g_test_add_func ("/libnm/settings/wireguard/compare", test_wireguard_compare);
+
 #if WITH_JSON_VALIDATION
 	g_test_add_func ("/libnm/settings/team/sync_runner_from_config_roundrobin",
 	                 test_runner_roundrobin_sync_from_config);
@@ -1,13 +0,0 @@
-/*
- * Basic Tests
- */
-
-#include <assert.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include "n-acd.h"
-
-int main(int argc, char **argv) {
-        return 0;
-}
@@ -64,6 +64,7 @@
 #include "nm-setting-vpn.h"
 #include "nm-setting-vxlan.h"
 #include "nm-setting-wimax.h"
+#include "nm-setting-wireguard.h"
 #include "nm-setting-wired.h"
 #include "nm-setting-wireless.h"
 #include "nm-setting-wireless-security.h"
@@ -396,6 +397,12 @@ const NMMetaSettingInfo nm_meta_setting_infos[] = {
 		.setting_name =             NM_SETTING_WIMAX_SETTING_NAME,
 		.get_setting_gtype =        nm_setting_wimax_get_type,
 	},
+	[NM_META_SETTING_TYPE_WIREGUARD] = {
+		.meta_type =                NM_META_SETTING_TYPE_WIREGUARD,
+		.setting_priority =         NM_SETTING_PRIORITY_HW_BASE,
+		.setting_name =             NM_SETTING_WIREGUARD_SETTING_NAME,
+		.get_setting_gtype =        nm_setting_wireguard_get_type,
+	},
 	[NM_META_SETTING_TYPE_WIRED] = {
 		.meta_type =                NM_META_SETTING_TYPE_WIRED,
 		.setting_priority =         NM_SETTING_PRIORITY_HW_BASE,
@@ -45,6 +45,11 @@ struct _NMDedupMultiIndex {
 	int ref_count;
 	GHashTable *idx_entries;
 	GHashTable *idx_objs;
+
+	/* entries and head entries are allocated from per-index pools. They
+	 * are freed by the index only, and the index is not thread-safe anyway. */
+	NMSlab slab_entries;
+	NMSlab slab_head_entries;
 };
 
 /*****************************************************************************/
@@ -346,7 +351,7 @@ _add (NMDedupMultiIndex *self,
 		head_entry = head_existing;
 
 	if (!head_entry) {
-		head_entry = g_slice_new0 (NMDedupMultiHeadEntry);
+		head_entry = nm_slab_alloc0 (&self->slab_head_entries);
 		head_entry->is_head = TRUE;
 		head_entry->idx_type = idx_type;
 		c_list_init (&head_entry->lst_entries_head);
@@ -362,7 +367,7 @@ _add (NMDedupMultiIndex *self,
 		nm_assert (c_list_contains (&entry_order->lst_entries, &head_entry->lst_entries_head));
 	}
 
-	entry = g_slice_new0 (NMDedupMultiEntry);
+	entry = nm_slab_alloc0 (&self->slab_entries);
 	entry->obj = obj_new;
 	entry->head = head_entry;
 
@@ -542,12 +547,12 @@ _remove_entry (NMDedupMultiIndex *self,
 		nm_assert_not_reached ();
 
 	c_list_unlink_stale (&entry->lst_entries);
-	g_slice_free (NMDedupMultiEntry, entry);
+	nm_slab_free (&self->slab_entries, entry);
 
 	if (head_entry) {
 		nm_assert (c_list_is_empty (&head_entry->lst_entries_head));
 		c_list_unlink_stale (&head_entry->lst_idx);
-		g_slice_free (NMDedupMultiHeadEntry, head_entry);
+		nm_slab_free (&self->slab_head_entries, head_entry);
 	}
 
 	nm_dedup_multi_obj_unref (obj);
@@ -1066,9 +1071,22 @@ nm_dedup_multi_index_new (void)
 	self->ref_count = 1;
 	self->idx_entries = g_hash_table_new ((GHashFunc) _dict_idx_entries_hash, (GEqualFunc) _dict_idx_entries_equal);
 	self->idx_objs    = g_hash_table_new ((GHashFunc) _dict_idx_objs_hash,    (GEqualFunc) _dict_idx_objs_equal);
+	nm_slab_init (&self->slab_entries, "dedup-entry", sizeof (NMDedupMultiEntry));
+	nm_slab_init (&self->slab_head_entries, "dedup-head-entry", sizeof (NMDedupMultiHeadEntry));
 	return self;
 }
 
+void
+nm_dedup_multi_index_get_stats (NMDedupMultiIndex *self,
+                                NMSlabStats *out_entries,
+                                NMSlabStats *out_head_entries)
+{
+	g_return_if_fail (self);
+
+	NM_SET_OUT (out_entries, *nm_slab_get_stats (&self->slab_entries));
+	NM_SET_OUT (out_head_entries, *nm_slab_get_stats (&self->slab_head_entries));
+}
+
 NMDedupMultiIndex *
 nm_dedup_multi_index_ref (NMDedupMultiIndex *self)
 {
@@ -1116,6 +1134,9 @@ more:
 	g_hash_table_unref (self->idx_entries);
 	g_hash_table_unref (self->idx_objs);
 
+	nm_slab_clear (&self->slab_entries);
+	nm_slab_clear (&self->slab_head_entries);
+
 	g_slice_free (NMDedupMultiIndex, self);
 	return NULL;
 }
@@ -24,6 +24,7 @@
 
 #include "nm-obj.h"
 #include "c-list-util.h"
+#include "nm-slab.h"
 
 /*****************************************************************************/
 
@@ -270,6 +271,10 @@ NMDedupMultiIndex *nm_dedup_multi_index_new (void);
 NMDedupMultiIndex *nm_dedup_multi_index_ref (NMDedupMultiIndex *self);
 NMDedupMultiIndex *nm_dedup_multi_index_unref (NMDedupMultiIndex *self);
 
+void nm_dedup_multi_index_get_stats (NMDedupMultiIndex *self,
+                                     NMSlabStats *out_entries,
+                                     NMSlabStats *out_head_entries);
+
 static inline void
 _nm_auto_unref_dedup_multi_index (NMDedupMultiIndex **v)
 {
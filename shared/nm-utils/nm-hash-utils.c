@@ -119,7 +119,14 @@ nm_hash_init (NMHashState *state, guint static_seed)
 	g = _get_hash_key ();
 	memcpy (seed, g, HASH_KEY_SIZE);
 	seed[0] ^= static_seed;
+#if NM_HASH_FAST
+	G_STATIC_ASSERT_EXPR (HASH_KEY_SIZE == sizeof (state->_k0) + sizeof (state->_k1));
+	memcpy (&state->_k0, &((const guint8 *) seed)[0], sizeof (state->_k0));
+	memcpy (&state->_k1, &((const guint8 *) seed)[sizeof (state->_k0)], sizeof (state->_k1));
+	state->_h = state->_k0 ^ state->_k1;
+#else
 	c_siphash_init (&state->_state, (const guint8 *) seed);
+#endif
 }
 
 guint
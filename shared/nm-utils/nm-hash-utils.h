@@ -25,8 +25,29 @@
 #include "c-siphash/src/c-siphash.h"
 #include "nm-macros-internal.h"
 
+/* The hash functions here are for internal hash tables only. They are
+ * seeded with a random key per process, so the result is not stable
+ * and must never be persisted.
+ *
+ * By default, siphash24 is used. With NM_HASH_FAST (configure --with-hash=fast),
+ * a multiply-mix hash in the style of wyhash is used instead. It is much
+ * cheaper for the short, fixed-size keys that make up the majority of our
+ * hashing (platform objects, addresses). It is keyed with a random 128 bit
+ * secret too, but unlike siphash24 it comes without an analysis of its
+ * resistance against hash flooding. Only choose it when the hashed data is
+ * not controlled by untrusted parties. */
+#ifndef NM_HASH_FAST
+#define NM_HASH_FAST 0
+#endif
+
 struct _NMHashState {
+#if NM_HASH_FAST
+	guint64 _h;
+	guint64 _k0;
+	guint64 _k1;
+#else
 	CSipHash _state;
+#endif
 };
 
 typedef struct _NMHashState NMHashState;
@@ -35,6 +56,29 @@ guint nm_hash_static (guint static_seed);
 
 void nm_hash_init (NMHashState *state, guint static_seed);
 
+#if NM_HASH_FAST
+static inline guint64
+_nm_hash_mum (guint64 a, guint64 b)
+{
+#if defined (__SIZEOF_INT128__)
+	__extension__ unsigned __int128 r = ((unsigned __int128) a) * b;
+
+	return ((guint64) (r >> 64)) ^ ((guint64) r);
+#else
+	guint64 ha = a >> 32, la = (guint32) a;
+	guint64 hb = b >> 32, lb = (guint32) b;
+	guint64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	guint64 t, lo, hi;
+
+	t = rl + (rm0 << 32);
+	hi = rh + (rm0 >> 32) + (rm1 >> 32) + (t < rl);
+	lo = t + (rm1 << 32);
+	hi += (lo < t);
+	return hi ^ lo;
+#endif
+}
+#endif
+
 static inline guint
 nm_hash_complete (NMHashState *state)
 {
@@ -42,7 +86,11 @@ nm_hash_complete (NMHashState *state)
 
 	nm_assert (state);
 
+#if NM_HASH_FAST
+	h = _nm_hash_mum (state->_h ^ state->_k0, state->_k1 ^ 0x9e3779b97f4a7c15ull);
+#else
 	h = c_siphash_finalize (&state->_state);
+#endif
 
 	/* we don't ever want to return a zero hash.
 	 *
@@ -53,16 +101,36 @@ nm_hash_complete (NMHashState *state)
 static inline void
 nm_hash_update (NMHashState *state, const void *ptr, gsize n)
 {
+#if NM_HASH_FAST
+	const guint8 *p = ptr;
+	guint64 h;
+	guint64 v;
+#endif
+
 	nm_assert (state);
 	nm_assert (ptr);
 	nm_assert (n > 0);
 
 	/* Note: the data passed in here might be sensitive data (secrets),
 	 * that we should nm_explicty_zero() afterwards. However, since
-	 * we are using siphash24 with a random key, that is not really
+	 * both hash implementations use a random key, that is not really
 	 * necessary. Something to keep in mind, if we ever move away from
-	 * this hash implementation. */
+	 * a keyed hash. */
+#if NM_HASH_FAST
+	h = state->_h;
+	for (; n >= sizeof (v); n -= sizeof (v), p += sizeof (v)) {
+		memcpy (&v, p, sizeof (v));
+		h = _nm_hash_mum (v ^ state->_k0, h ^ state->_k1);
+	}
+	if (n > 0) {
+		v = 0;
+		memcpy (&v, p, n);
+		h = _nm_hash_mum (v ^ state->_k0, h ^ state->_k1 ^ n);
+	}
+	state->_h = h;
+#else
 	c_siphash_append (&state->_state, ptr, n);
+#endif
 }
 
 #define nm_hash_update_val(state, val) \
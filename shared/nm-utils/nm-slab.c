@@ -0,0 +1,195 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * (C) Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-slab.h"
+
+/*****************************************************************************/
+
+#define SLAB_ALIGN_TO(x, a) (((x) + ((a) - 1)) & ~((gsize) ((a) - 1)))
+
+/* elements are aligned like g_slice_alloc() aligns them. */
+#define SLAB_ALIGN        (2 * sizeof (gpointer))
+#define SLAB_CHUNK_SIZE   (16u * 1024u)
+#define SLAB_CHUNK_MIN    16u
+
+/* the header of each chunk, padded to SLAB_ALIGN. */
+#define SLAB_CHUNK_HEADER (SLAB_ALIGN_TO (sizeof (gpointer), SLAB_ALIGN))
+
+/*****************************************************************************/
+
+void
+nm_slab_init (NMSlab *slab, const char *name, gsize elem_size)
+{
+	const char *env;
+
+	nm_assert (slab);
+	nm_assert (elem_size > 0);
+
+	memset (slab, 0, sizeof (*slab));
+	slab->name = name;
+
+	/* each element must be able to hold the free-list pointer. */
+	slab->elem_size = SLAB_ALIGN_TO (MAX (elem_size, sizeof (gpointer)), SLAB_ALIGN);
+	slab->elems_per_chunk = MAX (SLAB_CHUNK_MIN, (SLAB_CHUNK_SIZE - SLAB_CHUNK_HEADER) / slab->elem_size);
+
+	env = g_getenv ("G_SLICE");
+	slab->use_malloc = env && strstr (env, "always-malloc");
+}
+
+static void
+_slab_release_chunks (NMSlab *slab, gboolean keep_one)
+{
+	guint8 *keep = NULL;
+	gpointer chunk;
+
+	if (keep_one && slab->chunks) {
+		keep = slab->chunks;
+		slab->chunks = *((gpointer *) keep);
+	}
+
+	while ((chunk = slab->chunks)) {
+		slab->chunks = *((gpointer *) chunk);
+		g_free (chunk);
+	}
+
+	slab->free_list = NULL;
+	slab->stats.n_free = 0;
+
+	if (keep) {
+		gsize size = SLAB_CHUNK_HEADER + ((gsize) slab->elems_per_chunk) * slab->elem_size;
+
+		*((gpointer *) keep) = NULL;
+		slab->chunks = keep;
+		slab->chunk_pos = &keep[SLAB_CHUNK_HEADER];
+		slab->chunk_end = &keep[size];
+		slab->stats.n_chunks = 1;
+		slab->stats.bytes_allocated = size;
+	} else {
+		slab->chunk_pos = NULL;
+		slab->chunk_end = NULL;
+		slab->stats.n_chunks = 0;
+		slab->stats.bytes_allocated = 0;
+	}
+}
+
+void
+nm_slab_clear (NMSlab *slab)
+{
+	nm_assert (slab);
+	nm_assert (slab->stats.n_used == 0);
+
+	_slab_release_chunks (slab, FALSE);
+}
+
+gpointer
+nm_slab_alloc0 (NMSlab *slab)
+{
+	gpointer ptr;
+
+	nm_assert (slab);
+	nm_assert (slab->elem_size > 0);
+
+	slab->stats.n_used++;
+	if (slab->stats.n_used > slab->stats.n_used_max)
+		slab->stats.n_used_max = slab->stats.n_used;
+
+	if (G_UNLIKELY (slab->use_malloc)) {
+		slab->stats.bytes_allocated += slab->elem_size;
+		return g_malloc0 (slab->elem_size);
+	}
+
+	ptr = slab->free_list;
+	if (ptr) {
+		slab->free_list = *((gpointer *) ptr);
+		slab->stats.n_free--;
+		memset (ptr, 0, slab->elem_size);
+		return ptr;
+	}
+
+	if (G_UNLIKELY (slab->chunk_pos == slab->chunk_end)) {
+		gsize size = SLAB_CHUNK_HEADER + ((gsize) slab->elems_per_chunk) * slab->elem_size;
+		guint8 *chunk;
+
+		chunk = g_malloc (size);
+		*((gpointer *) chunk) = slab->chunks;
+		slab->chunks = chunk;
+		slab->chunk_pos = &chunk[SLAB_CHUNK_HEADER];
+		slab->chunk_end = &chunk[size];
+		slab->stats.n_chunks++;
+		slab->stats.bytes_allocated += size;
+	}
+
+	ptr = slab->chunk_pos;
+	slab->chunk_pos += slab->elem_size;
+	memset (ptr, 0, slab->elem_size);
+	return ptr;
+}
+
+void
+nm_slab_free (NMSlab *slab, gpointer ptr)
+{
+	nm_assert (slab);
+
+	if (!ptr)
+		return;
+
+	nm_assert (slab->stats.n_used > 0);
+	slab->stats.n_used--;
+
+	if (G_UNLIKELY (slab->use_malloc)) {
+		slab->stats.bytes_allocated -= slab->elem_size;
+		g_free (ptr);
+		return;
+	}
+
+	if (slab->stats.n_used == 0) {
+		/* the pool is unused. Give the memory back, but keep one chunk
+		 * around, so that a pool that toggles between empty and non-empty
+		 * does not allocate a chunk every time. */
+		_slab_release_chunks (slab, TRUE);
+		return;
+	}
+
+	*((gpointer *) ptr) = slab->free_list;
+	slab->free_list = ptr;
+	slab->stats.n_free++;
+}
+
+const char *
+nm_slab_to_string (const NMSlab *slab, char *buf, gsize len)
+{
+	if (!nm_utils_to_string_buffer_init_null (slab, &buf, &len))
+		return buf;
+
+	g_snprintf (buf, len,
+	            "slab %s: size %"G_GSIZE_FORMAT", used %"G_GSIZE_FORMAT" (max %"G_GSIZE_FORMAT"), free %"G_GSIZE_FORMAT", chunks %"G_GSIZE_FORMAT", %"G_GSIZE_FORMAT" bytes%s",
+	            slab->name ?: "???",
+	            slab->elem_size,
+	            slab->stats.n_used,
+	            slab->stats.n_used_max,
+	            slab->stats.n_free,
+	            slab->stats.n_chunks,
+	            slab->stats.bytes_allocated,
+	            slab->use_malloc ? " (malloc)" : "");
+	return buf;
+}
@@ -0,0 +1,86 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * (C) Copyright 2018 Red Hat, Inc.
+ */
+
+#ifndef __NM_SLAB_H__
+#define __NM_SLAB_H__
+
+/*****************************************************************************/
+
+/* NMSlab is a simple pool allocator for objects of one fixed size.
+ *
+ * Elements are carved out of larger chunks, so that objects that are allocated
+ * together also end up close together in memory. Freed elements go to a
+ * per-pool free list and are reused first. Chunks are only returned once
+ * the pool is completely unused (or cleared).
+ *
+ * The pool is not thread-safe. Either use it only from one thread, or
+ * embed it in a data structure that has the same restriction.
+ *
+ * With G_SLICE=always-malloc (like when running under valgrind), the pool
+ * falls back to plain malloc() for every element, but still keeps the
+ * accounting. */
+
+typedef struct {
+	gsize n_used;
+	gsize n_used_max;
+	gsize n_free;
+	gsize n_chunks;
+	gsize bytes_allocated;
+} NMSlabStats;
+
+typedef struct {
+	const char *name;
+	gsize elem_size;
+	guint elems_per_chunk;
+	bool use_malloc:1;
+
+	/* the singly linked list of chunks. */
+	gpointer chunks;
+
+	/* the not yet used tail of the current chunk. */
+	guint8 *chunk_pos;
+	guint8 *chunk_end;
+
+	/* singly linked list of released elements. */
+	gpointer free_list;
+
+	NMSlabStats stats;
+} NMSlab;
+
+void nm_slab_init (NMSlab *slab, const char *name, gsize elem_size);
+
+void nm_slab_clear (NMSlab *slab);
+
+gpointer nm_slab_alloc0 (NMSlab *slab);
+
+void nm_slab_free (NMSlab *slab, gpointer ptr);
+
+static inline const NMSlabStats *
+nm_slab_get_stats (const NMSlab *slab)
+{
+	nm_assert (slab);
+
+	return &slab->stats;
+}
+
+const char *nm_slab_to_string (const NMSlab *slab, char *buf, gsize len);
+
+#endif /* __NM_SLAB_H__ */
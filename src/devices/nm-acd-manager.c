@@ -18,17 +18,43 @@
 
 #include "nm-acd-manager.h"
 
+#include <endian.h>
 #include <netinet/in.h>
+#include <netinet/if_ether.h>
+#include <sys/socket.h>
 #include <sys/types.h>
-#include <sys/wait.h>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
 
 #include "platform/nm-platform.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
-#include "n-acd/src/n-acd.h"
+#include "c-list/src/c-list.h"
 
 /*****************************************************************************/
 
+/* All addresses of a manager are probed and defended through a single
+ * packet socket, whose BPF filter matches the whole address set, and a single
+ * timer that serves the per-address deadlines.
+ *
+ * The timings follow RFC 5227, scaled like n-acd did: the probe timeout
+ * is a multiplier for the intervals below, where a value of 9000 corresponds
+ * to the RFC values. Announcements always use the RFC interval. */
+
+#define ACD_PROBE_NUM                   3
+#define ACD_PROBE_WAIT_USEC             ((guint64) 111)
+#define ACD_PROBE_MIN_USEC              ((guint64) 111)
+#define ACD_PROBE_MAX_USEC              ((guint64) 333)
+#define ACD_ANNOUNCE_NUM                3
+#define ACD_ANNOUNCE_WAIT_USEC          ((guint64) 222)
+#define ACD_ANNOUNCE_INTERVAL_USEC      ((guint64) 222)
+#define ACD_DEFEND_INTERVAL_USEC        ((guint64) 10000000)
+#define ACD_TIMEOUT_RFC5227             ((guint64) 9000)
+
+/* beyond this many addresses, the filter only checks for valid ARP
+ * packets and the addresses are matched in user space. */
+#define ACD_FILTER_MAX_ADDRESSES        500
+
 typedef enum {
 	STATE_INIT,
 	STATE_PROBING,
@@ -36,13 +62,23 @@ typedef enum {
 	STATE_ANNOUNCING,
 } State;
 
+typedef enum {
+	ADDR_STATE_INIT,
+	ADDR_STATE_PROBING,
+	ADDR_STATE_READY,
+	ADDR_STATE_ANNOUNCING,
+	ADDR_STATE_STOPPED,
+} AddrState;
+
 typedef struct {
 	in_addr_t address;
 	gboolean duplicate;
 	NMAcdManager *manager;
-	NAcd *acd;
-	GIOChannel *channel;
-	guint event_id;
+	CList timer_lst;
+	guint64 deadline_usec;
+	guint64 last_defend_usec;
+	AddrState state;
+	guint n_iteration;
 } AddressInfo;
 
 enum {
@@ -58,6 +94,16 @@ typedef struct {
 	State          state;
 	GHashTable    *addresses;
 	guint          completed;
+	guint64        timeout_multiplier;
+
+	int            fd;
+	GIOChannel    *channel;
+	guint          event_id;
+
+	/* AddressInfo with a pending deadline, sorted by deadline. */
+	CList          timer_lst_head;
+	guint          timer_id;
+	guint64        timer_usec;
 } NMAcdManagerPrivate;
 
 struct _NMAcdManager {
@@ -93,51 +139,15 @@ G_DEFINE_TYPE (NMAcdManager, nm_acd_manager, G_TYPE_OBJECT)
 
 /*****************************************************************************/
 
-static const char *
-_acd_event_to_string (unsigned int event)
-{
-	switch (event) {
-	case N_ACD_EVENT_READY:
-		return "ready";
-	case N_ACD_EVENT_USED:
-		return "used";
-	case N_ACD_EVENT_DEFENDED:
-		return "defended";
-	case N_ACD_EVENT_CONFLICT:
-		return "conflict";
-	case N_ACD_EVENT_DOWN:
-		return "down";
-	}
-	return NULL;
-}
-
-#define acd_event_to_string(event) NM_UTILS_LOOKUP_STR (_acd_event_to_string, event)
+static void _timer_schedule (NMAcdManager *self);
+static void _probe_completed (NMAcdManager *self);
 
-static const char *
-_acd_error_to_string (int error)
+static guint64
+_now_usec (void)
 {
-	if (error < 0)
-		return strerror(-error);
-
-	switch (error) {
-	case _N_ACD_E_SUCCESS:
-		return "success";
-	case N_ACD_E_DONE:
-		return "no more events (engine running)";
-	case N_ACD_E_STOPPED:
-		return "no more events (engine stopped)";
-	case N_ACD_E_PREEMPTED:
-		return "preempted";
-	case N_ACD_E_INVALID_ARGUMENT:
-		return "invalid argument";
-	case N_ACD_E_BUSY:
-		return "busy";
-	}
-	return NULL;
+	return nm_utils_get_monotonic_timestamp_ns () / 1000;
 }
 
-#define acd_error_to_string(error) NM_UTILS_LOOKUP_STR (_acd_error_to_string, error)
-
 /*****************************************************************************/
 
 /**
@@ -165,124 +175,425 @@ nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address)
 	info = g_slice_new0 (AddressInfo);
 	info->address = address;
 	info->manager = self;
+	c_list_init (&info->timer_lst);
 
 	g_hash_table_insert (priv->addresses, GUINT_TO_POINTER (address), info);
 
 	return TRUE;
 }
 
-static gboolean
-acd_event (GIOChannel *source, GIOCondition condition, gpointer data)
+/*****************************************************************************/
+
+static void
+_addr_set_deadline (NMAcdManager *self, AddressInfo *info, guint64 deadline_usec)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	CList *iter;
+
+	c_list_unlink (&info->timer_lst);
+	info->deadline_usec = deadline_usec;
+
+	/* Deadlines are mostly scheduled in increasing order, search
+	 * the insert position from the end. */
+	for (iter = priv->timer_lst_head.prev; iter != &priv->timer_lst_head; iter = iter->prev) {
+		if (c_list_entry (iter, AddressInfo, timer_lst)->deadline_usec <= deadline_usec)
+			break;
+	}
+	c_list_link_after (iter, &info->timer_lst);
+	_timer_schedule (self);
+}
+
+static void
+_addr_stop (NMAcdManager *self, AddressInfo *info)
+{
+	info->state = ADDR_STATE_STOPPED;
+	c_list_unlink (&info->timer_lst);
+}
+
+static void
+_addr_send (NMAcdManager *self, AddressInfo *info, gboolean announce)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	struct sockaddr_ll address = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htobe16 (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+		.sll_halen = ETH_ALEN,
+		.sll_addr = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	};
+	struct ether_arp arp = {
+		.ea_hdr.ar_hrd = htobe16 (ARPHRD_ETHER),
+		.ea_hdr.ar_pro = htobe16 (ETHERTYPE_IP),
+		.ea_hdr.ar_hln = ETH_ALEN,
+		.ea_hdr.ar_pln = sizeof (in_addr_t),
+		.ea_hdr.ar_op = htobe16 (ARPOP_REQUEST),
+	};
+	ssize_t l;
+
+	/* A probe has an unspecified sender address, an announcement
+	 * claims the address. */
+	memcpy (arp.arp_sha, priv->hwaddr, ETH_ALEN);
+	memcpy (arp.arp_tpa, &info->address, sizeof (in_addr_t));
+	if (announce)
+		memcpy (arp.arp_spa, &info->address, sizeof (in_addr_t));
+
+	l = sendto (priv->fd, &arp, sizeof (arp), MSG_NOSIGNAL, (struct sockaddr *) &address, sizeof (address));
+	if (l != (ssize_t) sizeof (arp)) {
+		int errsv = l < 0 ? errno : EMSGSIZE;
+
+		_LOGD ("couldn't send %s for address %s: %s",
+		       announce ? "announcement" : "probe",
+		       nm_utils_inet4_ntop (info->address, NULL),
+		       g_strerror (errsv));
+	}
+}
+
+static void
+_addr_announce (NMAcdManager *self, AddressInfo *info)
+{
+	info->state = ADDR_STATE_ANNOUNCING;
+	info->n_iteration = 0;
+	_LOGD ("announcing address %s", nm_utils_inet4_ntop (info->address, NULL));
+	_addr_set_deadline (self, info, _now_usec ());
+}
+
+static void
+_addr_ready (NMAcdManager *self, AddressInfo *info)
 {
-	AddressInfo *info = data;
-	NMAcdManager *self = info->manager;
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
-	NAcdEvent *event;
+
+	info->duplicate = FALSE;
+	info->state = ADDR_STATE_READY;
+
+	if (priv->state == STATE_ANNOUNCING)
+		_addr_announce (self, info);
+	else
+		_probe_completed (self);
+}
+
+static void
+_addr_timeout (NMAcdManager *self, AddressInfo *info, guint64 now)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	guint64 m = priv->timeout_multiplier;
+
+	switch (info->state) {
+	case ADDR_STATE_PROBING:
+		if (info->n_iteration >= ACD_PROBE_NUM) {
+			_addr_ready (self, info);
+			return;
+		}
+
+		_addr_send (self, info, FALSE);
+		if (++info->n_iteration >= ACD_PROBE_NUM)
+			_addr_set_deadline (self, info, now + m * ACD_ANNOUNCE_WAIT_USEC);
+		else {
+			_addr_set_deadline (self, info,
+			                    now + m * ACD_PROBE_MIN_USEC
+			                        + g_random_int_range (0, m * (ACD_PROBE_MAX_USEC - ACD_PROBE_MIN_USEC)));
+		}
+		return;
+	case ADDR_STATE_ANNOUNCING:
+		_addr_send (self, info, TRUE);
+		if (++info->n_iteration < ACD_ANNOUNCE_NUM)
+			_addr_set_deadline (self, info, now + ACD_TIMEOUT_RFC5227 * ACD_ANNOUNCE_INTERVAL_USEC);
+		return;
+	default:
+		nm_assert_not_reached ();
+		return;
+	}
+}
+
+static void
+_addr_handle_packet (NMAcdManager *self, AddressInfo *info, const struct ether_arp *packet, gboolean hard_conflict)
+{
 	char address_str[INET_ADDRSTRLEN];
 	gs_free char *hwaddr_str = NULL;
-	int r;
-
-	if (   n_acd_dispatch (info->acd)
-	    || n_acd_pop_event (info->acd, &event))
-		return G_SOURCE_CONTINUE;
-
-	switch (event->event) {
-	case N_ACD_EVENT_READY:
-		info->duplicate = FALSE;
-		if (priv->state == STATE_ANNOUNCING) {
-			r = n_acd_announce (info->acd, N_ACD_DEFEND_ONCE);
-			if (r) {
-				_LOGW ("couldn't announce address %s on interface '%s': %s",
-				       nm_utils_inet4_ntop (info->address, address_str),
-				       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
-				       acd_error_to_string (r));
-			} else {
-				_LOGD ("announcing address %s",
-				       nm_utils_inet4_ntop (info->address, address_str));
-			}
-		}
-		break;
-	case N_ACD_EVENT_USED:
-		info->duplicate = TRUE;
-		break;
-	case N_ACD_EVENT_DEFENDED:
-		_LOGD ("defended address %s from host %s",
-		       nm_utils_inet4_ntop (info->address, address_str),
-		       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
-		                                           event->defended.n_sender)));
-		break;
-	case N_ACD_EVENT_CONFLICT:
-		_LOGW ("conflict for address %s detected with host %s on interface '%s'",
+	guint64 now;
+
+	switch (info->state) {
+	case ADDR_STATE_PROBING:
+		_LOGD ("address %s is used by host %s",
 		       nm_utils_inet4_ntop (info->address, address_str),
-		       (hwaddr_str = nm_utils_hwaddr_ntoa (event->defended.sender,
-		                                           event->defended.n_sender)),
-		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
-		break;
+		       (hwaddr_str = nm_utils_hwaddr_ntoa (packet->arp_sha, ETH_ALEN)));
+		_addr_stop (self, info);
+		info->duplicate = TRUE;
+		_probe_completed (self);
+		return;
+	case ADDR_STATE_ANNOUNCING:
+		if (!hard_conflict)
+			return;
+
+		/* we defend the address once per defend interval. A timestamp
+		 * of zero means we never defended it. */
+		now = _now_usec ();
+		if (   info->last_defend_usec == 0
+		    || now > info->last_defend_usec + ACD_DEFEND_INTERVAL_USEC) {
+			_addr_send (self, info, TRUE);
+			info->last_defend_usec = now;
+			_LOGD ("defended address %s from host %s",
+			       nm_utils_inet4_ntop (info->address, address_str),
+			       (hwaddr_str = nm_utils_hwaddr_ntoa (packet->arp_sha, ETH_ALEN)));
+		} else {
+			_LOGW ("conflict for address %s detected with host %s on interface '%s'",
+			       nm_utils_inet4_ntop (info->address, address_str),
+			       (hwaddr_str = nm_utils_hwaddr_ntoa (packet->arp_sha, ETH_ALEN)),
+			       nm_platform_link_get_name (NM_PLATFORM_GET, NM_ACD_MANAGER_GET_PRIVATE (self)->ifindex));
+			_addr_stop (self, info);
+		}
+		return;
 	default:
-		_LOGD ("event '%s' for address %s",
-		       acd_event_to_string (event->event),
-		       nm_utils_inet4_ntop (info->address, address_str));
-		return G_SOURCE_CONTINUE;
+		return;
 	}
+}
+
+static void
+_probe_completed (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 
 	if (   priv->state == STATE_PROBING
 	    && ++priv->completed == g_hash_table_size (priv->addresses)) {
 		priv->state = STATE_PROBE_DONE;
 		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
 	}
+}
 
-	return G_SOURCE_CONTINUE;
+/*****************************************************************************/
+
+static gboolean
+_timer_cb (gpointer user_data)
+{
+	NMAcdManager *self = user_data;
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	AddressInfo *info;
+	guint64 now;
+
+	priv->timer_id = 0;
+
+	g_object_ref (self);
+
+	now = _now_usec ();
+	while ((info = c_list_first_entry (&priv->timer_lst_head, AddressInfo, timer_lst))) {
+		if (info->deadline_usec > now)
+			break;
+		c_list_unlink (&info->timer_lst);
+		_addr_timeout (self, info, now);
+		if (!priv->addresses)
+			goto out;
+	}
+
+	_timer_schedule (self);
+out:
+	g_object_unref (self);
+	return G_SOURCE_REMOVE;
 }
 
+static void
+_timer_schedule (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	AddressInfo *info;
+	guint64 now;
+
+	info = c_list_first_entry (&priv->timer_lst_head, AddressInfo, timer_lst);
+	if (!info) {
+		nm_clear_g_source (&priv->timer_id);
+		return;
+	}
+
+	if (   priv->timer_id
+	    && priv->timer_usec <= info->deadline_usec)
+		return;
+
+	nm_clear_g_source (&priv->timer_id);
+	now = _now_usec ();
+	priv->timer_usec = info->deadline_usec;
+	priv->timer_id = g_timeout_add (info->deadline_usec > now
+	                                  ? (guint) ((info->deadline_usec - now + 999) / 1000)
+	                                  : 0,
+	                                _timer_cb,
+	                                self);
+}
+
+/*****************************************************************************/
+
 static gboolean
-acd_probe_start (NMAcdManager *self,
-                 AddressInfo *info,
-                 guint64 timeout)
+_socket_event (GIOChannel *source, GIOCondition condition, gpointer data)
 {
+	NMAcdManager *self = data;
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
-	NAcdConfig *config;
-	int r, fd;
+	struct ether_arp packet;
+	gboolean hard_conflict;
+	AddressInfo *info;
+	in_addr_t spa, tpa;
+	ssize_t l;
+	guint i;
 
-	r = n_acd_new (&info->acd);
-	if (r) {
-		_LOGW ("could not create ACD for %s on interface '%s': %s",
-		       nm_utils_inet4_ntop (info->address, NULL),
-		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
-		       acd_error_to_string (r));
-		return FALSE;
+	g_object_ref (self);
+
+	for (i = 0; i < 128 && priv->fd >= 0; i++) {
+		l = recv (priv->fd, &packet, sizeof (packet), 0);
+		if (l < 0) {
+			if (!NM_IN_SET (errno, EAGAIN, EINTR, ENETDOWN, ENXIO)) {
+				_LOGD ("error receiving ARP packet: %s", g_strerror (errno));
+			}
+			break;
+		}
+		if (l != (ssize_t) sizeof (packet))
+			continue;
+		if (!memcmp (packet.arp_sha, priv->hwaddr, ETH_ALEN))
+			continue;
+
+		memcpy (&spa, packet.arp_spa, sizeof (spa));
+		memcpy (&tpa, packet.arp_tpa, sizeof (tpa));
+
+		/* Either a probe for one of our addresses by another host, or
+		 * any packet claiming one of our addresses. */
+		if (   spa == 0
+		    && packet.ea_hdr.ar_op == htobe16 (ARPOP_REQUEST)
+		    && (info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (tpa))))
+			hard_conflict = FALSE;
+		else if ((info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (spa))))
+			hard_conflict = TRUE;
+		else
+			continue;
+
+		_addr_handle_packet (self, info, &packet, hard_conflict);
 	}
 
-	n_acd_get_fd (info->acd, &fd);
-	info->channel = g_io_channel_unix_new (fd);
-	info->event_id = g_io_add_watch (info->channel, G_IO_IN, acd_event, info);
-
-	config = &(NAcdConfig) {
-		.ifindex = priv->ifindex,
-		.mac = priv->hwaddr,
-		.n_mac = ETH_ALEN,
-		.ip = info->address,
-		.timeout_msec = timeout,
-		.transport = N_ACD_TRANSPORT_ETHERNET,
+	g_object_unref (self);
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+_socket_setup (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+	gs_free struct sock_filter *filter = NULL;
+	const union {
+		guint8 u8[6];
+		guint16 u16[3];
+		guint32 u32[1];
+	} mac = {
+		.u8 = {
+			priv->hwaddr[0], priv->hwaddr[1], priv->hwaddr[2],
+			priv->hwaddr[3], priv->hwaddr[4], priv->hwaddr[5],
+		},
+	};
+	const struct sockaddr_ll address = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htobe16 (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+		.sll_halen = ETH_ALEN,
+		.sll_addr = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	};
+	struct sock_fprog fprog;
+	guint n_addresses = g_hash_table_size (priv->addresses);
+	gboolean match_addresses = (n_addresses <= ACD_FILTER_MAX_ADDRESSES);
+	GHashTableIter iter;
+	gpointer key;
+	guint n = 0;
+	int fd;
+
+	if (priv->fd >= 0)
+		return TRUE;
+
+	filter = g_new (struct sock_filter, 32 + (match_addresses ? 4 * n_addresses : 0));
+
+#define _F(...) G_STMT_START { filter[n++] = (struct sock_filter) __VA_ARGS__; } G_STMT_END
+
+	/* only valid ARP requests and replies for IPv4 over Ethernet. */
+	_F (BPF_STMT (BPF_LD + BPF_W + BPF_LEN, 0));
+	_F (BPF_JUMP (BPF_JMP + BPF_JGE + BPF_K, sizeof (struct ether_arp), 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	_F (BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hrd)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPHRD_ETHER, 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	_F (BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pro)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETHERTYPE_IP, 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	_F (BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_hln)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETH_ALEN, 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	_F (BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_pln)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sizeof (in_addr_t), 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	_F (BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, ea_hdr.ar_op)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REQUEST, 2, 0));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REPLY, 1, 0));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+
+	/* drop our own packets. */
+	_F (BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ether_arp, arp_sha)));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, be32toh (mac.u32[0]), 0, 3));
+	_F (BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct ether_arp, arp_sha) + 4));
+	_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, be16toh (mac.u16[2]), 0, 1));
+	_F (BPF_STMT (BPF_RET + BPF_K, 0));
+
+	if (match_addresses) {
+		/* accept packets whose sender or target is in the address set. */
+		_F (BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ether_arp, arp_spa)));
+		g_hash_table_iter_init (&iter, priv->addresses);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, be32toh (GPOINTER_TO_UINT (key)), 0, 1));
+			_F (BPF_STMT (BPF_RET + BPF_K, 65535));
+		}
+		_F (BPF_STMT (BPF_LD + BPF_W + BPF_ABS, offsetof (struct ether_arp, arp_tpa)));
+		g_hash_table_iter_init (&iter, priv->addresses);
+		while (g_hash_table_iter_next (&iter, &key, NULL)) {
+			_F (BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, be32toh (GPOINTER_TO_UINT (key)), 0, 1));
+			_F (BPF_STMT (BPF_RET + BPF_K, 65535));
+		}
+		_F (BPF_STMT (BPF_RET + BPF_K, 0));
+	} else
+		_F (BPF_STMT (BPF_RET + BPF_K, 65535));
+
+#undef _F
+
+	fprog = (struct sock_fprog) {
+		.len = n,
+		.filter = filter,
 	};
 
-	r = n_acd_start (info->acd, config);
-	if (r) {
-		_LOGW ("could not start probe for %s on interface '%s': %s",
-		       nm_utils_inet4_ntop (info->address, NULL),
+	fd = socket (PF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		_LOGW ("could not create ACD socket on interface '%s': %s",
 		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
-		       acd_error_to_string (r));
+		       g_strerror (errno));
 		return FALSE;
 	}
 
-	if (timeout) {
-		_LOGD ("started probe for %s with timeout %llu",
-		       nm_utils_inet4_ntop (info->address, NULL),
-		       (unsigned long long) timeout);
+	if (   setsockopt (fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog)) < 0
+	    || bind (fd, (struct sockaddr *) &address, sizeof (address)) < 0) {
+		_LOGW ("could not set up ACD socket on interface '%s': %s",
+		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+		       g_strerror (errno));
+		nm_close (fd);
+		return FALSE;
 	}
 
+	priv->fd = fd;
+	priv->channel = g_io_channel_unix_new (fd);
+	priv->event_id = g_io_add_watch (priv->channel, G_IO_IN, _socket_event, self);
 	return TRUE;
 }
 
+static void
+_socket_close (NMAcdManager *self)
+{
+	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->event_id);
+	g_clear_pointer (&priv->channel, g_io_channel_unref);
+	if (priv->fd >= 0) {
+		nm_close (priv->fd);
+		priv->fd = -1;
+	}
+}
+
+/*****************************************************************************/
+
 /**
  * nm_acd_manager_start_probe:
  * @self: a #NMAcdManager
@@ -292,7 +603,7 @@ acd_probe_start (NMAcdManager *self,
  * Start probing IP addresses for duplicates; when the probe terminates a
  * PROBE_TERMINATED signal is emitted.
  *
- * Returns: %TRUE if at least one probe could be started, %FALSE otherwise
+ * Returns: %TRUE if the probe could be started, %FALSE otherwise
  */
 gboolean
 nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
@@ -300,22 +611,41 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	NMAcdManagerPrivate *priv;
 	GHashTableIter iter;
 	AddressInfo *info;
-	gboolean success = FALSE;
+	guint64 now;
 
 	g_return_val_if_fail (NM_IS_ACD_MANAGER (self), FALSE);
 	priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
+	if (!g_hash_table_size (priv->addresses))
+		return FALSE;
+
+	if (!_socket_setup (self))
+		return FALSE;
+
 	priv->completed = 0;
+	priv->timeout_multiplier = timeout;
+	priv->state = STATE_PROBING;
 
+	now = _now_usec ();
 	g_hash_table_iter_init (&iter, priv->addresses);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
-		success |= acd_probe_start (self, info, timeout);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		info->state = ADDR_STATE_PROBING;
+		if (timeout) {
+			info->n_iteration = 0;
+			_addr_set_deadline (self, info,
+			                    now + g_random_int_range (0, timeout * ACD_PROBE_WAIT_USEC));
+		} else {
+			/* no probing, the address is ready right away. */
+			info->n_iteration = ACD_PROBE_NUM;
+			_addr_set_deadline (self, info, now);
+		}
+	}
 
-	if (success)
-		priv->state = STATE_PROBING;
+	_LOGD ("started probe for %u addresses with timeout %u",
+	       g_hash_table_size (priv->addresses), timeout);
 
-	return success;
+	return TRUE;
 }
 
 /**
@@ -332,6 +662,8 @@ nm_acd_manager_reset (NMAcdManager *self)
 	g_return_if_fail (NM_IS_ACD_MANAGER (self));
 	priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 
+	nm_clear_g_source (&priv->timer_id);
+	_socket_close (self);
 	g_hash_table_remove_all (priv->addresses);
 
 	priv->state = STATE_INIT;
@@ -391,35 +723,26 @@ nm_acd_manager_announce_addresses (NMAcdManager *self)
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 	GHashTableIter iter;
 	AddressInfo *info;
-	int r;
 
 	if (priv->state == STATE_INIT) {
-		/* n-acd can't announce without probing, therefore let's
-		 * start a fake probe with zero timeout and then perform
-		 * the announce. */
+		/* announce without probing. */
+		if (!_socket_setup (self)) {
+			_LOGW ("couldn't announce addresses on interface '%s'",
+			       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
+			return;
+		}
 		priv->state = STATE_ANNOUNCING;
 		g_hash_table_iter_init (&iter, priv->addresses);
-		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-			if (!acd_probe_start (self, info, 0)) {
-				_LOGW ("couldn't announce address %s on interface '%s'",
-				       nm_utils_inet4_ntop (info->address, NULL),
-				       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex));
-			}
-		}
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
+			_addr_announce (self, info);
 	} else if (priv->state == STATE_PROBE_DONE) {
 		priv->state = STATE_ANNOUNCING;
 		g_hash_table_iter_init (&iter, priv->addresses);
 		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-			if (info->duplicate)
+			if (   info->duplicate
+			    || info->state != ADDR_STATE_READY)
 				continue;
-			r = n_acd_announce (info->acd, N_ACD_DEFEND_ONCE);
-			if (r) {
-				_LOGW ("couldn't announce address %s on interface '%s': %s",
-				       nm_utils_inet4_ntop (info->address, NULL),
-				       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
-				       acd_error_to_string (r));
-			} else
-				_LOGD ("announcing address %s", nm_utils_inet4_ntop (info->address, NULL));
+			_addr_announce (self, info);
 		}
 	} else
 		nm_assert_not_reached ();
@@ -430,10 +753,7 @@ destroy_address_info (gpointer data)
 {
 	AddressInfo *info = (AddressInfo *) data;
 
-	g_clear_pointer (&info->channel, g_io_channel_unref);
-	g_clear_pointer (&info->acd, n_acd_free);
-	nm_clear_g_source (&info->event_id);
-
+	c_list_unlink (&info->timer_lst);
 	g_slice_free (AddressInfo, info);
 }
 
@@ -447,6 +767,8 @@ nm_acd_manager_init (NMAcdManager *self)
 	priv->addresses = g_hash_table_new_full (nm_direct_hash, NULL,
 	                                         NULL, destroy_address_info);
 	priv->state = STATE_INIT;
+	priv->fd = -1;
+	c_list_init (&priv->timer_lst_head);
 }
 
 NMAcdManager *
@@ -472,6 +794,8 @@ dispose (GObject *object)
 	NMAcdManager *self = NM_ACD_MANAGER (object);
 	NMAcdManagerPrivate *priv = NM_ACD_MANAGER_GET_PRIVATE (self);
 
+	nm_clear_g_source (&priv->timer_id);
+	_socket_close (self);
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_acd_manager_parent_class)->dispose (object);
@@ -24,6 +24,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <arpa/inet.h>
 
 #include "NetworkManagerUtils.h"
 #include "nm-device-private.h"
@@ -118,11 +119,111 @@ ignore_option (NMSettingBond *s_bond, const char *option, const char *value)
 	return nm_streq0 (value, defvalue);
 }
 
+/* Returns the value of @option in the format of sysfs, or %FALSE if
+ * @lnk doesn't know it. */
+static gboolean
+lnk_get_option (NMPlatform *platform,
+                const NMPlatformLnkBond *lnk,
+                const char *option,
+                char **out_value)
+{
+	guint32 v;
+	guint i;
+
+	*out_value = NULL;
+
+	if (nm_streq (option, NM_SETTING_BOND_OPTION_MODE))
+		v = lnk->mode;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_MIIMON))
+		v = lnk->miimon;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_UPDELAY))
+		v = lnk->updelay;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_DOWNDELAY))
+		v = lnk->downdelay;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_USE_CARRIER))
+		v = lnk->use_carrier;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_ARP_INTERVAL))
+		v = lnk->arp_interval;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_ARP_VALIDATE))
+		v = lnk->arp_validate;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_ARP_ALL_TARGETS))
+		v = lnk->arp_all_targets;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_PRIMARY_RESELECT))
+		v = lnk->primary_reselect;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_FAIL_OVER_MAC))
+		v = lnk->fail_over_mac;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY))
+		v = lnk->xmit_hash_policy;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_RESEND_IGMP))
+		v = lnk->resend_igmp;
+	else if (NM_IN_STRSET (option, NM_SETTING_BOND_OPTION_NUM_GRAT_ARP,
+	                               NM_SETTING_BOND_OPTION_NUM_UNSOL_NA))
+		v = lnk->num_grat_arp;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_ALL_SLAVES_ACTIVE))
+		v = lnk->all_slaves_active;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_MIN_LINKS))
+		v = lnk->min_links;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_LP_INTERVAL))
+		v = lnk->lp_interval;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_PACKETS_PER_SLAVE))
+		v = lnk->packets_per_slave;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_LACP_RATE))
+		v = lnk->lacp_rate;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_AD_SELECT))
+		v = lnk->ad_select;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_AD_ACTOR_SYS_PRIO))
+		v = lnk->ad_actor_sys_prio;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_AD_USER_PORT_KEY))
+		v = lnk->ad_user_port_key;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_TLB_DYNAMIC_LB))
+		v = lnk->tlb_dynamic_lb;
+	else if (nm_streq (option, NM_SETTING_BOND_OPTION_AD_ACTOR_SYSTEM)) {
+		if (lnk->ad_actor_system_has) {
+			*out_value = g_strdup_printf ("%02x:%02x:%02x:%02x:%02x:%02x",
+			                              lnk->ad_actor_system[0], lnk->ad_actor_system[1],
+			                              lnk->ad_actor_system[2], lnk->ad_actor_system[3],
+			                              lnk->ad_actor_system[4], lnk->ad_actor_system[5]);
+		}
+		return TRUE;
+	} else if (nm_streq (option, NM_SETTING_BOND_OPTION_ACTIVE_SLAVE)) {
+		if (lnk->active_slave_has)
+			*out_value = g_strdup (nm_platform_link_get_name (platform, lnk->active_slave));
+		return TRUE;
+	} else if (nm_streq (option, NM_SETTING_BOND_OPTION_PRIMARY)) {
+		/* kernel only reports the primary if it is currently a slave.
+		 * Let sysfs tell the configured name. */
+		if (!lnk->primary_has)
+			return FALSE;
+		*out_value = g_strdup (nm_platform_link_get_name (platform, lnk->primary));
+		return TRUE;
+	} else if (nm_streq (option, NM_SETTING_BOND_OPTION_ARP_IP_TARGET)) {
+		GString *str;
+		char buf[NM_UTILS_INET_ADDRSTRLEN];
+
+		str = g_string_new (NULL);
+		for (i = 0; i < lnk->arp_ip_targets_num; i++) {
+			if (i)
+				g_string_append_c (str, ' ');
+			g_string_append (str, nm_utils_inet4_ntop (lnk->arp_ip_target[i], buf));
+		}
+		*out_value = g_string_free (str, FALSE);
+		return TRUE;
+	} else
+		return FALSE;
+
+	*out_value = g_strdup (_nm_setting_bond_option_from_uint (option, v));
+	if (!*out_value)
+		*out_value = g_strdup_printf ("%u", (guint) v);
+	return TRUE;
+}
+
 static void
 update_connection (NMDevice *device, NMConnection *connection)
 {
 	NMSettingBond *s_bond = nm_connection_get_setting_bond (connection);
 	int ifindex = nm_device_get_ifindex (device);
+	NMPlatform *platform = nm_device_get_platform (device);
+	const NMPlatformLnkBond *lnk;
 	NMBondMode mode = NM_BOND_MODE_UNKNOWN;
 	const char **options;
 
@@ -131,12 +232,19 @@ update_connection (NMDevice *device, NMConnection *connection)
 		nm_connection_add_setting (connection, (NMSetting *) s_bond);
 	}
 
-	/* Read bond options from sysfs and update the Bond setting to match */
+	lnk = nm_platform_link_get_lnk_bond (platform, ifindex, NULL);
+
+	/* Read bond options from the platform cache (or sysfs, if the kernel
+	 * doesn't report them) and update the Bond setting to match */
 	options = nm_setting_bond_get_valid_options (s_bond);
 	for (; *options; options++) {
-		gs_free char *value = nm_platform_sysctl_master_get_option (nm_device_get_platform (device), ifindex, *options);
+		gs_free char *value = NULL;
 		char *p;
 
+		if (   !lnk
+		    || !lnk_get_option (platform, lnk, *options, &value))
+			value = nm_platform_sysctl_master_get_option (platform, ifindex, *options);
+
 		if (   value
 		    && _nm_setting_bond_get_option_type (s_bond, *options) == NM_BOND_OPTION_TYPE_BOTH) {
 			p = strchr (value, ' ');
@@ -216,6 +324,171 @@ set_simple_option (NMDevice *device,
 	set_bond_attr (device, mode, opt, value);
 }
 
+static gboolean
+option_get_uint (NMSettingBond *s_bond, const char *opt, guint32 *out_value)
+{
+	const char *value;
+
+	value = nm_setting_bond_get_option_by_name (s_bond, opt);
+	if (!value)
+		value = nm_setting_bond_get_option_default (s_bond, opt);
+	return _nm_setting_bond_option_to_uint (opt, value, out_value);
+}
+
+/* Builds the options like apply_bonding_config() and sets them with a
+ * single netlink message. Returns %FALSE if that is not possible, in
+ * which case the caller falls back to sysfs. */
+static gboolean
+apply_bonding_config_netlink (NMDevice *device, NMSettingBond *s_bond, NMBondMode mode)
+{
+	NMDeviceBond *self = NM_DEVICE_BOND (device);
+	NMPlatform *platform = nm_device_get_platform (device);
+	int ifindex = nm_device_get_ifindex (device);
+	NMPlatformLnkBond props = { };
+	const char *value;
+	const char *primary = NULL;
+	gboolean set_arp_interval = TRUE;
+	guint32 v;
+
+	props.mode = mode - NM_BOND_MODE_ROUNDROBIN;
+
+	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_MIIMON);
+	if (value && atoi (value)) {
+		/* clear arp interval */
+		props.arp_interval_has = _nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_ARP_INTERVAL, mode);
+		props.arp_interval = 0;
+		set_arp_interval = FALSE;
+
+		if (!option_get_uint (s_bond, NM_SETTING_BOND_OPTION_MIIMON, &props.miimon))
+			return FALSE;
+		props.miimon_has = TRUE;
+		if (!option_get_uint (s_bond, NM_SETTING_BOND_OPTION_UPDELAY, &props.updelay))
+			return FALSE;
+		props.updelay_has = TRUE;
+		if (!option_get_uint (s_bond, NM_SETTING_BOND_OPTION_DOWNDELAY, &props.downdelay))
+			return FALSE;
+		props.downdelay_has = TRUE;
+	} else if (!value) {
+		/* If not given, and arp_interval is not given or disabled, default to 100 */
+		value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL);
+		if (_nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXUINT32, 0) == 0) {
+			props.miimon = 100;
+			props.miimon_has = TRUE;
+		}
+	}
+
+	if (   set_arp_interval
+	    && _nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_ARP_INTERVAL, mode)) {
+		if (!option_get_uint (s_bond, NM_SETTING_BOND_OPTION_ARP_INTERVAL, &props.arp_interval))
+			return FALSE;
+		props.arp_interval_has = TRUE;
+	}
+
+	/* ARP validate: value > 0 only valid in active-backup mode */
+	if (_nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_ARP_VALIDATE, mode)) {
+		value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_VALIDATE);
+		if (   value
+		    && mode == NM_BOND_MODE_ACTIVEBACKUP) {
+			if (!_nm_setting_bond_option_to_uint (NM_SETTING_BOND_OPTION_ARP_VALIDATE, value, &props.arp_validate))
+				return FALSE;
+		}
+		props.arp_validate_has = TRUE;
+	}
+
+	/* Primary: kernel wants an ifindex. If the interface doesn't exist yet,
+	 * set the name via sysfs afterwards. */
+	if (_nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_PRIMARY, mode)) {
+		primary = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_PRIMARY);
+		if (primary) {
+			props.primary = nm_platform_link_get_ifindex (platform, primary);
+			props.primary_has = props.primary > 0;
+		} else
+			props.primary_has = TRUE;
+	}
+
+	/* ARP targets: the list is always replaced */
+	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ARP_IP_TARGET);
+	if (value) {
+		gs_strfreev char **items = NULL;
+		char **iter;
+
+		items = g_strsplit_set (value, ",", 0);
+		for (iter = items; *iter; iter++) {
+			if (!*iter[0])
+				continue;
+			if (props.arp_ip_targets_num >= NM_BOND_MAX_ARP_TARGETS)
+				return FALSE;
+			if (inet_pton (AF_INET, *iter, &props.arp_ip_target[props.arp_ip_targets_num]) != 1)
+				return FALSE;
+			props.arp_ip_targets_num++;
+		}
+	}
+
+	/* AD actor system: don't set if empty */
+	value = nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_AD_ACTOR_SYSTEM);
+	if (   value
+	    && _nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_AD_ACTOR_SYSTEM, mode)) {
+		if (!nm_utils_hwaddr_aton (value, props.ad_actor_system, ETH_ALEN))
+			return FALSE;
+		props.ad_actor_system_has = TRUE;
+	}
+
+	/* The active slave can only be set after it is enslaved, which happens
+	 * later in enslave_slave(). Only clear it here. */
+	if (   _nm_setting_bond_option_supported (NM_SETTING_BOND_OPTION_ACTIVE_SLAVE, mode)
+	    && !nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_ACTIVE_SLAVE))
+		props.active_slave_has = TRUE;
+
+#define _get_uint(opt, field) \
+	G_STMT_START { \
+		if (!option_get_uint (s_bond, (opt), &v)) \
+			return FALSE; \
+		props.field = v; \
+	} G_STMT_END
+#define _get_uint_has(opt, field) \
+	G_STMT_START { \
+		if (_nm_setting_bond_option_supported ((opt), mode)) { \
+			_get_uint (opt, field); \
+			props.field##_has = TRUE; \
+		} \
+	} G_STMT_END
+
+	_get_uint (NM_SETTING_BOND_OPTION_AD_SELECT, ad_select);
+	_get_uint (NM_SETTING_BOND_OPTION_ALL_SLAVES_ACTIVE, all_slaves_active);
+	_get_uint (NM_SETTING_BOND_OPTION_ARP_ALL_TARGETS, arp_all_targets);
+	_get_uint (NM_SETTING_BOND_OPTION_FAIL_OVER_MAC, fail_over_mac);
+	_get_uint (NM_SETTING_BOND_OPTION_LP_INTERVAL, lp_interval);
+	_get_uint (NM_SETTING_BOND_OPTION_MIN_LINKS, min_links);
+	_get_uint (NM_SETTING_BOND_OPTION_PRIMARY_RESELECT, primary_reselect);
+	_get_uint (NM_SETTING_BOND_OPTION_RESEND_IGMP, resend_igmp);
+	_get_uint (NM_SETTING_BOND_OPTION_USE_CARRIER, use_carrier);
+	_get_uint (NM_SETTING_BOND_OPTION_XMIT_HASH_POLICY, xmit_hash_policy);
+	_get_uint_has (NM_SETTING_BOND_OPTION_AD_ACTOR_SYS_PRIO, ad_actor_sys_prio);
+	_get_uint_has (NM_SETTING_BOND_OPTION_AD_USER_PORT_KEY, ad_user_port_key);
+	_get_uint_has (NM_SETTING_BOND_OPTION_LACP_RATE, lacp_rate);
+	_get_uint_has (NM_SETTING_BOND_OPTION_PACKETS_PER_SLAVE, packets_per_slave);
+	_get_uint_has (NM_SETTING_BOND_OPTION_TLB_DYNAMIC_LB, tlb_dynamic_lb);
+
+	/* num_grat_arp and num_unsol_na are the same attribute on kernel side */
+	if (nm_setting_bond_get_option_by_name (s_bond, NM_SETTING_BOND_OPTION_NUM_GRAT_ARP))
+		_get_uint (NM_SETTING_BOND_OPTION_NUM_GRAT_ARP, num_grat_arp);
+	else
+		_get_uint (NM_SETTING_BOND_OPTION_NUM_UNSOL_NA, num_grat_arp);
+
+#undef _get_uint
+#undef _get_uint_has
+
+	if (!nm_platform_link_bond_change (platform, ifindex, &props)) {
+		_LOGD (LOGD_BOND, "failed to set bonding options via netlink, fall back to sysfs");
+		return FALSE;
+	}
+
+	if (primary && !props.primary_has)
+		set_bond_attr (device, mode, NM_SETTING_BOND_OPTION_PRIMARY, primary);
+
+	return TRUE;
+}
+
 static NMActStageReturn
 apply_bonding_config (NMDevice *device)
 {
@@ -256,6 +529,9 @@ apply_bonding_config (NMDevice *device)
 		return NM_ACT_STAGE_RETURN_FAILURE;
 	}
 
+	if (apply_bonding_config_netlink (device, s_bond, mode))
+		return NM_ACT_STAGE_RETURN_SUCCESS;
+
 	/* Set mode first, as some other options (e.g. arp_interval) are valid
 	 * only for certain modes.
 	 */
@@ -191,14 +191,12 @@ static const Option slave_options[] = {
 	{ NULL, NULL }
 };
 
-static void
-commit_option (NMDevice *device, NMSetting *setting, const Option *option, gboolean slave)
+static guint32
+option_get_uint (NMSetting *setting, const Option *option)
 {
-	int ifindex = nm_device_get_ifindex (device);
 	GParamSpec *pspec;
 	GValue val = G_VALUE_INIT;
 	guint32 uval = 0;
-	gs_free char *value = NULL;
 
 	g_assert (setting);
 
@@ -234,7 +232,26 @@ commit_option (NMDevice *device, NMSetting *setting, const Option *option, gbool
 		g_assert_not_reached ();
 	g_value_unset (&val);
 
-	value = g_strdup_printf ("%u", uval);
+	return uval;
+}
+
+static guint32
+option_get_uint_by_name (NMSetting *setting, const Option *options, const char *name)
+{
+	for (; options->name; options++) {
+		if (nm_streq (options->name, name))
+			return option_get_uint (setting, options);
+	}
+	g_return_val_if_reached (0);
+}
+
+static void
+commit_option (NMDevice *device, NMSetting *setting, const Option *option, gboolean slave)
+{
+	int ifindex = nm_device_get_ifindex (device);
+	char value[30];
+
+	nm_sprintf_buf (value, "%u", option_get_uint (setting, option));
 	if (slave)
 		nm_platform_sysctl_slave_set_option (nm_device_get_platform (device), ifindex, option->sysname, value);
 	else
@@ -246,6 +263,23 @@ commit_master_options (NMDevice *device, NMSettingBridge *setting)
 {
 	const Option *option;
 	NMSetting *s = NM_SETTING (setting);
+	NMPlatformLnkBridge props = {
+		.stp_state      = !!option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_STP),
+		.priority       = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_PRIORITY),
+		.forward_delay  = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_FORWARD_DELAY),
+		.hello_time     = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_HELLO_TIME),
+		.max_age        = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_MAX_AGE),
+		.ageing_time    = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_AGEING_TIME),
+		.group_fwd_mask = option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_GROUP_FORWARD_MASK),
+		.mcast_snooping = !!option_get_uint_by_name (s, master_options, NM_SETTING_BRIDGE_MULTICAST_SNOOPING),
+	};
+
+	/* Set all options with one netlink message. Older kernels don't
+	 * support changing the bridge via netlink; fall back to sysfs. */
+	if (nm_platform_link_bridge_change (nm_device_get_platform (device),
+	                                    nm_device_get_ifindex (device),
+	                                    &props))
+		return;
 
 	for (option = master_options; option->name; option++)
 		commit_option (device, s, option, FALSE);
@@ -262,8 +296,14 @@ commit_slave_options (NMDevice *device, NMSettingBridgePort *setting)
 	else
 		s = s_clear = nm_setting_bridge_port_new ();
 
-	for (option = slave_options; option->name; option++)
-		commit_option (device, s, option, TRUE);
+	if (!nm_platform_link_bridge_port_change (nm_device_get_platform (device),
+	                                          nm_device_get_ifindex (device),
+	                                          option_get_uint_by_name (s, slave_options, NM_SETTING_BRIDGE_PORT_PRIORITY),
+	                                          option_get_uint_by_name (s, slave_options, NM_SETTING_BRIDGE_PORT_PATH_COST),
+	                                          option_get_uint_by_name (s, slave_options, NM_SETTING_BRIDGE_PORT_HAIRPIN_MODE))) {
+		for (option = slave_options; option->name; option++)
+			commit_option (device, s, option, TRUE);
+	}
 
 	g_clear_object (&s_clear);
 }
@@ -274,6 +314,7 @@ update_connection (NMDevice *device, NMConnection *connection)
 	NMDeviceBridge *self = NM_DEVICE_BRIDGE (device);
 	NMSettingBridge *s_bridge = nm_connection_get_setting_bridge (connection);
 	int ifindex = nm_device_get_ifindex (device);
+	const NMPlatformLnkBridge *lnk;
 	const Option *option;
 
 	if (!s_bridge) {
@@ -281,6 +322,22 @@ update_connection (NMDevice *device, NMConnection *connection)
 		nm_connection_add_setting (connection, (NMSetting *) s_bridge);
 	}
 
+	lnk = nm_platform_link_get_lnk_bridge (nm_device_get_platform (device), ifindex, NULL);
+	if (lnk) {
+		/* See comments in option_get_uint() about centiseconds. */
+		g_object_set (s_bridge,
+		              NM_SETTING_BRIDGE_STP, (gboolean) lnk->stp_state,
+		              NM_SETTING_BRIDGE_PRIORITY, (guint) lnk->priority,
+		              NM_SETTING_BRIDGE_FORWARD_DELAY, (guint) (lnk->forward_delay / 100),
+		              NM_SETTING_BRIDGE_HELLO_TIME, (guint) (lnk->hello_time / 100),
+		              NM_SETTING_BRIDGE_MAX_AGE, (guint) (lnk->max_age / 100),
+		              NM_SETTING_BRIDGE_AGEING_TIME, (guint) (lnk->ageing_time / 100),
+		              NM_SETTING_BRIDGE_GROUP_FORWARD_MASK, (guint) lnk->group_fwd_mask,
+		              NM_SETTING_BRIDGE_MULTICAST_SNOOPING, (gboolean) lnk->mcast_snooping,
+		              NULL);
+		return;
+	}
+
 	for (option = master_options; option->name; option++) {
 		gs_free char *str = nm_platform_sysctl_master_get_option (nm_device_get_platform (device), ifindex, option->sysname);
 		int value;
@@ -288,7 +345,7 @@ update_connection (NMDevice *device, NMConnection *connection)
 		if (str) {
 			value = strtol (str, NULL, 10);
 
-			/* See comments in set_sysfs_uint() about centiseconds. */
+			/* See comments in option_get_uint() about centiseconds. */
 			if (option->user_hz_compensate)
 				value /= 100;
 
@@ -327,7 +384,7 @@ master_update_slave_connection (NMDevice *device,
 		if (str) {
 			value = strtol (str, NULL, 10);
 
-			/* See comments in set_sysfs_uint() about centiseconds. */
+			/* See comments in option_get_uint() about centiseconds. */
 			if (option->user_hz_compensate)
 				value /= 100;
 
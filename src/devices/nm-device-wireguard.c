@@ -22,8 +22,11 @@
 #include "nm-device-wireguard.h"
 
 #include "nm-device-private.h"
+#include "NetworkManagerUtils.h"
 #include "platform/nm-platform.h"
+#include "platform/nmp-object.h"
 #include "nm-device-factory.h"
+#include "nm-core-internal.h"
 
 #include "nm-device-logging.h"
 _LOG_DECLARE_SELF(NMDeviceWireGuard);
@@ -70,7 +73,9 @@ update_properties (NMDevice *device)
 	ifindex = nm_device_get_ifindex (device);
 	props = nm_platform_link_get_lnk_wireguard (nm_device_get_platform (device), ifindex, &plink);
 	if (!props) {
-		_LOGW (LOGD_PLATFORM, "could not get wireguard properties");
+		/* the platform fetches the WireGuard data deferred. We get
+		 * another link-changed notification once it is there. */
+		_LOGD (LOGD_PLATFORM, "wireguard properties not (yet) available");
 		return;
 	}
 
@@ -107,6 +112,195 @@ link_changed (NMDevice *device,
 	update_properties (device);
 }
 
+/******************************************************************/
+
+static gboolean
+link_config (NMDeviceWireGuard *self, NMConnection *connection)
+{
+	NMSettingWireGuard *s_wg;
+	NMPlatformLnkWireGuard lnk = { 0 };
+	gs_free NMPWireGuardPeer *peers = NULL;
+	gs_free NMPWireGuardAllowedIP *allowed_ips = NULL;
+	guint peers_len;
+	guint allowed_ips_len = 0;
+	guint i, j, k;
+	int ifindex;
+	gboolean success = FALSE;
+
+	s_wg = nm_connection_get_setting_wireguard (connection);
+	g_return_val_if_fail (s_wg, FALSE);
+
+	ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+	if (ifindex <= 0)
+		return FALSE;
+
+	if (!_nm_utils_wireguard_decode_key (nm_setting_wireguard_get_private_key (s_wg),
+	                                     sizeof (lnk.private_key),
+	                                     lnk.private_key)) {
+		_LOGW (LOGD_DEVICE, "wireguard: missing or invalid private key");
+		return FALSE;
+	}
+	lnk.listen_port = nm_setting_wireguard_get_listen_port (s_wg);
+	lnk.fwmark = nm_setting_wireguard_get_fwmark (s_wg);
+
+	peers_len = nm_setting_wireguard_get_peers_len (s_wg);
+	for (i = 0; i < peers_len; i++)
+		allowed_ips_len += nm_wireguard_peer_get_allowed_ips_len (nm_setting_wireguard_get_peer (s_wg, i));
+
+	peers = peers_len > 0 ? g_new0 (NMPWireGuardPeer, peers_len) : NULL;
+	allowed_ips = allowed_ips_len > 0 ? g_new0 (NMPWireGuardAllowedIP, allowed_ips_len) : NULL;
+
+	for (i = 0, k = 0; i < peers_len; i++) {
+		NMWireGuardPeer *s_peer = nm_setting_wireguard_get_peer (s_wg, i);
+		NMPWireGuardPeer *peer = &peers[i];
+		const char *str;
+		int addr_family;
+
+		/* the setting is verified, parsing the peers is not expected to fail. */
+		if (!_nm_utils_wireguard_decode_key (nm_wireguard_peer_get_public_key (s_peer),
+		                                     sizeof (peer->public_key),
+		                                     peer->public_key))
+			goto out;
+
+		str = nm_wireguard_peer_get_endpoint (s_peer);
+		if (str) {
+			if (!_nm_utils_wireguard_parse_endpoint (str,
+			                                         &addr_family,
+			                                         &peer->endpoint_addr,
+			                                         &peer->endpoint_port))
+				goto out;
+			peer->endpoint_family = addr_family;
+		}
+
+		peer->persistent_keepalive_interval = nm_wireguard_peer_get_persistent_keepalive (s_peer);
+
+		peer->allowed_ips = &allowed_ips[k];
+		peer->allowed_ips_len = nm_wireguard_peer_get_allowed_ips_len (s_peer);
+		for (j = 0; j < peer->allowed_ips_len; j++, k++) {
+			NMPWireGuardAllowedIP *allowed_ip = &allowed_ips[k];
+			NMIPAddr addr;
+			guint8 prefix;
+
+			if (!_nm_utils_wireguard_parse_allowed_ip (nm_wireguard_peer_get_allowed_ip (s_peer, j),
+			                                           &addr_family,
+			                                           &addr,
+			                                           &prefix))
+				goto out;
+
+			/* the kernel would mask the address too. Do it upfront, so that
+			 * the platform can compare it with what the kernel reports. */
+			nm_utils_ipx_address_clear_host_address (addr_family, &allowed_ip->addr, &addr, prefix);
+			allowed_ip->family = addr_family;
+			allowed_ip->mask = prefix;
+		}
+	}
+
+	/* the platform only sends the peers that differ from the kernel's
+	 * configuration, so this is cheap on reapply. */
+	success = nm_platform_link_wireguard_change (nm_device_get_platform (NM_DEVICE (self)),
+	                                             ifindex,
+	                                             &lnk,
+	                                             peers,
+	                                             peers_len,
+	                                             TRUE);
+
+out:
+	nm_explicit_bzero (lnk.private_key, sizeof (lnk.private_key));
+	if (!success)
+		_LOGW (LOGD_DEVICE, "wireguard: failed to configure the link");
+	return success;
+}
+
+static NMDeviceCapabilities
+get_generic_capabilities (NMDevice *dev)
+{
+	return NM_DEVICE_CAP_IS_SOFTWARE;
+}
+
+static gboolean
+create_and_realize (NMDevice *device,
+                    NMConnection *connection,
+                    NMDevice *parent,
+                    const NMPlatformLink **out_plink,
+                    GError **error)
+{
+	const char *iface = nm_device_get_iface (device);
+	NMPlatformError plerr;
+
+	g_return_val_if_fail (nm_connection_get_setting_wireguard (connection), FALSE);
+
+	plerr = nm_platform_link_wireguard_add (nm_device_get_platform (device), iface, out_plink);
+	if (plerr != NM_PLATFORM_ERROR_SUCCESS) {
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_CREATION_FAILED,
+		             "Failed to create WireGuard interface '%s' for '%s': %s",
+		             iface,
+		             nm_connection_get_id (connection),
+		             nm_platform_error_to_string_a (plerr));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static NMActStageReturn
+act_stage2_config (NMDevice *device, NMDeviceStateReason *out_failure_reason)
+{
+	NMDeviceWireGuard *self = NM_DEVICE_WIREGUARD (device);
+	NMConnection *connection;
+
+	connection = nm_device_get_applied_connection (device);
+	g_return_val_if_fail (connection, NM_ACT_STAGE_RETURN_FAILURE);
+
+	if (nm_connection_need_secrets (connection, NULL)) {
+		_LOGW (LOGD_DEVICE, "Activation: connection '%s' has no WireGuard private key",
+		       nm_connection_get_id (connection));
+		NM_SET_OUT (out_failure_reason, NM_DEVICE_STATE_REASON_NO_SECRETS);
+		return NM_ACT_STAGE_RETURN_FAILURE;
+	}
+
+	if (!link_config (self, connection)) {
+		NM_SET_OUT (out_failure_reason, NM_DEVICE_STATE_REASON_CONFIG_FAILED);
+		return NM_ACT_STAGE_RETURN_FAILURE;
+	}
+
+	return NM_ACT_STAGE_RETURN_SUCCESS;
+}
+
+static gboolean
+can_reapply_change (NMDevice *device,
+                    const char *setting_name,
+                    NMSetting *s_old,
+                    NMSetting *s_new,
+                    GHashTable *diffs,
+                    GError **error)
+{
+	NMDeviceClass *device_class;
+
+	/* all WireGuard properties can be changed on the running link. */
+	if (nm_streq (setting_name, NM_SETTING_WIREGUARD_SETTING_NAME))
+		return TRUE;
+
+	device_class = NM_DEVICE_CLASS (nm_device_wireguard_parent_class);
+	return device_class->can_reapply_change (device,
+	                                         setting_name,
+	                                         s_old,
+	                                         s_new,
+	                                         diffs,
+	                                         error);
+}
+
+static void
+reapply_connection (NMDevice *device, NMConnection *con_old, NMConnection *con_new)
+{
+	NMDeviceWireGuard *self = NM_DEVICE_WIREGUARD (device);
+
+	NM_DEVICE_CLASS (nm_device_wireguard_parent_class)->reapply_connection (device,
+	                                                                        con_old,
+	                                                                        con_new);
+
+	_LOGD (LOGD_DEVICE, "reapplying wireguard settings");
+	link_config (self, con_new);
+}
 
 /******************************************************************/
 
@@ -159,9 +353,15 @@ nm_device_wireguard_class_init (NMDeviceWireGuardClass *klass)
 
 	dbus_object_class->interface_infos = NM_DBUS_INTERFACE_INFOS (&interface_info_device_wireguard);
 
-	device_class->connection_type_supported = NULL;
+	device_class->connection_type_supported = NM_SETTING_WIREGUARD_SETTING_NAME;
+	device_class->connection_type_check_compatible = NM_SETTING_WIREGUARD_SETTING_NAME;
 	device_class->link_types = NM_DEVICE_DEFINE_LINK_TYPES (NM_LINK_TYPE_WIREGUARD);
 
+	device_class->create_and_realize = create_and_realize;
+	device_class->get_generic_capabilities = get_generic_capabilities;
+	device_class->act_stage2_config = act_stage2_config;
+	device_class->can_reapply_change = can_reapply_change;
+	device_class->reapply_connection = reapply_connection;
 	device_class->link_changed = link_changed;
 
 	obj_properties[PROP_PUBLIC_KEY] =
@@ -207,6 +407,7 @@ create_device (NMDeviceFactory *factory,
 }
 
 NM_DEVICE_FACTORY_DEFINE_INTERNAL (WIREGUARD, WireGuard, wireguard,
-	NM_DEVICE_FACTORY_DECLARE_LINK_TYPES (NM_LINK_TYPE_WIREGUARD),
+	NM_DEVICE_FACTORY_DECLARE_LINK_TYPES (NM_LINK_TYPE_WIREGUARD)
+	NM_DEVICE_FACTORY_DECLARE_SETTING_TYPES (NM_SETTING_WIREGUARD_SETTING_NAME),
 	factory_class->create_device = create_device;
 )
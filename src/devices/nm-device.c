@@ -172,6 +172,7 @@ struct _NMDeviceConnectivityHandle {
 	gpointer user_data;
 	NMConnectivityCheckHandle *c_handle;
 	guint64 seq;
+	gint64 start_ns;
 	bool is_periodic:1;
 	bool is_periodic_bump:1;
 	bool is_periodic_bump_on_complete:1;
@@ -243,6 +244,7 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMDevice,
 	PROP_TX_BYTES,
 	PROP_RX_BYTES,
 	PROP_CONNECTIVITY,
+	PROP_CONNECTIVITY_CHECK_LATENCY,
 );
 
 typedef struct _NMDevicePrivate {
@@ -328,6 +330,9 @@ typedef struct _NMDevicePrivate {
 
 	GCancellable *deactivating_cancellable;
 
+	GCancellable *sriov_cancellable;
+	bool          sriov_params_set:1;
+
 	guint32         ip4_address;
 
 	NMActRequest *  queued_act_request;
@@ -569,8 +574,15 @@ typedef struct _NMDevicePrivate {
 	 * concheck_p_cur_interval. */
 	gint64 concheck_p_cur_basetime_ns;
 
+	/* a random, per-device phase by which the periodic checks are shifted
+	 * once we reached the max interval. It is a fraction of the interval. */
+	guint32 concheck_p_jitter;
+
 	NMConnectivityState connectivity_state;
 
+	/* the duration of the last check that got a response from the server. */
+	guint32 concheck_latency_msec;
+
 	CList concheck_lst_head;
 
 	guint check_delete_unrealized_id;
@@ -2508,6 +2520,16 @@ concheck_periodic_schedule_do (NMDevice *self, gint64 now_ns)
 	 * correct. */
 
 	expiry = priv->concheck_p_cur_basetime_ns + (priv->concheck_p_cur_interval * NM_UTILS_NS_PER_SECOND);
+
+	if (priv->concheck_p_cur_interval == priv->concheck_p_max_interval) {
+		/* Devices that got activated together (e.g. during boot) would otherwise
+		 * keep checking at the same moment. Spread them over the first half of
+		 * the interval. The phase is constant for the device, so the distance
+		 * between two checks is still the interval. */
+		expiry +=   ((priv->concheck_p_cur_interval * NM_UTILS_NS_PER_SECOND) / 2 / 0x10000)
+		          * (gint64) (priv->concheck_p_jitter >> 16);
+	}
+
 	tdiff = expiry - now_ns;
 
 	_LOGT (LOGD_CONCHECK, "connectivity: periodic-check: %sscheduled in %lld milliseconds (%u seconds interval)",
@@ -2890,6 +2912,17 @@ concheck_cb (NMConnectivity *connectivity,
 		                      || any_periodic_before;
 	}
 
+	if (NM_IN_SET (state, NM_CONNECTIVITY_FULL, NM_CONNECTIVITY_PORTAL)) {
+		guint32 latency_msec;
+
+		latency_msec = NM_MIN ((nm_utils_get_monotonic_timestamp_ns () - handle->start_ns) / NM_UTILS_NS_PER_MSEC,
+		                       (gint64) G_MAXUINT32);
+		if (priv->concheck_latency_msec != latency_msec) {
+			priv->concheck_latency_msec = latency_msec;
+			_notify (self, PROP_CONNECTIVITY_CHECK_LATENCY);
+		}
+	}
+
 	/* first update the new state, and emit signals. */
 	concheck_update_state (self, state, allow_periodic_bump);
 
@@ -2954,6 +2987,7 @@ concheck_start (NMDevice *self,
 
 	handle = g_slice_new0 (NMDeviceConnectivityHandle);
 	handle->seq = ++seq_counter;
+	handle->start_ns = nm_utils_get_monotonic_timestamp_ns ();
 	handle->self = self;
 	handle->callback = callback;
 	handle->user_data = user_data;
@@ -4115,8 +4149,9 @@ device_init_static_sriov_num_vfs (NMDevice *self)
 		                                          NULL);
 		num_vfs = _nm_utils_ascii_str_to_int64 (value, 10, 0, G_MAXINT32, -1);
 		if (num_vfs >= 0) {
-			nm_platform_link_set_sriov_params (nm_device_get_platform (self),
-			                                   priv->ifindex, num_vfs, -1);
+			nm_platform_link_set_sriov_params_async (nm_device_get_platform (self),
+			                                         priv->ifindex, num_vfs, -1,
+			                                         NULL, NULL, NULL);
 		}
 	}
 }
@@ -6153,6 +6188,32 @@ sriov_vf_config_to_platform (NMDevice *self,
 	return g_steal_pointer (&plat_vf);
 }
 
+static void
+sriov_params_cb (GError *error, gpointer data)
+{
+	NMDevice *self;
+	NMDevicePrivate *priv;
+
+	if (nm_utils_error_is_cancelled (error, FALSE))
+		return;
+
+	self = data;
+	priv = NM_DEVICE_GET_PRIVATE (self);
+
+	g_clear_object (&priv->sriov_cancellable);
+
+	if (error) {
+		_LOGE (LOGD_DEVICE, "failed to apply SR-IOV parameters: %s", error->message);
+		nm_device_state_changed (self,
+		                         NM_DEVICE_STATE_FAILED,
+		                         NM_DEVICE_STATE_REASON_SRIOV_CONFIGURATION_FAILED);
+		return;
+	}
+
+	priv->sriov_params_set = TRUE;
+	nm_device_activate_schedule_stage1_device_prepare (self);
+}
+
 static NMActStageReturn
 act_stage1_prepare (NMDevice *self, NMDeviceStateReason *out_failure_reason)
 {
@@ -6193,15 +6254,26 @@ act_stage1_prepare (NMDevice *self, NMDeviceStateReason *out_failure_reason)
 			}
 		}
 
-		if (!nm_platform_link_set_sriov_params (nm_device_get_platform (self),
-		                                        priv->ifindex,
-		                                        nm_setting_sriov_get_total_vfs (s_sriov),
-		                                        autoprobe)) {
-			_LOGE (LOGD_DEVICE, "failed to apply SR-IOV parameters");
-			NM_SET_OUT (out_failure_reason, NM_DEVICE_STATE_REASON_SRIOV_CONFIGURATION_FAILED);
-			return NM_ACT_STAGE_RETURN_FAILURE;
+		if (priv->sriov_cancellable)
+			return NM_ACT_STAGE_RETURN_POSTPONE;
+
+		if (!priv->sriov_params_set) {
+			/* Changing the number of VFs can block for a long time while the
+			 * driver creates them. Do it in the background and come back
+			 * to stage1 once it's done. */
+			priv->sriov_cancellable = g_cancellable_new ();
+			nm_platform_link_set_sriov_params_async (nm_device_get_platform (self),
+			                                         priv->ifindex,
+			                                         nm_setting_sriov_get_total_vfs (s_sriov),
+			                                         autoprobe,
+			                                         priv->sriov_cancellable,
+			                                         sriov_params_cb,
+			                                         self);
+			return NM_ACT_STAGE_RETURN_POSTPONE;
 		}
 
+		priv->sriov_params_set = FALSE;
+
 		if (!nm_platform_link_set_sriov_vfs (nm_device_get_platform (self),
 		                                     priv->ifindex,
 		                                     (const NMPlatformVF *const *) plat_vfs)) {
@@ -14004,6 +14076,9 @@ _cancel_activation (NMDevice *self)
 
 	ip_check_gw_ping_cleanup (self);
 
+	nm_clear_g_cancellable (&priv->sriov_cancellable);
+	priv->sriov_params_set = FALSE;
+
 	/* Break the activation chain */
 	activation_source_clear (self, AF_INET);
 	activation_source_clear (self, AF_INET6);
@@ -15787,6 +15862,7 @@ nm_device_init (NMDevice *self)
 	self->_priv = priv;
 
 	c_list_init (&priv->concheck_lst_head);
+	priv->concheck_p_jitter = g_random_int ();
 	c_list_init (&self->devices_lst);
 	c_list_init (&priv->slaves);
 
@@ -15922,6 +15998,7 @@ dispose (GObject *object)
 	}
 
 	nm_clear_g_cancellable (&priv->deactivating_cancellable);
+	nm_clear_g_cancellable (&priv->sriov_cancellable);
 
 	nm_device_assume_state_reset (self);
 
@@ -16331,6 +16408,9 @@ get_property (GObject *object, guint prop_id,
 	case PROP_CONNECTIVITY:
 		g_value_set_uint (value, priv->connectivity_state);
 		break;
+	case PROP_CONNECTIVITY_CHECK_LATENCY:
+		g_value_set_uint (value, priv->concheck_latency_msec);
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -16417,6 +16497,7 @@ static const NMDBusInterfaceInfoExtended interface_info_device = {
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE_L     ("Metered",              "u",      NM_DEVICE_METERED),
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE_L     ("LldpNeighbors",        "aa{sv}", NM_DEVICE_LLDP_NEIGHBORS),
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE_L     ("Real",                 "b",      NM_DEVICE_REAL),
+			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE_L     ("ConnectivityCheckLatency", "u",  NM_DEVICE_CONNECTIVITY_CHECK_LATENCY),
 		),
 	),
 };
@@ -16699,6 +16780,12 @@ nm_device_class_init (NMDeviceClass *klass)
 	                        G_PARAM_READABLE |
 	                        G_PARAM_STATIC_STRINGS);
 
+	obj_properties[PROP_CONNECTIVITY_CHECK_LATENCY] =
+	     g_param_spec_uint (NM_DEVICE_CONNECTIVITY_CHECK_LATENCY, "", "",
+	                        0, G_MAXUINT32, 0,
+	                        G_PARAM_READABLE |
+	                        G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	signals[STATE_CHANGED] =
@@ -149,6 +149,7 @@ nm_device_state_reason_check (NMDeviceStateReason reason)
 #define NM_DEVICE_STATISTICS_RX_BYTES        "rx-bytes"
 
 #define NM_DEVICE_CONNECTIVITY               "connectivity"
+#define NM_DEVICE_CONNECTIVITY_CHECK_LATENCY "connectivity-check-latency"
 
 #define NM_TYPE_DEVICE            (nm_device_get_type ())
 #define NM_DEVICE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_DEVICE, NMDevice))
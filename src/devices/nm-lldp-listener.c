@@ -78,6 +78,11 @@ typedef struct {
 	sd_lldp      *lldp_handle;
 	GHashTable   *lldp_neighbors;
 
+	/* the same neighbors as in @lldp_neighbors, but indexed by their raw
+	 * frame. Most LLDP frames are periodic retransmissions of the same data,
+	 * and this allows to drop them without parsing the TLVs again. */
+	GHashTable   *lldp_neighbors_raw;
+
 	/* the timestamp in nsec until which we delay updates. */
 	gint64        ratelimit_next;
 	guint         ratelimit_id;
@@ -108,6 +113,9 @@ typedef struct {
 
 	struct ether_addr destination_address;
 
+	guint8 *raw;
+	gsize raw_len;
+
 	bool valid:1;
 
 	LldpAttrData attrs[_LLDP_PROP_ID_COUNT];
@@ -309,6 +317,31 @@ lldp_neighbor_id_equal (gconstpointer a, gconstpointer b)
 	return lldp_neighbor_id_cmp (a, b) == 0;
 }
 
+static guint
+lldp_neighbor_raw_hash (gconstpointer ptr)
+{
+	const LldpNeighbor *neigh = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1254335071u);
+	nm_hash_update (&h, &neigh->destination_address, sizeof (neigh->destination_address));
+	nm_hash_update_val (&h, neigh->raw_len);
+	if (neigh->raw_len)
+		nm_hash_update (&h, neigh->raw, neigh->raw_len);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+lldp_neighbor_raw_equal (gconstpointer a, gconstpointer b)
+{
+	const LldpNeighbor *x = a;
+	const LldpNeighbor *y = b;
+
+	return    x->raw_len == y->raw_len
+	       && ether_addr_equal (&x->destination_address, &y->destination_address)
+	       && memcmp (x->raw, y->raw, x->raw_len) == 0;
+}
+
 static void
 lldp_neighbor_free (LldpNeighbor *neighbor)
 {
@@ -317,6 +350,7 @@ lldp_neighbor_free (LldpNeighbor *neighbor)
 	if (neighbor) {
 		g_free (neighbor->chassis_id);
 		g_free (neighbor->port_id);
+		g_free (neighbor->raw);
 		for (attr_id = 0; attr_id < _LLDP_PROP_ID_COUNT; attr_id++) {
 			if (neighbor->attrs[attr_id].attr_type == LLDP_ATTR_TYPE_STRING)
 				g_free (neighbor->attrs[attr_id].v_string);
@@ -375,8 +409,8 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 	uint8_t chassis_id_type, port_id_type;
 	uint16_t data16;
 	uint8_t *data8;
-	const void *chassis_id, *port_id;
-	gsize chassis_id_len, port_id_len, len;
+	const void *chassis_id, *port_id, *raw;
+	gsize chassis_id_len, port_id_len, raw_len, len;
 	const char *str;
 	int r;
 
@@ -417,6 +451,12 @@ lldp_neighbor_new (sd_lldp_neighbor *neighbor_sd, GError **error)
 		goto out;
 	}
 
+	if (   sd_lldp_neighbor_get_raw (neighbor_sd, &raw, &raw_len) == 0
+	    && raw_len > 0) {
+		neigh->raw = g_memdup (raw, raw_len);
+		neigh->raw_len = raw_len;
+	}
+
 	switch (chassis_id_type) {
 	case SD_LLDP_CHASSIS_SUBTYPE_INTERFACE_ALIAS:
 	case SD_LLDP_CHASSIS_SUBTYPE_INTERFACE_NAME:
@@ -672,6 +712,23 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	g_return_if_fail (priv->lldp_handle);
 	g_return_if_fail (neighbor_sd);
 
+	if (neighbor_valid) {
+		LldpNeighbor needle = { };
+		const void *raw;
+		size_t raw_len;
+
+		/* fast path: a neighbor that re-sends an identical frame. Skip
+		 * parsing it, it cannot change anything. */
+		if (   sd_lldp_neighbor_get_raw (neighbor_sd, &raw, &raw_len) == 0
+		    && raw_len > 0
+		    && sd_lldp_neighbor_get_destination_address (neighbor_sd, &needle.destination_address) == 0) {
+			needle.raw = (guint8 *) raw;
+			needle.raw_len = raw_len;
+			if (g_hash_table_contains (priv->lldp_neighbors_raw, &needle))
+				return;
+		}
+	}
+
 	p_parse_error = _LOGT_ENABLED () ? &parse_error : NULL;
 
 	neigh = lldp_neighbor_new (neighbor_sd, p_parse_error);
@@ -690,11 +747,24 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 			       "remove", LOG_NEIGH_ARG (neigh),
 			       NM_PRINT_FMT_QUOTED (parse_error, " (failed to parse: ", parse_error->message, ")", ""));
 
+			g_hash_table_remove (priv->lldp_neighbors_raw, neigh_old);
 			g_hash_table_remove (priv->lldp_neighbors, neigh_old);
 			changed = TRUE;
 			goto done;
-		} else if (lldp_neighbor_equal (neigh_old, neigh))
+		}
+		if (lldp_neighbor_equal (neigh_old, neigh)) {
+			/* the frame differs, but not in a way that we care about (for
+			 * example, the TTL). Remember the new raw data, so that further
+			 * repetitions take the fast path. */
+			if (neigh->raw_len) {
+				g_hash_table_remove (priv->lldp_neighbors_raw, neigh_old);
+				g_free (neigh_old->raw);
+				neigh_old->raw = g_steal_pointer (&neigh->raw);
+				neigh_old->raw_len = neigh->raw_len;
+				g_hash_table_add (priv->lldp_neighbors_raw, neigh_old);
+			}
 			return;
+		}
 	} else if (!neighbor_valid) {
 		if (parse_error)
 			_LOGT ("process: failed to parse neighbor: %s", parse_error->message);
@@ -713,6 +783,10 @@ process_lldp_neighbor (NMLldpListener *self, sd_lldp_neighbor *neighbor_sd, gboo
 	        LOG_NEIGH_ARG (neigh));
 
 	changed = TRUE;
+	if (neigh_old)
+		g_hash_table_remove (priv->lldp_neighbors_raw, neigh_old);
+	if (neigh->raw_len)
+		g_hash_table_add (priv->lldp_neighbors_raw, neigh);
 	g_hash_table_add (priv->lldp_neighbors, g_steal_pointer (&neigh));
 
 done:
@@ -812,6 +886,7 @@ nm_lldp_listener_stop (NMLldpListener *self)
 		priv->lldp_handle = NULL;
 
 		size = g_hash_table_size (priv->lldp_neighbors);
+		g_hash_table_remove_all (priv->lldp_neighbors_raw);
 		g_hash_table_remove_all (priv->lldp_neighbors);
 		if (size || priv->ratelimit_id)
 			changed = TRUE;
@@ -886,6 +961,8 @@ nm_lldp_listener_init (NMLldpListener *self)
 	priv->lldp_neighbors = g_hash_table_new_full (lldp_neighbor_id_hash,
 	                                              lldp_neighbor_id_equal,
 	                                              (GDestroyNotify) lldp_neighbor_free, NULL);
+	priv->lldp_neighbors_raw = g_hash_table_new (lldp_neighbor_raw_hash,
+	                                             lldp_neighbor_raw_equal);
 
 	_LOGT ("lldp listener created");
 }
@@ -911,6 +988,7 @@ finalize (GObject *object)
 	NMLldpListenerPrivate *priv = NM_LLDP_LISTENER_GET_PRIVATE (self);
 
 	nm_lldp_listener_stop (self);
+	g_hash_table_unref (priv->lldp_neighbors_raw);
 	g_hash_table_unref (priv->lldp_neighbors);
 
 	nm_clear_g_variant (&priv->variant);
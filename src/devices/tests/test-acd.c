@@ -143,6 +143,55 @@ test_acd_probe_2 (test_fixture *fixture, gconstpointer user_data)
 	test_acd_common (fixture, &info);
 }
 
+#define TEST_MANY_N 100
+
+static void
+test_acd_probe_many (test_fixture *fixture, gconstpointer user_data)
+{
+	gs_unref_object NMAcdManager *manager = NULL;
+	GMainLoop *loop;
+	guint i;
+	guint wait_time = 50;
+	gulong signal_id;
+
+	/* the peer uses every 10th address. */
+	for (i = 0; i < TEST_MANY_N; i += 10) {
+		nmtstp_ip4_address_add (NULL, FALSE, fixture->ifindex1, htonl (0x0a000001 + i),
+		                        8, 0, 3600, 1800, 0, NULL);
+	}
+
+again:
+	manager = nm_acd_manager_new (fixture->ifindex0, fixture->hwaddr0, fixture->hwaddr0_len);
+	g_assert (manager != NULL);
+
+	for (i = 0; i < TEST_MANY_N; i++)
+		g_assert (nm_acd_manager_add_address (manager, htonl (0x0a000001 + i)));
+
+	loop = g_main_loop_new (NULL, FALSE);
+	signal_id = g_signal_connect (manager, NM_ACD_MANAGER_PROBE_TERMINATED,
+	                              G_CALLBACK (acd_manager_probe_terminated), loop);
+	g_assert (nm_acd_manager_start_probe (manager, wait_time));
+	g_assert (nmtst_main_loop_run (loop, 2000));
+	g_signal_handler_disconnect (manager, signal_id);
+	g_main_loop_unref (loop);
+
+	for (i = 0; i < TEST_MANY_N; i++) {
+		gboolean expected = (i % 10) != 0;
+
+		if (nm_acd_manager_check_address (manager, htonl (0x0a000001 + i)) == expected)
+			continue;
+
+		if (wait_time == 50) {
+			wait_time = 1000;
+			g_clear_object (&manager);
+			goto again;
+		}
+
+		g_error ("expected check for address #%u to %s, but it didn't",
+		         i, expected ? "detect no duplicated" : "detect a duplicate");
+	}
+}
+
 static void
 test_acd_announce (test_fixture *fixture, gconstpointer user_data)
 {
@@ -181,5 +230,6 @@ _nmtstp_setup_tests (void)
 {
 	g_test_add ("/acd/probe/1", test_fixture, NULL, fixture_setup, test_acd_probe_1, fixture_teardown);
 	g_test_add ("/acd/probe/2", test_fixture, NULL, fixture_setup, test_acd_probe_2, fixture_teardown);
+	g_test_add ("/acd/probe/many", test_fixture, NULL, fixture_setup, test_acd_probe_many, fixture_teardown);
 	g_test_add ("/acd/announce", test_fixture, NULL, fixture_setup, test_acd_announce, fixture_teardown);
 }
@@ -168,6 +168,9 @@ _test_recv_data0_check (GMainLoop *loop, NMLldpListener *listener)
 
 TEST_RECV_DATA_DEFINE (_test_recv_data0,       1, _test_recv_data0_check,  &_test_recv_data0_frame0);
 TEST_RECV_DATA_DEFINE (_test_recv_data0_twice, 1, _test_recv_data0_check,  &_test_recv_data0_frame0, &_test_recv_data0_frame0);
+TEST_RECV_DATA_DEFINE (_test_recv_data0_many,  1, _test_recv_data0_check,  &_test_recv_data0_frame0, &_test_recv_data0_frame0,
+                                                                             &_test_recv_data0_frame0, &_test_recv_data0_frame0,
+                                                                             &_test_recv_data0_frame0, &_test_recv_data0_frame0);
 
 TEST_RECV_FRAME_DEFINE (_test_recv_data1_frame0,
 	/* lldp.detailed.pcap from
@@ -480,6 +483,7 @@ _nmtstp_setup_tests (void)
 	g_test_add (testpath, TestRecvFixture, testdata, _test_recv_fixture_setup, test_recv, _test_recv_fixture_teardown)
 	_TEST_ADD_RECV ("/lldp/recv/0",       &_test_recv_data0);
 	_TEST_ADD_RECV ("/lldp/recv/0_twice", &_test_recv_data0_twice);
+	_TEST_ADD_RECV ("/lldp/recv/0_many",  &_test_recv_data0_many);
 	_TEST_ADD_RECV ("/lldp/recv/1",       &_test_recv_data1);
 	_TEST_ADD_RECV ("/lldp/recv/2_ttl1",  &_test_recv_data2_ttl1);
 }
@@ -285,6 +285,17 @@ nm_dhcp_client_get_use_fqdn (NMDhcpClient *self)
 	return NM_DHCP_CLIENT_GET_PRIVATE (self)->use_fqdn;
 }
 
+gboolean
+nm_dhcp_client_has_lease (NMDhcpClient *self)
+{
+	NMDhcpClientClass *klass;
+
+	g_return_val_if_fail (NM_IS_DHCP_CLIENT (self), FALSE);
+
+	klass = NM_DHCP_CLIENT_GET_CLASS (self);
+	return klass->has_lease && klass->has_lease (self);
+}
+
 /*****************************************************************************/
 
 static const char *state_table[NM_DHCP_STATE_MAX + 1] = {
@@ -104,6 +104,16 @@ typedef struct {
 	 */
 	GBytes *(*get_duid) (NMDhcpClient *self);
 
+	/**
+	 * has_lease:
+	 * @self: the #NMDhcpClient
+	 *
+	 * Checks whether the DHCP client has a persisted lease that is still
+	 * valid, so that it will start with INIT-REBOOT instead of a full
+	 * DISCOVER.
+	 */
+	gboolean (*has_lease) (NMDhcpClient *self);
+
 	/* Signals */
 	void (*state_changed) (NMDhcpClient *self,
 	                       NMDhcpState state,
@@ -147,6 +157,8 @@ gboolean nm_dhcp_client_get_info_only (NMDhcpClient *self);
 
 gboolean nm_dhcp_client_get_use_fqdn (NMDhcpClient *self);
 
+gboolean nm_dhcp_client_has_lease (NMDhcpClient *self);
+
 gboolean nm_dhcp_client_start_ip4 (NMDhcpClient *self,
                                    GBytes *client_id,
                                    const char *dhcp_anycast_addr,
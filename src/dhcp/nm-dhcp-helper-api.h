@@ -33,4 +33,26 @@
 
 /*****************************************************************************/
 
+/* Besides the D-Bus "Notify" call, the helper can report an event with a
+ * single message on a SOCK_SEQPACKET unix socket. The message is
+ *
+ *   guint32 NM_DHCP_HELPER_EVENT_MAGIC
+ *
+ * followed by one record per environment variable:
+ *
+ *   guint16 length of the name,  the name (not NUL terminated)
+ *   guint32 length of the value, the value (not NUL terminated)
+ *
+ * All integers are in host byte order. NetworkManager answers with a single
+ * NM_DHCP_HELPER_EVENT_ACK byte once the event is handled. If the socket is
+ * not available, the helper falls back to D-Bus. */
+
+#define NM_DHCP_HELPER_EVENT_SOCKET_PATH        NMRUNDIR "/private-dhcp-event"
+
+#define NM_DHCP_HELPER_EVENT_MAGIC              ((guint32) 0x4e4d4431u) /* "NMD1" */
+#define NM_DHCP_HELPER_EVENT_ACK                ((guint8) 0x06)
+#define NM_DHCP_HELPER_EVENT_MAX_SIZE           (128 * 1024)
+
+/*****************************************************************************/
+
 #endif /* __NM_DHCP_HELPER_API_H__ */
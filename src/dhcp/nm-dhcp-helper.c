@@ -24,6 +24,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-utils/nm-vpn-plugin-macros.h"
 
@@ -64,6 +67,19 @@
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+static gboolean
+env_ignored (const char *name)
+{
+	const char **p;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (name, *p, strlen (*p)) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -74,7 +90,7 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
+		char *name, *val;
 
 		/* Split on the = */
 		name = g_strdup (*item);
@@ -83,11 +99,8 @@ build_signal_parameters (void)
 			goto next;
 		*val++ = '\0';
 
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		if (env_ignored (name))
+			goto next;
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -108,6 +121,110 @@ build_signal_parameters (void)
 	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
 }
 
+static GByteArray *
+build_event_message (void)
+{
+	GByteArray *msg;
+	char **item;
+	guint32 u32;
+
+	msg = g_byte_array_sized_new (4096);
+
+	u32 = NM_DHCP_HELPER_EVENT_MAGIC;
+	g_byte_array_append (msg, (const guint8 *) &u32, sizeof (u32));
+
+	for (item = environ; *item; item++) {
+		const char *val;
+		gs_free char *name = NULL;
+		gsize name_len;
+		guint16 u16;
+
+		val = strchr (*item, '=');
+		if (!val || val == *item)
+			continue;
+		name_len = val - *item;
+		val++;
+		if (name_len > G_MAXUINT16)
+			continue;
+
+		name = g_strndup (*item, name_len);
+		if (env_ignored (name))
+			continue;
+
+		u16 = name_len;
+		g_byte_array_append (msg, (const guint8 *) &u16, sizeof (u16));
+		g_byte_array_append (msg, (const guint8 *) name, name_len);
+		u32 = strlen (val);
+		g_byte_array_append (msg, (const guint8 *) &u32, sizeof (u32));
+		g_byte_array_append (msg, (const guint8 *) val, u32);
+	}
+
+	return msg;
+}
+
+/* Try to deliver the event with a single message on the event socket. This
+ * avoids the D-Bus authentication handshake and a GDBusConnection worker
+ * thread for every lease event. The caller falls back to D-Bus only if the
+ * message could not be sent. Once it is sent, NetworkManager processes it,
+ * so a missing acknowledgement must not cause the event to be sent again. */
+static gboolean
+notify_via_socket (void)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	struct timeval tv = { .tv_sec = 1 };
+	GByteArray *msg;
+	gboolean success = FALSE;
+	guint8 ack = 0;
+	ssize_t n;
+	int fd;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH) <= sizeof (addr.sun_path));
+
+	msg = build_event_message ();
+	if (msg->len > NM_DHCP_HELPER_EVENT_MAX_SIZE) {
+		_LOGi ("event of %u bytes too large for event socket", msg->len);
+		goto out_free;
+	}
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		_LOGi ("could not create event socket: %s", g_strerror (errno));
+		goto out_free;
+	}
+
+	memcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH));
+	if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+		_LOGi ("could not connect to event socket: %s", g_strerror (errno));
+		goto out_close;
+	}
+
+	setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv));
+	setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof (tv));
+
+	n = send (fd, msg->data, msg->len, MSG_NOSIGNAL);
+	if (n != (ssize_t) msg->len) {
+		_LOGi ("could not send event: %s", n < 0 ? g_strerror (errno) : "short write");
+		goto out_close;
+	}
+
+	/* the datagram is queued on NetworkManager's side, the event is delivered.
+	 * Still wait for the acknowledgement, so that dhclient doesn't continue
+	 * before the event was handled. */
+	success = TRUE;
+
+	do {
+		n = recv (fd, &ack, sizeof (ack), 0);
+	} while (n < 0 && errno == EINTR);
+	if (n != 1 || ack != NM_DHCP_HELPER_EVENT_ACK)
+		_LOGi ("event not acknowledged: %s", n < 0 ? g_strerror (errno) : "bad reply");
+
+out_close:
+	close (fd);
+out_free:
+	g_byte_array_unref (msg);
+	return success;
+}
+
 static void
 kill_pid (void)
 {
@@ -134,6 +251,9 @@ main (int argc, char *argv[])
 	guint try_count = 0;
 	gint64 time_end;
 
+	if (notify_via_socket ())
+		return EXIT_SUCCESS;
+
 	/* FIXME: g_dbus_connection_new_for_address_sync() tries to connect to the socket in
 	 * non-blocking mode, which can easily fail with EAGAIN, causing the creation of the
 	 * socket to fail with "Could not connect: Resource temporarily unavailable".
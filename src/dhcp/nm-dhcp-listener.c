@@ -22,6 +22,8 @@
 #include "nm-dhcp-listener.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -29,8 +31,10 @@
 #include <errno.h>
 #include <unistd.h>
 
+#include "c-list/src/c-list.h"
 #include "nm-dhcp-helper-api.h"
 #include "nm-dhcp-client.h"
+#include "nm-dhcp-utils.h"
 #include "nm-dhcp-manager.h"
 #include "nm-core-internal.h"
 #include "nm-dbus-manager.h"
@@ -64,6 +68,11 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        connections;
+	struct {
+		GIOChannel *channel;
+		guint       watch_id;
+		CList       conns_lst_head;
+	} event_sock;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -139,18 +148,15 @@ get_option (GVariant *options, const char *key)
 }
 
 static void
-_method_call_handle (NMDhcpListener *self,
-                     GVariant *parameters)
+_event_handle (NMDhcpListener *self,
+               GVariant *options)
 {
 	gs_free char *iface = NULL;
 	gs_free char *pid_str = NULL;
 	gs_free char *reason = NULL;
-	gs_unref_variant GVariant *options = NULL;
 	int pid;
 	gboolean handled = FALSE;
 
-	g_variant_get (parameters, "(@a{sv})", &options);
-
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		_LOGW ("dhcp-event: didn't have associated interface.");
@@ -180,6 +186,16 @@ _method_call_handle (NMDhcpListener *self,
 	}
 }
 
+static void
+_method_call_handle (NMDhcpListener *self,
+                     GVariant *parameters)
+{
+	gs_unref_variant GVariant *options = NULL;
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	_event_handle (self, options);
+}
+
 static void
 _method_call (GDBusConnection *connection,
               const char *sender,
@@ -276,6 +292,150 @@ dis_connection_cb (NMDBusManager *mgr,
 
 /*****************************************************************************/
 
+/* A connection of nm-dhcp-helper on the event socket. The helper sends
+ * exactly one message and waits for the acknowledgement, after which
+ * we close the connection. */
+typedef struct {
+	NMDhcpListener *self;
+	CList conns_lst;
+	GIOChannel *channel;
+	guint watch_id;
+} EventConn;
+
+static void
+_event_conn_free (EventConn *conn)
+{
+	c_list_unlink_stale (&conn->conns_lst);
+	nm_clear_g_source (&conn->watch_id);
+	g_io_channel_unref (conn->channel);
+	g_slice_free (EventConn, conn);
+}
+
+static gboolean
+_event_conn_cb (GIOChannel *source,
+                GIOCondition condition,
+                gpointer user_data)
+{
+	EventConn *conn = user_data;
+	NMDhcpListener *self = conn->self;
+	gs_free_error GError *error = NULL;
+	gs_unref_variant GVariant *options = NULL;
+	gs_free guint8 *buf = NULL;
+	const guint8 ack = NM_DHCP_HELPER_EVENT_ACK;
+	int fd = g_io_channel_unix_get_fd (conn->channel);
+	ssize_t n;
+
+	buf = g_malloc (NM_DHCP_HELPER_EVENT_MAX_SIZE + 1);
+	n = recv (fd, buf, NM_DHCP_HELPER_EVENT_MAX_SIZE + 1, MSG_DONTWAIT);
+	if (n < 0) {
+		if (NM_IN_SET (errno, EAGAIN, EINTR))
+			return G_SOURCE_CONTINUE;
+		_LOGD ("dhcp-event: failure to receive event: %s", g_strerror (errno));
+		goto out;
+	}
+	if (n == 0)
+		goto out;
+
+	options = nm_dhcp_utils_helper_event_to_variant (buf, n, &error);
+	if (!options) {
+		_LOGW ("dhcp-event: invalid event: %s", error->message);
+		goto out;
+	}
+	g_variant_ref_sink (options);
+
+	_event_handle (self, options);
+
+	if (send (fd, &ack, sizeof (ack), MSG_DONTWAIT | MSG_NOSIGNAL) < 0)
+		_LOGD ("dhcp-event: failure to acknowledge event: %s", g_strerror (errno));
+
+out:
+	conn->watch_id = 0;
+	_event_conn_free (conn);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_event_sock_accept_cb (GIOChannel *source,
+                       GIOCondition condition,
+                       gpointer user_data)
+{
+	NMDhcpListener *self = user_data;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct ucred cred;
+	socklen_t cred_len = sizeof (cred);
+	EventConn *conn;
+	int fd;
+
+	fd = accept4 (g_io_channel_unix_get_fd (priv->event_sock.channel),
+	              NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (fd < 0) {
+		if (!NM_IN_SET (errno, EAGAIN, EINTR, ECONNABORTED))
+			_LOGD ("dhcp-event: failure to accept connection: %s", g_strerror (errno));
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* The socket is only accessible to root, but be explicit about it. */
+	if (   getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0
+	    || !NM_IN_SET (cred.uid, 0, geteuid ())) {
+		_LOGW ("dhcp-event: reject connection from unprivileged peer");
+		nm_close (fd);
+		return G_SOURCE_CONTINUE;
+	}
+
+	conn = g_slice_new0 (EventConn);
+	conn->self = self;
+	conn->channel = g_io_channel_unix_new (fd);
+	g_io_channel_set_close_on_unref (conn->channel, TRUE);
+	conn->watch_id = g_io_add_watch (conn->channel,
+	                                 G_IO_IN | G_IO_ERR | G_IO_HUP,
+	                                 _event_conn_cb,
+	                                 conn);
+	c_list_link_tail (&priv->event_sock.conns_lst_head, &conn->conns_lst);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+_event_sock_setup (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	int fd;
+
+	G_STATIC_ASSERT (sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH) <= sizeof (addr.sun_path));
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		goto fail;
+
+	memcpy (addr.sun_path, NM_DHCP_HELPER_EVENT_SOCKET_PATH, sizeof (NM_DHCP_HELPER_EVENT_SOCKET_PATH));
+	unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+		goto fail;
+	if (chmod (NM_DHCP_HELPER_EVENT_SOCKET_PATH, 0600) < 0)
+		goto fail;
+	if (listen (fd, 32) < 0)
+		goto fail;
+
+	priv->event_sock.channel = g_io_channel_unix_new (fd);
+	g_io_channel_set_close_on_unref (priv->event_sock.channel, TRUE);
+	priv->event_sock.watch_id = g_io_add_watch (priv->event_sock.channel,
+	                                            G_IO_IN,
+	                                            _event_sock_accept_cb,
+	                                            self);
+	return;
+
+fail:
+	/* not fatal, nm-dhcp-helper falls back to D-Bus. */
+	_LOGD ("failure to set up event socket %s: %s",
+	       NM_DHCP_HELPER_EVENT_SOCKET_PATH, g_strerror (errno));
+	if (fd >= 0) {
+		nm_close (fd);
+		unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	}
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
@@ -296,12 +456,24 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	                                      NM_DBUS_MANAGER_PRIVATE_CONNECTION_DISCONNECTED "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (dis_connection_cb),
 	                                      self);
+
+	c_list_init (&priv->event_sock.conns_lst_head);
+	_event_sock_setup (self);
 }
 
 static void
 dispose (GObject *object)
 {
 	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE ((NMDhcpListener *) object);
+	EventConn *conn, *conn_safe;
+
+	c_list_for_each_entry_safe (conn, conn_safe, &priv->event_sock.conns_lst_head, conns_lst)
+		_event_conn_free (conn);
+	if (priv->event_sock.channel) {
+		nm_clear_g_source (&priv->event_sock.watch_id);
+		g_clear_pointer (&priv->event_sock.channel, g_io_channel_unref);
+		unlink (NM_DHCP_HELPER_EVENT_SOCKET_PATH);
+	}
 
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->new_conn_id);
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->dis_conn_id);
@@ -41,10 +41,63 @@
 
 /*****************************************************************************/
 
+#define START_LIMIT_DEFAULT        32
+#define START_JITTER_MSEC_DEFAULT  500
+
+/* a started client gives up its slot after this time, even if it
+ * didn't get a lease yet. Otherwise clients on networks without DHCP
+ * server (possibly with an infinite timeout) would block all others. */
+#define START_SLOT_TIMEOUT_SEC     15
+
+/* Tracks a DHCP client from the request to start it until it either
+ * got its first lease or failed. While the number of clients holding a
+ * slot is at the limit, new requests are queued.
+ *
+ * Queued clients are neither in dhcp_client_lst nor referenced by the
+ * manager. Only the caller holds a reference, and if it drops the client
+ * before it is started, the request goes away. */
+typedef struct {
+	NMDhcpManager *self;
+	NMDhcpClient *client;
+	CList queue_lst;
+	gint64 queued_ns;
+	gint64 started_ns;
+	guint slot_timeout_id;
+	bool holds_slot:1;
+	bool init_reboot:1;
+	bool has_ll_addr:1;
+	bool enforce_duid:1;
+
+	GBytes *client_id;
+	char *anycast_addr;
+	char *hostname;
+	char *last_ip4_address;
+	struct in6_addr ll_addr;
+	NMSettingIP6ConfigPrivacy privacy;
+	guint needed_prefixes;
+} StartRequest;
+
 typedef struct {
 	const NMDhcpClientFactory *client_factory;
 	char *default_hostname;
 	CList dhcp_client_lst_head;
+
+	struct {
+		/* NMDhcpClient -> StartRequest */
+		GHashTable *reqs;
+		CList queue_lst_head;
+		guint queue_id;
+		guint limit;
+		guint jitter_msec;
+		guint n_active;
+
+		guint n_dequeued;
+		gint64 queue_sum_ns;
+		gint64 queue_max_ns;
+		guint n_acquired;
+		gint64 acquire_sum_ns;
+		gint64 acquire_max_ns;
+	} start;
 } NMDhcpManagerPrivate;
 
 struct _NMDhcpManager {
@@ -99,6 +152,7 @@ get_client_for_ifindex (NMDhcpManager *manager, int addr_family, int ifindex)
 {
 	NMDhcpManagerPrivate *priv;
 	NMDhcpClient *client;
+	StartRequest *req;
 
 	g_return_val_if_fail (NM_IS_DHCP_MANAGER (manager), NULL);
 	g_return_val_if_fail (ifindex > 0, NULL);
@@ -111,6 +165,12 @@ get_client_for_ifindex (NMDhcpManager *manager, int addr_family, int ifindex)
 			return client;
 	}
 
+	c_list_for_each_entry (req, &priv->start.queue_lst_head, queue_lst) {
+		if (   nm_dhcp_client_get_ifindex (req->client) == ifindex
+		    && nm_dhcp_client_get_addr_family (req->client) == addr_family)
+			return req->client;
+	}
+
 	return NULL;
 }
 
@@ -121,23 +181,290 @@ static void client_state_changed (NMDhcpClient *client,
                                   const char *event_id,
                                   NMDhcpManager *self);
 
+static void remove_client_unref (NMDhcpManager *self, NMDhcpClient *client);
+
+/*****************************************************************************/
+
+static void _start_request_client_gone (gpointer data, GObject *where_the_object_was);
+
+static void
+_start_queue_unlink (StartRequest *req)
+{
+	if (!c_list_is_linked (&req->queue_lst))
+		return;
+
+	c_list_unlink (&req->queue_lst);
+	g_object_weak_unref (G_OBJECT (req->client), _start_request_client_gone, req);
+}
+
+static void
+_start_request_free (gpointer data)
+{
+	StartRequest *req = data;
+
+	_start_queue_unlink (req);
+	nm_clear_g_source (&req->slot_timeout_id);
+	if (req->client_id)
+		g_bytes_unref (req->client_id);
+	g_free (req->anycast_addr);
+	g_free (req->hostname);
+	g_free (req->last_ip4_address);
+	g_slice_free (StartRequest, req);
+}
+
+static void _start_queue_schedule (NMDhcpManager *self);
+
+static gboolean
+_start_slot_timeout_cb (gpointer user_data)
+{
+	StartRequest *req = user_data;
+	NMDhcpManager *self = req->self;
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
+	req->slot_timeout_id = 0;
+
+	nm_assert (req->holds_slot);
+	nm_assert (priv->start.n_active > 0);
+	req->holds_slot = FALSE;
+	priv->start.n_active--;
+
+	nm_log_dbg (LOGD_DHCP, "dhcp-start: (%s) no lease after %d seconds, release start slot (%u active)",
+	            nm_dhcp_client_get_iface (req->client),
+	            START_SLOT_TIMEOUT_SEC,
+	            priv->start.n_active);
+
+	_start_queue_schedule (self);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_start_request_run (NMDhcpManager *self, StartRequest *req, GError **error)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
+	nm_assert (!req->started_ns);
+	nm_assert (!c_list_is_linked (&req->queue_lst));
+
+	req->started_ns = nm_utils_get_monotonic_timestamp_ns ();
+	req->holds_slot = TRUE;
+	priv->start.n_active++;
+	req->slot_timeout_id = g_timeout_add_seconds (START_SLOT_TIMEOUT_SEC, _start_slot_timeout_cb, req);
+
+	if (nm_dhcp_client_get_addr_family (req->client) == AF_INET) {
+		return nm_dhcp_client_start_ip4 (req->client,
+		                                 req->client_id,
+		                                 req->anycast_addr,
+		                                 req->hostname,
+		                                 req->last_ip4_address,
+		                                 error);
+	}
+	return nm_dhcp_client_start_ip6 (req->client,
+	                                 req->client_id,
+	                                 req->enforce_duid,
+	                                 req->anycast_addr,
+	                                 req->has_ll_addr ? &req->ll_addr : NULL,
+	                                 req->hostname,
+	                                 req->privacy,
+	                                 req->needed_prefixes,
+	                                 error);
+}
+
+static gboolean _start_queue_cb (gpointer user_data);
+
+static void
+_start_queue_schedule (NMDhcpManager *self)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
+	if (   priv->start.queue_id
+	    || c_list_is_empty (&priv->start.queue_lst_head))
+		return;
+	if (   priv->start.limit
+	    && priv->start.n_active >= priv->start.limit)
+		return;
+
+	/* stagger the queued clients so that they don't all send their
+	 * DISCOVER in the same instant. */
+	priv->start.queue_id = g_timeout_add (priv->start.jitter_msec
+	                                      ? g_random_int_range (0, priv->start.jitter_msec + 1)
+	                                      : 0,
+	                                      _start_queue_cb,
+	                                      self);
+}
+
+static void
+_start_request_drop (NMDhcpManager *self, NMDhcpClient *client)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	StartRequest *req;
+
+	req = g_hash_table_lookup (priv->start.reqs, client);
+	if (!req)
+		return;
+
+	if (req->holds_slot) {
+		nm_assert (priv->start.n_active > 0);
+		priv->start.n_active--;
+	}
+	g_hash_table_remove (priv->start.reqs, client);
+	_start_queue_schedule (self);
+}
+
+static void
+_start_request_bound (NMDhcpManager *self, NMDhcpClient *client)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	StartRequest *req;
+	gint64 duration_ns;
+
+	req = g_hash_table_lookup (priv->start.reqs, client);
+	if (!req || !req->started_ns)
+		return;
+
+	duration_ns = nm_utils_get_monotonic_timestamp_ns () - req->started_ns;
+	priv->start.n_acquired++;
+	priv->start.acquire_sum_ns += duration_ns;
+	priv->start.acquire_max_ns = NM_MAX (priv->start.acquire_max_ns, duration_ns);
+
+	nm_log_dbg (LOGD_DHCP, "dhcp-start: (%s) lease acquired in %u ms (average %u ms, max %u ms over %u leases)",
+	            nm_dhcp_client_get_iface (client),
+	            (guint) (duration_ns / NM_UTILS_NS_PER_MSEC),
+	            (guint) (priv->start.acquire_sum_ns / priv->start.n_acquired / NM_UTILS_NS_PER_MSEC),
+	            (guint) (priv->start.acquire_max_ns / NM_UTILS_NS_PER_MSEC),
+	            priv->start.n_acquired);
+
+	_start_request_drop (self, client);
+}
+
+static void
+_start_queue_add (NMDhcpManager *self, StartRequest *req)
+{
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	StartRequest *iter;
+
+	req->queued_ns = nm_utils_get_monotonic_timestamp_ns ();
+	req->init_reboot =    req->last_ip4_address
+	                   || nm_dhcp_client_has_lease (req->client);
+
+	/* Clients that can INIT-REBOOT with a still valid lease only need
+	 * a REQUEST/ACK exchange and go first. */
+	if (req->init_reboot) {
+		c_list_for_each_entry (iter, &priv->start.queue_lst_head, queue_lst) {
+			if (!iter->init_reboot) {
+				c_list_link_before (&iter->queue_lst, &req->queue_lst);
+				goto out;
+			}
+		}
+	}
+	c_list_link_tail (&priv->start.queue_lst_head, &req->queue_lst);
+
+out:
+	g_object_weak_ref (G_OBJECT (req->client), _start_request_client_gone, req);
+
+	nm_log_dbg (LOGD_DHCP, "dhcp-start: (%s) queue DHCP%s start%s (%u active)",
+	            nm_dhcp_client_get_iface (req->client),
+	            nm_dhcp_client_get_addr_family (req->client) == AF_INET ? "4" : "6",
+	            req->init_reboot ? " with INIT-REBOOT" : "",
+	            priv->start.n_active);
+	_start_queue_schedule (self);
+}
+
+static gboolean
+_start_queue_cb (gpointer user_data)
+{
+	NMDhcpManager *self = user_data;
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	StartRequest *req;
+
+	priv->start.queue_id = 0;
+
+	while (   (!priv->start.limit || priv->start.n_active < priv->start.limit)
+	       && (req = c_list_first_entry (&priv->start.queue_lst_head, StartRequest, queue_lst))) {
+		gs_unref_object NMDhcpClient *client = g_object_ref (req->client);
+		gs_free_error GError *error = NULL;
+		gint64 queued_ns;
+
+		/* from now on, the manager holds a reference to the client. */
+		_start_queue_unlink (req);
+		c_list_link_tail (&priv->dhcp_client_lst_head, &client->dhcp_client_lst);
+		g_object_ref (client);
+
+		queued_ns = nm_utils_get_monotonic_timestamp_ns () - req->queued_ns;
+		priv->start.n_dequeued++;
+		priv->start.queue_sum_ns += queued_ns;
+		priv->start.queue_max_ns = NM_MAX (priv->start.queue_max_ns, queued_ns);
+
+		nm_log_dbg (LOGD_DHCP, "dhcp-start: (%s) start DHCP%s after %u ms in queue (average %u ms, max %u ms)",
+		            nm_dhcp_client_get_iface (client),
+		            nm_dhcp_client_get_addr_family (client) == AF_INET ? "4" : "6",
+		            (guint) (queued_ns / NM_UTILS_NS_PER_MSEC),
+		            (guint) (priv->start.queue_sum_ns / priv->start.n_dequeued / NM_UTILS_NS_PER_MSEC),
+		            (guint) (priv->start.queue_max_ns / NM_UTILS_NS_PER_MSEC));
+
+		if (!_start_request_run (self, req, &error)) {
+			nm_log_warn (LOGD_DHCP, "dhcp-start: (%s) failure to start DHCP: %s",
+			             nm_dhcp_client_get_iface (client),
+			             error->message);
+			/* the owner learns about the failure via the state change, which
+			 * also removes the client. */
+			nm_dhcp_client_set_state (client, NM_DHCP_STATE_FAIL, NULL, NULL);
+			continue;
+		}
+
+		/* start one client per timeout. */
+		break;
+	}
+
+	_start_queue_schedule (self);
+	return G_SOURCE_REMOVE;
+}
+
 static void
+_start_request_client_gone (gpointer data, GObject *where_the_object_was)
+{
+	StartRequest *req = data;
+	NMDhcpManager *self = req->self;
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+
+	/* the owner released the client while it was still queued. The weak
+	 * reference is already gone. */
+	nm_assert (c_list_is_linked (&req->queue_lst));
+	c_list_unlink (&req->queue_lst);
+
+	nm_log_dbg (LOGD_DHCP, "dhcp-start: drop queued DHCP start of released client");
+	g_hash_table_remove (priv->start.reqs, where_the_object_was);
+}
+
+/*****************************************************************************/
+
+/* Returns whether the manager held a reference to @client, which is
+ * not the case while its start is queued. */
+static gboolean
 remove_client (NMDhcpManager *self, NMDhcpClient *client)
 {
+	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
+	StartRequest *req;
+	gboolean queued;
+
+	req = g_hash_table_lookup (priv->start.reqs, client);
+	queued = req && c_list_is_linked (&req->queue_lst);
+
 	g_signal_handlers_disconnect_by_func (client, client_state_changed, self);
 	c_list_unlink (&client->dhcp_client_lst);
+	_start_request_drop (self, client);
 
 	/* Stopping the client is left up to the controlling device
 	 * explicitly since we may want to quit NetworkManager but not terminate
 	 * the DHCP client.
 	 */
+	return !queued;
 }
 
 static void
 remove_client_unref (NMDhcpManager *self, NMDhcpClient *client)
 {
-	remove_client (self, client);
-	g_object_unref (client);
+	if (remove_client (self, client))
+		g_object_unref (client);
 }
 
 static void
@@ -148,7 +475,9 @@ client_state_changed (NMDhcpClient *client,
                       const char *event_id,
                       NMDhcpManager *self)
 {
-	if (state >= NM_DHCP_STATE_TIMEOUT)
+	if (state == NM_DHCP_STATE_BOUND)
+		_start_request_bound (self, client);
+	else if (state >= NM_DHCP_STATE_TIMEOUT)
 		remove_client_unref (self, client);
 }
 
@@ -177,7 +506,7 @@ client_start (NMDhcpManager *self,
 {
 	NMDhcpManagerPrivate *priv;
 	NMDhcpClient *client;
-	gboolean success = FALSE;
+	StartRequest *req;
 	gsize hwaddr_len;
 
 	g_return_val_if_fail (NM_IS_DHCP_MANAGER (self), NULL);
@@ -209,9 +538,11 @@ client_start (NMDhcpManager *self,
 	/* Kill any old client instance */
 	client = get_client_for_ifindex (self, addr_family, ifindex);
 	if (client) {
-		remove_client (self, client);
-		nm_dhcp_client_stop (client, FALSE);
-		g_object_unref (client);
+		gs_unref_object NMDhcpClient *client_old = g_object_ref (client);
+
+		if (remove_client (self, client_old))
+			g_object_unref (client_old);
+		nm_dhcp_client_stop (client_old, FALSE);
 	}
 
 	client = g_object_new (priv->client_factory->get_type (),
@@ -230,29 +561,35 @@ client_start (NMDhcpManager *self,
 	                       ),
 	                       NULL);
 	nm_assert (client && c_list_is_empty (&client->dhcp_client_lst));
-	c_list_link_tail (&priv->dhcp_client_lst_head, &client->dhcp_client_lst);
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
 
-	if (addr_family == AF_INET) {
-		success = nm_dhcp_client_start_ip4 (client,
-		                                    dhcp_client_id,
-		                                    dhcp_anycast_addr,
-		                                    hostname,
-		                                    last_ip4_address,
-		                                    error);
-	} else {
-		success = nm_dhcp_client_start_ip6 (client,
-		                                    dhcp_client_id,
-		                                    enforce_duid,
-		                                    dhcp_anycast_addr,
-		                                    ipv6_ll_addr,
-		                                    hostname,
-		                                    privacy,
-		                                    needed_prefixes,
-		                                    error);
+	req = g_slice_new0 (StartRequest);
+	req->self = self;
+	req->client = client;
+	c_list_init (&req->queue_lst);
+	req->client_id = dhcp_client_id ? g_bytes_ref (dhcp_client_id) : NULL;
+	req->enforce_duid = enforce_duid;
+	req->anycast_addr = g_strdup (dhcp_anycast_addr);
+	req->hostname = g_strdup (hostname);
+	req->last_ip4_address = g_strdup (last_ip4_address);
+	if (ipv6_ll_addr) {
+		req->ll_addr = *ipv6_ll_addr;
+		req->has_ll_addr = TRUE;
+	}
+	req->privacy = privacy;
+	req->needed_prefixes = needed_prefixes;
+	g_hash_table_insert (priv->start.reqs, client, req);
+
+	if (   !c_list_is_empty (&priv->start.queue_lst_head)
+	    || (   priv->start.limit
+	        && priv->start.n_active >= priv->start.limit)) {
+		/* the caller gets the only reference. */
+		_start_queue_add (self, req);
+		return client;
 	}
 
-	if (!success) {
+	c_list_link_tail (&priv->dhcp_client_lst_head, &client->dhcp_client_lst);
+	if (!_start_request_run (self, req, error)) {
 		remove_client_unref (self, client);
 		return NULL;
 	}
@@ -396,6 +733,21 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 
 	c_list_init (&priv->dhcp_client_lst_head);
 
+	c_list_init (&priv->start.queue_lst_head);
+	priv->start.reqs = g_hash_table_new_full (nm_direct_hash, NULL, NULL, _start_request_free);
+	if (!nm_config_get_configure_and_quit (config)) {
+		priv->start.limit = nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+		                                                    NM_CONFIG_KEYFILE_GROUP_MAIN,
+		                                                    NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_LIMIT,
+		                                                    10, 0, G_MAXUINT32,
+		                                                    START_LIMIT_DEFAULT);
+	}
+	priv->start.jitter_msec = nm_config_data_get_value_int64 (nm_config_get_data_orig (config),
+	                                                          NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                          NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_JITTER,
+	                                                          10, 0, 60000,
+	                                                          START_JITTER_MSEC_DEFAULT);
+
 	for (i = 0; i < G_N_ELEMENTS (_nm_dhcp_manager_factories); i++) {
 		const NMDhcpClientFactory *f = _nm_dhcp_manager_factories[i];
 
@@ -455,10 +807,17 @@ dispose (GObject *object)
 	NMDhcpManager *self = NM_DHCP_MANAGER (object);
 	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE (self);
 	NMDhcpClient *client, *client_safe;
+	StartRequest *req;
 
 	c_list_for_each_entry_safe (client, client_safe, &priv->dhcp_client_lst_head, dhcp_client_lst)
 		remove_client_unref (self, client);
 
+	while ((req = c_list_first_entry (&priv->start.queue_lst_head, StartRequest, queue_lst)))
+		remove_client_unref (self, req->client);
+
+	nm_clear_g_source (&priv->start.queue_id);
+	g_clear_pointer (&priv->start.reqs, g_hash_table_destroy);
+
 	G_OBJECT_CLASS (nm_dhcp_manager_parent_class)->dispose (object);
 
 	nm_clear_g_free (&priv->default_hostname);
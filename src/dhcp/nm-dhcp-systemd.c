@@ -27,6 +27,7 @@
 #include <arpa/inet.h>
 #include <ctype.h>
 #include <net/if_arp.h>
+#include <sys/stat.h>
 
 #include "nm-utils/nm-dedup-multi.h"
 #include "nm-utils/unaligned.h"
@@ -451,6 +452,36 @@ get_leasefile_path (int addr_family, const char *iface, const char *uuid)
 	                        iface);
 }
 
+static gboolean
+has_lease (NMDhcpClient *client)
+{
+	gs_free char *lease_file = NULL;
+	sd_dhcp_lease *lease = NULL;
+	struct stat st;
+	uint32_t lifetime = 0;
+	gboolean valid = FALSE;
+
+	if (nm_dhcp_client_get_addr_family (client) != AF_INET)
+		return FALSE;
+
+	lease_file = get_leasefile_path (AF_INET,
+	                                 nm_dhcp_client_get_iface (client),
+	                                 nm_dhcp_client_get_uuid (client));
+	if (stat (lease_file, &st) != 0)
+		return FALSE;
+
+	/* The lease file is written when the lease is acquired or renewed,
+	 * so its modification time tells when the lifetime started. */
+	if (   dhcp_lease_load (&lease, lease_file) >= 0
+	    && lease
+	    && sd_dhcp_lease_get_lifetime (lease, &lifetime) >= 0)
+		valid = ((gint64) st.st_mtime + lifetime > (gint64) time (NULL));
+
+	if (lease)
+		sd_dhcp_lease_unref (lease);
+	return valid;
+}
+
 /*****************************************************************************/
 
 static void
@@ -1048,6 +1079,7 @@ nm_dhcp_systemd_class_init (NMDhcpSystemdClass *sdhcp_class)
 	client_class->ip4_start = ip4_start;
 	client_class->ip6_start = ip6_start;
 	client_class->stop = stop;
+	client_class->has_lease = has_lease;
 }
 
 const NMDhcpClientFactory _nm_dhcp_client_factory_internal = {
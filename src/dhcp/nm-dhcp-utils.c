@@ -27,6 +27,7 @@
 #include "nm-utils/nm-dedup-multi.h"
 
 #include "nm-dhcp-utils.h"
+#include "nm-dhcp-helper-api.h"
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
 #include "platform/nm-platform.h"
@@ -775,3 +776,77 @@ nm_dhcp_utils_client_id_string_to_bytes (const char *client_id)
 	return bytes;
 }
 
+
+/**
+ * nm_dhcp_utils_helper_event_to_variant:
+ * @buf: a message as sent by nm-dhcp-helper on the event socket
+ * @len: the length of @buf
+ * @error: location for a #GError
+ *
+ * Parses the message as described in nm-dhcp-helper-api.h.
+ *
+ * Returns: a floating "a{sv}" variant with the values as "ay", in the
+ *   same format as the "Notify" D-Bus call, or %NULL on malformed input.
+ */
+GVariant *
+nm_dhcp_utils_helper_event_to_variant (const guint8 *buf, gsize len, GError **error)
+{
+	GVariantBuilder builder;
+	guint32 u32;
+	guint16 u16;
+	gsize pos;
+
+	if (   len < sizeof (u32)
+	    || len > NM_DHCP_HELPER_EVENT_MAX_SIZE) {
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "invalid message size %zu", len);
+		return NULL;
+	}
+
+	memcpy (&u32, buf, sizeof (u32));
+	if (u32 != NM_DHCP_HELPER_EVENT_MAGIC) {
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "invalid message header");
+		return NULL;
+	}
+	pos = sizeof (u32);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	while (pos < len) {
+		gs_free char *name = NULL;
+
+		if (len - pos < sizeof (u16))
+			goto truncated;
+		memcpy (&u16, &buf[pos], sizeof (u16));
+		pos += sizeof (u16);
+		if (   u16 == 0
+		    || len - pos < u16)
+			goto truncated;
+		name = g_strndup ((const char *) &buf[pos], u16);
+		pos += u16;
+		if (   strlen (name) != u16
+		    || !g_utf8_validate (name, -1, NULL))
+			goto truncated;
+
+		if (len - pos < sizeof (u32))
+			goto truncated;
+		memcpy (&u32, &buf[pos], sizeof (u32));
+		pos += sizeof (u32);
+		if (len - pos < u32)
+			goto truncated;
+
+		g_variant_builder_add (&builder, "{sv}",
+		                       name,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &buf[pos], u32, 1));
+		pos += u32;
+	}
+
+	return g_variant_builder_end (&builder);
+
+truncated:
+	g_variant_builder_clear (&builder);
+	g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+	             "malformed message at offset %zu", pos);
+	return NULL;
+}
@@ -43,5 +43,7 @@ char *nm_dhcp_utils_duid_to_string (GBytes *duid);
 
 GBytes *     nm_dhcp_utils_client_id_string_to_bytes (const char *client_id);
 
+GVariant *nm_dhcp_utils_helper_event_to_variant (const guint8 *buf, gsize len, GError **error);
+
 #endif /* __NETWORKMANAGER_DHCP_UTILS_H__ */
 
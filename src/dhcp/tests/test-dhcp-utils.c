@@ -28,6 +28,7 @@
 #include "nm-utils.h"
 
 #include "dhcp/nm-dhcp-utils.h"
+#include "dhcp/nm-dhcp-helper-api.h"
 #include "platform/nm-platform.h"
 
 #include "nm-test-utils-core.h"
@@ -720,6 +721,80 @@ test_client_id_from_string (void)
 	COMPARE_ID (endcolon, TRUE, endcolon, strlen (endcolon));
 }
 
+static void
+_event_append (GByteArray *msg, const char *name, const char *value)
+{
+	guint16 u16 = strlen (name);
+	guint32 u32 = strlen (value);
+
+	g_byte_array_append (msg, (const guint8 *) &u16, sizeof (u16));
+	g_byte_array_append (msg, (const guint8 *) name, u16);
+	g_byte_array_append (msg, (const guint8 *) &u32, sizeof (u32));
+	g_byte_array_append (msg, (const guint8 *) value, u32);
+}
+
+static void
+test_helper_event_parse (void)
+{
+	gs_unref_variant GVariant *v = NULL;
+	gs_unref_variant GVariant *value = NULL;
+	gs_free_error GError *error = NULL;
+	GByteArray *msg;
+	guint32 magic = NM_DHCP_HELPER_EVENT_MAGIC;
+	const guint8 *bytes;
+	gsize len, i;
+
+	msg = g_byte_array_new ();
+	g_byte_array_append (msg, (const guint8 *) &magic, sizeof (magic));
+
+	v = nm_dhcp_utils_helper_event_to_variant (msg->data, msg->len, &error);
+	g_assert_no_error (error);
+	g_assert (v);
+	g_variant_ref_sink (v);
+	g_assert_cmpint (g_variant_n_children (v), ==, 0);
+	g_clear_pointer (&v, g_variant_unref);
+
+	_event_append (msg, "interface", "eth0");
+	_event_append (msg, "reason", "BOUND");
+	_event_append (msg, "empty", "");
+
+	v = nm_dhcp_utils_helper_event_to_variant (msg->data, msg->len, &error);
+	g_assert_no_error (error);
+	g_assert (v);
+	g_variant_ref_sink (v);
+	g_assert_cmpint (g_variant_n_children (v), ==, 3);
+
+	g_assert (g_variant_lookup (v, "interface", "@ay", &value));
+	bytes = g_variant_get_fixed_array (value, &len, 1);
+	g_assert_cmpint (len, ==, 4);
+	g_assert (memcmp (bytes, "eth0", 4) == 0);
+	g_clear_pointer (&value, g_variant_unref);
+
+	g_assert (g_variant_lookup (v, "empty", "@ay", &value));
+	g_variant_get_fixed_array (value, &len, 1);
+	g_assert_cmpint (len, ==, 0);
+	g_clear_pointer (&v, g_variant_unref);
+
+	/* every truncation of a valid message but at record boundaries is invalid */
+	for (i = 0; i < msg->len; i++) {
+		if (NM_IN_SET (i, 4, 4 + 2 + 9 + 4 + 4, 4 + 2 + 9 + 4 + 4 + 2 + 6 + 4 + 5))
+			continue;
+		v = nm_dhcp_utils_helper_event_to_variant (msg->data, i, &error);
+		g_assert (!v);
+		g_assert (error);
+		g_clear_error (&error);
+	}
+
+	/* bad magic */
+	msg->data[0] ^= 0xFF;
+	v = nm_dhcp_utils_helper_event_to_variant (msg->data, msg->len, &error);
+	g_assert (!v);
+	g_assert (error);
+	g_clear_error (&error);
+
+	g_byte_array_unref (msg);
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -746,6 +821,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/dhcp/ip4-missing-prefix-8", test_ip4_missing_prefix_8);
 	g_test_add_func ("/dhcp/ip4-prefix-classless", test_ip4_prefix_classless);
 	g_test_add_func ("/dhcp/client-id-from-string", test_client_id_from_string);
+	g_test_add_func ("/dhcp/helper-event-parse", test_helper_event_parse);
 	g_test_add_func ("/dhcp/vendor-option-metered", test_vendor_option_metered);
 
 	return g_test_run ();
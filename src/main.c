@@ -46,6 +46,7 @@
 #include "nm-session-monitor.h"
 #include "nm-dispatcher.h"
 #include "settings/nm-settings.h"
+#include "settings/nm-settings-connection.h"
 #include "nm-auth-manager.h"
 #include "nm-core-internal.h"
 #include "nm-dbus-object.h"
@@ -388,7 +389,10 @@ main (int argc, char *argv[])
 	             );
 
 	/* Set up platform interaction layer */
-	nm_linux_platform_setup ();
+	nm_linux_platform_setup_full (nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                                                NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                NM_CONFIG_KEYFILE_KEY_MAIN_COMPACT_FOREIGN_ROUTES,
+	                                                                FALSE));
 
 	NM_UTILS_KEEP_ALIVE (config, nm_netns_get (), "NMConfig-depends-on-NMNetns");
 
@@ -447,6 +451,8 @@ done:
 
 	nm_manager_stop (manager);
 
+	nm_settings_connection_flush_state_db ();
+
 	nm_config_state_set (config, TRUE, TRUE);
 
 	nm_dns_manager_stop (nm_dns_manager_get ());
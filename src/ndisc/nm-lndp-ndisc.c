@@ -38,11 +38,26 @@
 
 /*****************************************************************************/
 
+/* All NMLndpNDisc instances of one network namespace share a single libndp
+ * socket. Each instance only registers its ifindex in the lookup table
+ * of the node type it serves, and the shared receive handlers dispatch
+ * the incoming messages to the right instance. */
 typedef struct {
+	NMPNetns *netns;
 	struct ndp *ndp;
 
 	GIOChannel *event_channel;
 	guint event_id;
+
+	/* ifindex -> NMNDisc */
+	GHashTable *ndiscs_ra;
+	GHashTable *ndiscs_rs;
+
+	int ref_count;
+} NdpShared;
+
+typedef struct {
+	NdpShared *shared;
 } NMLndpNDiscPrivate;
 
 /*****************************************************************************/
@@ -80,7 +95,7 @@ send_rs (NMNDisc *ndisc, GError **error)
 	}
 	ndp_msg_ifindex_set (msg, nm_ndisc_get_ifindex (ndisc));
 
-	errsv = ndp_msg_send (priv->ndp, msg);
+	errsv = ndp_msg_send (priv->shared->ndp, msg);
 	ndp_msg_destroy (msg);
 	if (errsv) {
 		errsv = errsv > 0 ? errsv : -errsv;
@@ -465,7 +480,7 @@ send_ra (NMNDisc *ndisc, GError **error)
 		}
 	}
 
-	errsv = ndp_msg_send (priv->ndp, msg);
+	errsv = ndp_msg_send (priv->shared->ndp, msg);
 
 	ndp_msg_destroy (msg);
 	if (errsv) {
@@ -488,46 +503,153 @@ receive_rs (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
 	return 0;
 }
 
+/*****************************************************************************/
+
+static GHashTable *_ndp_shared_by_netns = NULL;
+
+static int
+_shared_receive_ra (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
+{
+	NdpShared *shared = user_data;
+	NMNDisc *ndisc;
+
+	ndisc = g_hash_table_lookup (shared->ndiscs_ra, GINT_TO_POINTER ((int) ndp_msg_ifindex (msg)));
+	if (!ndisc)
+		return 0;
+	return receive_ra (ndp, msg, ndisc);
+}
+
+static int
+_shared_receive_rs (struct ndp *ndp, struct ndp_msg *msg, gpointer user_data)
+{
+	NdpShared *shared = user_data;
+	NMNDisc *ndisc;
+
+	ndisc = g_hash_table_lookup (shared->ndiscs_rs, GINT_TO_POINTER ((int) ndp_msg_ifindex (msg)));
+	if (!ndisc)
+		return 0;
+	return receive_rs (ndp, msg, ndisc);
+}
+
 static gboolean
-event_ready (GIOChannel *source, GIOCondition condition, NMNDisc *ndisc)
+_shared_event_ready (GIOChannel *source, GIOCondition condition, gpointer user_data)
 {
-	nm_auto_pop_netns NMPNetns *netns = NULL;
-	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
+	NdpShared *shared = user_data;
 
-	_LOGD ("processing libndp events");
+	nm_log_dbg (LOGD_IP6, "ndisc-lndp: processing libndp events");
 
-	if (!nm_ndisc_netns_push (ndisc, &netns))
+	if (shared->netns && !nmp_netns_push (shared->netns))
 		return G_SOURCE_CONTINUE;
 
-	ndp_callall_eventfd_handler (priv->ndp);
+	ndp_callall_eventfd_handler (shared->ndp);
+
+	if (shared->netns)
+		nmp_netns_pop (shared->netns);
 	return G_SOURCE_CONTINUE;
 }
 
+static NdpShared *
+_shared_acquire (NMPNetns *netns, GError **error)
+{
+	NdpShared *shared;
+	int errsv;
+
+	if (G_UNLIKELY (!_ndp_shared_by_netns))
+		_ndp_shared_by_netns = g_hash_table_new (nm_direct_hash, NULL);
+
+	shared = g_hash_table_lookup (_ndp_shared_by_netns, netns);
+	if (shared) {
+		shared->ref_count++;
+		return shared;
+	}
+
+	shared = g_slice_new0 (NdpShared);
+	errsv = ndp_open (&shared->ndp);
+	if (errsv != 0) {
+		errsv = errsv > 0 ? errsv : -errsv;
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "failure creating libndp socket: %s (%d)",
+		             g_strerror (errsv), errsv);
+		g_slice_free (NdpShared, shared);
+		return NULL;
+	}
+
+	shared->ref_count = 1;
+	shared->netns = netns ? g_object_ref (netns) : NULL;
+	shared->ndiscs_ra = g_hash_table_new (nm_direct_hash, NULL);
+	shared->ndiscs_rs = g_hash_table_new (nm_direct_hash, NULL);
+
+	ndp_msgrcv_handler_register (shared->ndp, _shared_receive_ra, NDP_MSG_RA, 0, shared);
+	ndp_msgrcv_handler_register (shared->ndp, _shared_receive_rs, NDP_MSG_RS, 0, shared);
+
+	shared->event_channel = g_io_channel_unix_new (ndp_get_eventfd (shared->ndp));
+	shared->event_id = g_io_add_watch (shared->event_channel, G_IO_IN, _shared_event_ready, shared);
+
+	g_hash_table_insert (_ndp_shared_by_netns, netns, shared);
+	return shared;
+}
+
 static void
-start (NMNDisc *ndisc)
+_shared_release (NdpShared *shared)
 {
-	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
-	int fd = ndp_get_eventfd (priv->ndp);
+	nm_assert (shared);
+	nm_assert (shared->ref_count > 0);
 
-	g_return_if_fail (!priv->event_channel);
-	g_return_if_fail (!priv->event_id);
+	if (--shared->ref_count > 0)
+		return;
 
-	priv->event_channel = g_io_channel_unix_new (fd);
-	priv->event_id = g_io_add_watch (priv->event_channel, G_IO_IN, (GIOFunc) event_ready, ndisc);
+	nm_assert (g_hash_table_size (shared->ndiscs_ra) == 0);
+	nm_assert (g_hash_table_size (shared->ndiscs_rs) == 0);
 
-	/* Flush any pending messages to avoid using obsolete information */
-	event_ready (priv->event_channel, 0, ndisc);
+	g_hash_table_remove (_ndp_shared_by_netns, shared->netns);
+
+	nm_clear_g_source (&shared->event_id);
+	g_clear_pointer (&shared->event_channel, g_io_channel_unref);
+
+	ndp_msgrcv_handler_unregister (shared->ndp, _shared_receive_ra, NDP_MSG_RA, 0, shared);
+	ndp_msgrcv_handler_unregister (shared->ndp, _shared_receive_rs, NDP_MSG_RS, 0, shared);
+	ndp_close (shared->ndp);
 
+	g_hash_table_unref (shared->ndiscs_ra);
+	g_hash_table_unref (shared->ndiscs_rs);
+	g_clear_object (&shared->netns);
+	g_slice_free (NdpShared, shared);
+}
+
+static GHashTable *
+_shared_get_ndiscs (NdpShared *shared, NMNDisc *ndisc)
+{
 	switch (nm_ndisc_get_node_type (ndisc)) {
 	case NM_NDISC_NODE_TYPE_HOST:
-		ndp_msgrcv_handler_register (priv->ndp, receive_ra, NDP_MSG_RA, nm_ndisc_get_ifindex (ndisc), ndisc);
-		break;
+		return shared->ndiscs_ra;
 	case NM_NDISC_NODE_TYPE_ROUTER:
-		ndp_msgrcv_handler_register (priv->ndp, receive_rs, NDP_MSG_RS, nm_ndisc_get_ifindex (ndisc), ndisc);
-		break;
+		return shared->ndiscs_rs;
 	default:
 		g_assert_not_reached ();
 	}
+	return NULL;
+}
+
+/*****************************************************************************/
+
+static void
+start (NMNDisc *ndisc)
+{
+	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
+	GHashTable *ndiscs;
+	int ifindex = nm_ndisc_get_ifindex (ndisc);
+
+	g_return_if_fail (priv->shared);
+
+	ndiscs = _shared_get_ndiscs (priv->shared, ndisc);
+	g_return_if_fail (g_hash_table_lookup (ndiscs, GINT_TO_POINTER (ifindex)) != ndisc);
+
+	/* Flush any pending messages to avoid using obsolete information */
+	_shared_event_ready (priv->shared->event_channel, 0, priv->shared);
+
+	if (g_hash_table_lookup (ndiscs, GINT_TO_POINTER (ifindex)))
+		_LOGD ("replacing previous instance for ifindex %d", ifindex);
+	g_hash_table_insert (ndiscs, GINT_TO_POINTER (ifindex), ndisc);
 }
 
 /*****************************************************************************/
@@ -562,8 +684,7 @@ nm_lndp_ndisc_new (NMPlatform *platform,
 {
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	NMNDisc *ndisc;
-	NMLndpNDiscPrivate *priv;
-	int errsv;
+	NdpShared *shared;
 
 	g_return_val_if_fail (NM_IS_PLATFORM (platform), NULL);
 	g_return_val_if_fail (!error || !*error, NULL);
@@ -591,18 +712,12 @@ nm_lndp_ndisc_new (NMPlatform *platform,
 	                                                                              1, G_MAXINT32, NM_NDISC_ROUTER_SOLICITATION_INTERVAL_DEFAULT),
 	                      NULL);
 
-	priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
-
-	errsv = ndp_open (&priv->ndp);
-
-	if (errsv != 0) {
-		errsv = errsv > 0 ? errsv : -errsv;
-		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
-		             "failure creating libndp socket: %s (%d)",
-		             g_strerror (errsv), errsv);
+	shared = _shared_acquire (nm_platform_netns_get (platform), error);
+	if (!shared) {
 		g_object_unref (ndisc);
 		return NULL;
 	}
+	NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc)->shared = shared;
 	return ndisc;
 }
 
@@ -612,22 +727,13 @@ dispose (GObject *object)
 	NMNDisc *ndisc = (NMNDisc *) object;
 	NMLndpNDiscPrivate *priv = NM_LNDP_NDISC_GET_PRIVATE ((NMLndpNDisc *) ndisc);
 
-	nm_clear_g_source (&priv->event_id);
-	g_clear_pointer (&priv->event_channel, g_io_channel_unref);
+	if (priv->shared) {
+		GHashTable *ndiscs = _shared_get_ndiscs (priv->shared, ndisc);
+		gpointer key = GINT_TO_POINTER (nm_ndisc_get_ifindex (ndisc));
 
-	if (priv->ndp) {
-		switch (nm_ndisc_get_node_type (ndisc)) {
-		case NM_NDISC_NODE_TYPE_HOST:
-			ndp_msgrcv_handler_unregister (priv->ndp, receive_ra, NDP_MSG_RA, nm_ndisc_get_ifindex (ndisc), ndisc);
-			break;
-		case NM_NDISC_NODE_TYPE_ROUTER:
-			ndp_msgrcv_handler_unregister (priv->ndp, receive_rs, NDP_MSG_RS, nm_ndisc_get_ifindex (ndisc), ndisc);
-			break;
-		default:
-			g_assert_not_reached ();
-		}
-		ndp_close (priv->ndp);
-		priv->ndp = NULL;
+		if (g_hash_table_lookup (ndiscs, key) == ndisc)
+			g_hash_table_remove (ndiscs, key);
+		_shared_release (g_steal_pointer (&priv->shared));
 	}
 
 	G_OBJECT_CLASS (nm_lndp_ndisc_parent_class)->dispose (object);
@@ -37,6 +37,15 @@
 
 /*****************************************************************************/
 
+typedef enum {
+	STORE_GATEWAYS,
+	STORE_ADDRESSES,
+	STORE_ROUTES,
+	STORE_DNS_SERVERS,
+	STORE_DNS_DOMAINS,
+	_STORE_NUM,
+} StoreType;
+
 struct _NMNDiscPrivate {
 	/* this *must* be the first field. */
 	NMNDiscDataInternal rdata;
@@ -71,6 +80,14 @@ struct _NMNDiscPrivate {
 
 	NMPlatform *platform;
 	NMPNetns *netns;
+
+	/* The RA items, see StoreEntry. */
+	struct {
+		GHashTable *idx[_STORE_NUM];
+		GPtrArray *heap;
+		guint64 seq;
+		guint dirty;
+	} store;
 };
 
 typedef struct _NMNDiscPrivate NMNDiscPrivate;
@@ -178,6 +195,409 @@ nm_ndisc_get_node_type (NMNDisc *self)
 
 /*****************************************************************************/
 
+static gint32
+get_expiry_time (guint32 timestamp, guint32 lifetime)
+{
+	gint64 t;
+
+	/* timestamp is supposed to come from nm_utils_get_monotonic_timestamp_s().
+	 * It is expected to be within a certain range. */
+	nm_assert (timestamp > 0);
+	nm_assert (timestamp <= G_MAXINT32);
+
+	if (lifetime == NM_NDISC_INFINITY)
+		return G_MAXINT32;
+
+	t = (gint64) timestamp + (gint64) lifetime;
+	return CLAMP (t, 0, G_MAXINT32 - 1);
+}
+
+#define get_expiry(item) \
+	({ \
+		typeof (item) _item = (item); \
+		nm_assert (_item); \
+		get_expiry_time ((_item->timestamp), (_item->lifetime)); \
+	})
+
+#define get_expiry_half(item) \
+	({ \
+		typeof (item) _item = (item); \
+		nm_assert (_item); \
+		get_expiry_time ((_item->timestamp),\
+		                 (_item->lifetime) == NM_NDISC_INFINITY \
+		                   ? NM_NDISC_INFINITY \
+		                   : (_item->lifetime) / 2); \
+	})
+
+/*****************************************************************************/
+
+/* The RA items are kept in a store with one hash table per kind of item,
+ * indexed by the key of the item (address, network/plen or domain), and
+ * a min-heap of the deadlines at which an item needs attention. That is
+ * when it expires or, for DNS items, when it should be refreshed. So an RA
+ * with many options and a lifetime timeout only touch the items they concern.
+ *
+ * The GArrays of NMNDiscDataInternal are only a snapshot of the store that
+ * is rebuilt for the kinds of items that changed, before the data is
+ * exposed. */
+
+typedef struct {
+	guint64 seq;
+	gint32 deadline;
+	guint heap_idx;
+	StoreType type:8;
+	bool refresh_pending:1;
+	union {
+		NMNDiscGateway gateway;
+		NMNDiscAddress address;
+		NMNDiscRoute route;
+		NMNDiscDNSServer dns_server;
+		NMNDiscDNSDomain dns_domain;
+	};
+} StoreEntry;
+
+static const NMNDiscConfigMap _store_config_map[_STORE_NUM] = {
+	[STORE_GATEWAYS]    = NM_NDISC_CONFIG_GATEWAYS,
+	[STORE_ADDRESSES]   = NM_NDISC_CONFIG_ADDRESSES,
+	[STORE_ROUTES]      = NM_NDISC_CONFIG_ROUTES,
+	[STORE_DNS_SERVERS] = NM_NDISC_CONFIG_DNS_SERVERS,
+	[STORE_DNS_DOMAINS] = NM_NDISC_CONFIG_DNS_DOMAINS,
+};
+
+static const gsize _store_item_size[_STORE_NUM] = {
+	[STORE_GATEWAYS]    = sizeof (NMNDiscGateway),
+	[STORE_ADDRESSES]   = sizeof (NMNDiscAddress),
+	[STORE_ROUTES]      = sizeof (NMNDiscRoute),
+	[STORE_DNS_SERVERS] = sizeof (NMNDiscDNSServer),
+	[STORE_DNS_DOMAINS] = sizeof (NMNDiscDNSDomain),
+};
+
+static guint
+_store_entry_hash (gconstpointer ptr)
+{
+	const StoreEntry *item = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1648934069u);
+	switch (item->type) {
+	case STORE_GATEWAYS:
+		nm_hash_update_val (&h, item->gateway.address);
+		break;
+	case STORE_ADDRESSES:
+		nm_hash_update_val (&h, item->address.address);
+		break;
+	case STORE_ROUTES:
+		nm_hash_update_val (&h, item->route.network);
+		nm_hash_update_val (&h, item->route.plen);
+		break;
+	case STORE_DNS_SERVERS:
+		nm_hash_update_val (&h, item->dns_server.address);
+		break;
+	case STORE_DNS_DOMAINS:
+		nm_hash_update_str0 (&h, item->dns_domain.domain);
+		break;
+	default:
+		nm_assert_not_reached ();
+	}
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_store_entry_equal (gconstpointer pa, gconstpointer pb)
+{
+	const StoreEntry *a = pa;
+	const StoreEntry *b = pb;
+
+	nm_assert (a->type == b->type);
+
+	switch (a->type) {
+	case STORE_GATEWAYS:
+		return IN6_ARE_ADDR_EQUAL (&a->gateway.address, &b->gateway.address);
+	case STORE_ADDRESSES:
+		return IN6_ARE_ADDR_EQUAL (&a->address.address, &b->address.address);
+	case STORE_ROUTES:
+		return    IN6_ARE_ADDR_EQUAL (&a->route.network, &b->route.network)
+		       && a->route.plen == b->route.plen;
+	case STORE_DNS_SERVERS:
+		return IN6_ARE_ADDR_EQUAL (&a->dns_server.address, &b->dns_server.address);
+	case STORE_DNS_DOMAINS:
+		return nm_streq0 (a->dns_domain.domain, b->dns_domain.domain);
+	default:
+		nm_assert_not_reached ();
+	}
+	return FALSE;
+}
+
+static void
+_store_entry_free (gpointer data)
+{
+	StoreEntry *item = data;
+
+	nm_assert (item->heap_idx == G_MAXUINT);
+
+	if (item->type == STORE_DNS_DOMAINS)
+		g_free (item->dns_domain.domain);
+	g_slice_free (StoreEntry, item);
+}
+
+static gint32
+_store_entry_get_expiry (const StoreEntry *item)
+{
+	switch (item->type) {
+	case STORE_GATEWAYS:
+		return get_expiry (&item->gateway);
+	case STORE_ADDRESSES:
+		return get_expiry (&item->address);
+	case STORE_ROUTES:
+		return get_expiry (&item->route);
+	case STORE_DNS_SERVERS:
+		return get_expiry (&item->dns_server);
+	case STORE_DNS_DOMAINS:
+		return get_expiry (&item->dns_domain);
+	default:
+		nm_assert_not_reached ();
+	}
+	return G_MAXINT32;
+}
+
+/* DNS items are refreshed by soliciting a new RA at half of their lifetime. */
+static gint32
+_store_entry_get_refresh (const StoreEntry *item)
+{
+	switch (item->type) {
+	case STORE_DNS_SERVERS:
+		return get_expiry_half (&item->dns_server);
+	case STORE_DNS_DOMAINS:
+		return get_expiry_half (&item->dns_domain);
+	default:
+		return G_MAXINT32;
+	}
+}
+
+static int
+_store_entry_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	const StoreEntry *a = *((const StoreEntry *const*) pa);
+	const StoreEntry *b = *((const StoreEntry *const*) pb);
+
+	switch (a->type) {
+	case STORE_GATEWAYS:
+		/* more preferable gateways first, in the order they were added. */
+		NM_CMP_DIRECT (_preference_to_priority (b->gateway.preference),
+		               _preference_to_priority (a->gateway.preference));
+		NM_CMP_FIELD (a, b, seq);
+		return 0;
+	case STORE_ROUTES:
+		/* more preferable routes first, the most recently added first. */
+		NM_CMP_DIRECT (_preference_to_priority (b->route.preference),
+		               _preference_to_priority (a->route.preference));
+		NM_CMP_FIELD (b, a, seq);
+		return 0;
+	default:
+		NM_CMP_FIELD (a, b, seq);
+		return 0;
+	}
+}
+
+/*****************************************************************************/
+
+static void
+_heap_swap (GPtrArray *heap, guint a, guint b)
+{
+	StoreEntry *item_a = heap->pdata[a];
+	StoreEntry *item_b = heap->pdata[b];
+
+	heap->pdata[a] = item_b;
+	heap->pdata[b] = item_a;
+	item_b->heap_idx = a;
+	item_a->heap_idx = b;
+}
+
+#define _heap_deadline(heap, i) (((StoreEntry *) (heap)->pdata[(i)])->deadline)
+
+static void
+_heap_sift (GPtrArray *heap, guint idx)
+{
+	while (idx > 0) {
+		guint parent = (idx - 1) / 2;
+
+		if (_heap_deadline (heap, parent) <= _heap_deadline (heap, idx))
+			break;
+		_heap_swap (heap, idx, parent);
+		idx = parent;
+	}
+
+	for (;;) {
+		guint l = 2 * idx + 1;
+		guint r = l + 1;
+		guint m = idx;
+
+		if (l < heap->len && _heap_deadline (heap, l) < _heap_deadline (heap, m))
+			m = l;
+		if (r < heap->len && _heap_deadline (heap, r) < _heap_deadline (heap, m))
+			m = r;
+		if (m == idx)
+			break;
+		_heap_swap (heap, idx, m);
+		idx = m;
+	}
+}
+
+static void
+_heap_remove (GPtrArray *heap, StoreEntry *item)
+{
+	guint idx = item->heap_idx;
+	guint last;
+
+	if (idx == G_MAXUINT)
+		return;
+
+	nm_assert (idx < heap->len && heap->pdata[idx] == item);
+
+	last = heap->len - 1;
+	if (idx != last)
+		_heap_swap (heap, idx, last);
+	g_ptr_array_set_size (heap, last);
+	item->heap_idx = G_MAXUINT;
+	if (idx != last)
+		_heap_sift (heap, idx);
+}
+
+static void
+_heap_set_deadline (GPtrArray *heap, StoreEntry *item, gint32 deadline)
+{
+	item->deadline = deadline;
+
+	if (deadline == G_MAXINT32) {
+		/* infinite lifetime, nothing to do. */
+		_heap_remove (heap, item);
+		return;
+	}
+
+	if (item->heap_idx == G_MAXUINT) {
+		item->heap_idx = heap->len;
+		g_ptr_array_add (heap, item);
+	}
+	_heap_sift (heap, item->heap_idx);
+}
+
+/*****************************************************************************/
+
+static StoreEntry *
+_store_lookup (NMNDiscPrivate *priv, StoreType type, gconstpointer key)
+{
+	StoreEntry needle;
+
+	needle.type = type;
+	memcpy (&needle.gateway, key, _store_item_size[type]);
+	return g_hash_table_lookup (priv->store.idx[type], &needle);
+}
+
+/* Must be called after the item of @item was modified. */
+static void
+_store_entry_changed (NMNDiscPrivate *priv, StoreEntry *item)
+{
+	gint32 refresh = _store_entry_get_refresh (item);
+
+	item->refresh_pending = (refresh != G_MAXINT32);
+	_heap_set_deadline (priv->store.heap,
+	                    item,
+	                    item->refresh_pending
+	                      ? refresh
+	                      : _store_entry_get_expiry (item));
+	priv->store.dirty |= (1u << item->type);
+}
+
+static StoreEntry *
+_store_add (NMNDiscPrivate *priv, StoreType type, gconstpointer data)
+{
+	StoreEntry *item;
+
+	item = g_slice_new0 (StoreEntry);
+	item->type = type;
+	item->seq = ++priv->store.seq;
+	item->heap_idx = G_MAXUINT;
+	memcpy (&item->gateway, data, _store_item_size[type]);
+	if (type == STORE_DNS_DOMAINS)
+		item->dns_domain.domain = g_strdup (item->dns_domain.domain);
+
+	g_hash_table_add (priv->store.idx[type], item);
+	_store_entry_changed (priv, item);
+	return item;
+}
+
+static void
+_store_remove (NMNDiscPrivate *priv, StoreEntry *item)
+{
+	priv->store.dirty |= (1u << item->type);
+	_heap_remove (priv->store.heap, item);
+	g_hash_table_remove (priv->store.idx[item->type], item);
+}
+
+static void
+_store_clear (NMNDiscPrivate *priv, StoreType type)
+{
+	GHashTableIter iter;
+	StoreEntry *item;
+
+	g_hash_table_iter_init (&iter, priv->store.idx[type]);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &item, NULL))
+		_heap_remove (priv->store.heap, item);
+	g_hash_table_remove_all (priv->store.idx[type]);
+	priv->store.dirty |= (1u << type);
+}
+
+static GArray *
+_store_get_snapshot (NMNDiscDataInternal *rdata, StoreType type)
+{
+	switch (type) {
+	case STORE_GATEWAYS:
+		return rdata->gateways;
+	case STORE_ADDRESSES:
+		return rdata->addresses;
+	case STORE_ROUTES:
+		return rdata->routes;
+	case STORE_DNS_SERVERS:
+		return rdata->dns_servers;
+	case STORE_DNS_DOMAINS:
+		return rdata->dns_domains;
+	default:
+		nm_assert_not_reached ();
+	}
+	return NULL;
+}
+
+static void
+_store_sync (NMNDiscPrivate *priv)
+{
+	StoreType type;
+
+	if (!priv->store.dirty)
+		return;
+
+	for (type = 0; type < _STORE_NUM; type++) {
+		gs_free StoreEntry **items = NULL;
+		GArray *arr;
+		guint i, n;
+
+		if (!NM_FLAGS_ANY (priv->store.dirty, (1u << type)))
+			continue;
+
+		arr = _store_get_snapshot (&priv->rdata, type);
+		items = (StoreEntry **) g_hash_table_get_keys_as_array (priv->store.idx[type], &n);
+		if (n > 1)
+			g_qsort_with_data (items, n, sizeof (StoreEntry *), _store_entry_cmp, NULL);
+
+		/* The snapshot borrows the domain strings from the store. */
+		g_array_set_size (arr, n);
+		for (i = 0; i < n; i++)
+			memcpy (arr->data + i * _store_item_size[type], &items[i]->gateway, _store_item_size[type]);
+	}
+	priv->store.dirty = 0;
+}
+
+/*****************************************************************************/
+
 static void
 _ASSERT_data_gateways (const NMNDiscDataInternal *data)
 {
@@ -211,8 +631,11 @@ _ASSERT_data_gateways (const NMNDiscDataInternal *data)
 /*****************************************************************************/
 
 static const NMNDiscData *
-_data_complete (NMNDiscDataInternal *data)
+_data_complete (NMNDiscPrivate *priv)
 {
+	NMNDiscDataInternal *data = &priv->rdata;
+
+	_store_sync (priv);
 	_ASSERT_data_gateways (data);
 
 #define _SET(data, field) \
@@ -234,9 +657,12 @@ _data_complete (NMNDiscDataInternal *data)
 void
 nm_ndisc_emit_config_change (NMNDisc *self, NMNDiscConfigMap changed)
 {
+	const NMNDiscData *rdata;
+
+	rdata = _data_complete (NM_NDISC_GET_PRIVATE (self));
 	_config_changed_log (self, changed);
 	g_signal_emit (self, signals[CONFIG_RECEIVED], 0,
-	               _data_complete (&NM_NDISC_GET_PRIVATE (self)->rdata),
+	               rdata,
 	               (guint) changed);
 }
 
@@ -245,46 +671,28 @@ nm_ndisc_emit_config_change (NMNDisc *self, NMNDiscConfigMap changed)
 gboolean
 nm_ndisc_add_gateway (NMNDisc *ndisc, const NMNDiscGateway *new)
 {
-	NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-	guint i;
-	guint insert_idx = G_MAXUINT;
-
-	for (i = 0; i < rdata->gateways->len; ) {
-		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->gateways, i);
-				_ASSERT_data_gateways (rdata);
-				return TRUE;
-			}
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	StoreEntry *item;
 
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->gateways, i);
-				continue;
-			}
+	item = _store_lookup (priv, STORE_GATEWAYS, new);
+	if (item) {
+		if (new->lifetime == 0) {
+			_store_remove (priv, item);
+			return TRUE;
+		}
 
-			*item = *new;
-			_ASSERT_data_gateways (rdata);
+		if (item->gateway.preference == new->preference) {
+			item->gateway = *new;
+			_store_entry_changed (priv, item);
 			return FALSE;
 		}
 
-		/* Put before less preferable gateways. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
-
-		i++;
+		/* Re-add it after the gateways of the new preference. */
+		_store_remove (priv, item);
 	}
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->gateways,
-		                    insert_idx == G_MAXUINT
-		                      ? rdata->gateways->len
-		                      : insert_idx,
-		                    *new);
-	}
-	_ASSERT_data_gateways (rdata);
+	if (new->lifetime)
+		_store_add (priv, STORE_GATEWAYS, new);
 	return !!new->lifetime;
 }
 
@@ -346,30 +754,27 @@ static gboolean
 nm_ndisc_add_address (NMNDisc *ndisc, const NMNDiscAddress *new)
 {
 	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
-	NMNDiscDataInternal *rdata = &priv->rdata;
-	guint i;
+	StoreEntry *item;
 
 	nm_assert (new);
 	nm_assert (new->timestamp > 0 && new->timestamp < G_MAXINT32);
 	nm_assert (!IN6_IS_ADDR_UNSPECIFIED (&new->address));
 	nm_assert (!IN6_IS_ADDR_LINKLOCAL (&new->address));
 
-	for (i = 0; i < rdata->addresses->len; i++) {
-		NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			gboolean changed;
-
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->addresses, i);
-				return TRUE;
-			}
+	item = _store_lookup (priv, STORE_ADDRESSES, new);
+	if (item) {
+		gboolean changed;
 
-			changed = item->timestamp + item->lifetime  != new->timestamp + new->lifetime ||
-			          item->timestamp + item->preferred != new->timestamp + new->preferred;
-			*item = *new;
-			return changed;
+		if (new->lifetime == 0) {
+			_store_remove (priv, item);
+			return TRUE;
 		}
+
+		changed = item->address.timestamp + item->address.lifetime  != new->timestamp + new->lifetime ||
+		          item->address.timestamp + item->address.preferred != new->timestamp + new->preferred;
+		item->address = *new;
+		_store_entry_changed (priv, item);
+		return changed;
 	}
 
 	/* we create at most max_addresses autoconf addresses. This is different from
@@ -377,11 +782,11 @@ nm_ndisc_add_address (NMNDisc *ndisc, const NMNDiscAddress *new)
 	 * static and other temporary addresses).
 	 **/
 	if (   priv->max_addresses
-	    && rdata->addresses->len >= priv->max_addresses)
+	    && g_hash_table_size (priv->store.idx[STORE_ADDRESSES]) >= priv->max_addresses)
 		return FALSE;
 
 	if (new->lifetime)
-		g_array_append_val (rdata->addresses, *new);
+		_store_add (priv, STORE_ADDRESSES, new);
 	return !!new->lifetime;
 }
 
@@ -398,9 +803,7 @@ gboolean
 nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 {
 	NMNDiscPrivate *priv;
-	NMNDiscDataInternal *rdata;
-	guint i;
-	guint insert_idx = G_MAXUINT;
+	StoreEntry *item;
 
 	if (new->plen == 0 || new->plen > 128) {
 		/* Only expect non-default routes.  The router has no idea what the
@@ -414,72 +817,50 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	}
 
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
-	rdata = &priv->rdata;
-
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
 
-		if (IN6_ARE_ADDR_EQUAL (&item->network, &new->network) && item->plen == new->plen) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->routes, i);
-				return TRUE;
-			}
-
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->routes, i);
-				continue;
-			}
+	item = _store_lookup (priv, STORE_ROUTES, new);
+	if (item) {
+		if (new->lifetime == 0) {
+			_store_remove (priv, item);
+			return TRUE;
+		}
 
-			memcpy (item, new, sizeof (*new));
+		if (item->route.preference == new->preference) {
+			item->route = *new;
+			_store_entry_changed (priv, item);
 			return FALSE;
 		}
 
-		/* Put before less preferable routes. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
-
-		i++;
+		_store_remove (priv, item);
 	}
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->routes,
-		                    insert_idx == G_MAXUINT
-		                      ? 0u
-		                      : insert_idx,
-		                    *new);
-	}
+	if (new->lifetime)
+		_store_add (priv, STORE_ROUTES, new);
 	return !!new->lifetime;
 }
 
 gboolean
 nm_ndisc_add_dns_server (NMNDisc *ndisc, const NMNDiscDNSServer *new)
 {
-	NMNDiscPrivate *priv;
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	priv = NM_NDISC_GET_PRIVATE (ndisc);
-	rdata = &priv->rdata;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	StoreEntry *item;
 
-	for (i = 0; i < rdata->dns_servers->len; i++) {
-		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->dns_servers, i);
-				return TRUE;
-			}
-			if (item->timestamp != new->timestamp || item->lifetime != new->lifetime) {
-				*item = *new;
-				return TRUE;
-			}
-			return FALSE;
+	item = _store_lookup (priv, STORE_DNS_SERVERS, new);
+	if (item) {
+		if (new->lifetime == 0) {
+			_store_remove (priv, item);
+			return TRUE;
+		}
+		if (item->dns_server.timestamp != new->timestamp || item->dns_server.lifetime != new->lifetime) {
+			item->dns_server = *new;
+			_store_entry_changed (priv, item);
+			return TRUE;
 		}
+		return FALSE;
 	}
 
 	if (new->lifetime)
-		g_array_append_val (rdata->dns_servers, *new);
+		_store_add (priv, STORE_DNS_SERVERS, new);
 	return !!new->lifetime;
 }
 
@@ -487,42 +868,30 @@ nm_ndisc_add_dns_server (NMNDisc *ndisc, const NMNDiscDNSServer *new)
 gboolean
 nm_ndisc_add_dns_domain (NMNDisc *ndisc, const NMNDiscDNSDomain *new)
 {
-	NMNDiscPrivate *priv;
-	NMNDiscDataInternal *rdata;
-	NMNDiscDNSDomain *item;
-	guint i;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	StoreEntry *item;
 
-	priv = NM_NDISC_GET_PRIVATE (ndisc);
-	rdata = &priv->rdata;
+	item = _store_lookup (priv, STORE_DNS_DOMAINS, new);
+	if (item) {
+		gboolean changed;
 
-	for (i = 0; i < rdata->dns_domains->len; i++) {
-		item = &g_array_index (rdata->dns_domains, NMNDiscDNSDomain, i);
-
-		if (!g_strcmp0 (item->domain, new->domain)) {
-			gboolean changed;
-
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->dns_domains, i);
-				return TRUE;
-			}
-
-			changed = (item->timestamp != new->timestamp ||
-			           item->lifetime != new->lifetime);
-			if (changed) {
-				item->timestamp = new->timestamp;
-				item->lifetime = new->lifetime;
-			}
-			return changed;
+		if (new->lifetime == 0) {
+			_store_remove (priv, item);
+			return TRUE;
 		}
-	}
 
-	if (new->lifetime) {
-		g_array_append_val (rdata->dns_domains, *new);
-		item = &g_array_index (rdata->dns_domains,
-		                       NMNDiscDNSDomain,
-		                       rdata->dns_domains->len - 1);
-		item->domain = g_strdup (new->domain);
+		changed = (item->dns_domain.timestamp != new->timestamp ||
+		           item->dns_domain.lifetime != new->lifetime);
+		if (changed) {
+			item->dns_domain.timestamp = new->timestamp;
+			item->dns_domain.lifetime = new->lifetime;
+			_store_entry_changed (priv, item);
+		}
+		return changed;
 	}
+
+	if (new->lifetime)
+		_store_add (priv, STORE_DNS_DOMAINS, new);
 	return !!new->lifetime;
 }
 
@@ -607,6 +976,7 @@ announce_router (NMNDisc *ndisc)
 		return G_SOURCE_REMOVE;
 
 	priv->last_ra = nm_utils_get_monotonic_timestamp_s ();
+	_data_complete (priv);
 	if (klass->send_ra (ndisc, &error)) {
 		_LOGD ("router advertisement sent");
 		g_clear_pointer (&priv->last_error, g_free);
@@ -727,12 +1097,10 @@ gboolean
 nm_ndisc_set_iid (NMNDisc *ndisc, const NMUtilsIPv6IfaceId iid)
 {
 	NMNDiscPrivate *priv;
-	NMNDiscDataInternal *rdata;
 
 	g_return_val_if_fail (NM_IS_NDISC (ndisc), FALSE);
 
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
-	rdata = &priv->rdata;
 
 	if (priv->iid.id != iid.id) {
 		priv->iid = iid;
@@ -740,9 +1108,9 @@ nm_ndisc_set_iid (NMNDisc *ndisc, const NMUtilsIPv6IfaceId iid)
 		if (priv->addr_gen_mode == NM_SETTING_IP6_CONFIG_ADDR_GEN_MODE_STABLE_PRIVACY)
 			return FALSE;
 
-		if (rdata->addresses->len) {
+		if (g_hash_table_size (priv->store.idx[STORE_ADDRESSES])) {
 			_LOGD ("IPv6 interface identifier changed, flushing addresses");
-			g_array_remove_range (rdata->addresses, 0, rdata->addresses->len);
+			_store_clear (priv, STORE_ADDRESSES);
 			nm_ndisc_emit_config_change (ndisc, NM_NDISC_CONFIG_ADDRESSES);
 			solicit_routers (ndisc);
 		}
@@ -799,30 +1167,32 @@ nm_ndisc_start (NMNDisc *ndisc)
 NMNDiscConfigMap
 nm_ndisc_dad_failed (NMNDisc *ndisc, const struct in6_addr *address, gboolean emit_changed_signal)
 {
-	NMNDiscDataInternal *rdata;
-	guint i;
-	gboolean changed = FALSE;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->addresses->len; ) {
-		NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
-
-		if (IN6_ARE_ADDR_EQUAL (&item->address, address)) {
-			_LOGD ("DAD failed for discovered address %s", nm_utils_inet6_ntop (address, NULL));
-			changed = TRUE;
-			if (!complete_address (ndisc, item)) {
-				g_array_remove_index (rdata->addresses, i);
-				continue;
-			}
-		}
-		i++;
+	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	NMNDiscAddress addr = { .address = *address };
+	StoreEntry *item;
+
+	item = _store_lookup (priv, STORE_ADDRESSES, &addr);
+	if (!item)
+		return NM_NDISC_CONFIG_NONE;
+
+	_LOGD ("DAD failed for discovered address %s", nm_utils_inet6_ntop (address, NULL));
+
+	addr = item->address;
+	if (   !complete_address (ndisc, &addr)
+	    || _store_lookup (priv, STORE_ADDRESSES, &addr))
+		_store_remove (priv, item);
+	else {
+		/* the address is the key of the entry, re-index it. */
+		g_hash_table_steal (priv->store.idx[STORE_ADDRESSES], item);
+		item->address = addr;
+		g_hash_table_add (priv->store.idx[STORE_ADDRESSES], item);
+		_store_entry_changed (priv, item);
 	}
 
-	if (emit_changed_signal && changed)
+	if (emit_changed_signal)
 		nm_ndisc_emit_config_change (ndisc, NM_NDISC_CONFIG_ADDRESSES);
 
-	return changed ? NM_NDISC_CONFIG_ADDRESSES : NM_NDISC_CONFIG_NONE;
+	return NM_NDISC_CONFIG_ADDRESSES;
 }
 
 #define CONFIG_MAP_MAX_STR 7
@@ -860,40 +1230,6 @@ dhcp_level_to_string (NMNDiscDHCPLevel dhcp_level)
 	}
 }
 
-static gint32
-get_expiry_time (guint32 timestamp, guint32 lifetime)
-{
-	gint64 t;
-
-	/* timestamp is supposed to come from nm_utils_get_monotonic_timestamp_s().
-	 * It is expected to be within a certain range. */
-	nm_assert (timestamp > 0);
-	nm_assert (timestamp <= G_MAXINT32);
-
-	if (lifetime == NM_NDISC_INFINITY)
-		return G_MAXINT32;
-
-	t = (gint64) timestamp + (gint64) lifetime;
-	return CLAMP (t, 0, G_MAXINT32 - 1);
-}
-
-#define get_expiry(item) \
-	({ \
-		typeof (item) _item = (item); \
-		nm_assert (_item); \
-		get_expiry_time ((_item->timestamp), (_item->lifetime)); \
-	})
-
-#define get_expiry_half(item) \
-	({ \
-		typeof (item) _item = (item); \
-		nm_assert (_item); \
-		get_expiry_time ((_item->timestamp),\
-		                 (_item->lifetime) == NM_NDISC_INFINITY \
-		                   ? NM_NDISC_INFINITY \
-		                   : (_item->lifetime) / 2); \
-	})
-
 static const char *
 _get_exp (char *buf, gsize buf_size, gint64 now_ns, gint32 expiry_time)
 {
@@ -973,164 +1309,39 @@ _config_changed_log (NMNDisc *ndisc, NMNDiscConfigMap changed)
 	}
 }
 
-static void
-clean_gateways (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->gateways->len; ) {
-		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->gateways, i);
-				*changed |= NM_NDISC_CONFIG_GATEWAYS;
-				continue;
-			}
-			if (*nextevent > expiry)
-				*nextevent = expiry;
-		}
-		i++;
-	}
-
-	_ASSERT_data_gateways (rdata);
-}
-
-static void
-clean_addresses (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->addresses->len; ) {
-		const NMNDiscAddress *item = &g_array_index (rdata->addresses, NMNDiscAddress, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->addresses, i);
-				*changed |= NM_NDISC_CONFIG_ADDRESSES;
-				continue;
-			}
-			if (*nextevent > expiry)
-				*nextevent = expiry;
-		}
-		i++;
-	}
-}
-
-static void
-clean_routes (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->routes, i);
-				*changed |= NM_NDISC_CONFIG_ROUTES;
-				continue;
-			}
-			if (*nextevent > expiry)
-				*nextevent = expiry;
-		}
-		i++;
-	}
-}
-
-static void
-clean_dns_servers (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->dns_servers->len; ) {
-		NMNDiscDNSServer *item = &g_array_index (rdata->dns_servers, NMNDiscDNSServer, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-			gint32 refresh;
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->dns_servers, i);
-				*changed |= NM_NDISC_CONFIG_DNS_SERVERS;
-				continue;
-			}
-
-			refresh = get_expiry_half (item);
-			if (now >= refresh)
-				solicit_routers (ndisc);
-			else if (*nextevent > refresh)
-				*nextevent = refresh;
-		}
-		i++;
-	}
-}
-
-static void
-clean_dns_domains (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
-{
-	NMNDiscDataInternal *rdata;
-	guint i;
-
-	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
-
-	for (i = 0; i < rdata->dns_domains->len; ) {
-		NMNDiscDNSDomain *item = &g_array_index (rdata->dns_domains, NMNDiscDNSDomain, i);
-
-		if (item->lifetime != NM_NDISC_INFINITY) {
-			gint32 expiry = get_expiry (item);
-			gint32 refresh;
-
-			if (now >= expiry) {
-				g_array_remove_index (rdata->dns_domains, i);
-				*changed |= NM_NDISC_CONFIG_DNS_DOMAINS;
-				continue;
-			}
-
-			refresh = get_expiry_half (item);
-			if (now >= refresh)
-				solicit_routers (ndisc);
-			else if (*nextevent > refresh)
-				*nextevent = refresh;
-		}
-		i++;
-	}
-}
-
 static gboolean timeout_cb (gpointer user_data);
 
 static void
 check_timestamps (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap changed)
 {
 	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
+	GPtrArray *heap = priv->store.heap;
 	/* Use a magic date in the distant future (~68 years) */
 	gint32 nextevent = G_MAXINT32;
 
 	nm_clear_g_source (&priv->timeout_id);
 
-	clean_gateways (ndisc, now, &changed, &nextevent);
-	clean_addresses (ndisc, now, &changed, &nextevent);
-	clean_routes (ndisc, now, &changed, &nextevent);
-	clean_dns_servers (ndisc, now, &changed, &nextevent);
-	clean_dns_domains (ndisc, now, &changed, &nextevent);
+	/* Only the items whose deadline passed need to be looked at. */
+	while (heap->len > 0) {
+		StoreEntry *item = heap->pdata[0];
+		gint32 expiry;
+
+		if (item->deadline > now) {
+			nextevent = item->deadline;
+			break;
+		}
+
+		expiry = _store_entry_get_expiry (item);
+		if (item->refresh_pending && now < expiry) {
+			item->refresh_pending = FALSE;
+			_heap_set_deadline (heap, item, expiry);
+			solicit_routers (ndisc);
+			continue;
+		}
+
+		changed |= _store_config_map[item->type];
+		_store_remove (priv, item);
+	}
 
 	if (changed)
 		nm_ndisc_emit_config_change (ndisc, changed);
@@ -1176,12 +1387,6 @@ nm_ndisc_rs_received (NMNDisc *ndisc)
 
 /*****************************************************************************/
 
-static void
-dns_domain_free (gpointer data)
-{
-	g_free (((NMNDiscDNSDomain *)(data))->domain);
-}
-
 static void
 set_property (GObject *object, guint prop_id,
               const GValue *value, GParamSpec *pspec)
@@ -1254,6 +1459,7 @@ nm_ndisc_init (NMNDisc *ndisc)
 {
 	NMNDiscPrivate *priv;
 	NMNDiscDataInternal *rdata;
+	guint i;
 
 	priv = G_TYPE_INSTANCE_GET_PRIVATE (ndisc, NM_TYPE_NDISC, NMNDiscPrivate);
 	ndisc->_priv = priv;
@@ -1265,9 +1471,12 @@ nm_ndisc_init (NMNDisc *ndisc)
 	rdata->routes = g_array_new (FALSE, FALSE, sizeof (NMNDiscRoute));
 	rdata->dns_servers = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSServer));
 	rdata->dns_domains = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSDomain));
-	g_array_set_clear_func (rdata->dns_domains, dns_domain_free);
 	priv->rdata.public.hop_limit = 64;
 
+	for (i = 0; i < _STORE_NUM; i++)
+		priv->store.idx[i] = g_hash_table_new_full (_store_entry_hash, _store_entry_equal, _store_entry_free, NULL);
+	priv->store.heap = g_ptr_array_new ();
+
 	/* Start at very low number so that last_rs - router_solicitation_interval
 	 * is much lower than nm_utils_get_monotonic_timestamp_s() at startup.
 	 */
@@ -1296,10 +1505,24 @@ finalize (GObject *object)
 	NMNDisc *ndisc = NM_NDISC (object);
 	NMNDiscPrivate *priv = NM_NDISC_GET_PRIVATE (ndisc);
 	NMNDiscDataInternal *rdata = &priv->rdata;
+	guint i;
 
 	g_free (priv->ifname);
 	g_free (priv->network_id);
 
+	/* the heap only borrows the entries. */
+	g_ptr_array_set_size (priv->store.heap, 0);
+	g_ptr_array_unref (priv->store.heap);
+	for (i = 0; i < _STORE_NUM; i++) {
+		GHashTableIter iter;
+		StoreEntry *item;
+
+		g_hash_table_iter_init (&iter, priv->store.idx[i]);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &item, NULL))
+			item->heap_idx = G_MAXUINT;
+		g_hash_table_unref (priv->store.idx[i]);
+	}
+
 	g_array_unref (rdata->gateways);
 	g_array_unref (rdata->addresses);
 	g_array_unref (rdata->routes);
@@ -520,6 +520,92 @@ test_dns_solicit_loop (void)
 	g_main_loop_unref (data.loop);
 }
 
+#define TEST_MANY_ROUTES_N 500
+
+static const NMIcmpv6RouterPref test_many_routes_prefs[] = {
+	NM_ICMPV6_ROUTER_PREF_LOW,
+	NM_ICMPV6_ROUTER_PREF_MEDIUM,
+	NM_ICMPV6_ROUTER_PREF_HIGH,
+};
+
+static guint
+test_many_routes_priority (NMIcmpv6RouterPref pref)
+{
+	switch (pref) {
+	case NM_ICMPV6_ROUTER_PREF_LOW:
+		return 1;
+	case NM_ICMPV6_ROUTER_PREF_MEDIUM:
+		return 2;
+	case NM_ICMPV6_ROUTER_PREF_HIGH:
+		return 3;
+	default:
+		g_assert_not_reached ();
+	}
+	return 0;
+}
+
+static void
+test_many_routes_changed (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	NMNDiscConfigMap changed = changed_int;
+	guint i;
+
+	g_assert (NM_FLAGS_HAS (changed, NM_NDISC_CONFIG_ROUTES));
+
+	if (data->counter == 0) {
+		g_assert_cmpint (rdata->routes_n, ==, TEST_MANY_ROUTES_N);
+		g_assert_cmpint (rdata->addresses_n, ==, NM_NDISC_MAX_ADDRESSES_DEFAULT);
+	} else {
+		/* the second RA withdrew every other route. */
+		g_assert_cmpint (rdata->routes_n, ==, TEST_MANY_ROUTES_N / 2);
+	}
+
+	for (i = 1; i < rdata->routes_n; i++) {
+		g_assert_cmpint (test_many_routes_priority (rdata->routes[i - 1].preference),
+		                 >=,
+		                 test_many_routes_priority (rdata->routes[i].preference));
+	}
+
+	if (++data->counter == 2) {
+		g_assert (nm_fake_ndisc_done (NM_FAKE_NDISC (ndisc)));
+		g_main_loop_quit (data->loop);
+	}
+}
+
+static void
+test_many_routes (void)
+{
+	NMFakeNDisc *ndisc = ndisc_new ();
+	guint32 now = nm_utils_get_monotonic_timestamp_s ();
+	TestData data = { g_main_loop_new (NULL, FALSE), 0, 0, now };
+	guint id1, id2;
+	guint i;
+
+	id1 = nm_fake_ndisc_add_ra (ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	id2 = nm_fake_ndisc_add_ra (ndisc, 1, NM_NDISC_DHCP_LEVEL_NONE, 4, 1500);
+	for (i = 0; i < TEST_MANY_ROUTES_N; i++) {
+		char network[INET6_ADDRSTRLEN];
+		NMIcmpv6RouterPref pref = test_many_routes_prefs[i % G_N_ELEMENTS (test_many_routes_prefs)];
+
+		nm_sprintf_buf (network, "2001:db8:%x::", i);
+		nm_fake_ndisc_add_prefix (ndisc, id1, network, 64, "fe80::1", now, 100, 100, pref);
+		if (i % 2)
+			nm_fake_ndisc_add_prefix (ndisc, id2, network, 64, "fe80::1", now, 0, 0, pref);
+	}
+
+	g_signal_connect (ndisc,
+	                  NM_NDISC_CONFIG_RECEIVED,
+	                  G_CALLBACK (test_many_routes_changed),
+	                  &data);
+
+	nm_ndisc_start (NM_NDISC (ndisc));
+	g_main_loop_run (data.loop);
+	g_assert_cmpint (data.counter, ==, 2);
+
+	g_object_unref (ndisc);
+	g_main_loop_unref (data.loop);
+}
+
 NMTST_DEFINE ();
 
 int
@@ -539,6 +625,7 @@ main (int argc, char **argv)
 	g_test_add_func ("/ndisc/preference-order", test_preference_order);
 	g_test_add_func ("/ndisc/preference-changed", test_preference_changed);
 	g_test_add_func ("/ndisc/dns-solicit-loop", test_dns_solicit_loop);
+	g_test_add_func ("/ndisc/many-routes", test_many_routes);
 
 	return g_test_run ();
 }
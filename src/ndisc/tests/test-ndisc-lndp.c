@@ -0,0 +1,209 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <sched.h>
+#include <arpa/inet.h>
+
+#include "ndisc/nm-ndisc.h"
+#include "ndisc/nm-lndp-ndisc.h"
+
+#include "platform/nm-linux-platform.h"
+
+#include "nm-test-utils-core.h"
+
+static gboolean has_netns;
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_links;
+	guint n_received;
+	NMNDisc **hosts;
+	NMNDisc **routers;
+	guint *counters;
+} TestData;
+
+static void
+_dns_server_for_link (guint i, struct in6_addr *addr)
+{
+	char buf[INET6_ADDRSTRLEN];
+
+	nm_sprintf_buf (buf, "2001:db8:%x::1", i + 1);
+	g_assert (inet_pton (AF_INET6, buf, addr) == 1);
+}
+
+static void
+test_shared_socket_changed (NMNDisc *ndisc, const NMNDiscData *rdata, guint changed_int, TestData *data)
+{
+	struct in6_addr expected;
+	guint i;
+
+	for (i = 0; i < data->n_links; i++) {
+		if (data->hosts[i] == ndisc)
+			break;
+	}
+	g_assert_cmpint (i, <, data->n_links);
+
+	/* each host only sees the RA of the router on its own link. */
+	_dns_server_for_link (i, &expected);
+	g_assert_cmpint (rdata->dns_servers_n, ==, 1);
+	g_assert (IN6_ARE_ADDR_EQUAL (&rdata->dns_servers[0].address, &expected));
+	g_assert_cmpint (rdata->gateways_n, ==, 1);
+
+	if (data->counters[i]++ == 0) {
+		if (++data->n_received == data->n_links)
+			g_main_loop_quit (data->loop);
+	}
+}
+
+static NMNDisc *
+_ndisc_new (const char *ifname, NMNDiscNodeType node_type)
+{
+	gs_free_error GError *error = NULL;
+	NMUtilsIPv6IfaceId iid = { };
+	NMNDisc *ndisc;
+	int ifindex;
+
+	ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, ifname);
+	g_assert_cmpint (ifindex, >, 0);
+
+	ndisc = nm_lndp_ndisc_new (NM_PLATFORM_GET,
+	                           ifindex,
+	                           ifname,
+	                           NM_UTILS_STABLE_TYPE_UUID,
+	                           "8ce666e8-d34d-4fb1-b858-f15a7a128086",
+	                           NM_SETTING_IP6_CONFIG_ADDR_GEN_MODE_EUI64,
+	                           node_type,
+	                           &error);
+	g_assert_no_error (error);
+	g_assert (ndisc);
+
+	iid.id_u8[7] = 1;
+	nm_ndisc_set_iid (ndisc, iid);
+	return ndisc;
+}
+
+static void
+test_shared_socket (gconstpointer test_data)
+{
+	const guint n_links = GPOINTER_TO_UINT (test_data);
+	gs_free NMNDisc **hosts = g_new0 (NMNDisc *, n_links);
+	gs_free NMNDisc **routers = g_new0 (NMNDisc *, n_links);
+	gs_free guint *counters = g_new0 (guint, n_links);
+	TestData data = {
+		.n_links = n_links,
+		.hosts = hosts,
+		.routers = routers,
+		.counters = counters,
+	};
+	char name[IFNAMSIZ];
+	guint i;
+
+	if (!has_netns) {
+		g_test_skip ("Skipping test: requires root to create a network namespace");
+		return;
+	}
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	/* skip DAD for the link-local addresses that we send from. */
+	nm_platform_sysctl_set (NM_PLATFORM_GET,
+	                        NMP_SYSCTL_PATHID_ABSOLUTE ("/proc/sys/net/ipv6/conf/default/accept_dad"),
+	                        "0");
+
+	for (i = 0; i < n_links; i++) {
+		char peer[IFNAMSIZ];
+
+		nm_sprintf_buf (name, "ndh%u", i);
+		nm_sprintf_buf (peer, "ndr%u", i);
+		g_assert_cmpint (nm_platform_link_veth_add (NM_PLATFORM_GET, name, peer, NULL), ==, NM_PLATFORM_ERROR_SUCCESS);
+		g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, nm_platform_link_get_ifindex (NM_PLATFORM_GET, name), NULL));
+		g_assert (nm_platform_link_set_up (NM_PLATFORM_GET, nm_platform_link_get_ifindex (NM_PLATFORM_GET, peer), NULL));
+	}
+
+	/* all instances of the namespace, hosts and routers, share one socket.
+	 * A host's RS must only reach the router on its link, and the router's
+	 * RA only the host on that link. */
+	for (i = 0; i < n_links; i++) {
+		gs_unref_array GArray *addresses = g_array_new (FALSE, FALSE, sizeof (NMNDiscAddress));
+		gs_unref_array GArray *dns_servers = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSServer));
+		gs_unref_array GArray *dns_domains = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSDomain));
+		NMNDiscDNSServer dns_server = {
+			.timestamp = nm_utils_get_monotonic_timestamp_s (),
+			.lifetime = 900,
+		};
+
+		nm_sprintf_buf (name, "ndr%u", i);
+		data.routers[i] = _ndisc_new (name, NM_NDISC_NODE_TYPE_ROUTER);
+		_dns_server_for_link (i, &dns_server.address);
+		g_array_append_val (dns_servers, dns_server);
+		nm_ndisc_set_config (data.routers[i], addresses, dns_servers, dns_domains);
+		nm_ndisc_start (data.routers[i]);
+	}
+
+	for (i = 0; i < n_links; i++) {
+		nm_sprintf_buf (name, "ndh%u", i);
+		data.hosts[i] = _ndisc_new (name, NM_NDISC_NODE_TYPE_HOST);
+		g_signal_connect (data.hosts[i],
+		                  NM_NDISC_CONFIG_RECEIVED,
+		                  G_CALLBACK (test_shared_socket_changed),
+		                  &data);
+		nm_ndisc_start (data.hosts[i]);
+	}
+
+	g_assert (nmtst_main_loop_run (data.loop, 10000));
+	g_assert_cmpint (data.n_received, ==, n_links);
+
+	/* give misdirected messages a chance to show up. */
+	nmtst_main_loop_run (data.loop, 1000);
+
+	for (i = 0; i < n_links; i++) {
+		g_object_unref (data.hosts[i]);
+		g_object_unref (data.routers[i]);
+		nm_sprintf_buf (name, "ndh%u", i);
+		g_assert (nm_platform_link_delete (NM_PLATFORM_GET, nm_platform_link_get_ifindex (NM_PLATFORM_GET, name)));
+	}
+	g_main_loop_unref (data.loop);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "DEFAULT");
+
+	/* the test needs raw sockets and creates links. Run it in a
+	 * separate network namespace. */
+	if (   getuid () == 0
+	    && unshare (CLONE_NEWNET) == 0) {
+		has_netns = TRUE;
+		nm_linux_platform_setup ();
+	}
+
+	g_test_add_data_func ("/ndisc/lndp/shared-socket/4", GUINT_TO_POINTER (4), test_shared_socket);
+	g_test_add_data_func ("/ndisc/lndp/shared-socket/64", GUINT_TO_POINTER (64), test_shared_socket);
+
+	return g_test_run ();
+}
@@ -34,6 +34,11 @@
 #define CANCELLATION_ID_PREFIX "cancellation-id-"
 #define CANCELLATION_TIMEOUT_MS 5000
 
+/* how long a decision from polkit is reused for the same subject and
+ * action, and how many decisions are remembered at most. */
+#define CACHE_TTL_MSEC  5000
+#define CACHE_SIZE_MAX  512
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE_BASE (
@@ -53,6 +58,16 @@ typedef struct {
 	GCancellable *new_proxy_cancellable;
 	GCancellable *cancel_cancellable;
 	guint64 call_numid_counter;
+	struct {
+		GHashTable *idx;
+		/* CacheEntry instances, sorted by expiry. */
+		CList lst_head;
+		guint64 hits;
+		guint64 misses;
+		/* bumped on each flush, so that replies to requests that
+		 * were sent before, don't populate the cache. */
+		guint generation;
+	} cache;
 	bool polkit_enabled:1;
 	bool disposing:1;
 	bool shutting_down:1;
@@ -126,6 +141,7 @@ typedef enum {
 typedef enum {
 	IDLE_REASON_AUTHORIZED,
 	IDLE_REASON_NO_DBUS,
+	IDLE_REASON_CACHED,
 } IdleReason;
 
 struct _NMAuthManagerCallId {
@@ -135,16 +151,143 @@ struct _NMAuthManagerCallId {
 	GCancellable *dbus_cancellable;
 	NMAuthManagerCheckAuthorizationCallback callback;
 	gpointer user_data;
+	char *cache_key;
 	guint64 call_numid;
 	guint idle_id;
+	guint cache_generation;
 	IdleReason idle_reason:8;
+	bool cached_is_authorized:1;
+	bool allow_user_interaction:1;
 };
 
+typedef struct {
+	CList cache_lst;
+	gint64 expiry_msec;
+	bool is_authorized;
+	char key[];
+} CacheEntry;
+
 #define cancellation_id_to_str_a(call_numid) \
 	nm_sprintf_bufa (NM_STRLEN (CANCELLATION_ID_PREFIX) + 20, \
 	                 CANCELLATION_ID_PREFIX"%"G_GUINT64_FORMAT, \
 	                 (call_numid))
 
+/*****************************************************************************/
+
+static char *
+_cache_key_new (NMAuthSubject *subject,
+                const char *action_id,
+                PolkitCheckAuthorizationFlags flags)
+{
+	/* pid, uid and the start-time of the process identify the caller
+	 * uniquely. The flags are part of the key, because polkit may answer
+	 * differently depending on whether user interaction is allowed. */
+	return g_strdup_printf ("%lu\n%lu\n%"G_GUINT64_FORMAT"\n%u\n%s",
+	                        nm_auth_subject_get_unix_process_pid (subject),
+	                        nm_auth_subject_get_unix_process_uid (subject),
+	                        nm_auth_subject_get_unix_process_start_time (subject),
+	                        (guint) flags,
+	                        action_id);
+}
+
+static void
+_cache_entry_remove (NMAuthManagerPrivate *priv, CacheEntry *entry)
+{
+	c_list_unlink_stale (&entry->cache_lst);
+	if (!g_hash_table_remove (priv->cache.idx, entry->key))
+		nm_assert_not_reached ();
+	g_free (entry);
+}
+
+static void
+_cache_expire (NMAuthManagerPrivate *priv, gint64 now_msec)
+{
+	CacheEntry *entry;
+
+	while ((entry = c_list_first_entry (&priv->cache.lst_head, CacheEntry, cache_lst))) {
+		if (entry->expiry_msec > now_msec)
+			break;
+		_cache_entry_remove (priv, entry);
+	}
+}
+
+static CacheEntry *
+_cache_lookup (NMAuthManagerPrivate *priv, const char *key)
+{
+	_cache_expire (priv, nm_utils_get_monotonic_timestamp_ms ());
+	return g_hash_table_lookup (priv->cache.idx, key);
+}
+
+static void
+_cache_add (NMAuthManagerPrivate *priv, const char *key, gboolean is_authorized)
+{
+	CacheEntry *entry;
+	gsize key_len;
+
+	entry = g_hash_table_lookup (priv->cache.idx, key);
+	if (entry)
+		_cache_entry_remove (priv, entry);
+	else if (g_hash_table_size (priv->cache.idx) >= CACHE_SIZE_MAX) {
+		/* evict the entry that expires first. */
+		_cache_entry_remove (priv, c_list_first_entry (&priv->cache.lst_head, CacheEntry, cache_lst));
+	}
+
+	key_len = strlen (key) + 1;
+	entry = g_malloc (sizeof (CacheEntry) + key_len);
+	entry->expiry_msec = nm_utils_get_monotonic_timestamp_ms () + CACHE_TTL_MSEC;
+	entry->is_authorized = is_authorized;
+	memcpy (entry->key, key, key_len);
+
+	/* all entries have the same TTL, so appending keeps the list sorted. */
+	c_list_link_tail (&priv->cache.lst_head, &entry->cache_lst);
+	g_hash_table_insert (priv->cache.idx, entry->key, entry);
+}
+
+static void
+_cache_flush (NMAuthManager *self, const char *reason)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	CacheEntry *entry;
+
+	priv->cache.generation++;
+
+	if (c_list_is_empty (&priv->cache.lst_head))
+		return;
+
+	_LOGD ("flush authorization cache (%s): %u entries, %"G_GUINT64_FORMAT" hits, %"G_GUINT64_FORMAT" misses",
+	       reason,
+	       g_hash_table_size (priv->cache.idx),
+	       priv->cache.hits,
+	       priv->cache.misses);
+
+	while ((entry = c_list_first_entry (&priv->cache.lst_head, CacheEntry, cache_lst)))
+		_cache_entry_remove (priv, entry);
+}
+
+/**
+ * nm_auth_manager_get_cache_stats:
+ * @self: the #NMAuthManager
+ * @out_hits: (allow-none): the number of authorization requests that
+ *   were answered from the decision cache.
+ * @out_misses: (allow-none): the number of authorization requests that
+ *   were forwarded to polkit.
+ */
+void
+nm_auth_manager_get_cache_stats (NMAuthManager *self,
+                                 guint64 *out_hits,
+                                 guint64 *out_misses)
+{
+	NMAuthManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
+
+	priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	NM_SET_OUT (out_hits, priv->cache.hits);
+	NM_SET_OUT (out_misses, priv->cache.misses);
+}
+
+/*****************************************************************************/
+
 static void
 _call_id_free (NMAuthManagerCallId *call_id)
 {
@@ -152,6 +295,7 @@ _call_id_free (NMAuthManagerCallId *call_id)
 	nm_clear_g_source (&call_id->idle_id);
 	if (call_id->dbus_parameters)
 		g_variant_unref (g_steal_pointer (&call_id->dbus_parameters));
+	nm_clear_g_free (&call_id->cache_key);
 
 	if (call_id->dbus_cancellable) {
 		/* we have a pending D-Bus call. We keep the call-id instance alive
@@ -257,13 +401,32 @@ _call_check_authorize_cb (GObject *proxy,
 	}
 
 	if (!error) {
+		gs_unref_variant GVariant *details = NULL;
+		gboolean is_retained;
+
 		g_variant_get (value,
 		               "((bb@a{ss}))",
 		               &is_authorized,
 		               &is_challenge,
-		               NULL);
-		_LOG2T (call_id, "completed: authorized=%d, challenge=%d",
-		        is_authorized, is_challenge);
+		               &details);
+		is_retained = g_variant_lookup (details, "polkit.retains_authorization_after_challenge", "&s", NULL);
+		_LOG2T (call_id, "completed: authorized=%d, challenge=%d%s",
+		        is_authorized, is_challenge,
+		        is_retained ? ", retained" : "");
+
+		/* a challenge depends on the presence of an authentication agent
+		 * and on user interaction. Never cache it.
+		 *
+		 * When user interaction was allowed, polkit might have granted the
+		 * request only after prompting the user. Such a grant is only for
+		 * this request, unless polkit reports that it retains it (for the
+		 * "*_keep" implicit authorizations). */
+		if (   !is_challenge
+		    && call_id->cache_key
+		    && call_id->cache_generation == priv->cache.generation
+		    && (   !call_id->allow_user_interaction
+		        || (is_authorized && is_retained)))
+			_cache_add (priv, call_id->cache_key, is_authorized);
 	} else
 		_LOG2T (call_id, "completed: failed: %s", error->message);
 
@@ -281,6 +444,7 @@ _call_check_authorize (NMAuthManagerCallId *call_id)
 	nm_assert (!call_id->dbus_cancellable);
 
 	call_id->dbus_cancellable = g_cancellable_new ();
+	call_id->cache_generation = priv->cache.generation;
 
 	nm_assert (priv->cancel_cancellable);
 
@@ -308,6 +472,10 @@ _call_on_idle (gpointer user_data)
 		is_authorized = TRUE;
 		_LOG2T (call_id, "completed: authorized=%d, challenge=%d (simulated)",
 		        is_authorized, is_challenge);
+	} else if (call_id->idle_reason == IDLE_REASON_CACHED) {
+		is_authorized = call_id->cached_is_authorized;
+		_LOG2T (call_id, "completed: authorized=%d, challenge=%d (cached)",
+		        is_authorized, is_challenge);
 	} else {
 		nm_assert (call_id->idle_reason == IDLE_REASON_NO_DBUS);
 		error_msg = "failure creating GDBusProxy for authorization request";
@@ -370,6 +538,7 @@ nm_auth_manager_check_authorization (NMAuthManager *self,
 	call_id->callback = callback;
 	call_id->user_data = user_data;
 	call_id->call_numid = ++priv->call_numid_counter;
+	call_id->allow_user_interaction = allow_user_interaction;
 	c_list_link_tail (&priv->calls_lst_head, &call_id->calls_lst);
 
 	if (!priv->polkit_enabled) {
@@ -390,6 +559,22 @@ nm_auth_manager_check_authorization (NMAuthManager *self,
 		call_id->idle_reason = IDLE_REASON_NO_DBUS;
 		call_id->idle_id = g_idle_add (_call_on_idle, call_id);
 	} else {
+		call_id->cache_key = _cache_key_new (subject, action_id, flags);
+		if (priv->proxy) {
+			const CacheEntry *entry;
+
+			entry = _cache_lookup (priv, call_id->cache_key);
+			if (entry) {
+				priv->cache.hits++;
+				_LOG2T (call_id, "CheckAuthorization(%s), subject=%s (cached decision)", action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)));
+				call_id->idle_reason = IDLE_REASON_CACHED;
+				call_id->cached_is_authorized = entry->is_authorized;
+				call_id->idle_id = g_idle_add (_call_on_idle, call_id);
+				return call_id;
+			}
+		}
+		priv->cache.misses++;
+
 		subject_value = nm_auth_subject_unix_process_to_polkit_gvariant (subject);
 		nm_assert (g_variant_is_floating (subject_value));
 
@@ -472,6 +657,10 @@ _dbus_on_name_owner_notify_cb (GObject    *object,
 	nm_assert (NM_AUTH_MANAGER_GET_PRIVATE (self)->proxy == (GDBusProxy *) object);
 
 	_log_name_owner (self, &name_owner);
+
+	/* a new polkit instance might decide differently. */
+	_cache_flush (self, "name owner changed");
+
 	if (!name_owner) {
 		/* when the name disappears, we also want to raise a emit signal.
 		 * When it appears, we raise one already. */
@@ -488,6 +677,7 @@ _dbus_on_changed_signal_cb (GDBusProxy *proxy,
 	nm_assert (NM_AUTH_MANAGER_GET_PRIVATE (self)->proxy == proxy);
 
 	_LOGD ("dbus signal: \"Changed\"");
+	_cache_flush (self, "changed signal");
 	_emit_changed_signal (self);
 }
 
@@ -619,6 +809,8 @@ nm_auth_manager_init (NMAuthManager *self)
 	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
 
 	c_list_init (&priv->calls_lst_head);
+	c_list_init (&priv->cache.lst_head);
+	priv->cache.idx = g_hash_table_new (nm_str_hash, g_str_equal);
 }
 
 static void
@@ -685,9 +877,22 @@ dispose (GObject *object)
 		g_clear_object (&priv->proxy);
 	}
 
+	_cache_flush (self, "dispose");
+
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE ((NMAuthManager *) object);
+
+	nm_assert (c_list_is_empty (&priv->cache.lst_head));
+	g_hash_table_unref (priv->cache.idx);
+
+	G_OBJECT_CLASS (nm_auth_manager_parent_class)->finalize (object);
+}
+
 static void
 nm_auth_manager_class_init (NMAuthManagerClass *klass)
 {
@@ -696,6 +901,7 @@ nm_auth_manager_class_init (NMAuthManagerClass *klass)
 	object_class->set_property = set_property;
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
+	object_class->finalize = finalize;
 
 	obj_properties[PROP_POLKIT_ENABLED] =
 	     g_param_spec_boolean (NM_AUTH_MANAGER_POLKIT_ENABLED, "", "",
@@ -71,6 +71,10 @@ void nm_auth_manager_force_shutdown (NMAuthManager *self);
 
 gboolean nm_auth_manager_get_polkit_enabled (NMAuthManager *self);
 
+void nm_auth_manager_get_cache_stats (NMAuthManager *self,
+                                      guint64 *out_hits,
+                                      guint64 *out_misses);
+
 /*****************************************************************************/
 
 typedef struct _NMAuthManagerCallId NMAuthManagerCallId;
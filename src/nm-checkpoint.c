@@ -102,6 +102,76 @@ G_DEFINE_TYPE (NMCheckpoint, nm_checkpoint, NM_TYPE_DBUS_OBJECT)
 
 /*****************************************************************************/
 
+/* A checkpoint keeps a snapshot of the applied and the settings connection
+ * of each device. Checkpoints are often created one after another for the
+ * same, unchanged profiles. Instead of cloning the connections each time, we
+ * remember the last snapshot per UUID and share it by reference, as long as
+ * the current connection still compares equal to it.
+ *
+ * Snapshots are immutable. Somebody who needs a modifiable connection (like
+ * the applied connection of a new activation) must clone it first. */
+
+typedef struct {
+	GHashTable *store;
+	char *uuid;
+
+	/* not owned. The snapshot unregisters itself via a weak-pointer. */
+	NMConnection *connection;
+} Snapshot;
+
+static GHashTable *_snapshots_settings;
+static GHashTable *_snapshots_applied;
+
+static void
+_snapshot_weak_notify (gpointer data, GObject *where_the_object_was)
+{
+	Snapshot *snapshot = data;
+
+	if (g_hash_table_lookup (snapshot->store, snapshot->uuid) == snapshot)
+		g_hash_table_remove (snapshot->store, snapshot->uuid);
+	g_free (snapshot->uuid);
+	g_slice_free (Snapshot, snapshot);
+}
+
+static NMConnection *
+_snapshot_get (GHashTable **p_store,
+               NMConnection *connection,
+               guint *out_n_shared)
+{
+	Snapshot *snapshot;
+	const char *uuid;
+
+	nm_assert (NM_IS_CONNECTION (connection));
+
+	uuid = nm_connection_get_uuid (connection);
+	if (!uuid)
+		return nm_simple_connection_new_clone (connection);
+
+	if (G_UNLIKELY (!*p_store))
+		*p_store = g_hash_table_new (nm_str_hash, g_str_equal);
+
+	snapshot = g_hash_table_lookup (*p_store, uuid);
+	if (   snapshot
+	    && nm_connection_compare (snapshot->connection,
+	                              connection,
+	                              NM_SETTING_COMPARE_FLAG_EXACT)) {
+		(*out_n_shared)++;
+		return g_object_ref (snapshot->connection);
+	}
+
+	/* the previous snapshot (if any) stays alive as long as other checkpoints
+	 * reference it. But new checkpoints will share the new one. */
+	snapshot = g_slice_new (Snapshot);
+	snapshot->store = *p_store;
+	snapshot->uuid = g_strdup (uuid);
+	snapshot->connection = nm_simple_connection_new_clone (connection);
+	g_object_weak_ref (G_OBJECT (snapshot->connection), _snapshot_weak_notify, snapshot);
+	g_hash_table_replace (*p_store, snapshot->uuid, snapshot);
+	return snapshot->connection;
+}
+
+/*****************************************************************************/
+
 void
 nm_checkpoint_log_destroy (NMCheckpoint *self)
 {
@@ -159,15 +229,28 @@ find_settings_connection (NMCheckpoint *self,
 {
 	NMCheckpointPrivate *priv = NM_CHECKPOINT_GET_PRIVATE (self);
 	NMActiveConnection *active;
-	NMSettingsConnection *sett_conn;
+	NMSettingsConnection *sett_conn = NULL;
 	const char *uuid, *ac_uuid;
 	const CList *tmp_clist;
+	NMActRequest *act_request;
 
 	*need_activation = FALSE;
 	*need_update = FALSE;
 
 	uuid = nm_connection_get_uuid (dev_checkpoint->settings_connection);
-	sett_conn = nm_settings_get_connection_by_uuid (nm_settings_get (), uuid);
+
+	/* usually, the device is still activated with the same profile. Avoid
+	 * searching all profiles and active connections in that case. */
+	act_request = nm_device_get_act_request (dev_checkpoint->device);
+	if (act_request) {
+		sett_conn = nm_act_request_get_settings_connection (act_request);
+		if (   sett_conn
+		    && !nm_streq0 (uuid, nm_settings_connection_get_uuid (sett_conn)))
+			sett_conn = NULL;
+	}
+
+	if (!sett_conn)
+		sett_conn = nm_settings_get_connection_by_uuid (nm_settings_get (), uuid);
 
 	if (!sett_conn)
 		return NULL;
@@ -182,11 +265,17 @@ find_settings_connection (NMCheckpoint *self,
 	}
 
 	/* ... is active, ... */
-	nm_manager_for_each_active_connection (priv->manager, active, tmp_clist) {
-		ac_uuid = nm_settings_connection_get_uuid (nm_active_connection_get_settings_connection (active));
-		if (nm_streq (uuid, ac_uuid)) {
-			_LOGT ("rollback: connection %s is active", uuid);
-			break;
+	if (   act_request
+	    && nm_act_request_get_settings_connection (act_request) == sett_conn) {
+		active = NM_ACTIVE_CONNECTION (act_request);
+		_LOGT ("rollback: connection %s is active", uuid);
+	} else {
+		nm_manager_for_each_active_connection (priv->manager, active, tmp_clist) {
+			ac_uuid = nm_settings_connection_get_uuid (nm_active_connection_get_settings_connection (active));
+			if (nm_streq (uuid, ac_uuid)) {
+				_LOGT ("rollback: connection %s is active", uuid);
+				break;
+			}
 		}
 	}
 
@@ -215,10 +304,14 @@ nm_checkpoint_rollback (NMCheckpoint *self)
 	NMDevice *device;
 	GError *local_error = NULL;
 	GVariantBuilder builder;
+	gint64 start_ns;
+	guint n_changed = 0;
 
 	_LOGI ("rollback of %s", nm_dbus_object_get_path (NM_DBUS_OBJECT (self)));
 	 g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
 
+	start_ns = nm_utils_get_monotonic_timestamp_ns ();
+
 	/* Start rolling-back each device */
 	g_hash_table_iter_init (&iter, priv->devices);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &device, (gpointer *) &dev_checkpoint)) {
@@ -234,6 +327,7 @@ nm_checkpoint_rollback (NMCheckpoint *self)
 		if (nm_device_is_real (device)) {
 			if (!dev_checkpoint->realized) {
 				_LOGD ("rollback: device was not realized, unmanage it");
+				n_changed++;
 				nm_device_set_unmanaged_by_flags_queue (device,
 				                                        NM_UNMANAGED_USER_EXPLICIT,
 				                                        TRUE,
@@ -269,6 +363,7 @@ activate:
 			if (   nm_device_get_state (device) != NM_DEVICE_STATE_UNMANAGED
 			    || dev_checkpoint->unmanaged_explicit == NM_UNMAN_FLAG_OP_SET_UNMANAGED) {
 				_LOGD ("rollback: explicitly unmanage device");
+				n_changed++;
 				nm_device_set_unmanaged_by_flags_queue (device,
 				                                        NM_UNMANAGED_USER_EXPLICIT,
 				                                        TRUE,
@@ -283,24 +378,36 @@ activate:
 			/* The device had an active connection: check if the
 			 * connection still exists, is active and was changed */
 			connection = find_settings_connection (self, dev_checkpoint, &need_update, &need_activation);
+			if (need_update || need_activation || !connection)
+				n_changed++;
 			if (connection) {
 				if (need_update) {
+					gs_unref_object NMConnection *settings_connection = NULL;
+
 					_LOGD ("rollback: updating connection %s",
 					        nm_settings_connection_get_uuid (connection));
+					/* the snapshot is possibly shared with other checkpoints, and
+					 * updating might normalize the connection we pass. */
+					settings_connection = nm_simple_connection_new_clone (dev_checkpoint->settings_connection);
 					nm_settings_connection_update (connection,
-					                               dev_checkpoint->settings_connection,
+					                               settings_connection,
 					                               NM_SETTINGS_CONNECTION_PERSIST_MODE_DISK,
 					                               NM_SETTINGS_CONNECTION_COMMIT_REASON_NONE,
 					                               "checkpoint-rollback",
 					                               NULL);
 				}
 			} else {
+				gs_unref_object NMConnection *settings_connection = NULL;
+
 				/* The connection was deleted, recreate it */
 				_LOGD ("rollback: adding connection %s again",
 				       nm_connection_get_uuid (dev_checkpoint->settings_connection));
 
+				/* adding takes over the connection. Don't let it modify
+				 * the snapshot. */
+				settings_connection = nm_simple_connection_new_clone (dev_checkpoint->settings_connection);
 				connection = nm_settings_add_connection (nm_settings_get (),
-				                                         dev_checkpoint->settings_connection,
+				                                         settings_connection,
 				                                         TRUE,
 				                                         &local_error);
 				if (!connection) {
@@ -313,10 +420,16 @@ activate:
 			}
 
 			if (need_activation) {
+				gs_unref_object NMConnection *applied_connection = NULL;
+
 				_LOGD ("rollback: reactivating connection %s",
 				       nm_settings_connection_get_uuid (connection));
 				subject = nm_auth_subject_new_internal ();
 
+				/* the snapshot is possibly shared with other checkpoints. The
+				 * active connection takes the applied connection and modifies it. */
+				applied_connection = nm_simple_connection_new_clone (dev_checkpoint->applied_connection);
+
 				/* Disconnect the device if needed. This necessary because now
 				 * the manager prevents the reactivation of the same connection by
 				 * an internal subject. */
@@ -329,7 +442,7 @@ activate:
 
 				if (!nm_manager_activate_connection (priv->manager,
 				                                     connection,
-				                                     dev_checkpoint->applied_connection,
+				                                     applied_connection,
 				                                     NULL,
 				                                     device,
 				                                     subject,
@@ -347,10 +460,10 @@ activate:
 			}
 		} else {
 			/* The device was initially disconnected, deactivate any existing connection */
-			_LOGD ("rollback: disconnecting device");
-
 			if (   nm_device_get_state (device) > NM_DEVICE_STATE_DISCONNECTED
 			    && nm_device_get_state (device) < NM_DEVICE_STATE_DEACTIVATING) {
+				_LOGD ("rollback: disconnecting device");
+				n_changed++;
 				nm_device_state_changed (device,
 				                         NM_DEVICE_STATE_DEACTIVATING,
 				                         NM_DEVICE_STATE_REASON_USER_REQUESTED);
@@ -401,11 +514,17 @@ next_dev:
 
 	}
 
+	_LOGI ("rollback of %s done: %u of %u devices changed (took %lld msec)",
+	       nm_dbus_object_get_path (NM_DBUS_OBJECT (self)),
+	       n_changed,
+	       g_hash_table_size (priv->devices),
+	       (long long) ((nm_utils_get_monotonic_timestamp_ns () - start_ns) / NM_UTILS_NS_PER_MSEC));
+
 	return g_variant_new ("(a{su})", &builder);
 }
 
 static DeviceCheckpoint *
-device_checkpoint_create (NMDevice *device)
+device_checkpoint_create (NMDevice *device, guint *n_shared)
 {
 	DeviceCheckpoint *dev_checkpoint;
 	NMConnection *applied_connection;
@@ -435,8 +554,12 @@ device_checkpoint_create (NMDevice *device)
 		settings_connection = nm_act_request_get_settings_connection (act_request);
 		applied_connection = nm_act_request_get_applied_connection (act_request);
 
-		dev_checkpoint->applied_connection = nm_simple_connection_new_clone (applied_connection);
-		dev_checkpoint->settings_connection = nm_simple_connection_new_clone (nm_settings_connection_get_connection (settings_connection));
+		dev_checkpoint->applied_connection = _snapshot_get (&_snapshots_applied,
+		                                                    applied_connection,
+		                                                    n_shared);
+		dev_checkpoint->settings_connection = _snapshot_get (&_snapshots_settings,
+		                                                     nm_settings_connection_get_connection (settings_connection),
+		                                                     n_shared);
 		dev_checkpoint->ac_version_id = nm_active_connection_version_id_get (NM_ACTIVE_CONNECTION (act_request));
 		dev_checkpoint->activation_reason = nm_active_connection_get_activation_reason (NM_ACTIVE_CONNECTION (act_request));
 	}
@@ -562,12 +685,16 @@ nm_checkpoint_new (NMManager *manager, GPtrArray *devices, guint32 rollback_time
 	NMCheckpointPrivate *priv;
 	NMSettingsConnection *const *con;
 	gint64 rollback_timeout_ms;
+	gint64 start_ns;
+	guint n_shared = 0;
 	guint i;
 
 	g_return_val_if_fail (manager, NULL);
 	g_return_val_if_fail (devices, NULL);
 	g_return_val_if_fail (devices->len > 0, NULL);
 
+	start_ns = nm_utils_get_monotonic_timestamp_ns ();
+
 	self = g_object_new (NM_TYPE_CHECKPOINT, NULL);
 
 	priv = NM_CHECKPOINT_GET_PRIVATE (self);
@@ -600,9 +727,14 @@ nm_checkpoint_new (NMManager *manager, GPtrArray *devices, guint32 rollback_time
 		 *        a non-existing D-Bus path of a device. */
 		g_hash_table_insert (priv->devices,
 		                     device,
-		                     device_checkpoint_create (device));
+		                     device_checkpoint_create (device, &n_shared));
 	}
 
+	_LOGD ("created for %u devices, %u connection snapshots shared (took %lld msec)",
+	       devices->len,
+	       n_shared,
+	       (long long) ((nm_utils_get_monotonic_timestamp_ns () - start_ns) / NM_UTILS_NS_PER_MSEC));
+
 	return self;
 }
 
@@ -2121,6 +2121,10 @@ nm_config_device_state_load_all (void)
 	return states;
 }
 
+/* the content of the state files that we wrote last, by ifindex. Used to skip
+ * rewriting files that didn't change. */
+static GHashTable *_device_state_written;
+
 gboolean
 nm_config_device_state_write (int ifindex,
                               NMConfigDeviceStateManagedType managed,
@@ -2133,6 +2137,8 @@ nm_config_device_state_write (int ifindex,
 	char path[NM_STRLEN (NM_CONFIG_DEVICE_STATE_DIR) + 60];
 	GError *local = NULL;
 	gs_unref_keyfile GKeyFile *kf = NULL;
+	gs_free char *data = NULL;
+	gsize data_len;
 
 	g_return_val_if_fail (ifindex > 0, FALSE);
 	g_return_val_if_fail (!connection_uuid || *connection_uuid, FALSE);
@@ -2183,11 +2189,23 @@ nm_config_device_state_write (int ifindex,
 		}
 	}
 
-	if (!g_key_file_save_to_file (kf, path, &local)) {
+	data = g_key_file_to_data (kf, &data_len, NULL);
+
+	if (!_device_state_written)
+		_device_state_written = g_hash_table_new_full (nm_direct_hash, NULL, NULL, g_free);
+	else if (nm_streq0 (g_hash_table_lookup (_device_state_written, GINT_TO_POINTER (ifindex)), data)) {
+		_LOGT ("device-state: write #%d (%s) skipped, content unchanged", ifindex, path);
+		return TRUE;
+	}
+
+	if (!g_file_set_contents (path, data, data_len, &local)) {
 		_LOGW ("device-state: write #%d (%s) failed: %s", ifindex, path, local->message);
 		g_error_free (local);
+		g_hash_table_remove (_device_state_written, GINT_TO_POINTER (ifindex));
 		return FALSE;
 	}
+	g_hash_table_insert (_device_state_written, GINT_TO_POINTER (ifindex), g_steal_pointer (&data));
+
 	_LOGT ("device-state: write #%d (%s); managed=%s%s%s%s%s%s%s, route-metric-default=%"G_GUINT32_FORMAT"-%"G_GUINT32_FORMAT"",
 	       ifindex, path,
 	       _device_state_managed_type_to_str (managed),
@@ -2231,6 +2249,8 @@ nm_config_device_state_prune_unseen (GHashTable *seen_ifindexes)
 		           }));
 		_LOGT ("device-state: prune #%d (%s)", ifindex, buf);
 		(void) unlink (buf);
+		if (_device_state_written)
+			g_hash_table_remove (_device_state_written, GINT_TO_POINTER (ifindex));
 	}
 
 	g_dir_close (dir);
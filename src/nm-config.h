@@ -60,7 +60,10 @@
 
 #define NM_CONFIG_KEYFILE_KEY_MAIN_AUTH_POLKIT              "auth-polkit"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_AUTOCONNECT_RETRIES_DEFAULT "autoconnect-retries-default"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_COMPACT_FOREIGN_ROUTES   "compact-foreign-routes"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP                     "dhcp"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_LIMIT         "dhcp-start-limit"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_DHCP_START_JITTER        "dhcp-start-jitter"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DEBUG                    "debug"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE            "hostname-mode"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER             "slaves-order"
@@ -36,6 +36,31 @@
 
 #define HEADER_STATUS_ONLINE "X-NetworkManager-Status: online\r\n"
 
+/* the total time we allow for one check (including connecting and
+ * draining the response). */
+#define CONCHECK_TIMEOUT_SEC        20
+
+/* once we know the result, we still read the remainder of the response
+ * so that the connection can be reused. But not indefinitely. */
+#define CONCHECK_DRAIN_MAX_BYTES    (16 * 1024)
+
+/* how long the address that the check host resolved to on an interface
+ * is reused for subsequent checks on that interface. */
+#define CONCHECK_PIN_TTL_SEC        300
+
+/* CURLOPT_CONNECT_TO is only available since libcurl 7.49.0. With older
+ * versions, connections are still reused but addresses are not pinned. */
+#if WITH_CONCHECK && LIBCURL_VERSION_NUM >= 0x073100
+#define CONCHECK_PIN_ADDRESS        1
+#else
+#define CONCHECK_PIN_ADDRESS        0
+#endif
+
+/* interfaces that didn't see a check for this long get their pooled
+ * easy handle released. */
+#define CONCHECK_IFACE_IDLE_SEC     600
+#define CONCHECK_IFACE_GC_SEC       60
+
 /*****************************************************************************/
 
 NM_UTILS_LOOKUP_STR_DEFINE_STATIC (_state_to_string, int /*NMConnectivityState*/,
@@ -71,9 +96,13 @@ struct _NMConnectivityCheckHandle {
 		char *response;
 
 		CURL *curl_ehandle;
-		struct curl_slist *request_headers;
+		struct curl_slist *connect_to;
 
 		GString *recv_msg;
+		gsize drained;
+
+		/* the result, once the callback was invoked. */
+		NMConnectivityState result;
 	} concheck;
 #endif
 
@@ -88,6 +117,24 @@ enum {
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+#if WITH_CONCHECK
+/* Per-interface state, shared by all checks on that interface.
+ *
+ * Established connections live in the connection cache of the multi handle,
+ * which cURL matches by interface too. As long as we don't ask for
+ * "Connection: close", consecutive checks on an interface reuse the
+ * connection. What we keep here is an idle easy handle and the address
+ * the check host resolved to on this interface, which we pin for
+ * CONCHECK_PIN_TTL_SEC with CURLOPT_CONNECT_TO. */
+typedef struct {
+	char *ifspec;
+	CURL *curl_ehandle;
+	char *connect_to;
+	gint64 connect_to_expiry_ns;
+	gint64 last_used_ns;
+} ConcheckIface;
+#endif
+
 typedef struct {
 	CList handles_lst_head;
 	char *uri;
@@ -99,6 +146,13 @@ typedef struct {
 	struct {
 		CURLM *curl_mhandle;
 		guint curl_timer;
+
+		/* "host:port" of @uri, or %NULL if the host is an IP address
+		 * literal (in which case there is nothing to pin). */
+		char *host_port;
+
+		GHashTable *ifaces;
+		gint64 ifaces_gc_ns;
 	} concheck;
 #endif
 } NMConnectivityPrivate;
@@ -158,6 +212,10 @@ cb_data_invoke_callback (NMConnectivityCheckHandle *cb_data,
 
 	cb_data->callback = NULL;
 
+#if WITH_CONCHECK
+	cb_data->concheck.result = state;
+#endif
+
 	nm_assert (log_message);
 
 	_LOG2D ("check completed: %s; %s",
@@ -190,25 +248,35 @@ cb_data_free (NMConnectivityCheckHandle *cb_data,
 #if WITH_CONCHECK
 	if (cb_data->concheck.curl_ehandle) {
 		NMConnectivityPrivate *priv;
+		ConcheckIface *c_iface;
+		CURL *ehandle = cb_data->concheck.curl_ehandle;
 
 		/* Contrary to what cURL manual claim it is *not* safe to remove
 		 * the easy handle "at any moment"; specifically not from the
 		 * write function. Thus here we just dissociate the cb_data from
 		 * the easy handle and the easy handle will be cleaned up when the
 		 * message goes to CURLMSG_DONE in _con_curl_check_connectivity(). */
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_WRITEFUNCTION, NULL);
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_WRITEDATA, NULL);
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_HEADERFUNCTION, NULL);
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_HEADERDATA, NULL);
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_PRIVATE, NULL);
-		curl_easy_setopt (cb_data->concheck.curl_ehandle, CURLOPT_HTTPHEADER, NULL);
+		curl_easy_setopt (ehandle, CURLOPT_WRITEFUNCTION, NULL);
+		curl_easy_setopt (ehandle, CURLOPT_WRITEDATA, NULL);
+		curl_easy_setopt (ehandle, CURLOPT_HEADERFUNCTION, NULL);
+		curl_easy_setopt (ehandle, CURLOPT_HEADERDATA, NULL);
+		curl_easy_setopt (ehandle, CURLOPT_PRIVATE, NULL);
+#if CONCHECK_PIN_ADDRESS
+		curl_easy_setopt (ehandle, CURLOPT_CONNECT_TO, NULL);
+#endif
 
 		priv = NM_CONNECTIVITY_GET_PRIVATE (self);
 
-		curl_multi_remove_handle (priv->concheck.curl_mhandle, cb_data->concheck.curl_ehandle);
-		curl_easy_cleanup (cb_data->concheck.curl_ehandle);
+		curl_multi_remove_handle (priv->concheck.curl_mhandle, ehandle);
 
-		curl_slist_free_all (cb_data->concheck.request_headers);
+		/* keep the easy handle for the next check on this interface. */
+		c_iface = g_hash_table_lookup (priv->concheck.ifaces, cb_data->ifspec);
+		if (c_iface && !c_iface->curl_ehandle)
+			c_iface->curl_ehandle = ehandle;
+		else
+			curl_easy_cleanup (ehandle);
+
+		curl_slist_free_all (cb_data->concheck.connect_to);
 	}
 #endif
 
@@ -228,6 +296,165 @@ cb_data_free (NMConnectivityCheckHandle *cb_data,
 /*****************************************************************************/
 
 #if WITH_CONCHECK
+static void
+_con_iface_free (gpointer data)
+{
+	ConcheckIface *c_iface = data;
+
+	if (c_iface->curl_ehandle)
+		curl_easy_cleanup (c_iface->curl_ehandle);
+	g_free (c_iface->connect_to);
+	g_free (c_iface->ifspec);
+	g_slice_free (ConcheckIface, c_iface);
+}
+
+static void
+_con_ifaces_update_maxconnects (NMConnectivity *self)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+
+	/* keep (at most) one idle connection per interface around. */
+	curl_multi_setopt (priv->concheck.curl_mhandle,
+	                   CURLMOPT_MAXCONNECTS,
+	                   (long) NM_MAX (g_hash_table_size (priv->concheck.ifaces), 1u));
+}
+
+static void
+_con_ifaces_gc (NMConnectivity *self, gint64 now_ns)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	GHashTableIter iter;
+	ConcheckIface *c_iface;
+	gint64 idle_ns;
+	gboolean changed = FALSE;
+
+	if (now_ns < priv->concheck.ifaces_gc_ns)
+		return;
+	priv->concheck.ifaces_gc_ns = now_ns + (CONCHECK_IFACE_GC_SEC * NM_UTILS_NS_PER_SECOND);
+
+	idle_ns = NM_MAX ((gint64) CONCHECK_IFACE_IDLE_SEC, 2 * ((gint64) priv->interval)) * NM_UTILS_NS_PER_SECOND;
+
+	g_hash_table_iter_init (&iter, priv->concheck.ifaces);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &c_iface)) {
+		if (c_iface->last_used_ns + idle_ns < now_ns) {
+			g_hash_table_iter_remove (&iter);
+			changed = TRUE;
+		}
+	}
+
+	if (changed)
+		_con_ifaces_update_maxconnects (self);
+}
+
+static ConcheckIface *
+_con_iface_get (NMConnectivity *self, const char *ifspec, gint64 now_ns)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	ConcheckIface *c_iface;
+
+	c_iface = g_hash_table_lookup (priv->concheck.ifaces, ifspec);
+	if (!c_iface) {
+		c_iface = g_slice_new0 (ConcheckIface);
+		c_iface->ifspec = g_strdup (ifspec);
+		g_hash_table_insert (priv->concheck.ifaces, c_iface->ifspec, c_iface);
+		_con_ifaces_update_maxconnects (self);
+	}
+	c_iface->last_used_ns = now_ns;
+	return c_iface;
+}
+
+static void
+_con_iface_pin_update (NMConnectivity *self,
+                       NMConnectivityCheckHandle *cb_data,
+                       CURL *ehandle,
+                       NMConnectivityState state)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	ConcheckIface *c_iface;
+	const char *ip = NULL;
+	gint64 now_ns;
+
+	if (   !CONCHECK_PIN_ADDRESS
+	    || !priv->concheck.host_port)
+		return;
+
+	c_iface = g_hash_table_lookup (priv->concheck.ifaces, cb_data->ifspec);
+	if (!c_iface)
+		return;
+
+	if (state != NM_CONNECTIVITY_FULL) {
+		/* the pinned address might be the reason for the failure, or it
+		 * might belong to a captive portal. Resolve anew the next time. */
+		if (c_iface->connect_to) {
+			_LOG2T ("drop pinned address");
+			nm_clear_g_free (&c_iface->connect_to);
+		}
+		return;
+	}
+
+	now_ns = nm_utils_get_monotonic_timestamp_ns ();
+	if (   c_iface->connect_to
+	    && c_iface->connect_to_expiry_ns > now_ns)
+		return;
+
+	if (   curl_easy_getinfo (ehandle, CURLINFO_PRIMARY_IP, &ip) != CURLE_OK
+	    || !ip
+	    || !ip[0])
+		return;
+
+	g_free (c_iface->connect_to);
+	if (strchr (ip, ':'))
+		c_iface->connect_to = g_strdup_printf ("%s:[%s]:", priv->concheck.host_port, ip);
+	else
+		c_iface->connect_to = g_strdup_printf ("%s:%s:", priv->concheck.host_port, ip);
+	c_iface->connect_to_expiry_ns = now_ns + (CONCHECK_PIN_TTL_SEC * NM_UTILS_NS_PER_SECOND);
+	_LOG2T ("pin address %s for %d seconds", ip, CONCHECK_PIN_TTL_SEC);
+}
+
+static char *
+_con_uri_get_host_port (const char *uri)
+{
+	gs_free char *scheme = NULL;
+	gs_free char *host = NULL;
+	const char *authority;
+	const char *port;
+	const char *s;
+	gsize len;
+
+	scheme = g_uri_parse_scheme (uri);
+	if (!scheme)
+		return NULL;
+
+	authority = strstr (uri, "://");
+	if (!authority)
+		return NULL;
+	authority += 3;
+
+	len = strcspn (authority, "/?#");
+	s = memchr (authority, '@', len);
+	if (s) {
+		len -= (s + 1) - authority;
+		authority = s + 1;
+	}
+
+	if (   len == 0
+	    || authority[0] == '[') {
+		/* IPv6 address literal. Nothing to resolve. */
+		return NULL;
+	}
+
+	port = memchr (authority, ':', len);
+	host = g_strndup (authority, port ? (gsize) (port - authority) : len);
+	if (   !host[0]
+	    || nm_utils_parse_inaddr_bin (AF_INET, host, NULL))
+		return NULL;
+
+	if (port)
+		return g_strndup (authority, len);
+	return g_strdup_printf ("%s:%s", host,
+	                        strcasecmp (scheme, "https") == 0 ? "443" : "80");
+}
+
 static const char *
 _check_handle_get_response (NMConnectivityCheckHandle *cb_data)
 {
@@ -242,6 +469,9 @@ _con_curl_check_connectivity (CURLM *mhandle, int sockfd, int ev_bitmask)
 	CURLcode eret;
 	int m_left;
 	long response_code;
+	NMConnectivityState state;
+	const char *log_message;
+	gs_free char *log_message_free = NULL;
 	CURLMcode ret;
 	int running_handles;
 	gboolean success = TRUE;
@@ -266,29 +496,44 @@ _con_curl_check_connectivity (CURLM *mhandle, int sockfd, int ev_bitmask)
 		}
 
 		if (!cb_data->callback) {
-			/* callback was already invoked earlier. */
-			cb_data_free (cb_data, NM_CONNECTIVITY_UNKNOWN, NULL, NULL);
+			/* callback was already invoked earlier. We might have aborted
+			 * draining the response, which doesn't affect the result. */
+			state = cb_data->concheck.result;
+			log_message = NULL;
+		} else if (msg->data.result == CURLE_OPERATION_TIMEDOUT) {
+			state = NM_CONNECTIVITY_LIMITED;
+			log_message = "timeout";
 		} else if (msg->data.result != CURLE_OK) {
-			gs_free char *log_message = NULL;
-
-			log_message = g_strdup_printf ("check failed with curl status %d", msg->data.result);
-			cb_data_free (cb_data, NM_CONNECTIVITY_LIMITED, NULL,
-			              log_message);
+			state = NM_CONNECTIVITY_LIMITED;
+			nm_clear_g_free (&log_message_free);
+			log_message = log_message_free = g_strdup_printf ("check failed with curl status %d", msg->data.result);
 		} else if (   !((_check_handle_get_response (cb_data))[0])
 		           && (curl_easy_getinfo (msg->easy_handle, CURLINFO_RESPONSE_CODE, &response_code) == CURLE_OK)
 		           && response_code == 204) {
 			/* If we got a 204 response code (no content) and we actually
 			 * requested no content, report full connectivity. */
-			cb_data_free (cb_data, NM_CONNECTIVITY_FULL, NULL,
-			              "no content, as expected");
+			state = NM_CONNECTIVITY_FULL;
+			log_message = "no content, as expected";
 		} else {
 			/* If we get here, it means that easy_write_cb() didn't read enough
 			 * bytes to be able to do a match, or that we were asking for no content
 			 * (204 response code) and we actually got some. Either way, that is
 			 * an indication of a captive portal */
-			cb_data_free (cb_data, NM_CONNECTIVITY_PORTAL, NULL,
-			              "unexpected short response");
+			state = NM_CONNECTIVITY_PORTAL;
+			log_message = "unexpected short response";
 		}
+
+		/* only pin the address of a host that gave the expected response.
+		 * Otherwise we might keep talking to a captive portal. */
+		_con_iface_pin_update (NM_CONNECTIVITY (cb_data->self),
+		                       cb_data,
+		                       msg->easy_handle,
+		                       state);
+
+		if (!cb_data->callback)
+			cb_data_free (cb_data, NM_CONNECTIVITY_UNKNOWN, NULL, NULL);
+		else
+			cb_data_free (cb_data, state, NULL, log_message);
 	}
 
 	/* if we return a failure, we don't know what went wrong. It's likely serious, because
@@ -419,11 +664,11 @@ easy_header_cb (char *buffer, size_t size, size_t nitems, void *userdata)
 	NMConnectivityCheckHandle *cb_data = userdata;
 	size_t len = size * nitems;
 
-	if (   len >= sizeof (HEADER_STATUS_ONLINE) - 1
+	if (   cb_data->callback
+	    && len >= sizeof (HEADER_STATUS_ONLINE) - 1
 	    && !g_ascii_strncasecmp (buffer, HEADER_STATUS_ONLINE, sizeof (HEADER_STATUS_ONLINE) - 1)) {
 		cb_data_invoke_callback (cb_data, NM_CONNECTIVITY_FULL,
 		                         NULL, "status header found");
-		return 0;
 	}
 
 	return len;
@@ -436,6 +681,16 @@ easy_write_cb (void *buffer, size_t size, size_t nmemb, void *userdata)
 	size_t len = size * nmemb;
 	const char *response = _check_handle_get_response (cb_data);;
 
+	if (!cb_data->callback) {
+		/* We already know the result. Read the rest of the response, so that
+		 * cURL can keep the connection for the next check. Unless the response
+		 * is unreasonably large, which is the case with some portals. */
+		cb_data->concheck.drained += len;
+		if (cb_data->concheck.drained > CONCHECK_DRAIN_MAX_BYTES)
+			return 0;
+		return len;
+	}
+
 	if (!cb_data->concheck.recv_msg)
 		cb_data->concheck.recv_msg = g_string_sized_new (len + 10);
 
@@ -451,28 +706,11 @@ easy_write_cb (void *buffer, size_t size, size_t nmemb, void *userdata)
 			cb_data_invoke_callback (cb_data, NM_CONNECTIVITY_PORTAL, NULL,
 			                         "unexpected response");
 		}
-
-		return 0;
+		cb_data->concheck.drained = cb_data->concheck.recv_msg->len;
 	}
 
 	return len;
 }
-
-static gboolean
-_timeout_cb (gpointer user_data)
-{
-	NMConnectivityCheckHandle *cb_data = user_data;
-	NMConnectivity *self;
-
-	nm_assert (NM_IS_CONNECTIVITY (cb_data->self));
-
-	self = cb_data->self;
-
-	nm_assert (c_list_contains (&NM_CONNECTIVITY_GET_PRIVATE (self)->handles_lst_head, &cb_data->handles_lst));
-
-	cb_data_free (cb_data, NM_CONNECTIVITY_LIMITED, NULL, "timeout");
-	return G_SOURCE_REMOVE;
-}
 #endif
 
 static gboolean
@@ -521,28 +759,47 @@ nm_connectivity_check_start (NMConnectivity *self,
 		cb_data->ifspec = g_strdup_printf ("if!%s", iface);
 
 #if WITH_CONCHECK
-	if (iface) {
+	if (   iface
+	    && priv->enabled) {
+		ConcheckIface *c_iface;
 		CURL *ehandle;
+		gint64 now_ns;
+
+		now_ns = nm_utils_get_monotonic_timestamp_ns ();
+		_con_ifaces_gc (self, now_ns);
+		c_iface = _con_iface_get (self, cb_data->ifspec, now_ns);
+
+		ehandle = g_steal_pointer (&c_iface->curl_ehandle);
+		if (!ehandle) {
+			ehandle = curl_easy_init ();
+			if (ehandle) {
+				curl_easy_setopt (ehandle, CURLOPT_INTERFACE, c_iface->ifspec);
+				curl_easy_setopt (ehandle, CURLOPT_TIMEOUT, (long) CONCHECK_TIMEOUT_SEC);
+			}
+		}
 
-		if (   priv->enabled
-		    && (ehandle = curl_easy_init ())) {
+		if (ehandle) {
+			if (   c_iface->connect_to
+			    && c_iface->connect_to_expiry_ns <= now_ns)
+				nm_clear_g_free (&c_iface->connect_to);
 
 			cb_data->concheck.response = g_strdup (priv->response);
 			cb_data->concheck.curl_ehandle = ehandle;
-			cb_data->concheck.request_headers = curl_slist_append (NULL, "Connection: close");
+			if (c_iface->connect_to)
+				cb_data->concheck.connect_to = curl_slist_append (NULL, c_iface->connect_to);
 			curl_easy_setopt (ehandle, CURLOPT_URL, priv->uri);
 			curl_easy_setopt (ehandle, CURLOPT_WRITEFUNCTION, easy_write_cb);
 			curl_easy_setopt (ehandle, CURLOPT_WRITEDATA, cb_data);
 			curl_easy_setopt (ehandle, CURLOPT_HEADERFUNCTION, easy_header_cb);
 			curl_easy_setopt (ehandle, CURLOPT_HEADERDATA, cb_data);
 			curl_easy_setopt (ehandle, CURLOPT_PRIVATE, cb_data);
-			curl_easy_setopt (ehandle, CURLOPT_HTTPHEADER, cb_data->concheck.request_headers);
-			curl_easy_setopt (ehandle, CURLOPT_INTERFACE, cb_data->ifspec);
+#if CONCHECK_PIN_ADDRESS
+			curl_easy_setopt (ehandle, CURLOPT_CONNECT_TO, cb_data->concheck.connect_to);
+#endif
 			curl_multi_add_handle (priv->concheck.curl_mhandle, ehandle);
 
-			cb_data->timeout_id = g_timeout_add_seconds (20, _timeout_cb, cb_data);
-
-			_LOG2D ("start request to '%s'", priv->uri);
+			_LOG2D ("start request to '%s'%s", priv->uri,
+			        c_iface->connect_to ? " (pinned address)" : "");
 			return cb_data;
 		}
 	}
@@ -594,6 +851,30 @@ nm_connectivity_get_interval (NMConnectivity *self)
 	       : 0;
 }
 
+/* Returns %FALSE if addresses are never pinned. Otherwise, @out_connect_to
+ * is set to the "host:port:address:" pinned for @iface, if any. */
+gboolean
+_nm_connectivity_get_pinned_address (NMConnectivity *self,
+                                     const char *iface,
+                                     const char **out_connect_to)
+{
+#if CONCHECK_PIN_ADDRESS
+	gs_free char *ifspec = NULL;
+	ConcheckIface *c_iface;
+
+	g_return_val_if_fail (NM_IS_CONNECTIVITY (self), FALSE);
+	g_return_val_if_fail (iface, FALSE);
+
+	ifspec = g_strdup_printf ("if!%s", iface);
+	c_iface = g_hash_table_lookup (NM_CONNECTIVITY_GET_PRIVATE (self)->concheck.ifaces, ifspec);
+	NM_SET_OUT (out_connect_to, c_iface ? c_iface->connect_to : NULL);
+	return TRUE;
+#else
+	NM_SET_OUT (out_connect_to, NULL);
+	return FALSE;
+#endif
+}
+
 static void
 update_config (NMConnectivity *self, NMConfigData *config_data)
 {
@@ -627,6 +908,13 @@ update_config (NMConnectivity *self, NMConfigData *config_data)
 	if (changed) {
 		g_free (priv->uri);
 		priv->uri = g_strdup (uri);
+#if WITH_CONCHECK
+		/* connections and pinned addresses are for the previous host. */
+		g_free (priv->concheck.host_port);
+		priv->concheck.host_port = uri ? _con_uri_get_host_port (uri) : NULL;
+		if (priv->concheck.ifaces)
+			g_hash_table_remove_all (priv->concheck.ifaces);
+#endif
 	}
 
 	/* Set the interval. */
@@ -692,6 +980,8 @@ nm_connectivity_init (NMConnectivity *self)
 	                  self);
 
 #if WITH_CONCHECK
+	priv->concheck.ifaces = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, _con_iface_free);
+
 	if (curl_global_init (CURL_GLOBAL_ALL) == CURLE_OK)
 		priv->concheck.curl_mhandle = curl_multi_init ();
 
@@ -732,6 +1022,9 @@ again:
 #if WITH_CONCHECK
 	nm_clear_g_source (&priv->concheck.curl_timer);
 
+	g_clear_pointer (&priv->concheck.ifaces, g_hash_table_unref);
+	g_clear_pointer (&priv->concheck.host_port, g_free);
+
 	curl_multi_cleanup (priv->concheck.curl_mhandle);
 	curl_global_cleanup ();
 #endif
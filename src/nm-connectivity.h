@@ -63,4 +63,9 @@ NMConnectivityCheckHandle *nm_connectivity_check_start (NMConnectivity *self,
 
 void nm_connectivity_check_cancel (NMConnectivityCheckHandle *handle);
 
+/* For testcases only! */
+gboolean _nm_connectivity_get_pinned_address (NMConnectivity *self,
+                                              const char *iface,
+                                              const char **out_connect_to);
+
 #endif /* __NETWORKMANAGER_CONNECTIVITY_H__ */
@@ -196,6 +196,14 @@ typedef struct {
 
 	guint devices_inited_id;
 
+	/* devices whose state file needs to be written. */
+	GHashTable *device_state_pending;
+	guint device_state_write_id;
+
+	/* settings connections indexed by "<type>" and "<type>\n<interface-name>",
+	 * to find candidates when assuming devices. Built lazily. */
+	GHashTable *assume_index;
+
 	NMConnectivityState connectivity_state;
 
 	bool startup:1;
@@ -1475,6 +1483,53 @@ nm_manager_update_state (NMManager *self)
 	                            (guint32) priv->state);
 }
 
+/* Writing the device state is delayed shortly, so that bursts of state
+ * changes (like when activating many devices at once) only result in
+ * one write per device. */
+#define DEVICE_STATE_WRITE_DELAY_MSEC 200
+
+static gboolean
+_device_state_write_cb (gpointer user_data)
+{
+	NMManager *self = user_data;
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	NMDevice *device;
+
+	priv->device_state_write_id = 0;
+
+	g_hash_table_iter_init (&iter, priv->device_state_pending);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &device, NULL)) {
+		g_hash_table_iter_remove (&iter);
+		nm_manager_write_device_state (self, device);
+	}
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_device_state_schedule_write (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	g_hash_table_add (priv->device_state_pending, device);
+	if (!priv->device_state_write_id) {
+		priv->device_state_write_id = g_timeout_add (DEVICE_STATE_WRITE_DELAY_MSEC,
+		                                             _device_state_write_cb,
+		                                             self);
+	}
+}
+
+static void
+_device_state_flush (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	if (g_hash_table_remove (priv->device_state_pending, device))
+		nm_manager_write_device_state (self, device);
+	if (g_hash_table_size (priv->device_state_pending) == 0)
+		nm_clear_g_source (&priv->device_state_write_id);
+}
+
 static void
 manager_device_state_changed (NMDevice *device,
                               NMDeviceState new_state,
@@ -1501,7 +1556,7 @@ manager_device_state_changed (NMDevice *device,
 	               NM_DEVICE_STATE_UNMANAGED,
 	               NM_DEVICE_STATE_DISCONNECTED,
 	               NM_DEVICE_STATE_ACTIVATED))
-		nm_manager_write_device_state (self, device);
+		_device_state_schedule_write (self, device);
 
 	if (NM_IN_SET (new_state,
 	               NM_DEVICE_STATE_UNAVAILABLE,
@@ -1509,6 +1564,95 @@ manager_device_state_changed (NMDevice *device,
 		nm_settings_device_added (priv->settings, device);
 }
 
+/*****************************************************************************/
+
+static void
+_assume_index_add (GHashTable *idx,
+                   char *key_take,
+                   NMSettingsConnection *sett_conn)
+{
+	GPtrArray *arr;
+
+	arr = g_hash_table_lookup (idx, key_take);
+	if (!arr) {
+		arr = g_ptr_array_new ();
+		g_hash_table_insert (idx, key_take, arr);
+	} else
+		g_free (key_take);
+	g_ptr_array_add (arr, sett_conn);
+}
+
+static void
+_assume_index_remove (GHashTable *idx,
+                      const char *key,
+                      NMSettingsConnection *sett_conn)
+{
+	GPtrArray *arr;
+
+	arr = g_hash_table_lookup (idx, key);
+	if (!arr)
+		return;
+	g_ptr_array_remove_fast (arr, sett_conn);
+	if (arr->len == 0)
+		g_hash_table_remove (idx, key);
+}
+
+static void
+_assume_index_update (NMManager *self,
+                      NMSettingsConnection *sett_conn,
+                      gboolean add)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	NMConnection *connection;
+	const char *type;
+	const char *ifname;
+
+	if (!priv->assume_index)
+		return;
+
+	connection = nm_settings_connection_get_connection (sett_conn);
+	type = nm_connection_get_connection_type (connection);
+	if (!type)
+		return;
+	ifname = nm_connection_get_interface_name (connection);
+
+	if (add) {
+		_assume_index_add (priv->assume_index, g_strdup (type), sett_conn);
+		_assume_index_add (priv->assume_index, g_strdup_printf ("%s\n%s", type, ifname ?: ""), sett_conn);
+	} else {
+		gs_free char *key = g_strdup_printf ("%s\n%s", type, ifname ?: "");
+
+		_assume_index_remove (priv->assume_index, type, sett_conn);
+		_assume_index_remove (priv->assume_index, key, sett_conn);
+	}
+}
+
+static void
+_assume_index_clear (NMManager *self)
+{
+	nm_clear_pointer (&NM_MANAGER_GET_PRIVATE (self)->assume_index, g_hash_table_unref);
+}
+
+static GHashTable *
+_assume_index_get (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	NMSettingsConnection *const*list;
+	guint i, len;
+
+	if (priv->assume_index)
+		return priv->assume_index;
+
+	priv->assume_index = g_hash_table_new_full (nm_str_hash, g_str_equal,
+	                                            g_free, (GDestroyNotify) g_ptr_array_unref);
+	list = nm_settings_get_connections (priv->settings, &len);
+	for (i = 0; i < len; i++)
+		_assume_index_update (self, list[i], TRUE);
+	return priv->assume_index;
+}
+
+/*****************************************************************************/
+
 static void device_has_pending_action_changed (NMDevice *device,
                                                GParamSpec *pspec,
                                                NMManager *self);
@@ -1542,6 +1686,10 @@ check_if_startup_complete (NMManager *self)
 
 	priv->startup = FALSE;
 
+	/* the index mostly pays off while assuming all devices at startup. Drop it,
+	 * it gets rebuilt on demand. */
+	_assume_index_clear (self);
+
 	/* we no longer care about these signals. Startup-complete only
 	 * happens once. */
 	g_signal_handlers_disconnect_by_func (priv->settings, G_CALLBACK (settings_startup_complete_changed), self);
@@ -1637,6 +1785,10 @@ remove_device (NMManager *self,
 		}
 	}
 
+	/* don't lose a pending write of the device state, for example
+	 * after unmanaging the device above. */
+	_device_state_flush (self, device);
+
 	g_signal_handlers_disconnect_matched (device, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
 
 	nm_settings_device_removed (priv->settings, device, quitting);
@@ -2054,6 +2206,7 @@ connection_added_cb (NMSettings *settings,
                      NMSettingsConnection *sett_conn,
                      NMManager *self)
 {
+	_assume_index_update (self, sett_conn, TRUE);
 	connection_changed (self, sett_conn);
 }
 
@@ -2063,10 +2216,21 @@ connection_updated_cb (NMSettings *settings,
                        gboolean by_user,
                        NMManager *self)
 {
+	/* the type or interface-name might have changed, we don't know
+	 * the previous values. */
+	_assume_index_clear (self);
 	if (by_user)
 		connection_changed (self, sett_conn);
 }
 
+static void
+connection_removed_cb (NMSettings *settings,
+                       NMSettingsConnection *sett_conn,
+                       NMManager *self)
+{
+	_assume_index_update (self, sett_conn, FALSE);
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -2421,6 +2585,97 @@ new_activation_allowed_for_connection (NMManager *self,
 	                                NULL);
 }
 
+/*****************************************************************************/
+
+/**
+ * _assume_candidates_get:
+ * @self: the #NMManager
+ * @connection: the connection generated from the device
+ * @exclude: (allow-none): a settings connection to skip
+ * @out_len: the number of returned candidates
+ *
+ * Returns the activatable settings connections that can possibly match
+ * @connection in nm_utils_match_connection(). A candidate must have the
+ * same connection type, an interface-name that is either unset or equal,
+ * and a wired MAC address that is either unset or equal. Anything else would
+ * show up as a difference that nm_utils_match_connection() does not tolerate.
+ *
+ * Returns: (transfer container): the %NULL terminated, unsorted list of
+ *   candidates.
+ */
+static NMSettingsConnection **
+_assume_candidates_get (NMManager *self,
+                        NMConnection *connection,
+                        NMSettingsConnection *exclude,
+                        guint *out_len)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	const GetActivatableConnectionsFilterData d = {
+		.self = self,
+		.for_auto_activation = FALSE,
+	};
+	GHashTable *idx;
+	GPtrArray *arrs[2] = { NULL, NULL };
+	NMSettingsConnection **list;
+	NMSettingWired *s_wired;
+	const char *type;
+	const char *ifname;
+	const char *mac = NULL;
+	guint i, k, j = 0;
+
+	type = nm_connection_get_connection_type (connection);
+	if (!type) {
+		*out_len = 0;
+		return NULL;
+	}
+
+	idx = _assume_index_get (self);
+	ifname = nm_connection_get_interface_name (connection);
+	if (ifname) {
+		gs_free char *key_bound = g_strdup_printf ("%s\n%s", type, ifname);
+		gs_free char *key_unbound = g_strdup_printf ("%s\n", type);
+
+		arrs[0] = g_hash_table_lookup (idx, key_bound);
+		arrs[1] = g_hash_table_lookup (idx, key_unbound);
+	} else
+		arrs[0] = g_hash_table_lookup (idx, type);
+
+	s_wired = nm_connection_get_setting_wired (connection);
+	if (s_wired)
+		mac = nm_setting_wired_get_mac_address (s_wired);
+
+	list = g_new (NMSettingsConnection *, (arrs[0] ? arrs[0]->len : 0u) + (arrs[1] ? arrs[1]->len : 0u) + 1u);
+	for (k = 0; k < G_N_ELEMENTS (arrs); k++) {
+		if (!arrs[k])
+			continue;
+		for (i = 0; i < arrs[k]->len; i++) {
+			NMSettingsConnection *sett_conn = arrs[k]->pdata[i];
+
+			if (sett_conn == exclude)
+				continue;
+
+			if (mac) {
+				NMSettingWired *s_wired_cand;
+				const char *cand_mac;
+
+				s_wired_cand = nm_connection_get_setting_wired (nm_settings_connection_get_connection (sett_conn));
+				cand_mac = s_wired_cand ? nm_setting_wired_get_mac_address (s_wired_cand) : NULL;
+				if (   cand_mac
+				    && !nm_utils_hwaddr_matches (mac, -1, cand_mac, -1))
+					continue;
+			}
+
+			if (!_get_activatable_connections_filter (priv->settings, sett_conn, (gpointer) &d))
+				continue;
+
+			list[j++] = sett_conn;
+		}
+	}
+	list[j] = NULL;
+	*out_len = j;
+	return list;
+}
+
 /**
  * get_existing_connection:
  * @manager: #NMManager instance
@@ -2539,16 +2794,17 @@ get_existing_connection (NMManager *self,
 		guint len, i, j;
 
 		/* the state file doesn't indicate a connection UUID to assume. Search the
-		 * persistent connections for a matching candidate. */
-		sett_conns = nm_manager_get_activatable_connections (self, FALSE, FALSE, &len);
+		 * persistent connections for a matching candidate. Only look at the ones
+		 * that can possibly match, this matters during startup when many devices
+		 * get assumed against many profiles. */
+		sett_conns = _assume_candidates_get (self, connection, connection_checked, &len);
 		if (len > 0) {
 			for (i = 0, j = 0; i < len; i++) {
 				NMSettingsConnection *sett_conn = sett_conns[i];
 
-				if (   sett_conn != connection_checked
-				    && nm_device_check_connection_compatible (device,
-				                                              nm_settings_connection_get_connection (sett_conn),
-				                                              NULL))
+				if (nm_device_check_connection_compatible (device,
+				                                           nm_settings_connection_get_connection (sett_conn),
+				                                           NULL))
 					sett_conns[j++] = sett_conn;
 			}
 			sett_conns[j] = NULL;
@@ -6153,6 +6409,10 @@ nm_manager_write_device_state_all (NMManager *self)
 
 	seen_ifindexes = g_hash_table_new (nm_direct_hash, NULL);
 
+	/* we write the state of all devices, including those with pending writes. */
+	g_hash_table_remove_all (priv->device_state_pending);
+	nm_clear_g_source (&priv->device_state_write_id);
+
 	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
 		if (nm_manager_write_device_state (self, device)) {
 			g_hash_table_add (seen_ifindexes,
@@ -6976,6 +7236,8 @@ constructed (GObject *object)
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_UPDATED,
 	                  G_CALLBACK (connection_updated_cb), self);
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_FLAGS_CHANGED, G_CALLBACK (connection_flags_changed), self);
+	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_REMOVED,
+	                  G_CALLBACK (connection_removed_cb), self);
 
 	priv->hostname_manager = g_object_ref (nm_hostname_manager_get ());
 	g_signal_connect (priv->hostname_manager, "notify::" NM_HOSTNAME_MANAGER_HOSTNAME,
@@ -6984,7 +7246,8 @@ constructed (GObject *object)
 	/*
 	 * Do not delete existing virtual devices to keep connectivity up.
 	 * Virtual devices are reused when NetworkManager is restarted.
-	 * Hence, don't react on NM_SETTINGS_SIGNAL_CONNECTION_REMOVED.
+	 * Hence, don't react on NM_SETTINGS_SIGNAL_CONNECTION_REMOVED, other than
+	 * by dropping the connection from the index of assume candidates.
 	 */
 
 	priv->policy = nm_policy_new (self, priv->settings);
@@ -7038,6 +7301,8 @@ nm_manager_init (NMManager *self)
 	c_list_init (&priv->async_op_lst_head);
 	c_list_init (&priv->delete_volatile_connection_lst_head);
 
+	priv->device_state_pending = g_hash_table_new (nm_direct_hash, NULL);
+
 	priv->platform = g_object_ref (NM_PLATFORM_GET);
 
 	priv->capabilities = g_array_new (FALSE, FALSE, sizeof (guint32));
@@ -7338,12 +7603,15 @@ dispose (GObject *object)
 		g_clear_object (&priv->policy);
 	}
 
+	_assume_index_clear (self);
+
 	if (priv->settings) {
 		g_signal_handlers_disconnect_by_func (priv->settings, settings_startup_complete_changed, self);
 		g_signal_handlers_disconnect_by_func (priv->settings, system_unmanaged_devices_changed_cb, self);
 		g_signal_handlers_disconnect_by_func (priv->settings, connection_added_cb, self);
 		g_signal_handlers_disconnect_by_func (priv->settings, connection_updated_cb, self);
 		g_signal_handlers_disconnect_by_func (priv->settings, connection_flags_changed, self);
+		g_signal_handlers_disconnect_by_func (priv->settings, connection_removed_cb, self);
 		g_clear_object (&priv->settings);
 	}
 
@@ -7385,6 +7653,8 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timestamp_update_id);
 
+	nm_clear_g_source (&priv->device_state_write_id);
+
 	g_clear_pointer (&priv->device_route_metrics, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_manager_parent_class)->dispose (object);
@@ -7397,6 +7667,9 @@ finalize (GObject *object)
 
 	g_array_free (priv->capabilities, TRUE);
 
+	nm_assert (g_hash_table_size (priv->device_state_pending) == 0);
+	g_hash_table_unref (priv->device_state_pending);
+
 	G_OBJECT_CLASS (nm_manager_parent_class)->finalize (object);
 
 	g_object_unref (priv->platform);
@@ -772,6 +772,43 @@ link_vlan_change (NMPlatform *platform,
 	return FALSE;
 }
 
+static gboolean
+link_bond_change (NMPlatform *platform,
+                  int ifindex,
+                  const NMPlatformLnkBond *props)
+{
+	return FALSE;
+}
+
+static gboolean
+link_bridge_change (NMPlatform *platform,
+                    int ifindex,
+                    const NMPlatformLnkBridge *props)
+{
+	return FALSE;
+}
+
+static gboolean
+link_wireguard_change (NMPlatform *platform,
+                       int ifindex,
+                       const NMPlatformLnkWireGuard *lnk_wireguard,
+                       const NMPWireGuardPeer *peers,
+                       guint peers_len,
+                       gboolean replace_peers)
+{
+	return FALSE;
+}
+
+static gboolean
+link_bridge_port_change (NMPlatform *platform,
+                         int ifindex,
+                         guint16 priority,
+                         guint32 path_cost,
+                         gboolean hairpin)
+{
+	return FALSE;
+}
+
 static void
 _vxlan_add_prepare (NMPlatform *platform,
                     NMFakePlatformLink *device,
@@ -1422,6 +1459,10 @@ nm_fake_platform_class_init (NMFakePlatformClass *klass)
 
 	platform_class->vlan_add = vlan_add;
 	platform_class->link_vlan_change = link_vlan_change;
+	platform_class->link_bond_change = link_bond_change;
+	platform_class->link_bridge_change = link_bridge_change;
+	platform_class->link_wireguard_change = link_wireguard_change;
+	platform_class->link_bridge_port_change = link_bridge_port_change;
 	platform_class->link_vxlan_add = link_vxlan_add;
 
 	platform_class->infiniband_partition_add = infiniband_partition_add;
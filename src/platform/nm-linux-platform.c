@@ -183,6 +183,55 @@ G_STATIC_ASSERT (RTA_MAX == (__RTA_MAX - 1));
 
 /*****************************************************************************/
 
+#define IFLA_INFO_SLAVE_KIND            4
+#define IFLA_INFO_SLAVE_DATA            5
+
+#define IFLA_BOND_UNSPEC                0
+#define IFLA_BOND_MODE                  1
+#define IFLA_BOND_ACTIVE_SLAVE          2
+#define IFLA_BOND_MIIMON                3
+#define IFLA_BOND_UPDELAY               4
+#define IFLA_BOND_DOWNDELAY             5
+#define IFLA_BOND_USE_CARRIER           6
+#define IFLA_BOND_ARP_INTERVAL          7
+#define IFLA_BOND_ARP_IP_TARGET         8
+#define IFLA_BOND_ARP_VALIDATE          9
+#define IFLA_BOND_ARP_ALL_TARGETS       10
+#define IFLA_BOND_PRIMARY               11
+#define IFLA_BOND_PRIMARY_RESELECT      12
+#define IFLA_BOND_FAIL_OVER_MAC         13
+#define IFLA_BOND_XMIT_HASH_POLICY      14
+#define IFLA_BOND_RESEND_IGMP           15
+#define IFLA_BOND_NUM_PEER_NOTIF        16
+#define IFLA_BOND_ALL_SLAVES_ACTIVE     17
+#define IFLA_BOND_MIN_LINKS             18
+#define IFLA_BOND_LP_INTERVAL           19
+#define IFLA_BOND_PACKETS_PER_SLAVE     20
+#define IFLA_BOND_AD_LACP_RATE          21
+#define IFLA_BOND_AD_SELECT             22
+#define IFLA_BOND_AD_INFO               23
+#define IFLA_BOND_AD_ACTOR_SYS_PRIO     24
+#define IFLA_BOND_AD_USER_PORT_KEY      25
+#define IFLA_BOND_AD_ACTOR_SYSTEM       26
+#define IFLA_BOND_TLB_DYNAMIC_LB        27
+#define __IFLA_BOND_MAX                 28
+
+#define IFLA_BR_UNSPEC                  0
+#define IFLA_BR_FORWARD_DELAY           1
+#define IFLA_BR_HELLO_TIME              2
+#define IFLA_BR_MAX_AGE                 3
+#define IFLA_BR_AGEING_TIME             4
+#define IFLA_BR_STP_STATE               5
+#define IFLA_BR_PRIORITY                6
+#define IFLA_BR_GROUP_FWD_MASK          9
+#define IFLA_BR_MCAST_SNOOPING          23
+
+#define IFLA_BRPORT_PRIORITY            2
+#define IFLA_BRPORT_COST                3
+#define IFLA_BRPORT_MODE                4
+
+/*****************************************************************************/
+
 #define WG_CMD_GET_DEVICE 0
 #define WG_CMD_SET_DEVICE 1
 
@@ -215,6 +264,11 @@ G_STATIC_ASSERT (RTA_MAX == (__RTA_MAX - 1));
 #define WGALLOWEDIP_A_CIDR_MASK                3
 #define WGALLOWEDIP_A_MAX                      3
 
+#define WGDEVICE_F_REPLACE_PEERS               ((guint32) (1U << 0))
+
+#define WGPEER_F_REMOVE_ME                     ((guint32) (1U << 0))
+#define WGPEER_F_REPLACE_ALLOWEDIPS            ((guint32) (1U << 1))
+
 /*****************************************************************************/
 
 /* Redefine VF enums and structures that are not available on older kernels. */
@@ -353,6 +407,34 @@ typedef struct {
 	} response;
 } DelayedActionWaitForNlResponseData;
 
+/* a route that we didn't add, in compact form. See _foreign_route_update(). */
+typedef struct {
+	guint32 table;
+	guint32 metric;
+	int ifindex;
+	guint8 plen;
+	guint8 tos;
+	guint8 rtprot;
+	guint8 flags;
+
+	/* the network, followed by the gateway. */
+	guint8 addrs[];
+} ForeignRoute;
+
+typedef struct {
+	/* packed ForeignRoute records, sorted by _foreign_route_cmp(). */
+	GArray *sorted;
+
+	/* changes that are not yet merged into @sorted, in the order
+	 * in which they happened. */
+	GArray *pending;
+
+	/* the number of records in @sorted that are marked as deleted. */
+	guint n_deleted;
+
+	guint8 addr_len;
+} ForeignRoutes;
+
 /*****************************************************************************/
 
 typedef struct {
@@ -374,6 +456,30 @@ typedef struct {
 
 	NMUdevClient *udev_client;
 
+	bool compact_foreign_routes;
+
+	/* the foreign routes for IPv4 and IPv6. */
+	ForeignRoutes foreign_routes[2];
+
+	struct {
+		/* the generic netlink family id of "wireguard", or -1 if it is not
+		 * yet resolved. */
+		int family_id;
+
+		/* the ifindexes of WireGuard links that should be refetched. */
+		GHashTable *pending;
+		guint timeout_id;
+		gint64 last_refresh_msec;
+		bool refreshing:1;
+	} wireguard;
+
+	struct {
+		/* ifindex -> GQueue of GTask. Changing the SR-IOV parameters of
+		 * one link is serialized, the head of the queue is the running
+		 * task. */
+		GHashTable *params_queues;
+	} sriov;
+
 	struct {
 		/* which delayed actions are scheduled, as marked in @flags.
 		 * Some types have additional arguments in the fields below. */
@@ -400,6 +506,10 @@ struct _NMLinuxPlatformClass {
 	NMPlatformClass parent;
 };
 
+NM_GOBJECT_PROPERTIES_DEFINE_BASE (
+	PROP_COMPACT_FOREIGN_ROUTES,
+);
+
 G_DEFINE_TYPE (NMLinuxPlatform, nm_linux_platform, NM_TYPE_PLATFORM)
 
 #define NM_LINUX_PLATFORM_GET_PRIVATE(self) _NM_GET_PRIVATE (self, NMLinuxPlatform, NM_IS_LINUX_PLATFORM, NMPlatform)
@@ -1212,6 +1322,190 @@ _parse_af_inet6 (NMPlatform *platform,
 
 /*****************************************************************************/
 
+static NMPObject *
+_parse_lnk_bond (const char *kind, struct nlattr *info_data)
+{
+	static const struct nla_policy policy[__IFLA_BOND_MAX] = {
+		[IFLA_BOND_MODE]              = { .type = NLA_U8 },
+		[IFLA_BOND_ACTIVE_SLAVE]      = { .type = NLA_U32 },
+		[IFLA_BOND_MIIMON]            = { .type = NLA_U32 },
+		[IFLA_BOND_UPDELAY]           = { .type = NLA_U32 },
+		[IFLA_BOND_DOWNDELAY]         = { .type = NLA_U32 },
+		[IFLA_BOND_USE_CARRIER]       = { .type = NLA_U8 },
+		[IFLA_BOND_ARP_INTERVAL]      = { .type = NLA_U32 },
+		[IFLA_BOND_ARP_IP_TARGET]     = { .type = NLA_NESTED },
+		[IFLA_BOND_ARP_VALIDATE]      = { .type = NLA_U32 },
+		[IFLA_BOND_ARP_ALL_TARGETS]   = { .type = NLA_U32 },
+		[IFLA_BOND_PRIMARY]           = { .type = NLA_U32 },
+		[IFLA_BOND_PRIMARY_RESELECT]  = { .type = NLA_U8 },
+		[IFLA_BOND_FAIL_OVER_MAC]     = { .type = NLA_U8 },
+		[IFLA_BOND_XMIT_HASH_POLICY]  = { .type = NLA_U8 },
+		[IFLA_BOND_RESEND_IGMP]       = { .type = NLA_U32 },
+		[IFLA_BOND_NUM_PEER_NOTIF]    = { .type = NLA_U8 },
+		[IFLA_BOND_ALL_SLAVES_ACTIVE] = { .type = NLA_U8 },
+		[IFLA_BOND_MIN_LINKS]         = { .type = NLA_U32 },
+		[IFLA_BOND_LP_INTERVAL]       = { .type = NLA_U32 },
+		[IFLA_BOND_PACKETS_PER_SLAVE] = { .type = NLA_U32 },
+		[IFLA_BOND_AD_LACP_RATE]      = { .type = NLA_U8 },
+		[IFLA_BOND_AD_SELECT]         = { .type = NLA_U8 },
+		[IFLA_BOND_AD_ACTOR_SYS_PRIO] = { .type = NLA_U16 },
+		[IFLA_BOND_AD_USER_PORT_KEY]  = { .type = NLA_U16 },
+		[IFLA_BOND_AD_ACTOR_SYSTEM]   = { .minlen = ETH_ALEN },
+		[IFLA_BOND_TLB_DYNAMIC_LB]    = { .type = NLA_U8 },
+	};
+	struct nlattr *tb[__IFLA_BOND_MAX];
+	int err;
+	NMPObject *obj;
+	NMPlatformLnkBond *props;
+
+	if (!info_data || !nm_streq0 (kind, "bond"))
+		return NULL;
+
+	err = nla_parse_nested (tb, __IFLA_BOND_MAX - 1, info_data, policy);
+	if (err < 0)
+		return NULL;
+
+	obj = nmp_object_new (NMP_OBJECT_TYPE_LNK_BOND, NULL);
+	props = &obj->lnk_bond;
+
+	if (tb[IFLA_BOND_MODE])
+		props->mode = nla_get_u8 (tb[IFLA_BOND_MODE]);
+	if (tb[IFLA_BOND_ACTIVE_SLAVE]) {
+		props->active_slave = nla_get_u32 (tb[IFLA_BOND_ACTIVE_SLAVE]);
+		props->active_slave_has = TRUE;
+	}
+	if (tb[IFLA_BOND_MIIMON]) {
+		props->miimon = nla_get_u32 (tb[IFLA_BOND_MIIMON]);
+		props->miimon_has = TRUE;
+	}
+	if (tb[IFLA_BOND_UPDELAY]) {
+		props->updelay = nla_get_u32 (tb[IFLA_BOND_UPDELAY]);
+		props->updelay_has = TRUE;
+	}
+	if (tb[IFLA_BOND_DOWNDELAY]) {
+		props->downdelay = nla_get_u32 (tb[IFLA_BOND_DOWNDELAY]);
+		props->downdelay_has = TRUE;
+	}
+	if (tb[IFLA_BOND_USE_CARRIER])
+		props->use_carrier = !!nla_get_u8 (tb[IFLA_BOND_USE_CARRIER]);
+	if (tb[IFLA_BOND_ARP_INTERVAL]) {
+		props->arp_interval = nla_get_u32 (tb[IFLA_BOND_ARP_INTERVAL]);
+		props->arp_interval_has = TRUE;
+	}
+	if (tb[IFLA_BOND_ARP_IP_TARGET]) {
+		struct nlattr *attr;
+		int rem;
+
+		nla_for_each_nested (attr, tb[IFLA_BOND_ARP_IP_TARGET], rem) {
+			if (props->arp_ip_targets_num >= NM_BOND_MAX_ARP_TARGETS)
+				break;
+			if (nla_len (attr) < (int) sizeof (in_addr_t))
+				continue;
+			props->arp_ip_target[props->arp_ip_targets_num++] = nla_get_u32 (attr);
+		}
+	}
+	if (tb[IFLA_BOND_ARP_VALIDATE]) {
+		props->arp_validate = nla_get_u32 (tb[IFLA_BOND_ARP_VALIDATE]);
+		props->arp_validate_has = TRUE;
+	}
+	if (tb[IFLA_BOND_ARP_ALL_TARGETS])
+		props->arp_all_targets = nla_get_u32 (tb[IFLA_BOND_ARP_ALL_TARGETS]);
+	if (tb[IFLA_BOND_PRIMARY]) {
+		props->primary = nla_get_u32 (tb[IFLA_BOND_PRIMARY]);
+		props->primary_has = TRUE;
+	}
+	if (tb[IFLA_BOND_PRIMARY_RESELECT])
+		props->primary_reselect = nla_get_u8 (tb[IFLA_BOND_PRIMARY_RESELECT]);
+	if (tb[IFLA_BOND_FAIL_OVER_MAC])
+		props->fail_over_mac = nla_get_u8 (tb[IFLA_BOND_FAIL_OVER_MAC]);
+	if (tb[IFLA_BOND_XMIT_HASH_POLICY])
+		props->xmit_hash_policy = nla_get_u8 (tb[IFLA_BOND_XMIT_HASH_POLICY]);
+	if (tb[IFLA_BOND_RESEND_IGMP])
+		props->resend_igmp = nla_get_u32 (tb[IFLA_BOND_RESEND_IGMP]);
+	if (tb[IFLA_BOND_NUM_PEER_NOTIF])
+		props->num_grat_arp = nla_get_u8 (tb[IFLA_BOND_NUM_PEER_NOTIF]);
+	if (tb[IFLA_BOND_ALL_SLAVES_ACTIVE])
+		props->all_slaves_active = nla_get_u8 (tb[IFLA_BOND_ALL_SLAVES_ACTIVE]);
+	if (tb[IFLA_BOND_MIN_LINKS])
+		props->min_links = nla_get_u32 (tb[IFLA_BOND_MIN_LINKS]);
+	if (tb[IFLA_BOND_LP_INTERVAL])
+		props->lp_interval = nla_get_u32 (tb[IFLA_BOND_LP_INTERVAL]);
+	if (tb[IFLA_BOND_PACKETS_PER_SLAVE]) {
+		props->packets_per_slave = nla_get_u32 (tb[IFLA_BOND_PACKETS_PER_SLAVE]);
+		props->packets_per_slave_has = TRUE;
+	}
+	if (tb[IFLA_BOND_AD_LACP_RATE]) {
+		props->lacp_rate = nla_get_u8 (tb[IFLA_BOND_AD_LACP_RATE]);
+		props->lacp_rate_has = TRUE;
+	}
+	if (tb[IFLA_BOND_AD_SELECT])
+		props->ad_select = nla_get_u8 (tb[IFLA_BOND_AD_SELECT]);
+	if (tb[IFLA_BOND_AD_ACTOR_SYS_PRIO]) {
+		props->ad_actor_sys_prio = nla_get_u16 (tb[IFLA_BOND_AD_ACTOR_SYS_PRIO]);
+		props->ad_actor_sys_prio_has = TRUE;
+	}
+	if (tb[IFLA_BOND_AD_USER_PORT_KEY]) {
+		props->ad_user_port_key = nla_get_u16 (tb[IFLA_BOND_AD_USER_PORT_KEY]);
+		props->ad_user_port_key_has = TRUE;
+	}
+	if (tb[IFLA_BOND_AD_ACTOR_SYSTEM]) {
+		memcpy (props->ad_actor_system, nla_data (tb[IFLA_BOND_AD_ACTOR_SYSTEM]), sizeof (props->ad_actor_system));
+		props->ad_actor_system_has = TRUE;
+	}
+	if (tb[IFLA_BOND_TLB_DYNAMIC_LB]) {
+		props->tlb_dynamic_lb = !!nla_get_u8 (tb[IFLA_BOND_TLB_DYNAMIC_LB]);
+		props->tlb_dynamic_lb_has = TRUE;
+	}
+
+	return obj;
+}
+
+/*****************************************************************************/
+
+static NMPObject *
+_parse_lnk_bridge (const char *kind, struct nlattr *info_data)
+{
+	static const struct nla_policy policy[IFLA_BR_MCAST_SNOOPING + 1] = {
+		[IFLA_BR_FORWARD_DELAY]  = { .type = NLA_U32 },
+		[IFLA_BR_HELLO_TIME]     = { .type = NLA_U32 },
+		[IFLA_BR_MAX_AGE]        = { .type = NLA_U32 },
+		[IFLA_BR_AGEING_TIME]    = { .type = NLA_U32 },
+		[IFLA_BR_STP_STATE]      = { .type = NLA_U32 },
+		[IFLA_BR_PRIORITY]       = { .type = NLA_U16 },
+		[IFLA_BR_GROUP_FWD_MASK] = { .type = NLA_U16 },
+		[IFLA_BR_MCAST_SNOOPING] = { .type = NLA_U8 },
+	};
+	struct nlattr *tb[IFLA_BR_MCAST_SNOOPING + 1];
+	int err;
+	NMPObject *obj;
+	NMPlatformLnkBridge *props;
+
+	if (!info_data || !nm_streq0 (kind, "bridge"))
+		return NULL;
+
+	/* we only care about a subset of the attributes. nla_parse() ignores
+	 * the ones beyond maxtype. */
+	err = nla_parse_nested (tb, IFLA_BR_MCAST_SNOOPING, info_data, policy);
+	if (err < 0)
+		return NULL;
+
+	obj = nmp_object_new (NMP_OBJECT_TYPE_LNK_BRIDGE, NULL);
+	props = &obj->lnk_bridge;
+
+	props->forward_delay = tb[IFLA_BR_FORWARD_DELAY] ? nla_get_u32 (tb[IFLA_BR_FORWARD_DELAY]) : 0;
+	props->hello_time = tb[IFLA_BR_HELLO_TIME] ? nla_get_u32 (tb[IFLA_BR_HELLO_TIME]) : 0;
+	props->max_age = tb[IFLA_BR_MAX_AGE] ? nla_get_u32 (tb[IFLA_BR_MAX_AGE]) : 0;
+	props->ageing_time = tb[IFLA_BR_AGEING_TIME] ? nla_get_u32 (tb[IFLA_BR_AGEING_TIME]) : 0;
+	props->stp_state = tb[IFLA_BR_STP_STATE] ? !!nla_get_u32 (tb[IFLA_BR_STP_STATE]) : FALSE;
+	props->priority = tb[IFLA_BR_PRIORITY] ? nla_get_u16 (tb[IFLA_BR_PRIORITY]) : 0;
+	props->group_fwd_mask = tb[IFLA_BR_GROUP_FWD_MASK] ? nla_get_u16 (tb[IFLA_BR_GROUP_FWD_MASK]) : 0;
+	props->mcast_snooping = tb[IFLA_BR_MCAST_SNOOPING] ? !!nla_get_u8 (tb[IFLA_BR_MCAST_SNOOPING]) : FALSE;
+
+	return obj;
+}
+
+/*****************************************************************************/
+
 static NMPObject *
 _parse_lnk_gre (const char *kind, struct nlattr *info_data)
 {
@@ -2035,7 +2329,7 @@ _wireguard_update_from_peers_nla (CList *peers,
 			}
 		}
 		if (tb[WGPEER_A_PERSISTENT_KEEPALIVE_INTERVAL])
-			peer_c->data.persistent_keepalive_interval = nla_get_u64 (tb[WGPEER_A_PERSISTENT_KEEPALIVE_INTERVAL]);
+			peer_c->data.persistent_keepalive_interval = nla_get_u16 (tb[WGPEER_A_PERSISTENT_KEEPALIVE_INTERVAL]);
 		if (tb[WGPEER_A_LAST_HANDSHAKE_TIME])
 			nla_memcpy (&peer_c->data.last_handshake_time, tb[WGPEER_A_LAST_HANDSHAKE_TIME], sizeof (peer_c->data.last_handshake_time));
 		if (tb[WGPEER_A_RX_BYTES])
@@ -2287,6 +2581,109 @@ nla_put_failure:
 	g_return_val_if_reached (NULL);
 }
 
+#define WIREGUARD_REFRESH_RATELIMIT_MSEC 2000
+
+static int
+_wireguard_get_family_id (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (priv->wireguard.family_id < 0)
+		priv->wireguard.family_id = genl_ctrl_resolve (priv->genl, "wireguard");
+	return priv->wireguard.family_id;
+}
+
+static void
+_wireguard_refresh_link (NMPlatform *platform, int ifindex)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	nm_auto_nmpobj const NMPObject *lnk = NULL;
+	nm_auto_nmpobj const NMPObject *obj_old = NULL;
+	nm_auto_nmpobj const NMPObject *obj_new = NULL;
+	const NMPObject *obj_cache;
+	NMPCacheOpsType cache_op;
+	int family_id;
+
+	obj_cache = nmp_cache_lookup_link (nm_platform_get_cache (platform), ifindex);
+	if (   !obj_cache
+	    || !obj_cache->_link.netlink.is_in_netlink
+	    || obj_cache->link.type != NM_LINK_TYPE_WIREGUARD)
+		return;
+
+	family_id = _wireguard_get_family_id (platform);
+	if (family_id < 0)
+		return;
+
+	lnk = _wireguard_read_info (platform, priv->genl, family_id, ifindex);
+	if (!lnk) {
+		/* maybe the module was reloaded. Resolve the family id again next time. */
+		priv->wireguard.family_id = -1;
+		return;
+	}
+
+	cache_op = nmp_cache_update_link_lnk (nm_platform_get_cache (platform), ifindex, lnk, &obj_old, &obj_new);
+	if (cache_op != NMP_CACHE_OPS_UNCHANGED) {
+		nm_auto_pop_netns NMPNetns *netns = NULL;
+
+		/* don't schedule another refresh for our own update. */
+		priv->wireguard.refreshing = TRUE;
+		cache_on_change (platform, cache_op, obj_old, obj_new);
+		priv->wireguard.refreshing = FALSE;
+		if (!nm_platform_netns_push (platform, &netns))
+			return;
+		nm_platform_cache_update_emit_signal (platform, cache_op, obj_old, obj_new);
+	}
+}
+
+static gboolean
+_wireguard_refresh_timeout_cb (gpointer user_data)
+{
+	NMPlatform *platform = user_data;
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_unref_hashtable GHashTable *pending = NULL;
+	GHashTableIter iter;
+	gpointer ifindex;
+
+	priv->wireguard.timeout_id = 0;
+	priv->wireguard.last_refresh_msec = nm_utils_get_monotonic_timestamp_ms ();
+
+	pending = g_steal_pointer (&priv->wireguard.pending);
+	if (pending) {
+		g_hash_table_iter_init (&iter, pending);
+		while (g_hash_table_iter_next (&iter, &ifindex, NULL))
+			_wireguard_refresh_link (platform, GPOINTER_TO_INT (ifindex));
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Fetching the WireGuard data can be expensive with many peers. Don't do it
+ * while parsing netlink events, but coalesce the requests per ifindex and
+ * handle them at most once per WIREGUARD_REFRESH_RATELIMIT_MSEC. */
+static void
+_wireguard_refresh_schedule (NMPlatform *platform, int ifindex, gboolean immediately)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gint64 now;
+	gint64 delay = 0;
+
+	if (!priv->wireguard.pending)
+		priv->wireguard.pending = g_hash_table_new (nm_direct_hash, NULL);
+	g_hash_table_add (priv->wireguard.pending, GINT_TO_POINTER (ifindex));
+
+	if (immediately)
+		nm_clear_g_source (&priv->wireguard.timeout_id);
+	else if (priv->wireguard.timeout_id)
+		return;
+	else {
+		now = nm_utils_get_monotonic_timestamp_ms ();
+		if (priv->wireguard.last_refresh_msec + WIREGUARD_REFRESH_RATELIMIT_MSEC > now)
+			delay = priv->wireguard.last_refresh_msec + WIREGUARD_REFRESH_RATELIMIT_MSEC - now;
+	}
+
+	priv->wireguard.timeout_id = g_timeout_add (delay, _wireguard_refresh_timeout_cb, platform);
+}
+
 /*****************************************************************************/
 
 /* Copied and heavily modified from libnl3's link_msg_parser(). */
@@ -2465,6 +2862,12 @@ _new_from_nl_link (NMPlatform *platform, const NMPCache *cache, struct nlmsghdr
 	}
 
 	switch (obj->link.type) {
+	case NM_LINK_TYPE_BOND:
+		lnk_data = _parse_lnk_bond (nl_info_kind, nl_info_data);
+		break;
+	case NM_LINK_TYPE_BRIDGE:
+		lnk_data = _parse_lnk_bridge (nl_info_kind, nl_info_data);
+		break;
 	case NM_LINK_TYPE_GRE:
 	case NM_LINK_TYPE_GRETAP:
 		lnk_data = _parse_lnk_gre (nl_info_kind, nl_info_data);
@@ -2508,6 +2911,8 @@ _new_from_nl_link (NMPlatform *platform, const NMPCache *cache, struct nlmsghdr
 		lnk_data_complete_from_cache = FALSE;
 		break;
 	case NM_LINK_TYPE_WIREGUARD:
+		/* The WireGuard data is not part of the message. It is fetched
+		 * separately, see _wireguard_refresh_schedule(). */
 		lnk_data_complete_from_cache = TRUE;
 		break;
 	default:
@@ -2591,42 +2996,6 @@ _new_from_nl_link (NMPlatform *platform, const NMPCache *cache, struct nlmsghdr
 		}
 	}
 
-	if (obj->link.type == NM_LINK_TYPE_WIREGUARD) {
-		const NMPObject *lnk_data_new = NULL;
-		struct nl_sock *genl = NM_LINUX_PLATFORM_GET_PRIVATE (platform)->genl;
-
-		/* The WireGuard kernel module does not yet send link update
-		 * notifications, so we don't actually update the cache. For
-		 * now, always refetch link data here. */
-
-		_lookup_cached_link (cache, obj->link.ifindex, completed_from_cache, &link_cached);
-		if (   link_cached
-		    && link_cached->_link.netlink.is_in_netlink
-		    && link_cached->link.type == NM_LINK_TYPE_WIREGUARD)
-			obj->_link.wireguard_family_id = link_cached->_link.wireguard_family_id;
-		else
-			obj->_link.wireguard_family_id = -1;
-
-		if (obj->_link.wireguard_family_id < 0)
-			obj->_link.wireguard_family_id = genl_ctrl_resolve (genl, "wireguard");
-
-		if (obj->_link.wireguard_family_id >= 0) {
-			lnk_data_new = _wireguard_read_info (platform,
-			                                     genl,
-			                                     obj->_link.wireguard_family_id,
-			                                     obj->link.ifindex);
-		}
-
-		if (   lnk_data_new
-		    && obj->_link.netlink.lnk
-		    && nmp_object_equal (obj->_link.netlink.lnk, lnk_data_new))
-			nmp_object_unref (lnk_data_new);
-		else {
-			nmp_object_unref (obj->_link.netlink.lnk);
-			obj->_link.netlink.lnk = lnk_data_new;
-		}
-	}
-
 	obj->_link.netlink.is_in_netlink = TRUE;
 	return g_steal_pointer (&obj);
 }
@@ -3004,6 +3373,45 @@ _new_from_nl_qdisc (struct nlmsghdr *nlh, gboolean id_only)
 	return obj;
 }
 
+static void
+_new_from_nl_tfilter_action (struct nlattr *options, NMPlatformAction *action)
+{
+	static const struct nla_policy act_policy[TCA_ACT_MAX + 1] = {
+		[TCA_ACT_KIND]    = { .type = NLA_STRING },
+		[TCA_ACT_OPTIONS] = { .type = NLA_NESTED },
+	};
+	static const struct nla_policy simple_policy[TCA_DEF_MAX + 1] = {
+		[TCA_DEF_DATA]    = { .type = NLA_STRING },
+	};
+	struct nlattr *options_tb[TCA_OPTIONS + 1];
+	struct nlattr *act_tab_tb[1 + 1];
+	struct nlattr *act_tb[TCA_ACT_MAX + 1];
+	struct nlattr *simple_tb[TCA_DEF_MAX + 1];
+
+	/* this is the reverse of _nl_msg_new_tfilter(). The action table is at the
+	 * same place for the filter kinds we create, and we only ever add one
+	 * action with priority 1. */
+	if (   nla_parse_nested (options_tb, TCA_OPTIONS, options, NULL) < 0
+	    || !options_tb[TCA_OPTIONS])
+		return;
+
+	if (   nla_parse_nested (act_tab_tb, 1, options_tb[TCA_OPTIONS], NULL) < 0
+	    || !act_tab_tb[1])
+		return;
+
+	if (   nla_parse_nested (act_tb, TCA_ACT_MAX, act_tab_tb[1], act_policy) < 0
+	    || !act_tb[TCA_ACT_KIND])
+		return;
+
+	action->kind = g_intern_string (nla_get_string (act_tb[TCA_ACT_KIND]));
+
+	if (   nm_streq (action->kind, NM_PLATFORM_ACTION_KIND_SIMPLE)
+	    && act_tb[TCA_ACT_OPTIONS]
+	    && nla_parse_nested (simple_tb, TCA_DEF_MAX, act_tb[TCA_ACT_OPTIONS], simple_policy) >= 0
+	    && simple_tb[TCA_DEF_DATA])
+		nla_strlcpy (action->simple.sdata, simple_tb[TCA_DEF_DATA], sizeof (action->simple.sdata));
+}
+
 static NMPObject *
 _new_from_nl_tfilter (struct nlmsghdr *nlh, gboolean id_only)
 {
@@ -3012,7 +3420,8 @@ _new_from_nl_tfilter (struct nlmsghdr *nlh, gboolean id_only)
 	struct nlattr *tb[TCA_MAX + 1];
 	int err;
 	static const struct nla_policy policy[TCA_MAX + 1] = {
-		[TCA_KIND] = { .type = NLA_STRING },
+		[TCA_KIND]    = { .type = NLA_STRING },
+		[TCA_OPTIONS] = { .type = NLA_NESTED },
 	};
 
 	if (!nlmsg_valid_hdr (nlh, sizeof (*tcm)))
@@ -3035,6 +3444,9 @@ _new_from_nl_tfilter (struct nlmsghdr *nlh, gboolean id_only)
 	obj->tfilter.parent = tcm->tcm_parent;
 	obj->tfilter.info = tcm->tcm_info;
 
+	if (tb[TCA_OPTIONS])
+		_new_from_nl_tfilter_action (tb[TCA_OPTIONS], &obj->tfilter.action);
+
 	return obj;
 }
 
@@ -4374,90 +4786,542 @@ delayed_action_schedule_WAIT_FOR_NL_RESPONSE (NMPlatform *platform,
 
 /*****************************************************************************/
 
-static void
-cache_prune_one_type (NMPlatform *platform, NMPObjectType obj_type)
+/* With compact-foreign-routes, routes that were not added by NetworkManager
+ * (their rtm_protocol is none of the protocols that we use) are not put into
+ * the platform cache. On routers that carry full BGP tables, these are the
+ * vast majority of routes, and each NMPObject together with its dedup entries
+ * costs several hundred bytes.
+ *
+ * Instead, such routes are kept as packed ForeignRoute records of 24 (IPv4)
+ * or 48 (IPv6) bytes, in an array sorted by table and prefix. New routes
+ * are first appended to a list of pending changes, which gets merged into
+ * the sorted array in batches. That keeps inserting many routes cheap.
+ *
+ * These routes are not visible to the rest of NetworkManager and are
+ * not part of the device's IP configuration. Only route sync sees them,
+ * so that syncing the full route table still deletes them. */
+
+enum {
+	/* the route was not seen again by the ongoing dump. */
+	FOREIGN_ROUTE_DIRTY   = 0x01,
+
+	/* in the sorted array, the route was deleted. As pending change,
+	 * the route is to be deleted. */
+	FOREIGN_ROUTE_DELETE  = 0x02,
+
+	/* as pending change, the route replaces all routes with the
+	 * same weak-id. */
+	FOREIGN_ROUTE_REPLACE = 0x04,
+};
+
+/* merge the pending changes once they grow beyond a quarter of the
+ * sorted array, but not before there are a few of them. */
+#define FOREIGN_ROUTES_MERGE_MIN 1024
+
+#define FOREIGN_ROUTE_SIZE_MAX (sizeof (ForeignRoute) + 2 * sizeof (struct in6_addr))
+
+#define _foreign_route_size(addr_len) (sizeof (ForeignRoute) + 2 * (addr_len))
+
+static ForeignRoute *
+_foreign_route_at (GArray *arr, guint idx)
 {
-	NMDedupMultiIter iter;
-	const NMPObject *obj;
-	NMPCacheOpsType cache_op;
-	NMPLookup lookup;
-	NMPCache *cache = nm_platform_get_cache (platform);
+	nm_assert (idx < arr->len);
 
-	nmp_lookup_init_obj_type (&lookup,
-	                          obj_type);
-	nm_dedup_multi_iter_init (&iter,
-	                          nmp_cache_lookup (cache,
-	                                            &lookup));
-	while (nm_dedup_multi_iter_next (&iter)) {
-		if (iter.current->dirty) {
-			nm_auto_nmpobj const NMPObject *obj_old = NULL;
+	return (ForeignRoute *) ((gpointer) &arr->data[g_array_get_element_size (arr) * idx]);
+}
 
-			obj = iter.current->obj;
-			_LOGt ("cache-prune: prune %s", nmp_object_to_string (obj, NMP_OBJECT_TO_STRING_ALL, NULL, 0));
-			cache_op = nmp_cache_remove (cache, obj, TRUE, TRUE, &obj_old);
-			nm_assert (cache_op == NMP_CACHE_OPS_REMOVED);
-			cache_on_change (platform, cache_op, obj_old, NULL);
-			nm_platform_cache_update_emit_signal (platform, cache_op, obj_old, NULL);
-		}
-	}
+/* orders by the weak-id: table, network, plen, metric and tos. That is the
+ * identity under which kernel replaces routes. */
+static int
+_foreign_route_cmp_weak_id (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const ForeignRoute *r1 = a;
+	const ForeignRoute *r2 = b;
+
+	NM_CMP_FIELD (r1, r2, table);
+	NM_CMP_DIRECT_MEMCMP (r1->addrs, r2->addrs, GPOINTER_TO_SIZE (user_data));
+	NM_CMP_FIELD (r1, r2, plen);
+	NM_CMP_FIELD (r1, r2, metric);
+	NM_CMP_FIELD (r1, r2, tos);
+	return 0;
 }
 
-static void
-cache_prune_all (NMPlatform *platform)
+static int
+_foreign_route_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	DelayedActionType iflags, action_type;
+	const ForeignRoute *r1 = a;
+	const ForeignRoute *r2 = b;
+	const gsize addr_len = GPOINTER_TO_SIZE (user_data);
 
-	action_type = DELAYED_ACTION_TYPE_REFRESH_ALL;
-	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
-		bool *p = &priv->pruning[delayed_action_refresh_all_to_idx (iflags)];
+	NM_CMP_RETURN (_foreign_route_cmp_weak_id (r1, r2, user_data));
+	NM_CMP_FIELD (r1, r2, ifindex);
+	NM_CMP_DIRECT_MEMCMP (&r1->addrs[addr_len], &r2->addrs[addr_len], addr_len);
+	return 0;
+}
 
-		if (*p) {
-			*p = FALSE;
-			cache_prune_one_type (platform, delayed_action_refresh_to_object_type (iflags));
-		}
-	}
+static gboolean
+_foreign_route_is_foreign (const NMPObject *obj)
+{
+	if (!NM_IN_SET (NMP_OBJECT_GET_TYPE (obj), NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                           NMP_OBJECT_TYPE_IP6_ROUTE))
+		return FALSE;
+
+	/* responses to RTM_GETROUTE must be handled by the regular code path. */
+	if (NM_FLAGS_HAS (obj->ip_route.r_rtm_flags, RTM_F_CLONED))
+		return FALSE;
+
+	if (   NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP6_ROUTE
+	    && obj->ip6_route.src_plen > 0)
+		return FALSE;
+
+	return !NM_IN_SET (obj->ip_route.rt_source,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_UNSPEC,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_REDIRECT,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_KERNEL,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_BOOT,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_STATIC,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_RA,
+	                   NM_IP_CONFIG_SOURCE_RTPROT_DHCP);
 }
 
 static void
-cache_on_change (NMPlatform *platform,
-                 NMPCacheOpsType cache_op,
-                 const NMPObject *obj_old,
-                 const NMPObject *obj_new)
+_foreign_route_init (ForeignRoute *r, const NMPObject *obj, guint8 flags)
+{
+	const gboolean is_v4 = (NMP_OBJECT_GET_TYPE (obj) == NMP_OBJECT_TYPE_IP4_ROUTE);
+	const gsize addr_len = is_v4 ? sizeof (in_addr_t) : sizeof (struct in6_addr);
+
+	r->table = obj->ip_route.table_coerced;
+	r->metric = obj->ip_route.metric;
+	r->ifindex = obj->ip_route.ifindex;
+	r->plen = obj->ip_route.plen;
+	r->tos = is_v4 ? obj->ip4_route.tos : 0;
+	r->rtprot = nmp_utils_ip_config_source_coerce_to_rtprot (obj->ip_route.rt_source);
+	r->flags = flags;
+	memcpy (&r->addrs[0], obj->ip_route.network_ptr, addr_len);
+	if (is_v4)
+		memcpy (&r->addrs[addr_len], &obj->ip4_route.gateway, addr_len);
+	else
+		memcpy (&r->addrs[addr_len], &obj->ip6_route.gateway, addr_len);
+}
+
+static NMPObject *
+_foreign_route_to_obj (const ForeignRoute *r, gsize addr_len)
 {
-	const NMPClass *klass;
-	char str_buf[sizeof (_nm_utils_to_string_buffer)];
-	char str_buf2[sizeof (_nm_utils_to_string_buffer)];
-	NMPCache *cache = nm_platform_get_cache (platform);
+	NMPlatformIPXRoute route = { };
 
-	ASSERT_nmp_cache_ops (cache, cache_op, obj_old, obj_new);
-	nm_assert (cache_op != NMP_CACHE_OPS_UNCHANGED);
+	route.rx.ifindex = r->ifindex;
+	route.rx.table_coerced = r->table;
+	route.rx.metric = r->metric;
+	route.rx.plen = r->plen;
+	route.rx.rt_source = nmp_utils_ip_config_source_from_rtprot (r->rtprot);
 
-	klass = obj_old ? NMP_OBJECT_GET_CLASS (obj_old) : NMP_OBJECT_GET_CLASS (obj_new);
+	if (addr_len == sizeof (in_addr_t)) {
+		route.r4.tos = r->tos;
+		memcpy (&route.r4.network, &r->addrs[0], addr_len);
+		memcpy (&route.r4.gateway, &r->addrs[addr_len], addr_len);
+		return nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &route.r4);
+	}
 
-	_LOGt ("update-cache-%s: %s: %s%s%s",
-	       klass->obj_type_name,
-	       (cache_op == NMP_CACHE_OPS_UPDATED
-	           ? "UPDATE"
-	           : (cache_op == NMP_CACHE_OPS_REMOVED
-	                 ? "REMOVE"
-	                 : (cache_op == NMP_CACHE_OPS_ADDED) ? "ADD" : "???")),
-	       (cache_op != NMP_CACHE_OPS_ADDED
-	           ? nmp_object_to_string (obj_old, NMP_OBJECT_TO_STRING_ALL, str_buf2, sizeof (str_buf2))
-	           : nmp_object_to_string (obj_new, NMP_OBJECT_TO_STRING_ALL, str_buf2, sizeof (str_buf2))),
-	       (cache_op == NMP_CACHE_OPS_UPDATED) ? " -> " : "",
-	       (cache_op == NMP_CACHE_OPS_UPDATED
-	           ? nmp_object_to_string (obj_new, NMP_OBJECT_TO_STRING_ALL, str_buf, sizeof (str_buf))
-	           : ""));
+	memcpy (&route.r6.network, &r->addrs[0], addr_len);
+	memcpy (&route.r6.gateway, &r->addrs[addr_len], addr_len);
+	return nmp_object_new (NMP_OBJECT_TYPE_IP6_ROUTE, (const NMPlatformObject *) &route.r6);
+}
 
-	switch (klass->obj_type) {
-	case NMP_OBJECT_TYPE_LINK:
-		{
-			/* check whether changing a slave link can cause a master link (bridge or bond) to go up/down */
-			if (   obj_old
-			    && nmp_cache_link_connected_needs_toggle_by_ifindex (cache, obj_old->link.master, obj_new, obj_old))
-				delayed_action_schedule (platform, DELAYED_ACTION_TYPE_MASTER_CONNECTED, GINT_TO_POINTER (obj_old->link.master));
-			if (   obj_new
+static ForeignRoutes *
+_foreign_routes_get (NMPlatform *platform, int addr_family)
+{
+	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
+
+	return &NM_LINUX_PLATFORM_GET_PRIVATE (platform)->foreign_routes[addr_family == AF_INET ? 0 : 1];
+}
+
+static gboolean
+_foreign_routes_keep (const ForeignRoute *r, gboolean prune)
+{
+	if (NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE))
+		return FALSE;
+	if (   prune
+	    && NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DIRTY))
+		return FALSE;
+	return TRUE;
+}
+
+/* merges the pending changes into the sorted array and drops the deleted
+ * records. With @prune, also the dirty records are dropped. */
+static void
+_foreign_routes_merge (ForeignRoutes *routes, gboolean prune)
+{
+	gpointer user_data = GSIZE_TO_POINTER (routes->addr_len);
+	const gsize elt_size = _foreign_route_size (routes->addr_len);
+	GArray *sorted = routes->sorted;
+	GArray *pending = routes->pending;
+	GArray *merged;
+	gs_unref_array GArray *group = NULL;
+	guint i, j, k;
+
+	if (   pending->len == 0
+	    && routes->n_deleted == 0
+	    && !prune)
+		return;
+
+	/* g_qsort_with_data() is stable, so that the changes to one
+	 * weak-id stay in the order in which they happened. */
+	g_qsort_with_data (pending->data, pending->len, elt_size, _foreign_route_cmp_weak_id, user_data);
+
+	merged = g_array_sized_new (FALSE, FALSE, elt_size, sorted->len + pending->len);
+	group = g_array_new (FALSE, FALSE, elt_size);
+
+	i = 0;
+	j = 0;
+	while (   i < sorted->len
+	       || j < pending->len) {
+		const ForeignRoute *r;
+		const ForeignRoute *change;
+
+		if (   j == pending->len
+		    || (   i < sorted->len
+		        && _foreign_route_cmp_weak_id (_foreign_route_at (sorted, i),
+		                                       _foreign_route_at (pending, j),
+		                                       user_data) < 0)) {
+			r = _foreign_route_at (sorted, i++);
+			if (_foreign_routes_keep (r, prune))
+				g_array_append_vals (merged, r, 1);
+			continue;
+		}
+
+		/* apply the pending changes of one weak-id on top of the sorted
+		 * records with that weak-id. */
+		change = _foreign_route_at (pending, j);
+		g_array_set_size (group, 0);
+		for (; i < sorted->len; i++) {
+			r = _foreign_route_at (sorted, i);
+			if (_foreign_route_cmp_weak_id (r, change, user_data) != 0)
+				break;
+			if (!NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE))
+				g_array_append_vals (group, r, 1);
+		}
+		for (; j < pending->len; j++) {
+			ForeignRoute *g;
+
+			r = _foreign_route_at (pending, j);
+			if (_foreign_route_cmp_weak_id (r, change, user_data) != 0)
+				break;
+
+			if (NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_REPLACE))
+				g_array_set_size (group, 0);
+
+			for (k = 0; k < group->len; k++) {
+				if (_foreign_route_cmp (_foreign_route_at (group, k), r, user_data) == 0)
+					break;
+			}
+			if (NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE)) {
+				if (k < group->len)
+					g_array_remove_index (group, k);
+				continue;
+			}
+			if (k == group->len)
+				g_array_set_size (group, k + 1);
+			g = _foreign_route_at (group, k);
+			memcpy (g, r, elt_size);
+			g->flags = 0;
+		}
+
+		g_qsort_with_data (group->data, group->len, elt_size, _foreign_route_cmp, user_data);
+		for (k = 0; k < group->len; k++) {
+			r = _foreign_route_at (group, k);
+			if (_foreign_routes_keep (r, prune))
+				g_array_append_vals (merged, r, 1);
+		}
+	}
+
+	g_array_unref (sorted);
+	routes->sorted = merged;
+	routes->n_deleted = 0;
+	g_array_set_size (pending, 0);
+}
+
+static void
+_foreign_routes_apply (ForeignRoutes *routes, const ForeignRoute *change)
+{
+	gpointer user_data = GSIZE_TO_POINTER (routes->addr_len);
+	const gsize elt_size = _foreign_route_size (routes->addr_len);
+	GArray *sorted = routes->sorted;
+	ForeignRoute *r;
+	gssize idx;
+
+	if (routes->pending->len > 0) {
+		/* the sorted array might be outdated. Queue the change after the others. */
+		g_array_append_vals (routes->pending, change, 1);
+		goto out;
+	}
+
+	/* without pending changes, the sorted array is up to date and
+	 * can be modified in place. */
+	if (NM_FLAGS_HAS (change->flags, FOREIGN_ROUTE_REPLACE)) {
+		gssize first, last;
+
+		idx = nm_utils_array_find_binary_search (sorted->data, elt_size, sorted->len,
+		                                         change, _foreign_route_cmp_weak_id, user_data);
+		if (idx >= 0) {
+			for (first = idx; first > 0; first--) {
+				if (_foreign_route_cmp_weak_id (_foreign_route_at (sorted, first - 1), change, user_data) != 0)
+					break;
+			}
+			for (last = idx; (guint) (last + 1) < sorted->len; last++) {
+				if (_foreign_route_cmp_weak_id (_foreign_route_at (sorted, last + 1), change, user_data) != 0)
+					break;
+			}
+			for (idx = first; idx <= last; idx++) {
+				r = _foreign_route_at (sorted, idx);
+				if (!NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE)) {
+					r->flags |= FOREIGN_ROUTE_DELETE;
+					routes->n_deleted++;
+				}
+			}
+		}
+	}
+
+	idx = nm_utils_array_find_binary_search (sorted->data, elt_size, sorted->len,
+	                                         change, _foreign_route_cmp, user_data);
+
+	if (NM_FLAGS_HAS (change->flags, FOREIGN_ROUTE_DELETE)) {
+		if (idx >= 0) {
+			r = _foreign_route_at (sorted, idx);
+			if (!NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE)) {
+				r->flags |= FOREIGN_ROUTE_DELETE;
+				routes->n_deleted++;
+			}
+		}
+		goto out;
+	}
+
+	if (idx >= 0) {
+		r = _foreign_route_at (sorted, idx);
+		if (NM_FLAGS_HAS (r->flags, FOREIGN_ROUTE_DELETE))
+			routes->n_deleted--;
+		memcpy (r, change, elt_size);
+		r->flags = 0;
+		goto out;
+	}
+
+	/* a new route. The other routes with this weak-id were already
+	 * deleted above, there is no need to replace them again. */
+	g_array_append_vals (routes->pending, change, 1);
+	r = _foreign_route_at (routes->pending, routes->pending->len - 1);
+	r->flags = 0;
+
+out:
+	if (routes->pending->len + routes->n_deleted > MAX (FOREIGN_ROUTES_MERGE_MIN, sorted->len / 4))
+		_foreign_routes_merge (routes, FALSE);
+}
+
+/* returns TRUE, if @obj was handled as foreign route. In that case, it
+ * must not be put into the platform cache. */
+static gboolean
+_foreign_route_update (NMPlatform *platform,
+                       const NMPObject *obj,
+                       gboolean is_delete,
+                       gboolean is_dump,
+                       guint16 nlmsgflags,
+                       gboolean *out_resync_required)
+{
+	guint8 change_buf[FOREIGN_ROUTE_SIZE_MAX] _nm_alignas (guint64);
+	ForeignRoute *change = (ForeignRoute *) change_buf;
+	ForeignRoutes *routes;
+
+	if (!NM_LINUX_PLATFORM_GET_PRIVATE (platform)->compact_foreign_routes)
+		return FALSE;
+
+	if (!NM_IN_SET (NMP_OBJECT_GET_TYPE (obj), NMP_OBJECT_TYPE_IP4_ROUTE,
+	                                           NMP_OBJECT_TYPE_IP6_ROUTE))
+		return FALSE;
+
+	routes = _foreign_routes_get (platform, NMP_OBJECT_GET_CLASS (obj)->addr_family);
+
+	if (!_foreign_route_is_foreign (obj)) {
+		/* one of our routes. If it replaced foreign routes, forget about them. */
+		if (   !is_delete
+		    && !is_dump
+		    && NM_FLAGS_HAS (nlmsgflags, NLM_F_REPLACE)) {
+			_foreign_route_init (change, obj, FOREIGN_ROUTE_DELETE | FOREIGN_ROUTE_REPLACE);
+			_foreign_routes_apply (routes, change);
+		}
+		return FALSE;
+	}
+
+	if (is_delete) {
+		_foreign_route_init (change, obj, FOREIGN_ROUTE_DELETE);
+		_foreign_routes_apply (routes, change);
+		return TRUE;
+	}
+
+	if (!nmp_object_is_alive (obj))
+		return TRUE;
+
+	if (   !is_dump
+	    && NM_FLAGS_HAS (nlmsgflags, NLM_F_REPLACE)
+	    && nmp_cache_lookup_all (nm_platform_get_cache (platform),
+	                             NMP_CACHE_ID_TYPE_ROUTES_BY_WEAK_ID,
+	                             obj)) {
+		/* the foreign route replaced a route that we track in the cache.
+		 * Which one is unclear, resync. */
+		*out_resync_required = TRUE;
+	}
+
+	_foreign_route_init (change,
+	                     obj,
+	                     (   !is_dump
+	                      && NM_FLAGS_HAS (nlmsgflags, NLM_F_REPLACE))
+	                     ? FOREIGN_ROUTE_REPLACE
+	                     : 0);
+	_foreign_routes_apply (routes, change);
+	return TRUE;
+}
+
+static void
+_foreign_routes_dirty_set_all (NMPlatform *platform, NMPObjectType obj_type)
+{
+	ForeignRoutes *routes;
+	guint i;
+
+	if (!NM_LINUX_PLATFORM_GET_PRIVATE (platform)->compact_foreign_routes)
+		return;
+
+	routes = _foreign_routes_get (platform, nmp_class_from_type (obj_type)->addr_family);
+	_foreign_routes_merge (routes, FALSE);
+	for (i = 0; i < routes->sorted->len; i++)
+		_foreign_route_at (routes->sorted, i)->flags |= FOREIGN_ROUTE_DIRTY;
+}
+
+static void
+_foreign_routes_prune (NMPlatform *platform, NMPObjectType obj_type)
+{
+	const int addr_family = nmp_class_from_type (obj_type)->addr_family;
+	ForeignRoutes *routes;
+
+	if (!NM_LINUX_PLATFORM_GET_PRIVATE (platform)->compact_foreign_routes)
+		return;
+
+	routes = _foreign_routes_get (platform, addr_family);
+	_foreign_routes_merge (routes, TRUE);
+
+	_LOGt ("cache-prune: %u foreign IPv%c routes, %"G_GSIZE_FORMAT" bytes",
+	       routes->sorted->len,
+	       nm_utils_addr_family_to_char (addr_family),
+	       (gsize) routes->sorted->len * _foreign_route_size (routes->addr_len));
+}
+
+/*****************************************************************************/
+
+static void
+cache_prune_one_type (NMPlatform *platform, NMPObjectType obj_type)
+{
+	NMDedupMultiIter iter;
+	const NMPObject *obj;
+	NMPCacheOpsType cache_op;
+	NMPLookup lookup;
+	NMPCache *cache = nm_platform_get_cache (platform);
+
+	nmp_lookup_init_obj_type (&lookup,
+	                          obj_type);
+	nm_dedup_multi_iter_init (&iter,
+	                          nmp_cache_lookup (cache,
+	                                            &lookup));
+	while (nm_dedup_multi_iter_next (&iter)) {
+		if (iter.current->dirty) {
+			nm_auto_nmpobj const NMPObject *obj_old = NULL;
+
+			obj = iter.current->obj;
+			_LOGt ("cache-prune: prune %s", nmp_object_to_string (obj, NMP_OBJECT_TO_STRING_ALL, NULL, 0));
+			cache_op = nmp_cache_remove (cache, obj, TRUE, TRUE, &obj_old);
+			nm_assert (cache_op == NMP_CACHE_OPS_REMOVED);
+			cache_on_change (platform, cache_op, obj_old, NULL);
+			nm_platform_cache_update_emit_signal (platform, cache_op, obj_old, NULL);
+		}
+	}
+
+	if (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ROUTE,
+	                         NMP_OBJECT_TYPE_IP6_ROUTE))
+		_foreign_routes_prune (platform, obj_type);
+
+	if (_LOGt_ENABLED ()) {
+		const NMSlabStats *stats = nmp_object_get_pool_stats (obj_type);
+
+		_LOGt ("cache-prune: %s pool: %"G_GSIZE_FORMAT" objects (max %"G_GSIZE_FORMAT"), %"G_GSIZE_FORMAT" free, %"G_GSIZE_FORMAT" bytes",
+		       nmp_class_from_type (obj_type)->obj_type_name,
+		       stats->n_used,
+		       stats->n_used_max,
+		       stats->n_free,
+		       stats->bytes_allocated);
+	}
+}
+
+static void
+cache_prune_all (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionType iflags, action_type;
+
+	action_type = DELAYED_ACTION_TYPE_REFRESH_ALL;
+	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
+		bool *p = &priv->pruning[delayed_action_refresh_all_to_idx (iflags)];
+
+		if (*p) {
+			*p = FALSE;
+			cache_prune_one_type (platform, delayed_action_refresh_to_object_type (iflags));
+		}
+	}
+}
+
+static void
+cache_on_change (NMPlatform *platform,
+                 NMPCacheOpsType cache_op,
+                 const NMPObject *obj_old,
+                 const NMPObject *obj_new)
+{
+	const NMPClass *klass;
+	char str_buf[sizeof (_nm_utils_to_string_buffer)];
+	char str_buf2[sizeof (_nm_utils_to_string_buffer)];
+	NMPCache *cache = nm_platform_get_cache (platform);
+
+	ASSERT_nmp_cache_ops (cache, cache_op, obj_old, obj_new);
+	nm_assert (cache_op != NMP_CACHE_OPS_UNCHANGED);
+
+	klass = obj_old ? NMP_OBJECT_GET_CLASS (obj_old) : NMP_OBJECT_GET_CLASS (obj_new);
+
+	_LOGt ("update-cache-%s: %s: %s%s%s",
+	       klass->obj_type_name,
+	       (cache_op == NMP_CACHE_OPS_UPDATED
+	           ? "UPDATE"
+	           : (cache_op == NMP_CACHE_OPS_REMOVED
+	                 ? "REMOVE"
+	                 : (cache_op == NMP_CACHE_OPS_ADDED) ? "ADD" : "???")),
+	       (cache_op != NMP_CACHE_OPS_ADDED
+	           ? nmp_object_to_string (obj_old, NMP_OBJECT_TO_STRING_ALL, str_buf2, sizeof (str_buf2))
+	           : nmp_object_to_string (obj_new, NMP_OBJECT_TO_STRING_ALL, str_buf2, sizeof (str_buf2))),
+	       (cache_op == NMP_CACHE_OPS_UPDATED) ? " -> " : "",
+	       (cache_op == NMP_CACHE_OPS_UPDATED
+	           ? nmp_object_to_string (obj_new, NMP_OBJECT_TO_STRING_ALL, str_buf, sizeof (str_buf))
+	           : ""));
+
+	switch (klass->obj_type) {
+	case NMP_OBJECT_TYPE_LINK:
+		{
+			/* WireGuard does not notify about changes to its configuration, so
+			 * refetch it whenever the link changes (rate limited). Fetch it right
+			 * away, if we have nothing yet. */
+			if (   obj_new
+			    && obj_new->link.type == NM_LINK_TYPE_WIREGUARD
+			    && obj_new->_link.netlink.is_in_netlink
+			    && !NM_LINUX_PLATFORM_GET_PRIVATE (platform)->wireguard.refreshing)
+				_wireguard_refresh_schedule (platform, obj_new->link.ifindex, !obj_new->_link.netlink.lnk);
+		}
+		{
+			/* check whether changing a slave link can cause a master link (bridge or bond) to go up/down */
+			if (   obj_old
+			    && nmp_cache_link_connected_needs_toggle_by_ifindex (cache, obj_old->link.master, obj_new, obj_old))
+				delayed_action_schedule (platform, DELAYED_ACTION_TYPE_MASTER_CONNECTED, GINT_TO_POINTER (obj_old->link.master));
+			if (   obj_new
 			    && (!obj_old || obj_old->link.master != obj_new->link.master)
 			    && nmp_cache_link_connected_needs_toggle_by_ifindex (cache, obj_new->link.master, obj_new, obj_old))
 				delayed_action_schedule (platform, DELAYED_ACTION_TYPE_MASTER_CONNECTED, GINT_TO_POINTER (obj_new->link.master));
@@ -4818,9 +5682,14 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 	action_type &= DELAYED_ACTION_TYPE_REFRESH_ALL;
 
 	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
+		NMPObjectType obj_type = delayed_action_refresh_to_object_type (iflags);
+
 		priv->pruning[delayed_action_refresh_all_to_idx (iflags)] = TRUE;
 		nmp_cache_dirty_set_all (nm_platform_get_cache (platform),
-		                         delayed_action_refresh_to_object_type (iflags));
+		                         obj_type);
+		if (NM_IN_SET (obj_type, NMP_OBJECT_TYPE_IP4_ROUTE,
+		                         NMP_OBJECT_TYPE_IP6_ROUTE))
+			_foreign_routes_dirty_set_all (platform, obj_type);
 	}
 
 	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
@@ -5052,6 +5921,21 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 				}
 			}
 
+			if (_foreign_route_update (platform,
+			                           obj,
+			                           FALSE,
+			                           is_dump,
+			                           msghdr->nlmsg_flags,
+			                           &resync_required)) {
+				if (resync_required) {
+					_LOGT ("schedule resync of routes after RTM_NEWROUTE of foreign route");
+					delayed_action_schedule (platform,
+					                         delayed_action_refresh_from_object_type (NMP_OBJECT_GET_TYPE (obj)),
+					                         NULL);
+				}
+				break;
+			}
+
 			cache_op = nmp_cache_update_netlink_route (cache,
 			                                           obj,
 			                                           is_dump,
@@ -5106,9 +5990,12 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 			break;
 		}
 
+		case RTM_DELROUTE:
+			if (_foreign_route_update (platform, obj, TRUE, FALSE, 0, NULL))
+				break;
+			/* fall through */
 		case RTM_DELLINK:
 		case RTM_DELADDR:
-		case RTM_DELROUTE:
 		case RTM_DELQDISC:
 		case RTM_DELTFILTER:
 			cache_op = nmp_cache_remove_netlink (cache, obj, &obj_old, &obj_new);
@@ -5450,8 +6337,21 @@ link_delete (NMPlatform *platform, int ifindex)
 static gboolean
 link_refresh (NMPlatform *platform, int ifindex)
 {
+	const NMPlatformLink *plink;
+
 	do_request_link (platform, ifindex, NULL);
-	return !!nm_platform_link_get_obj (platform, ifindex, TRUE);
+	plink = nm_platform_link_get (platform, ifindex);
+	if (!plink)
+		return FALSE;
+
+	if (plink->type == NM_LINK_TYPE_WIREGUARD) {
+		NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+		if (priv->wireguard.pending)
+			g_hash_table_remove (priv->wireguard.pending, GINT_TO_POINTER (ifindex));
+		_wireguard_refresh_link (platform, ifindex);
+	}
+	return TRUE;
 }
 
 static void
@@ -5737,103 +6637,483 @@ nla_put_failure:
 	g_return_val_if_reached (FALSE);
 }
 
-static gboolean
-link_set_sriov_params (NMPlatform *platform,
-                       int ifindex,
-                       guint num_vfs,
-                       int autoprobe)
-{
-	nm_auto_pop_netns NMPNetns *netns = NULL;
-	nm_auto_close int dirfd = -1;
-	gboolean current_autoprobe;
-	guint total, current_num;
-	char ifname[IFNAMSIZ];
-	char buf[64];
+typedef struct {
+	int ifindex;
+	int dirfd;
+	guint num_vfs;
+	guint total_vfs;
+	int autoprobe;
+	NMPlatformAsyncCallback callback;
+	gpointer callback_data;
+	bool changed:1;
+	bool queued:1;
+} SriovParamsData;
 
-	if (!nm_platform_netns_push (platform, &netns))
-		return FALSE;
+static void
+_sriov_params_data_free (gpointer user_data)
+{
+	SriovParamsData *data = user_data;
 
-	dirfd = nm_platform_sysctl_open_netdir (platform, ifindex, ifname);
-	if (!dirfd)
-		return FALSE;
+	nm_close (data->dirfd);
+	g_slice_free (SriovParamsData, data);
+}
 
-	total = nm_platform_sysctl_get_int_checked (platform,
-	                                            NMP_SYSCTL_PATHID_NETDIR (dirfd,
-	                                                                      ifname,
-	                                                                      "device/sriov_totalvfs"),
-	                                            10, 0, G_MAXUINT, 0);
-	if (errno)
-		return FALSE;
-	if (num_vfs > total) {
-		_LOGW ("link: %d only supports %u VFs (requested %u)", ifindex, total, num_vfs);
-		num_vfs = total;
-	}
+/* the sysfs helpers below run in the worker thread. They must not
+ * touch the platform instance (or log), only the directory fd of the link. */
 
-	/*
-	 * Take special care when setting new values:
-	 *  - don't touch anything if the right values are already set
-	 *  - to change the number of VFs or autoprobe we need to destroy existing VFs
-	 *  - the autoprobe setting is irrelevant when numvfs is zero
-	 */
-	current_num = nm_platform_sysctl_get_int_checked (platform,
-	                                                  NMP_SYSCTL_PATHID_NETDIR (dirfd,
-	                                                                            ifname,
-	                                                                            "device/sriov_numvfs"),
-	                                                  10, 0, G_MAXUINT, 0);
-	current_autoprobe = nm_platform_sysctl_get_int_checked (platform,
-	                                                        NMP_SYSCTL_PATHID_NETDIR (dirfd,
-	                                                                                  ifname,
-	                                                                                  "device/sriov_drivers_autoprobe"),
-	                                                        10, 0, G_MAXUINT, 0);
-	if (   current_num == num_vfs
-	    && (autoprobe == -1 || current_autoprobe == autoprobe))
-		return TRUE;
+static gboolean
+_sriov_sysfs_read_uint (int dirfd, const char *path, guint *out_value, GError **error)
+{
+	nm_auto_close int fd = -1;
+	char buf[64];
+	gssize n;
+	gint64 value;
+	int errsv;
 
-	if (current_num != 0) {
-		/* We need to destroy all other VFs before changing any value */
-		if (!nm_platform_sysctl_set (NM_PLATFORM_GET,
-		                             NMP_SYSCTL_PATHID_NETDIR (dirfd,
-		                                                       ifname,
-		                                                      "device/sriov_numvfs"),
-		                             "0")) {
-			_LOGW ("link: couldn't reset SR-IOV num_vfs: %s", strerror (errno));
-			return FALSE;
-		}
+	fd = openat (dirfd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		errsv = errno;
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             "couldn't open %s: %s", path, g_strerror (errsv));
+		return FALSE;
 	}
 
-	if (num_vfs == 0)
-		return TRUE;
-
-	if (   autoprobe >= 0
-	    && current_autoprobe != autoprobe
-	    && !nm_platform_sysctl_set (NM_PLATFORM_GET,
-	                                NMP_SYSCTL_PATHID_NETDIR (dirfd,
-	                                                          ifname,
-	                                                          "device/sriov_drivers_autoprobe"),
-	                                nm_sprintf_buf (buf, "%d", autoprobe))) {
-		_LOGW ("link: couldn't set SR-IOV drivers-autoprobe to %d: %s", autoprobe, strerror (errno));
+	do {
+		n = read (fd, buf, sizeof (buf) - 1);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) {
+		errsv = errno;
+		g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+		             "couldn't read %s: %s", path, g_strerror (errsv));
 		return FALSE;
 	}
+	buf[n] = '\0';
 
-	if (!nm_platform_sysctl_set (NM_PLATFORM_GET,
-	                             NMP_SYSCTL_PATHID_NETDIR (dirfd,
-	                                                       ifname,
-	                                                       "device/sriov_numvfs"),
-	                             nm_sprintf_buf (buf, "%u", num_vfs))) {
-		_LOGW ("link: couldn't set SR-IOV num_vfs to %d: %s", num_vfs, strerror (errno));
+	value = _nm_utils_ascii_str_to_int64 (buf, 10, 0, G_MAXUINT, -1);
+	if (value < 0) {
+		g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+		             "invalid content of %s", path);
 		return FALSE;
 	}
 
+	*out_value = value;
 	return TRUE;
 }
 
 static gboolean
-link_set_sriov_vfs (NMPlatform *platform, int ifindex, const NMPlatformVF *const *vfs)
+_sriov_sysfs_write_uint (int dirfd, const char *path, guint value, GError **error)
 {
-	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-	struct nlattr *list, *info, *vlan_list;
-	guint i;
-
+	nm_auto_close int fd = -1;
+	char buf[64];
+	gssize n;
+	gsize len;
+	int errsv;
+
+	nm_sprintf_buf (buf, "%u", value);
+	len = strlen (buf);
+
+	fd = openat (dirfd, path, O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		errsv = errno;
+		goto fail;
+	}
+
+	do {
+		n = write (fd, buf, len);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) {
+		errsv = errno;
+		goto fail;
+	}
+	if ((gsize) n != len) {
+		errsv = EIO;
+		goto fail;
+	}
+
+	return TRUE;
+
+fail:
+	g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+	             "couldn't set %s to %u: %s", path, value, g_strerror (errsv));
+	return FALSE;
+}
+
+static void
+_sriov_params_thread (GTask *task,
+                      gpointer source_object,
+                      gpointer task_data,
+                      GCancellable *cancellable)
+{
+	SriovParamsData *data = task_data;
+	GError *error = NULL;
+	guint current_num;
+	guint current_autoprobe;
+
+	if (g_task_return_error_if_cancelled (task))
+		return;
+
+	if (   !_sriov_sysfs_read_uint (data->dirfd, "device/sriov_totalvfs", &data->total_vfs, &error)
+	    || !_sriov_sysfs_read_uint (data->dirfd, "device/sriov_numvfs", &current_num, &error)
+	    || !_sriov_sysfs_read_uint (data->dirfd, "device/sriov_drivers_autoprobe", &current_autoprobe, &error))
+		goto out_error;
+
+	if (data->num_vfs > data->total_vfs)
+		data->num_vfs = data->total_vfs;
+
+	/*
+	 * Take special care when setting new values:
+	 *  - don't touch anything if the right values are already set
+	 *  - to change the number of VFs or autoprobe we need to destroy existing VFs
+	 *  - the autoprobe setting is irrelevant when numvfs is zero
+	 */
+	if (   current_num == data->num_vfs
+	    && (data->autoprobe == -1 || current_autoprobe == (guint) data->autoprobe)) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	data->changed = TRUE;
+
+	if (current_num != 0) {
+		/* We need to destroy all other VFs before changing any value */
+		if (!_sriov_sysfs_write_uint (data->dirfd, "device/sriov_numvfs", 0, &error))
+			goto out_error;
+	}
+
+	if (data->num_vfs == 0) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	if (   data->autoprobe >= 0
+	    && current_autoprobe != (guint) data->autoprobe
+	    && !_sriov_sysfs_write_uint (data->dirfd, "device/sriov_drivers_autoprobe", data->autoprobe, &error))
+		goto out_error;
+
+	if (!_sriov_sysfs_write_uint (data->dirfd, "device/sriov_numvfs", data->num_vfs, &error))
+		goto out_error;
+
+	g_task_return_boolean (task, TRUE);
+	return;
+
+out_error:
+	g_task_return_error (task, error);
+}
+
+static void
+_sriov_params_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	NMPlatform *platform = NM_PLATFORM (source);
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	SriovParamsData *data = g_task_get_task_data (G_TASK (result));
+	gs_free_error GError *error = NULL;
+	GQueue *queue;
+
+	g_task_propagate_boolean (G_TASK (result), &error);
+
+	if (error) {
+		if (!nm_utils_error_is_cancelled (error, FALSE))
+			_LOGW ("link: couldn't set SR-IOV parameters of %d: %s", data->ifindex, error->message);
+	} else if (data->changed) {
+		if (data->num_vfs == data->total_vfs && data->total_vfs > 0)
+			_LOGD ("link: %d now has %u VFs (the maximum)", data->ifindex, data->num_vfs);
+		else
+			_LOGD ("link: %d now has %u VFs", data->ifindex, data->num_vfs);
+	}
+
+	if (data->callback)
+		data->callback (error, data->callback_data);
+
+	if (!data->queued)
+		return;
+
+	/* start the next request for the link, if any. */
+	queue = g_hash_table_lookup (priv->sriov.params_queues, GINT_TO_POINTER (data->ifindex));
+	nm_assert (queue && g_queue_peek_head (queue) == result);
+	g_object_unref (g_queue_pop_head (queue));
+	if (g_queue_is_empty (queue))
+		g_hash_table_remove (priv->sriov.params_queues, GINT_TO_POINTER (data->ifindex));
+	else
+		g_task_run_in_thread (g_queue_peek_head (queue), _sriov_params_thread);
+}
+
+static void
+link_set_sriov_params_async (NMPlatform *platform,
+                             int ifindex,
+                             guint num_vfs,
+                             int autoprobe,
+                             GCancellable *cancellable,
+                             NMPlatformAsyncCallback callback,
+                             gpointer callback_data)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	gs_unref_object GTask *task = NULL;
+	SriovParamsData *data;
+	char ifname[IFNAMSIZ];
+	GQueue *queue;
+
+	task = g_task_new (platform, cancellable, _sriov_params_cb, NULL);
+
+	data = g_slice_new0 (SriovParamsData);
+	data->ifindex = ifindex;
+	data->dirfd = -1;
+	data->num_vfs = num_vfs;
+	data->autoprobe = autoprobe;
+	data->callback = callback;
+	data->callback_data = callback_data;
+	g_task_set_task_data (task, data, _sriov_params_data_free);
+
+	if (!nm_platform_netns_push (platform, &netns)) {
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+		                         "couldn't switch network namespace");
+		return;
+	}
+
+	data->dirfd = nm_platform_sysctl_open_netdir (platform, ifindex, ifname);
+	if (data->dirfd < 0) {
+		g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NOT_FOUND,
+		                         "couldn't open sysfs directory of link %d", ifindex);
+		return;
+	}
+
+	/* requests for the same link run one after the other, in the order
+	 * they were made. A cancelled request still completes only after
+	 * its worker is done, so that the next one doesn't run concurrently. */
+	if (!priv->sriov.params_queues)
+		priv->sriov.params_queues = g_hash_table_new_full (nm_direct_hash, NULL, NULL, (GDestroyNotify) g_queue_free);
+	queue = g_hash_table_lookup (priv->sriov.params_queues, GINT_TO_POINTER (ifindex));
+	if (!queue) {
+		queue = g_queue_new ();
+		g_hash_table_insert (priv->sriov.params_queues, GINT_TO_POINTER (ifindex), queue);
+	}
+
+	data->queued = TRUE;
+	g_queue_push_tail (queue, g_object_ref (task));
+	if (g_queue_get_length (queue) == 1)
+		g_task_run_in_thread (task, _sriov_params_thread);
+}
+
+/* VFs per RTM_NEWLINK message. Each VF takes about 100 bytes, so
+ * this keeps the messages well below a page. */
+#define SRIOV_VFS_PER_MSG 16
+
+/* the VF configuration as reported by the kernel. */
+typedef struct {
+	guint32 index;
+	guint32 min_tx_rate;
+	guint32 max_tx_rate;
+	guint32 vlan_id;
+	guint32 vlan_qos;
+	guint16 vlan_proto;
+	guint8 mac[32];
+	gint8 spoofchk;
+	gint8 trust;
+	bool has_mac:1;
+	bool has_rate:1;
+	bool has_vlan:1;
+} SriovVFState;
+
+static int
+_sriov_vfs_read_cb (struct nl_msg *msg, void *arg)
+{
+	GHashTable *states = arg;
+	struct nlmsghdr *nlh = nlmsg_hdr (msg);
+	struct nlattr *tb[IFLA_MAX + 1];
+	struct nlattr *vf_info;
+	int rem;
+
+	if (nlh->nlmsg_type != RTM_NEWLINK)
+		return NL_SKIP;
+	if (nlmsg_parse (nlh, sizeof (struct ifinfomsg), tb, IFLA_MAX, NULL) < 0)
+		return NL_SKIP;
+	if (!tb[IFLA_VFINFO_LIST])
+		return NL_OK;
+
+	nla_for_each_nested (vf_info, tb[IFLA_VFINFO_LIST], rem) {
+		struct nlattr *vf_tb[IFLA_VF_VLAN_LIST + 1];
+		SriovVFState *state;
+
+		if (   nla_type (vf_info) != IFLA_VF_INFO
+		    || nla_parse_nested (vf_tb, IFLA_VF_VLAN_LIST, vf_info, NULL) < 0
+		    || !vf_tb[IFLA_VF_MAC]
+		    || nla_len (vf_tb[IFLA_VF_MAC]) < sizeof (struct ifla_vf_mac))
+			continue;
+
+		state = g_slice_new0 (SriovVFState);
+		state->spoofchk = -1;
+		state->trust = -1;
+
+		{
+			const struct ifla_vf_mac *ivm = nla_data (vf_tb[IFLA_VF_MAC]);
+
+			G_STATIC_ASSERT (sizeof (state->mac) == sizeof (ivm->mac));
+			state->index = ivm->vf;
+			memcpy (state->mac, ivm->mac, sizeof (state->mac));
+			state->has_mac = TRUE;
+		}
+
+		if (   vf_tb[IFLA_VF_SPOOFCHK]
+		    && nla_len (vf_tb[IFLA_VF_SPOOFCHK]) >= sizeof (struct _ifla_vf_setting)) {
+			const struct _ifla_vf_setting *ivs = nla_data (vf_tb[IFLA_VF_SPOOFCHK]);
+
+			if (ivs->setting <= 1)
+				state->spoofchk = ivs->setting;
+		}
+
+		if (   vf_tb[IFLA_VF_TRUST]
+		    && nla_len (vf_tb[IFLA_VF_TRUST]) >= sizeof (struct _ifla_vf_setting)) {
+			const struct _ifla_vf_setting *ivs = nla_data (vf_tb[IFLA_VF_TRUST]);
+
+			if (ivs->setting <= 1)
+				state->trust = ivs->setting;
+		}
+
+		if (   vf_tb[IFLA_VF_RATE]
+		    && nla_len (vf_tb[IFLA_VF_RATE]) >= sizeof (struct _ifla_vf_rate)) {
+			const struct _ifla_vf_rate *ivr = nla_data (vf_tb[IFLA_VF_RATE]);
+
+			state->min_tx_rate = ivr->min_tx_rate;
+			state->max_tx_rate = ivr->max_tx_rate;
+			state->has_rate = TRUE;
+		}
+
+		if (vf_tb[IFLA_VF_VLAN_LIST]) {
+			struct nlattr *vlan_info;
+			int rem2;
+
+			/* the kernel supports only one VLAN per VF. */
+			nla_for_each_nested (vlan_info, vf_tb[IFLA_VF_VLAN_LIST], rem2) {
+				const struct _ifla_vf_vlan_info *ivvi;
+
+				if (   nla_type (vlan_info) != IFLA_VF_VLAN_INFO
+				    || nla_len (vlan_info) < sizeof (struct _ifla_vf_vlan_info))
+					continue;
+				ivvi = nla_data (vlan_info);
+				state->vlan_id = ivvi->vlan;
+				state->vlan_qos = ivvi->qos;
+				state->vlan_proto = ivvi->vlan_proto;
+				state->has_vlan = TRUE;
+				break;
+			}
+		} else if (   vf_tb[IFLA_VF_VLAN]
+		           && nla_len (vf_tb[IFLA_VF_VLAN]) >= sizeof (struct ifla_vf_vlan)) {
+			const struct ifla_vf_vlan *ivv = nla_data (vf_tb[IFLA_VF_VLAN]);
+
+			state->vlan_id = ivv->vlan;
+			state->vlan_qos = ivv->qos;
+			state->vlan_proto = htons (ETH_P_8021Q);
+			state->has_vlan = TRUE;
+		}
+
+		g_hash_table_insert (states, GUINT_TO_POINTER (state->index), state);
+	}
+
+	return NL_OK;
+}
+
+static void
+_sriov_vf_state_free (gpointer data)
+{
+	g_slice_free (SriovVFState, data);
+}
+
+/* fetch the current VF configuration with a separate socket, so that the
+ * reply doesn't go through the event handling of the main socket. Returns
+ * NULL if the state can't be read. */
+static GHashTable *
+_sriov_vfs_read (NMPlatform *platform, int ifindex)
+{
+	nm_auto_pop_netns NMPNetns *netns = NULL;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	GHashTable *states = NULL;
+	struct nl_sock *sk;
+	int nle;
+
+	nlmsg = _nl_msg_new_link (RTM_GETLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return NULL;
+	NLA_PUT_U32 (nlmsg, IFLA_EXT_MASK, RTEXT_FILTER_VF);
+
+	/* the socket must be in the namespace of the platform. */
+	if (!nm_platform_netns_push (platform, &netns))
+		return NULL;
+
+	sk = nl_socket_alloc ();
+	if (!sk)
+		return NULL;
+
+	nle = nl_connect (sk, NETLINK_ROUTE);
+	if (nle >= 0)
+		nle = nl_send_auto (sk, nlmsg);
+	if (nle >= 0) {
+		states = g_hash_table_new_full (nm_direct_hash, NULL, NULL, _sriov_vf_state_free);
+		nle = nl_recvmsgs (sk,
+		                   &((const struct nl_cb) {
+		                       .valid_cb = _sriov_vfs_read_cb,
+		                       .valid_arg = states,
+		                   }));
+	}
+	nl_socket_free (sk);
+
+	if (nle < 0) {
+		_LOGD ("link: couldn't read VF configuration of %d: %s", ifindex, nl_geterror (nle));
+		nm_clear_pointer (&states, g_hash_table_unref);
+	}
+	return states;
+
+nla_put_failure:
+	g_return_val_if_reached (NULL);
+}
+
+/* whether the kernel has the VF already configured as requested. Only
+ * compare what _sriov_vfs_send() would set. */
+static gboolean
+_sriov_vf_is_configured (const SriovVFState *state, const NMPlatformVF *vf)
+{
+	if (   vf->spoofchk >= 0
+	    && state->spoofchk != vf->spoofchk)
+		return FALSE;
+
+	if (   vf->trust >= 0
+	    && state->trust != vf->trust)
+		return FALSE;
+
+	if (   vf->mac.len
+	    && (   !state->has_mac
+	        || vf->mac.len > sizeof (state->mac)
+	        || memcmp (state->mac, vf->mac.data, vf->mac.len) != 0))
+		return FALSE;
+
+	if (   (vf->min_tx_rate || vf->max_tx_rate)
+	    && (   !state->has_rate
+	        || state->min_tx_rate != vf->min_tx_rate
+	        || state->max_tx_rate != vf->max_tx_rate))
+		return FALSE;
+
+	/* the VLAN is always set, or cleared. */
+	if (!state->has_vlan)
+		return FALSE;
+	if (vf->num_vlans == 0)
+		return state->vlan_id == 0 && state->vlan_qos == 0;
+	return    vf->num_vlans == 1
+	       && state->vlan_id == vf->vlans[0].id
+	       && state->vlan_qos == vf->vlans[0].qos
+	       && state->vlan_proto == htons (vf->vlans[0].proto_ad ? ETH_P_8021AD : ETH_P_8021Q);
+}
+
+static gboolean
+_sriov_vfs_send (NMPlatform *platform, int ifindex, const NMPlatformVF *const *vfs, guint n_vfs)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *list, *info, *vlan_list;
+	guint i;
+
 	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
 	                          0,
 	                          ifindex,
@@ -5841,12 +7121,12 @@ link_set_sriov_vfs (NMPlatform *platform, int ifindex, const NMPlatformVF *const
 	                          0,
 	                          0);
 	if (!nlmsg)
-		g_return_val_if_reached (NM_PLATFORM_ERROR_UNSPECIFIED);
+		g_return_val_if_reached (FALSE);
 
 	if (!(list = nla_nest_start (nlmsg, IFLA_VFINFO_LIST)))
 		goto nla_put_failure;
 
-	for (i = 0; vfs[i]; i++) {
+	for (i = 0; i < n_vfs; i++) {
 		const NMPlatformVF *vf = vfs[i];
 
 		if (!(info = nla_nest_start (nlmsg, IFLA_VF_INFO)))
@@ -5922,6 +7202,47 @@ nla_put_failure:
 	g_return_val_if_reached (FALSE);
 }
 
+static gboolean
+link_set_sriov_vfs (NMPlatform *platform, int ifindex, const NMPlatformVF *const *vfs)
+{
+	gs_unref_hashtable GHashTable *states = NULL;
+	gs_free const NMPlatformVF **pending = NULL;
+	guint n_pending = 0;
+	guint n_unchanged = 0;
+	guint i, n;
+
+	/* skip the VFs that the kernel already has configured like this. Compare
+	 * against the actual state, so that changes made outside NetworkManager
+	 * or lost on a reset of the device are restored. */
+	states = _sriov_vfs_read (platform, ifindex);
+
+	pending = g_new (const NMPlatformVF *, NM_PTRARRAY_LEN (vfs) + 1);
+	for (i = 0; vfs[i]; i++) {
+		const SriovVFState *state = NULL;
+
+		if (states)
+			state = g_hash_table_lookup (states, GUINT_TO_POINTER (vfs[i]->index));
+		if (   state
+		    && _sriov_vf_is_configured (state, vfs[i])) {
+			n_unchanged++;
+			continue;
+		}
+		pending[n_pending++] = vfs[i];
+	}
+
+	/* one message for all VFs can get too large on devices with
+	 * many VFs. Send them in chunks. */
+	for (i = 0; i < n_pending; i += n) {
+		n = MIN (n_pending - i, (guint) SRIOV_VFS_PER_MSG);
+
+		if (!_sriov_vfs_send (platform, ifindex, &pending[i], n))
+			return FALSE;
+	}
+
+	_LOGD ("link: %u VFs of %d changed, %u already up to date", n_pending, ifindex, n_unchanged);
+	return TRUE;
+}
+
 static char *
 link_get_physical_port_id (NMPlatform *platform, int ifindex)
 {
@@ -6475,177 +7796,727 @@ link_6lowpan_add (NMPlatform *platform,
                   int parent,
                   const NMPlatformLink **out_link)
 {
-	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-	struct nlattr *info;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          NLM_F_CREATE | NLM_F_EXCL,
+	                          0,
+	                          name,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	NLA_PUT_U32 (nlmsg, IFLA_LINK, parent);
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "lowpan");
+
+	nla_nest_end (nlmsg, info);
+
+	return do_add_link_with_lookup (platform,
+	                                NM_LINK_TYPE_6LOWPAN,
+	                                name, nlmsg, out_link);
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+
+static void
+_vlan_change_vlan_qos_mapping_create (gboolean is_ingress_map,
+                                      gboolean reset_all,
+                                      const NMVlanQosMapping *current_map,
+                                      guint current_n_map,
+                                      const NMVlanQosMapping *set_map,
+                                      guint set_n_map,
+                                      NMVlanQosMapping **out_map,
+                                      guint *out_n_map)
+{
+	NMVlanQosMapping *map;
+	guint i, j, len;
+	const guint INGRESS_RANGE_LEN = 8;
+
+	nm_assert (out_map && !*out_map);
+	nm_assert (out_n_map && !*out_n_map);
+
+	if (!reset_all)
+		current_n_map = 0;
+	else if (is_ingress_map)
+		current_n_map = INGRESS_RANGE_LEN;
+
+	len = current_n_map + set_n_map;
+
+	if (len == 0)
+		return;
+
+	map = g_new (NMVlanQosMapping, len);
+
+	if (current_n_map) {
+		if (is_ingress_map) {
+			/* For the ingress-map, there are only 8 entries (0 to 7).
+			 * When the user requests to reset all entries, we don't actually
+			 * need the cached entries, we can just explicitly clear all possible
+			 * ones.
+			 *
+			 * That makes only a real difference in case our cache is out-of-date.
+			 *
+			 * For the egress map we cannot do that, because there are far too
+			 * many. There we can only clear the entries that we know about. */
+			for (i = 0; i < INGRESS_RANGE_LEN; i++) {
+				map[i].from = i;
+				map[i].to = 0;
+			}
+		} else {
+			for (i = 0; i < current_n_map; i++) {
+				map[i].from = current_map[i].from;
+				map[i].to = 0;
+			}
+		}
+	}
+	if (set_n_map)
+		memcpy (&map[current_n_map], set_map, sizeof (*set_map) * set_n_map);
+
+	g_qsort_with_data (map,
+	                   len,
+	                   sizeof (*map),
+	                   _vlan_qos_mapping_cmp_from,
+	                   NULL);
+
+	for (i = 0, j = 0; i < len; i++) {
+		if (   ( is_ingress_map && !VLAN_XGRESS_PRIO_VALID (map[i].from))
+		    || (!is_ingress_map && !VLAN_XGRESS_PRIO_VALID (map[i].to)))
+			continue;
+		if (   j > 0
+		    && map[j - 1].from == map[i].from)
+			map[j - 1] = map[i];
+		else
+			map[j++] = map[i];
+	}
+
+	*out_map = map;
+	*out_n_map = j;
+}
+
+static gboolean
+link_vlan_change (NMPlatform *platform,
+                  int ifindex,
+                  NMVlanFlags flags_mask,
+                  NMVlanFlags flags_set,
+                  gboolean ingress_reset_all,
+                  const NMVlanQosMapping *ingress_map,
+                  gsize n_ingress_map,
+                  gboolean egress_reset_all,
+                  const NMVlanQosMapping *egress_map,
+                  gsize n_egress_map)
+{
+	const NMPObject *obj_cache;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	const NMPObjectLnkVlan *lnk;
+	guint new_n_ingress_map = 0;
+	guint new_n_egress_map = 0;
+	gs_free NMVlanQosMapping *new_ingress_map = NULL;
+	gs_free NMVlanQosMapping *new_egress_map = NULL;
+
+	obj_cache = nmp_cache_lookup_link (nm_platform_get_cache (platform), ifindex);
+	if (   !obj_cache
+	    || !obj_cache->_link.netlink.is_in_netlink) {
+		_LOGD ("link: change %d: %s: link does not exist", ifindex, "vlan");
+		return FALSE;
+	}
+
+	lnk = obj_cache->_link.netlink.lnk ? &obj_cache->_link.netlink.lnk->_lnk_vlan : NULL;
+
+	flags_set &= flags_mask;
+
+	_vlan_change_vlan_qos_mapping_create (TRUE,
+	                                      ingress_reset_all,
+	                                      lnk ? lnk->ingress_qos_map : NULL,
+	                                      lnk ? lnk->n_ingress_qos_map : 0,
+	                                      ingress_map,
+	                                      n_ingress_map,
+	                                      &new_ingress_map,
+	                                      &new_n_ingress_map);
+
+	_vlan_change_vlan_qos_mapping_create (FALSE,
+	                                      egress_reset_all,
+	                                      lnk ? lnk->egress_qos_map : NULL,
+	                                      lnk ? lnk->n_egress_qos_map : 0,
+	                                      egress_map,
+	                                      n_egress_map,
+	                                      &new_egress_map,
+	                                      &new_n_egress_map);
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (   !nlmsg
+	    || !_nl_msg_new_link_set_linkinfo_vlan (nlmsg,
+	                                            -1,
+	                                            flags_mask,
+	                                            flags_set,
+	                                            new_ingress_map,
+	                                            new_n_ingress_map,
+	                                            new_egress_map,
+	                                            new_n_egress_map))
+		g_return_val_if_reached (FALSE);
+
+	return do_change_link (platform, CHANGE_LINK_TYPE_UNSPEC, ifindex, nlmsg, NULL) == NM_PLATFORM_ERROR_SUCCESS;
+}
+
+static gboolean
+link_bond_change (NMPlatform *platform,
+                  int ifindex,
+                  const NMPlatformLnkBond *props)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	const NMPObject *obj_cache;
+	const NMPlatformLnkBond *cached = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+	struct nlattr *targets;
+	guint i;
+
+	obj_cache = nmp_cache_lookup_link (nm_platform_get_cache (platform), ifindex);
+	if (   !obj_cache
+	    || !obj_cache->_link.netlink.is_in_netlink) {
+		_LOGD ("link: change %d: %s: link does not exist", ifindex, "bond");
+		return FALSE;
+	}
+	if (   obj_cache->_link.netlink.lnk
+	    && NMP_OBJECT_GET_TYPE (obj_cache->_link.netlink.lnk) == NMP_OBJECT_TYPE_LNK_BOND)
+		cached = &obj_cache->_link.netlink.lnk->lnk_bond;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "bond");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	/* Kernel refuses to change some options while the bond is up (or
+	 * has slaves), even if the value stays the same. Only send them
+	 * if they actually change. */
+	if (!cached || cached->mode != props->mode)
+		NLA_PUT_U8 (nlmsg, IFLA_BOND_MODE, props->mode);
+	if (!cached || cached->ad_select != props->ad_select)
+		NLA_PUT_U8 (nlmsg, IFLA_BOND_AD_SELECT, props->ad_select);
+	if (props->lacp_rate_has && (!cached || cached->lacp_rate != props->lacp_rate))
+		NLA_PUT_U8 (nlmsg, IFLA_BOND_AD_LACP_RATE, props->lacp_rate);
+	if (props->tlb_dynamic_lb_has && (!cached || cached->tlb_dynamic_lb != props->tlb_dynamic_lb))
+		NLA_PUT_U8 (nlmsg, IFLA_BOND_TLB_DYNAMIC_LB, props->tlb_dynamic_lb);
+	if (!cached || cached->fail_over_mac != props->fail_over_mac)
+		NLA_PUT_U8 (nlmsg, IFLA_BOND_FAIL_OVER_MAC, props->fail_over_mac);
+
+	/* The order matters: kernel applies the attributes in the order of
+	 * their type and setting arp_interval disables miimon and vice versa. */
+	if (props->miimon_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_MIIMON, props->miimon);
+	if (props->updelay_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_UPDELAY, props->updelay);
+	if (props->downdelay_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_DOWNDELAY, props->downdelay);
+	NLA_PUT_U8 (nlmsg, IFLA_BOND_USE_CARRIER, props->use_carrier);
+	if (props->arp_interval_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_ARP_INTERVAL, props->arp_interval);
+
+	/* the nested list replaces all existing targets. */
+	if (!(targets = nla_nest_start (nlmsg, IFLA_BOND_ARP_IP_TARGET)))
+		goto nla_put_failure;
+	for (i = 0; i < props->arp_ip_targets_num && i < NM_BOND_MAX_ARP_TARGETS; i++)
+		NLA_PUT_U32 (nlmsg, i, props->arp_ip_target[i]);
+	nla_nest_end (nlmsg, targets);
+	if (props->arp_validate_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_ARP_VALIDATE, props->arp_validate);
+	NLA_PUT_U32 (nlmsg, IFLA_BOND_ARP_ALL_TARGETS, props->arp_all_targets);
+	if (props->primary_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_PRIMARY, props->primary);
+	if (props->active_slave_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_ACTIVE_SLAVE, props->active_slave);
+	NLA_PUT_U8 (nlmsg, IFLA_BOND_PRIMARY_RESELECT, props->primary_reselect);
+	NLA_PUT_U8 (nlmsg, IFLA_BOND_XMIT_HASH_POLICY, props->xmit_hash_policy);
+	NLA_PUT_U32 (nlmsg, IFLA_BOND_RESEND_IGMP, props->resend_igmp);
+	NLA_PUT_U8 (nlmsg, IFLA_BOND_NUM_PEER_NOTIF, props->num_grat_arp);
+	NLA_PUT_U8 (nlmsg, IFLA_BOND_ALL_SLAVES_ACTIVE, props->all_slaves_active);
+	NLA_PUT_U32 (nlmsg, IFLA_BOND_MIN_LINKS, props->min_links);
+	NLA_PUT_U32 (nlmsg, IFLA_BOND_LP_INTERVAL, props->lp_interval);
+	if (props->packets_per_slave_has)
+		NLA_PUT_U32 (nlmsg, IFLA_BOND_PACKETS_PER_SLAVE, props->packets_per_slave);
+	if (props->ad_actor_sys_prio_has)
+		NLA_PUT_U16 (nlmsg, IFLA_BOND_AD_ACTOR_SYS_PRIO, props->ad_actor_sys_prio);
+	if (props->ad_user_port_key_has)
+		NLA_PUT_U16 (nlmsg, IFLA_BOND_AD_USER_PORT_KEY, props->ad_user_port_key);
+	if (props->ad_actor_system_has)
+		NLA_PUT (nlmsg, IFLA_BOND_AD_ACTOR_SYSTEM, sizeof (props->ad_actor_system), props->ad_actor_system);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return do_change_link (platform, CHANGE_LINK_TYPE_UNSPEC, ifindex, nlmsg, NULL) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+link_bridge_change (NMPlatform *platform,
+                    int ifindex,
+                    const NMPlatformLnkBridge *props)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "bridge");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U32 (nlmsg, IFLA_BR_STP_STATE, props->stp_state);
+	NLA_PUT_U16 (nlmsg, IFLA_BR_PRIORITY, props->priority);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_FORWARD_DELAY, props->forward_delay);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_HELLO_TIME, props->hello_time);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_MAX_AGE, props->max_age);
+	NLA_PUT_U32 (nlmsg, IFLA_BR_AGEING_TIME, props->ageing_time);
+	NLA_PUT_U16 (nlmsg, IFLA_BR_GROUP_FWD_MASK, props->group_fwd_mask);
+	NLA_PUT_U8 (nlmsg, IFLA_BR_MCAST_SNOOPING, props->mcast_snooping);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return do_change_link (platform, CHANGE_LINK_TYPE_UNSPEC, ifindex, nlmsg, NULL) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static gboolean
+link_bridge_port_change (NMPlatform *platform,
+                         int ifindex,
+                         guint16 priority,
+                         guint32 path_cost,
+                         gboolean hairpin)
+{
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	struct nlattr *info;
+	struct nlattr *data;
+
+	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
+	                          0,
+	                          ifindex,
+	                          NULL,
+	                          0,
+	                          0);
+	if (!nlmsg)
+		return FALSE;
+
+	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
+		goto nla_put_failure;
+
+	NLA_PUT_STRING (nlmsg, IFLA_INFO_SLAVE_KIND, "bridge");
+
+	if (!(data = nla_nest_start (nlmsg, IFLA_INFO_SLAVE_DATA)))
+		goto nla_put_failure;
+
+	NLA_PUT_U16 (nlmsg, IFLA_BRPORT_PRIORITY, priority);
+	NLA_PUT_U32 (nlmsg, IFLA_BRPORT_COST, path_cost);
+	NLA_PUT_U8 (nlmsg, IFLA_BRPORT_MODE, !!hairpin);
+
+	nla_nest_end (nlmsg, data);
+	nla_nest_end (nlmsg, info);
+
+	return do_change_link (platform, CHANGE_LINK_TYPE_UNSPEC, ifindex, nlmsg, NULL) == NM_PLATFORM_ERROR_SUCCESS;
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+typedef struct {
+	const NMPWireGuardPeer *peer;
+	guint32 flags;
+} WireGuardPeerOp;
+
+static guint
+_wireguard_peer_public_key_hash (gconstpointer ptr)
+{
+	const NMPWireGuardPeer *peer = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1839416707u);
+	nm_hash_update_mem (&h, peer->public_key, sizeof (peer->public_key));
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_wireguard_peer_public_key_equal (gconstpointer a, gconstpointer b)
+{
+	const NMPWireGuardPeer *peer_a = a;
+	const NMPWireGuardPeer *peer_b = b;
+
+	return memcmp (peer_a->public_key, peer_b->public_key, sizeof (peer_a->public_key)) == 0;
+}
+
+static int
+_wireguard_allowed_ip_cmp (gconstpointer a, gconstpointer b)
+{
+	const NMPWireGuardAllowedIP *ip_a = a;
+	const NMPWireGuardAllowedIP *ip_b = b;
+
+	NM_CMP_FIELD (ip_a, ip_b, family);
+	NM_CMP_FIELD (ip_a, ip_b, mask);
+	NM_CMP_FIELD_MEMCMP_LEN (ip_a, ip_b, addr, nm_utils_addr_family_to_size (ip_a->family));
+	return 0;
+}
+
+static gboolean
+_wireguard_peer_is_unchanged (const NMPWireGuardPeer *peer_old,
+                              const NMPWireGuardPeer *peer)
+{
+	gs_free NMPWireGuardAllowedIP *ips_old = NULL;
+	gs_free NMPWireGuardAllowedIP *ips = NULL;
+	guint i;
 
-	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
-	                          NLM_F_CREATE | NLM_F_EXCL,
-	                          0,
-	                          name,
-	                          0,
-	                          0);
-	if (!nlmsg)
+	if (memcmp (peer_old->preshared_key, peer->preshared_key, sizeof (peer->preshared_key)) != 0)
+		return FALSE;
+	if (peer_old->persistent_keepalive_interval != peer->persistent_keepalive_interval)
 		return FALSE;
 
-	NLA_PUT_U32 (nlmsg, IFLA_LINK, parent);
-
-	if (!(info = nla_nest_start (nlmsg, IFLA_LINKINFO)))
-		goto nla_put_failure;
-
-	NLA_PUT_STRING (nlmsg, IFLA_INFO_KIND, "lowpan");
+	/* without an endpoint configured, the kernel learns it from incoming
+	 * packets. Don't treat that as a difference. */
+	if (peer->endpoint_family != AF_UNSPEC) {
+		if (   peer_old->endpoint_family != peer->endpoint_family
+		    || peer_old->endpoint_port != peer->endpoint_port
+		    || memcmp (&peer_old->endpoint_addr, &peer->endpoint_addr, nm_utils_addr_family_to_size (peer->endpoint_family)) != 0)
+			return FALSE;
+	}
 
-	nla_nest_end (nlmsg, info);
+	if (peer_old->allowed_ips_len != peer->allowed_ips_len)
+		return FALSE;
+	if (peer->allowed_ips_len == 0)
+		return TRUE;
 
-	return do_add_link_with_lookup (platform,
-	                                NM_LINK_TYPE_6LOWPAN,
-	                                name, nlmsg, out_link);
-nla_put_failure:
-	g_return_val_if_reached (FALSE);
+	/* the kernel returns the allowed-ips in the order of its routing trie,
+	 * compare them as sets. */
+	ips_old = nm_memdup (peer_old->allowed_ips, sizeof (NMPWireGuardAllowedIP) * peer_old->allowed_ips_len);
+	ips = nm_memdup (peer->allowed_ips, sizeof (NMPWireGuardAllowedIP) * peer->allowed_ips_len);
+	qsort (ips_old, peer->allowed_ips_len, sizeof (NMPWireGuardAllowedIP), _wireguard_allowed_ip_cmp);
+	qsort (ips, peer->allowed_ips_len, sizeof (NMPWireGuardAllowedIP), _wireguard_allowed_ip_cmp);
+	for (i = 0; i < peer->allowed_ips_len; i++) {
+		if (_wireguard_allowed_ip_cmp (&ips_old[i], &ips[i]) != 0)
+			return FALSE;
+	}
+	return TRUE;
 }
 
-
-static void
-_vlan_change_vlan_qos_mapping_create (gboolean is_ingress_map,
-                                      gboolean reset_all,
-                                      const NMVlanQosMapping *current_map,
-                                      guint current_n_map,
-                                      const NMVlanQosMapping *set_map,
-                                      guint set_n_map,
-                                      NMVlanQosMapping **out_map,
-                                      guint *out_n_map)
+static struct nl_msg *
+_wireguard_nlmsg_new (int family_id,
+                      int ifindex,
+                      const NMPlatformLnkWireGuard *lnk_wireguard,
+                      guint32 wgdevice_flags)
 {
-	NMVlanQosMapping *map;
-	guint i, j, len;
-	const guint INGRESS_RANGE_LEN = 8;
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
 
-	nm_assert (out_map && !*out_map);
-	nm_assert (out_n_map && !*out_n_map);
+	msg = nlmsg_alloc ();
 
-	if (!reset_all)
-		current_n_map = 0;
-	else if (is_ingress_map)
-		current_n_map = INGRESS_RANGE_LEN;
+	if (!genlmsg_put (msg,
+	                  NL_AUTO_PORT,
+	                  NL_AUTO_SEQ,
+	                  family_id,
+	                  0,
+	                  NLM_F_REQUEST,
+	                  WG_CMD_SET_DEVICE,
+	                  1))
+		goto nla_put_failure;
 
-	len = current_n_map + set_n_map;
+	NLA_PUT_U32 (msg, WGDEVICE_A_IFINDEX, (guint32) ifindex);
 
-	if (len == 0)
-		return;
+	if (lnk_wireguard) {
+		NLA_PUT (msg, WGDEVICE_A_PRIVATE_KEY, sizeof (lnk_wireguard->private_key), lnk_wireguard->private_key);
+		NLA_PUT_U16 (msg, WGDEVICE_A_LISTEN_PORT, lnk_wireguard->listen_port);
+		NLA_PUT_U32 (msg, WGDEVICE_A_FWMARK, lnk_wireguard->fwmark);
+	}
+	if (wgdevice_flags)
+		NLA_PUT_U32 (msg, WGDEVICE_A_FLAGS, wgdevice_flags);
 
-	map = g_new (NMVlanQosMapping, len);
+	return g_steal_pointer (&msg);
+nla_put_failure:
+	g_return_val_if_reached (NULL);
+}
 
-	if (current_n_map) {
-		if (is_ingress_map) {
-			/* For the ingress-map, there are only 8 entries (0 to 7).
-			 * When the user requests to reset all entries, we don't actually
-			 * need the cached entries, we can just explicitly clear all possible
-			 * ones.
-			 *
-			 * That makes only a real difference in case our cache is out-of-date.
-			 *
-			 * For the egress map we cannot do that, because there are far too
-			 * many. There we can only clear the entries that we know about. */
-			for (i = 0; i < INGRESS_RANGE_LEN; i++) {
-				map[i].from = i;
-				map[i].to = 0;
-			}
-		} else {
-			for (i = 0; i < current_n_map; i++) {
-				map[i].from = current_map[i].from;
-				map[i].to = 0;
+/* Appends @op to @msg. If the message is full, the peer is either dropped
+ * entirely or closed after the last allowed-ip that still fits. In the latter
+ * case, @p_header_done and @p_allowed_ip_idx are updated so that the next
+ * message only carries the public-key and the remaining allowed-ips of the
+ * peer. Returns %FALSE if the peer is not yet complete. */
+static gboolean
+_wireguard_nlmsg_append_peer (struct nl_msg *msg,
+                              const WireGuardPeerOp *op,
+                              gboolean *p_header_done,
+                              guint *p_allowed_ip_idx)
+{
+	const NMPWireGuardPeer *peer = op->peer;
+	struct nlattr *peer_nest;
+	struct nlattr *ips_nest;
+	struct nlattr *ip_nest;
+	guint i;
+
+	if (!(peer_nest = nla_nest_start (msg, 0)))
+		return FALSE;
+
+	if (nla_put (msg, WGPEER_A_PUBLIC_KEY, sizeof (peer->public_key), peer->public_key) < 0)
+		goto full;
+
+	if (!*p_header_done) {
+		if (nla_put (msg, WGPEER_A_FLAGS, sizeof (guint32), &op->flags) < 0)
+			goto full;
+
+		if (!NM_FLAGS_HAS (op->flags, WGPEER_F_REMOVE_ME)) {
+			if (nla_put (msg, WGPEER_A_PRESHARED_KEY, sizeof (peer->preshared_key), peer->preshared_key) < 0)
+				goto full;
+			if (nla_put (msg, WGPEER_A_PERSISTENT_KEEPALIVE_INTERVAL, sizeof (guint16), &peer->persistent_keepalive_interval) < 0)
+				goto full;
+
+			if (peer->endpoint_family == AF_INET) {
+				struct sockaddr_in sin = {
+					.sin_family = AF_INET,
+					.sin_port = htons (peer->endpoint_port),
+					.sin_addr.s_addr = peer->endpoint_addr.addr4,
+				};
+
+				if (nla_put (msg, WGPEER_A_ENDPOINT, sizeof (sin), &sin) < 0)
+					goto full;
+			} else if (peer->endpoint_family == AF_INET6) {
+				struct sockaddr_in6 sin6 = {
+					.sin6_family = AF_INET6,
+					.sin6_port = htons (peer->endpoint_port),
+					.sin6_addr = peer->endpoint_addr.addr6,
+				};
+
+				if (nla_put (msg, WGPEER_A_ENDPOINT, sizeof (sin6), &sin6) < 0)
+					goto full;
 			}
 		}
 	}
-	if (set_n_map)
-		memcpy (&map[current_n_map], set_map, sizeof (*set_map) * set_n_map);
 
-	g_qsort_with_data (map,
-	                   len,
-	                   sizeof (*map),
-	                   _vlan_qos_mapping_cmp_from,
-	                   NULL);
+	if (   !NM_FLAGS_HAS (op->flags, WGPEER_F_REMOVE_ME)
+	    && *p_allowed_ip_idx < peer->allowed_ips_len) {
+		if (!(ips_nest = nla_nest_start (msg, WGPEER_A_ALLOWEDIPS)))
+			goto full;
+
+		for (i = *p_allowed_ip_idx; i < peer->allowed_ips_len; i++) {
+			const NMPWireGuardAllowedIP *ip = &peer->allowed_ips[i];
+			guint16 family = ip->family;
+
+			if (   !(ip_nest = nla_nest_start (msg, 0))
+			    || nla_put (msg, WGALLOWEDIP_A_FAMILY, sizeof (family), &family) < 0
+			    || nla_put (msg, WGALLOWEDIP_A_IPADDR, nm_utils_addr_family_to_size (ip->family), &ip->addr) < 0
+			    || nla_put (msg, WGALLOWEDIP_A_CIDR_MASK, sizeof (guint8), &ip->mask) < 0) {
+				if (ip_nest)
+					nla_nest_cancel (msg, ip_nest);
+				if (i == *p_allowed_ip_idx) {
+					nla_nest_cancel (msg, ips_nest);
+					goto full;
+				}
 
-	for (i = 0, j = 0; i < len; i++) {
-		if (   ( is_ingress_map && !VLAN_XGRESS_PRIO_VALID (map[i].from))
-		    || (!is_ingress_map && !VLAN_XGRESS_PRIO_VALID (map[i].to)))
-			continue;
-		if (   j > 0
-		    && map[j - 1].from == map[i].from)
-			map[j - 1] = map[i];
-		else
-			map[j++] = map[i];
+				/* split the peer. Continue with the remaining allowed-ips
+				 * in the next message. */
+				nla_nest_end (msg, ips_nest);
+				nla_nest_end (msg, peer_nest);
+				*p_header_done = TRUE;
+				*p_allowed_ip_idx = i;
+				return FALSE;
+			}
+			nla_nest_end (msg, ip_nest);
+		}
+		nla_nest_end (msg, ips_nest);
 	}
 
-	*out_map = map;
-	*out_n_map = j;
+	nla_nest_end (msg, peer_nest);
+	return TRUE;
+
+full:
+	nla_nest_cancel (msg, peer_nest);
+	return FALSE;
 }
 
 static gboolean
-link_vlan_change (NMPlatform *platform,
-                  int ifindex,
-                  NMVlanFlags flags_mask,
-                  NMVlanFlags flags_set,
-                  gboolean ingress_reset_all,
-                  const NMVlanQosMapping *ingress_map,
-                  gsize n_ingress_map,
-                  gboolean egress_reset_all,
-                  const NMVlanQosMapping *egress_map,
-                  gsize n_egress_map)
+link_wireguard_change (NMPlatform *platform,
+                       int ifindex,
+                       const NMPlatformLnkWireGuard *lnk_wireguard,
+                       const NMPWireGuardPeer *peers,
+                       guint peers_len,
+                       gboolean replace_peers)
 {
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	nm_auto_nmpobj const NMPObject *lnk_old_obj = NULL;
+	gs_unref_hashtable GHashTable *old_peers = NULL;
+	gs_unref_ptrarray GPtrArray *msgs = NULL;
+	gs_free WireGuardPeerOp *ops = NULL;
+	const NMPObjectLnkWireGuard *lnk_old = NULL;
 	const NMPObject *obj_cache;
-	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-	const NMPObjectLnkVlan *lnk;
-	guint new_n_ingress_map = 0;
-	guint new_n_egress_map = 0;
-	gs_free NMVlanQosMapping *new_ingress_map = NULL;
-	gs_free NMVlanQosMapping *new_egress_map = NULL;
+	struct nl_msg *msg;
+	struct nlattr *peers_nest = NULL;
+	gboolean send_device;
+	gboolean header_done = FALSE;
+	guint allowed_ip_idx = 0;
+	guint32 wgdevice_flags = 0;
+	guint32 peers_nest_len = 0;
+	guint ops_len = 0;
+	int family_id;
+	int nle;
+	guint i;
 
-	obj_cache = nmp_cache_lookup_link (nm_platform_get_cache (platform), ifindex);
-	if (   !obj_cache
-	    || !obj_cache->_link.netlink.is_in_netlink) {
-		_LOGD ("link: change %d: %s: link does not exist", ifindex, "vlan");
+	family_id = _wireguard_get_family_id (platform);
+	if (family_id < 0) {
+		_LOGW ("wireguard: cannot change link %d: generic netlink family not available", ifindex);
 		return FALSE;
 	}
 
-	lnk = obj_cache->_link.netlink.lnk ? &obj_cache->_link.netlink.lnk->_lnk_vlan : NULL;
+	/* only send what differs from the configuration in the kernel. Re-read it
+	 * first, the cached data may lag behind due to rate limiting. */
+	_wireguard_refresh_link (platform, ifindex);
+	obj_cache = nmp_cache_lookup_link (nm_platform_get_cache (platform), ifindex);
+	if (   obj_cache
+	    && obj_cache->link.type == NM_LINK_TYPE_WIREGUARD
+	    && obj_cache->_link.netlink.lnk) {
+		lnk_old_obj = nmp_object_ref (obj_cache->_link.netlink.lnk);
+		lnk_old = &lnk_old_obj->_lnk_wireguard;
+	}
+
+	send_device =    !lnk_old
+	              || lnk_old->_public.listen_port != lnk_wireguard->listen_port
+	              || lnk_old->_public.fwmark != lnk_wireguard->fwmark
+	              || memcmp (lnk_old->_public.private_key, lnk_wireguard->private_key, sizeof (lnk_wireguard->private_key)) != 0;
+
+	if (lnk_old && lnk_old->peers_len > 0) {
+		old_peers = g_hash_table_new (_wireguard_peer_public_key_hash, _wireguard_peer_public_key_equal);
+		for (i = 0; i < lnk_old->peers_len; i++)
+			g_hash_table_add (old_peers, (gpointer) &lnk_old->peers[i]);
+	} else if (!lnk_old && replace_peers)
+		wgdevice_flags |= WGDEVICE_F_REPLACE_PEERS;
+
+	ops = g_new (WireGuardPeerOp, peers_len + (old_peers ? g_hash_table_size (old_peers) : 0u));
+
+	for (i = 0; i < peers_len; i++) {
+		const NMPWireGuardPeer *peer_old = NULL;
+
+		if (old_peers) {
+			peer_old = g_hash_table_lookup (old_peers, &peers[i]);
+			if (peer_old)
+				g_hash_table_remove (old_peers, peer_old);
+		}
+		if (   peer_old
+		    && _wireguard_peer_is_unchanged (peer_old, &peers[i]))
+			continue;
+		ops[ops_len++] = (WireGuardPeerOp) {
+			.peer = &peers[i],
+			.flags = WGPEER_F_REPLACE_ALLOWEDIPS,
+		};
+	}
 
-	flags_set &= flags_mask;
+	if (   replace_peers
+	    && old_peers) {
+		GHashTableIter iter;
+		const NMPWireGuardPeer *peer_old;
 
-	_vlan_change_vlan_qos_mapping_create (TRUE,
-	                                      ingress_reset_all,
-	                                      lnk ? lnk->ingress_qos_map : NULL,
-	                                      lnk ? lnk->n_ingress_qos_map : 0,
-	                                      ingress_map,
-	                                      n_ingress_map,
-	                                      &new_ingress_map,
-	                                      &new_n_ingress_map);
+		g_hash_table_iter_init (&iter, old_peers);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &peer_old, NULL)) {
+			ops[ops_len++] = (WireGuardPeerOp) {
+				.peer = peer_old,
+				.flags = WGPEER_F_REMOVE_ME,
+			};
+		}
+	}
 
-	_vlan_change_vlan_qos_mapping_create (FALSE,
-	                                      egress_reset_all,
-	                                      lnk ? lnk->egress_qos_map : NULL,
-	                                      lnk ? lnk->n_egress_qos_map : 0,
-	                                      egress_map,
-	                                      n_egress_map,
-	                                      &new_egress_map,
-	                                      &new_n_egress_map);
+	if (   !send_device
+	    && !wgdevice_flags
+	    && ops_len == 0) {
+		_LOGD ("wireguard: link %d is already up to date", ifindex);
+		return TRUE;
+	}
 
-	nlmsg = _nl_msg_new_link (RTM_NEWLINK,
-	                          0,
-	                          ifindex,
-	                          NULL,
-	                          0,
-	                          0);
-	if (   !nlmsg
-	    || !_nl_msg_new_link_set_linkinfo_vlan (nlmsg,
-	                                            -1,
-	                                            flags_mask,
-	                                            flags_set,
-	                                            new_ingress_map,
-	                                            new_n_ingress_map,
-	                                            new_egress_map,
-	                                            new_n_egress_map))
-		g_return_val_if_reached (FALSE);
+	/* a large set of peers and allowed-ips does not fit into one netlink
+	 * message. Split it across several WG_CMD_SET_DEVICE requests, which the
+	 * kernel applies incrementally. Only the first one carries the device
+	 * attributes and flags. */
+	msgs = g_ptr_array_new_with_free_func ((GDestroyNotify) nlmsg_free);
+	msg = _wireguard_nlmsg_new (family_id, ifindex, send_device ? lnk_wireguard : NULL, wgdevice_flags);
+	if (!msg)
+		return FALSE;
+	g_ptr_array_add (msgs, msg);
 
-	return do_change_link (platform, CHANGE_LINK_TYPE_UNSPEC, ifindex, nlmsg, NULL) == NM_PLATFORM_ERROR_SUCCESS;
+	i = 0;
+	while (i < ops_len) {
+		if (!peers_nest) {
+			if (!(peers_nest = nla_nest_start (msg, WGDEVICE_A_PEERS)))
+				g_return_val_if_reached (FALSE);
+			peers_nest_len = nlmsg_hdr (msg)->nlmsg_len;
+		}
+
+		if (_wireguard_nlmsg_append_peer (msg, &ops[i], &header_done, &allowed_ip_idx)) {
+			header_done = FALSE;
+			allowed_ip_idx = 0;
+			i++;
+			continue;
+		}
+
+		/* the message is full. If not even a part of the peer fit into
+		 * an otherwise empty message, give up. */
+		if (nlmsg_hdr (msg)->nlmsg_len == peers_nest_len)
+			g_return_val_if_reached (FALSE);
+
+		nla_nest_end (msg, peers_nest);
+		peers_nest = NULL;
+
+		msg = _wireguard_nlmsg_new (family_id, ifindex, NULL, 0);
+		if (!msg)
+			return FALSE;
+		g_ptr_array_add (msgs, msg);
+	}
+	if (peers_nest)
+		nla_nest_end (msg, peers_nest);
+
+	for (i = 0; i < msgs->len; i++) {
+		nle = nl_send_auto (priv->genl, msgs->pdata[i]);
+		if (nle >= 0)
+			nle = nl_wait_for_ack (priv->genl, NULL);
+		if (nle < 0) {
+			_LOGW ("wireguard: failed to change link %d (message %u of %u): %s",
+			       ifindex, i + 1, msgs->len, nl_geterror (nle));
+			_wireguard_refresh_link (platform, ifindex);
+			return FALSE;
+		}
+	}
+
+	_LOGD ("wireguard: changed link %d with %u peer updates in %u messages",
+	       ifindex, ops_len, msgs->len);
+
+	_wireguard_refresh_link (platform, ifindex);
+	return TRUE;
 }
 
 static gboolean
@@ -7174,6 +9045,56 @@ object_delete (NMPlatform *platform,
 
 /*****************************************************************************/
 
+static GPtrArray *
+ip_route_get_foreign (NMPlatform *platform, int addr_family, int ifindex)
+{
+	GPtrArray *result = NULL;
+	ForeignRoutes *routes;
+	guint i;
+
+	if (!NM_LINUX_PLATFORM_GET_PRIVATE (platform)->compact_foreign_routes)
+		return NULL;
+
+	routes = _foreign_routes_get (platform, addr_family);
+	_foreign_routes_merge (routes, FALSE);
+
+	for (i = 0; i < routes->sorted->len; i++) {
+		const ForeignRoute *r = _foreign_route_at (routes->sorted, i);
+
+		if (r->ifindex != ifindex)
+			continue;
+		if (!result)
+			result = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+		g_ptr_array_add (result, _foreign_route_to_obj (r, routes->addr_len));
+	}
+	return result;
+}
+
+static gboolean
+ip_route_is_foreign (NMPlatform *platform, const NMPObject *route)
+{
+	guint8 needle_buf[FOREIGN_ROUTE_SIZE_MAX] _nm_alignas (guint64);
+	ForeignRoute *needle = (ForeignRoute *) needle_buf;
+	ForeignRoutes *routes;
+
+	if (!NM_LINUX_PLATFORM_GET_PRIVATE (platform)->compact_foreign_routes)
+		return FALSE;
+
+	if (!_foreign_route_is_foreign (route))
+		return FALSE;
+
+	routes = _foreign_routes_get (platform, NMP_OBJECT_GET_CLASS (route)->addr_family);
+	_foreign_routes_merge (routes, FALSE);
+
+	_foreign_route_init (needle, route, 0);
+	return nm_utils_array_find_binary_search (routes->sorted->data,
+	                                          _foreign_route_size (routes->addr_len),
+	                                          routes->sorted->len,
+	                                          needle,
+	                                          _foreign_route_cmp,
+	                                          GSIZE_TO_POINTER (routes->addr_len)) >= 0;
+}
+
 static NMPlatformError
 ip_route_get (NMPlatform *platform,
               int addr_family,
@@ -7787,7 +9708,32 @@ handle_udev_event (NMUdevClient *udev_client,
 void
 nm_linux_platform_setup (void)
 {
-	nm_platform_setup (nm_linux_platform_new (FALSE, FALSE));
+	nm_linux_platform_setup_full (FALSE);
+}
+
+void
+nm_linux_platform_setup_full (gboolean compact_foreign_routes)
+{
+	nm_platform_setup (nm_linux_platform_new (FALSE, FALSE, compact_foreign_routes));
+}
+
+/*****************************************************************************/
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_COMPACT_FOREIGN_ROUTES:
+		/* construct-only */
+		priv->compact_foreign_routes = g_value_get_boolean (value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
 }
 
 /*****************************************************************************/
@@ -7800,6 +9746,7 @@ nm_linux_platform_init (NMLinuxPlatform *self)
 	priv->delayed_action.list_master_connected = g_ptr_array_new ();
 	priv->delayed_action.list_refresh_link = g_ptr_array_new ();
 	priv->delayed_action.list_wait_for_nl_response = g_array_new (FALSE, TRUE, sizeof (DelayedActionWaitForNlResponseData));
+	priv->wireguard.family_id = -1;
 }
 
 static void
@@ -7818,7 +9765,19 @@ constructed (GObject *_object)
 		                                        handle_udev_event, platform);
 	}
 
-	_LOGD ("create (%s netns, %s, %s udev)",
+	if (priv->compact_foreign_routes) {
+		guint i;
+
+		for (i = 0; i < G_N_ELEMENTS (priv->foreign_routes); i++) {
+			ForeignRoutes *routes = &priv->foreign_routes[i];
+
+			routes->addr_len = i == 0 ? sizeof (in_addr_t) : sizeof (struct in6_addr);
+			routes->sorted = g_array_new (FALSE, FALSE, _foreign_route_size (routes->addr_len));
+			routes->pending = g_array_new (FALSE, FALSE, _foreign_route_size (routes->addr_len));
+		}
+	}
+
+	_LOGD ("create (%s netns, %s, %s udev%s)",
 	       !platform->_netns ? "ignore" : "use",
 	       !platform->_netns && nmp_netns_is_initial ()
 	           ? "initial netns"
@@ -7827,7 +9786,8 @@ constructed (GObject *_object)
 	                : nm_sprintf_bufa (100, "in netns[%p]%s",
 	                                   nmp_netns_get_current (),
 	                                   nmp_netns_get_current () == nmp_netns_get_initial () ? "/main" : "")),
-	       nm_platform_get_use_udev (platform) ? "use" : "no");
+	       nm_platform_get_use_udev (platform) ? "use" : "no",
+	       priv->compact_foreign_routes ? ", compact foreign routes" : "");
 
 
 	priv->genl = nl_socket_alloc ();
@@ -7933,7 +9893,9 @@ constructed (GObject *_object)
 }
 
 NMPlatform *
-nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support)
+nm_linux_platform_new (gboolean log_with_ptr,
+                       gboolean netns_support,
+                       gboolean compact_foreign_routes)
 {
 	gboolean use_udev = FALSE;
 
@@ -7945,6 +9907,7 @@ nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support)
 	                     NM_PLATFORM_LOG_WITH_PTR, log_with_ptr,
 	                     NM_PLATFORM_USE_UDEV, use_udev,
 	                     NM_PLATFORM_NETNS_SUPPORT, netns_support,
+	                     NM_LINUX_PLATFORM_COMPACT_FOREIGN_ROUTES, compact_foreign_routes,
 	                     NULL);
 }
 
@@ -7963,6 +9926,10 @@ dispose (GObject *object)
 	g_ptr_array_set_size (priv->delayed_action.list_master_connected, 0);
 	g_ptr_array_set_size (priv->delayed_action.list_refresh_link, 0);
 
+	nm_clear_g_source (&priv->wireguard.timeout_id);
+	nm_clear_pointer (&priv->wireguard.pending, g_hash_table_destroy);
+	nm_clear_pointer (&priv->sriov.params_queues, g_hash_table_destroy);
+
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->dispose (object);
 }
 
@@ -7988,6 +9955,15 @@ finalize (GObject *object)
 
 	priv->udev_client = nm_udev_client_unref (priv->udev_client);
 
+	if (priv->compact_foreign_routes) {
+		guint i;
+
+		for (i = 0; i < G_N_ELEMENTS (priv->foreign_routes); i++) {
+			g_array_unref (priv->foreign_routes[i].sorted);
+			g_array_unref (priv->foreign_routes[i].pending);
+		}
+	}
+
 	G_OBJECT_CLASS (nm_linux_platform_parent_class)->finalize (object);
 }
 
@@ -7998,9 +9974,19 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	NMPlatformClass *platform_class = NM_PLATFORM_CLASS (klass);
 
 	object_class->constructed = constructed;
+	object_class->set_property = set_property;
 	object_class->dispose = dispose;
 	object_class->finalize = finalize;
 
+	obj_properties[PROP_COMPACT_FOREIGN_ROUTES] =
+	    g_param_spec_boolean (NM_LINUX_PLATFORM_COMPACT_FOREIGN_ROUTES, "", "",
+	                          FALSE,
+	                          G_PARAM_WRITABLE |
+	                          G_PARAM_CONSTRUCT_ONLY |
+	                          G_PARAM_STATIC_STRINGS);
+
+	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
+
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
 
@@ -8026,7 +10012,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->link_get_permanent_address = link_get_permanent_address;
 	platform_class->link_set_mtu = link_set_mtu;
 	platform_class->link_set_name = link_set_name;
-	platform_class->link_set_sriov_params = link_set_sriov_params;
+	platform_class->link_set_sriov_params_async = link_set_sriov_params_async;
 	platform_class->link_set_sriov_vfs = link_set_sriov_vfs;
 
 	platform_class->link_get_physical_port_id = link_get_physical_port_id;
@@ -8045,6 +10031,10 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->vlan_add = vlan_add;
 	platform_class->link_vlan_change = link_vlan_change;
+	platform_class->link_bond_change = link_bond_change;
+	platform_class->link_bridge_change = link_bridge_change;
+	platform_class->link_bridge_port_change = link_bridge_port_change;
+	platform_class->link_wireguard_change = link_wireguard_change;
 	platform_class->link_vxlan_add = link_vxlan_add;
 
 	platform_class->infiniband_partition_add = infiniband_partition_add;
@@ -8090,6 +10080,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->ip_route_add = ip_route_add;
 	platform_class->ip_route_get = ip_route_get;
+	platform_class->ip_route_get_foreign = ip_route_get_foreign;
+	platform_class->ip_route_is_foreign = ip_route_is_foreign;
 
 	platform_class->qdisc_add = qdisc_add;
 	platform_class->tfilter_add = tfilter_add;
@@ -30,13 +30,18 @@
 #define NM_IS_LINUX_PLATFORM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_LINUX_PLATFORM))
 #define NM_LINUX_PLATFORM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_LINUX_PLATFORM, NMLinuxPlatformClass))
 
+#define NM_LINUX_PLATFORM_COMPACT_FOREIGN_ROUTES "compact-foreign-routes"
+
 typedef struct _NMLinuxPlatform NMLinuxPlatform;
 typedef struct _NMLinuxPlatformClass NMLinuxPlatformClass;
 
 GType nm_linux_platform_get_type (void);
 
-NMPlatform *nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support);
+NMPlatform *nm_linux_platform_new (gboolean log_with_ptr,
+                                   gboolean netns_support,
+                                   gboolean compact_foreign_routes);
 
 void nm_linux_platform_setup (void);
+void nm_linux_platform_setup_full (gboolean compact_foreign_routes);
 
 #endif /* __NETWORKMANAGER_LINUX_PLATFORM_H__ */
@@ -34,6 +34,7 @@
 #include <linux/if_tun.h>
 #include <linux/if_tunnel.h>
 #include <linux/rtnetlink.h>
+#include <linux/pkt_sched.h>
 #include <libudev.h>
 
 #include "nm-utils.h"
@@ -944,6 +945,22 @@ nm_platform_link_dummy_add (NMPlatform *self,
 	return nm_platform_link_add (self, name, NM_LINK_TYPE_DUMMY, NULL, NULL, 0, out_link);
 }
 
+/**
+ * nm_platform_link_wireguard_add:
+ * @self: platform instance
+ * @name: New interface name
+ * @out_link: on success, the link object
+ *
+ * Create a WireGuard interface.
+ */
+NMPlatformError
+nm_platform_link_wireguard_add (NMPlatform *self,
+                                const char *name,
+                                const NMPlatformLink **out_link)
+{
+	return nm_platform_link_add (self, name, NM_LINK_TYPE_WIREGUARD, NULL, NULL, 0, out_link);
+}
+
 /**
  * nm_platform_link_delete:
  * @self: platform instance
@@ -1464,30 +1481,43 @@ nm_platform_link_supports_sriov (NMPlatform *self, int ifindex)
 }
 
 /**
- * nm_platform_link_set_sriov_params:
+ * nm_platform_link_set_sriov_params_async:
  * @self: platform instance
  * @ifindex: the index of the interface to change
  * @num_vfs: the number of VFs to create
  * @autoprobe: -1 to keep the current autoprobe-drivers value,
  *   or {0,1} to set a new value
+ * @cancellable: (allow-none): to abort waiting for the result
+ * @callback: (allow-none): invoked with the result
+ * @callback_data: user data for @callback
+ *
+ * The kernel creates and destroys the VFs synchronously while
+ * the number of VFs is written, which can take several seconds. Hence
+ * this happens in a worker thread. @callback is always invoked
+ * asynchronously on the main context, also if nothing needs to be changed
+ * or if @cancellable gets cancelled.
  */
-gboolean
-nm_platform_link_set_sriov_params (NMPlatform *self,
-                                   int ifindex,
-                                   guint num_vfs,
-                                   int autoprobe)
+void
+nm_platform_link_set_sriov_params_async (NMPlatform *self,
+                                         int ifindex,
+                                         guint num_vfs,
+                                         int autoprobe,
+                                         GCancellable *cancellable,
+                                         NMPlatformAsyncCallback callback,
+                                         gpointer callback_data)
 {
-	_CHECK_SELF (self, klass, FALSE);
+	_CHECK_SELF_VOID (self, klass);
 
-	g_return_val_if_fail (ifindex > 0, FALSE);
-	g_return_val_if_fail (NM_IN_SET (autoprobe, -1, 0, 1), FALSE);
+	g_return_if_fail (ifindex > 0);
+	g_return_if_fail (NM_IN_SET (autoprobe, -1, 0, 1));
 
 	_LOGD ("link: setting %u total VFs and autoprobe %d for %s (%d)",
 	       num_vfs,
 	       autoprobe,
 	       nm_strquote_a (25, nm_platform_link_get_name (self, ifindex)),
 	       ifindex);
-	return klass->link_set_sriov_params (self, ifindex, num_vfs, autoprobe);
+	klass->link_set_sriov_params_async (self, ifindex, num_vfs, autoprobe,
+	                                    cancellable, callback, callback_data);
 }
 
 gboolean
@@ -1884,6 +1914,18 @@ _link_get_lnk (NMPlatform *self, int ifindex, NMLinkType link_type, const NMPlat
 	return lnk ? &lnk->object : NULL;
 }
 
+const NMPlatformLnkBond *
+nm_platform_link_get_lnk_bond (NMPlatform *self, int ifindex, const NMPlatformLink **out_link)
+{
+	return _link_get_lnk (self, ifindex, NM_LINK_TYPE_BOND, out_link);
+}
+
+const NMPlatformLnkBridge *
+nm_platform_link_get_lnk_bridge (NMPlatform *self, int ifindex, const NMPlatformLink **out_link)
+{
+	return _link_get_lnk (self, ifindex, NM_LINK_TYPE_BRIDGE, out_link);
+}
+
 const NMPlatformLnkGre *
 nm_platform_link_get_lnk_gre (NMPlatform *self, int ifindex, const NMPlatformLink **out_link)
 {
@@ -2401,6 +2443,110 @@ nm_platform_link_vlan_change (NMPlatform *self,
 	                                n_egress_map);
 }
 
+/**
+ * nm_platform_link_bond_change:
+ * @self: platform instance
+ * @ifindex: the ifindex of the bond
+ * @props: the bonding options to set
+ *
+ * Sets the bonding options with a single RTM_NEWLINK message. Options
+ * whose "_has" flag is unset are not sent and keep their current value.
+ * The list of ARP targets is always replaced.
+ * Fails if the platform (or kernel) does not support it, in which
+ * case the caller is expected to fall back to sysfs.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_platform_link_bond_change (NMPlatform *self,
+                              int ifindex,
+                              const NMPlatformLnkBond *props)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	nm_assert (klass->link_bond_change);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (props, FALSE);
+
+	_LOGD ("link: change bond %d: %s", ifindex, nm_platform_lnk_bond_to_string (props, NULL, 0));
+	return klass->link_bond_change (self, ifindex, props);
+}
+
+gboolean
+nm_platform_link_bridge_change (NMPlatform *self,
+                                int ifindex,
+                                const NMPlatformLnkBridge *props)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	nm_assert (klass->link_bridge_change);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (props, FALSE);
+
+	_LOGD ("link: change bridge %d: %s", ifindex, nm_platform_lnk_bridge_to_string (props, NULL, 0));
+	return klass->link_bridge_change (self, ifindex, props);
+}
+
+gboolean
+nm_platform_link_bridge_port_change (NMPlatform *self,
+                                     int ifindex,
+                                     guint16 priority,
+                                     guint32 path_cost,
+                                     gboolean hairpin)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	nm_assert (klass->link_bridge_port_change);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	_LOGD ("link: change bridge port %d: priority %u path-cost %u hairpin %d",
+	       ifindex, (guint) priority, (guint) path_cost, !!hairpin);
+	return klass->link_bridge_port_change (self, ifindex, priority, path_cost, hairpin);
+}
+
+/**
+ * nm_platform_link_wireguard_change:
+ * @self: platform instance
+ * @ifindex: the ifindex of the WireGuard link
+ * @lnk_wireguard: the private key, listen port and fwmark to set
+ * @peers: (allow-none): the peers to configure
+ * @peers_len: the number of @peers
+ * @replace_peers: whether peers that are configured on the link but
+ *   are not in @peers should be removed.
+ *
+ * Peers that are already configured exactly as requested are not sent
+ * to the kernel again. Large configurations are split over multiple
+ * netlink messages.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_platform_link_wireguard_change (NMPlatform *self,
+                                   int ifindex,
+                                   const NMPlatformLnkWireGuard *lnk_wireguard,
+                                   const NMPWireGuardPeer *peers,
+                                   guint peers_len,
+                                   gboolean replace_peers)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	nm_assert (klass->link_wireguard_change);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+	g_return_val_if_fail (lnk_wireguard, FALSE);
+	g_return_val_if_fail (peers || peers_len == 0, FALSE);
+
+	_LOGD ("link: change wireguard %d: %s, %u peers%s",
+	       ifindex,
+	       nm_platform_lnk_wireguard_to_string (lnk_wireguard, NULL, 0),
+	       peers_len,
+	       replace_peers ? " (replace)" : "");
+	return klass->link_wireguard_change (self, ifindex, lnk_wireguard, peers, peers_len, replace_peers);
+}
+
 gboolean
 nm_platform_link_vlan_set_ingress_map (NMPlatform *self, int ifindex, int from, int to)
 {
@@ -4088,16 +4234,32 @@ _err_inval_due_to_ipv6_tentative_pref_src (NMPlatform *self, const NMPObject *ob
 	return TRUE;
 }
 
+static gboolean
+_ip_route_table_sync_includes (NMIPRouteTableSyncMode route_table_sync,
+                               const NMPObject *obj)
+{
+	if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_FULL)
+		return nm_platform_route_table_uncoerce (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced, TRUE) != RT_TABLE_LOCAL;
+	if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN)
+		return nm_platform_route_table_is_main (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced);
+
+	nm_assert (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_ALL);
+	return TRUE;
+}
+
 GPtrArray *
 nm_platform_ip_route_get_prune_list (NMPlatform *self,
                                      int addr_family,
                                      int ifindex,
                                      NMIPRouteTableSyncMode route_table_sync)
 {
+	NMPlatformClass *klass;
 	NMPLookup lookup;
 	GPtrArray *routes_prune;
+	gs_unref_ptrarray GPtrArray *routes_foreign = NULL;
 	const NMDedupMultiHeadEntry *head_entry;
 	CList *iter;
+	guint i;
 
 	nm_assert (NM_IS_PLATFORM (self));
 	nm_assert (NM_IN_SET (addr_family, AF_INET, AF_INET6));
@@ -4105,31 +4267,42 @@ nm_platform_ip_route_get_prune_list (NMPlatform *self,
 	                                        NM_IP_ROUTE_TABLE_SYNC_MODE_FULL,
 	                                        NM_IP_ROUTE_TABLE_SYNC_MODE_ALL));
 
+	klass = NM_PLATFORM_GET_CLASS (self);
+
 	nmp_lookup_init_object (&lookup,
 	                        addr_family == AF_INET
 	                          ? NMP_OBJECT_TYPE_IP4_ROUTE
 	                          : NMP_OBJECT_TYPE_IP6_ROUTE,
 	                        ifindex);
 	head_entry = nm_platform_lookup (self, &lookup);
-	if (!head_entry)
+
+	if (klass->ip_route_get_foreign)
+		routes_foreign = klass->ip_route_get_foreign (self, addr_family, ifindex);
+
+	if (   !head_entry
+	    && !routes_foreign)
 		return NULL;
 
-	routes_prune = g_ptr_array_new_full (head_entry->len,
+	routes_prune = g_ptr_array_new_full (  (head_entry ? head_entry->len : 0)
+	                                     + (routes_foreign ? routes_foreign->len : 0),
 	                                     (GDestroyNotify) nm_dedup_multi_obj_unref);
 
-	c_list_for_each (iter, &head_entry->lst_entries_head) {
-		const NMPObject *obj = c_list_entry (iter, NMDedupMultiEntry, lst_entries)->obj;
+	if (head_entry) {
+		c_list_for_each (iter, &head_entry->lst_entries_head) {
+			const NMPObject *obj = c_list_entry (iter, NMDedupMultiEntry, lst_entries)->obj;
 
-		if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_FULL) {
-			if (nm_platform_route_table_uncoerce (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced, TRUE) == RT_TABLE_LOCAL)
-				continue;
-		} else if (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_MAIN) {
-			if (!nm_platform_route_table_is_main (NMP_OBJECT_CAST_IP_ROUTE (obj)->table_coerced))
-				continue;
-		} else
-			nm_assert (route_table_sync == NM_IP_ROUTE_TABLE_SYNC_MODE_ALL);
+			if (_ip_route_table_sync_includes (route_table_sync, obj))
+				g_ptr_array_add (routes_prune, (gpointer) nmp_object_ref (obj));
+		}
+	}
 
-		g_ptr_array_add (routes_prune, (gpointer) nmp_object_ref (obj));
+	if (routes_foreign) {
+		for (i = 0; i < routes_foreign->len; i++) {
+			const NMPObject *obj = routes_foreign->pdata[i];
+
+			if (_ip_route_table_sync_includes (route_table_sync, obj))
+				g_ptr_array_add (routes_prune, (gpointer) nmp_object_ref (obj));
+		}
 	}
 
 	if (routes_prune->len == 0) {
@@ -4352,9 +4525,11 @@ sync_route_add:
 			    && g_hash_table_lookup (routes_idx, prune_o))
 				continue;
 
-			if (!nm_platform_lookup_entry (self,
-			                               NMP_CACHE_ID_TYPE_OBJECT_TYPE,
-			                               prune_o))
+			if (   !nm_platform_lookup_entry (self,
+			                                  NMP_CACHE_ID_TYPE_OBJECT_TYPE,
+			                                  prune_o)
+			    && !(   NM_PLATFORM_GET_CLASS (self)->ip_route_is_foreign
+			         && NM_PLATFORM_GET_CLASS (self)->ip_route_is_foreign (self, prune_o)))
 				continue;
 
 			if (!nm_platform_object_delete (self, prune_o)) {
@@ -4889,6 +5064,34 @@ nm_platform_qdisc_add (NMPlatform *self,
 	return klass->qdisc_add (self, flags, qdisc);
 }
 
+/* Whether the qdisc in the platform cache already is as @known requests it.
+ * The kernel assigns a handle if none was requested and reports the reference
+ * count in the info field. Ignore those, unless @known sets them explicitly. */
+static gboolean
+_qdisc_is_synced (const NMPlatformQdisc *known, const NMPlatformQdisc *plat)
+{
+	NMPlatformQdisc qdisc = *known;
+
+	if (!qdisc.handle)
+		qdisc.handle = plat->handle;
+	if (!qdisc.info)
+		qdisc.info = plat->info;
+	return nm_platform_qdisc_cmp (&qdisc, plat) == 0;
+}
+
+/**
+ * nm_platform_qdisc_sync:
+ * @self: the #NMPlatform instance
+ * @ifindex: the ifindex of the link
+ * @known_qdiscs: (allow-none): the qdiscs that should be configured
+ *
+ * Deletes all qdiscs of @ifindex that are not in @known_qdiscs. Of the
+ * known ones, only those that differ from the platform cache are sent
+ * to the kernel, so that calling this repeatedly with the same configuration
+ * doesn't touch traffic shaping on the link.
+ *
+ * Returns: %TRUE on success.
+ */
 gboolean
 nm_platform_qdisc_sync (NMPlatform *self,
                         int ifindex,
@@ -4897,6 +5100,7 @@ nm_platform_qdisc_sync (NMPlatform *self,
 	gs_unref_ptrarray GPtrArray *plat_qdiscs = NULL;
 	NMPLookup lookup;
 	guint i;
+	guint n_unchanged = 0;
 	gboolean success = TRUE;
 	gs_unref_hashtable GHashTable *known_qdiscs_idx = NULL;
 
@@ -4932,12 +5136,24 @@ nm_platform_qdisc_sync (NMPlatform *self,
 	if (known_qdiscs) {
 		for (i = 0; i < known_qdiscs->len; i++) {
 			const NMPObject *q = g_ptr_array_index (known_qdiscs, i);
+			const NMPObject *plat_q;
 
-			success &= (nm_platform_qdisc_add (self, NMP_NLM_FLAG_ADD,
+			plat_q = nmp_cache_lookup_obj (nm_platform_get_cache (self), q);
+			if (   plat_q
+			    && _qdisc_is_synced (NMP_OBJECT_CAST_QDISC (q), NMP_OBJECT_CAST_QDISC (plat_q))) {
+				n_unchanged++;
+				continue;
+			}
+
+			success &= (nm_platform_qdisc_add (self,
+			                                   plat_q ? NMP_NLM_FLAG_REPLACE : NMP_NLM_FLAG_ADD,
 			                                   NMP_OBJECT_CAST_QDISC (q)) == NM_PLATFORM_ERROR_SUCCESS);
 		}
 	}
 
+	if (n_unchanged > 0)
+		_LOGD ("qdisc-sync: %u qdiscs on ifindex %d already up to date", n_unchanged, ifindex);
+
 	return success;
 }
 
@@ -4954,42 +5170,118 @@ nm_platform_tfilter_add (NMPlatform *self,
 	return klass->tfilter_add (self, flags, tfilter);
 }
 
+/* Like _qdisc_is_synced(). Without an explicit handle or priority in
+ * @known, the kernel picks them. Adopt them in @out_tfilter, so that a
+ * replace request changes the existing filter instead of adding another one. */
+static gboolean
+_tfilter_is_synced (const NMPlatformTfilter *known,
+                    const NMPlatformTfilter *plat,
+                    NMPlatformTfilter *out_tfilter)
+{
+	*out_tfilter = *known;
+	if (!out_tfilter->handle)
+		out_tfilter->handle = plat->handle;
+	if (!TC_H_MAJ (out_tfilter->info))
+		out_tfilter->info = TC_H_MAKE (TC_H_MAJ (plat->info), TC_H_MIN (out_tfilter->info));
+	return nm_platform_tfilter_cmp (out_tfilter, plat) == 0;
+}
+
+/* find the filter in @plat_tfilters that @known refers to. A filter
+ * without a handle matches one on the same parent, with the same kind,
+ * protocol and (if set) priority. */
+static const NMPObject *
+_tfilter_find_plat (const NMPlatformTfilter *known,
+                    GPtrArray *plat_tfilters,
+                    GHashTable *plat_claimed)
+{
+	guint i;
+
+	if (!plat_tfilters)
+		return NULL;
+
+	for (i = 0; i < plat_tfilters->len; i++) {
+		const NMPObject *plat_q = g_ptr_array_index (plat_tfilters, i);
+		const NMPlatformTfilter *plat = NMP_OBJECT_CAST_TFILTER (plat_q);
+
+		if (g_hash_table_contains (plat_claimed, plat_q))
+			continue;
+
+		if (known->handle) {
+			if (plat->handle == known->handle)
+				return plat_q;
+			continue;
+		}
+
+		if (   plat->parent == known->parent
+		    && TC_H_MIN (plat->info) == TC_H_MIN (known->info)
+		    && (   !TC_H_MAJ (known->info)
+		        || TC_H_MAJ (plat->info) == TC_H_MAJ (known->info))
+		    && nm_streq0 (plat->kind, known->kind))
+			return plat_q;
+	}
+	return NULL;
+}
+
+/**
+ * nm_platform_tfilter_sync:
+ * @self: the #NMPlatform instance
+ * @ifindex: the ifindex of the link
+ * @known_tfilters: (allow-none): the tfilters that should be configured
+ *
+ * Like nm_platform_qdisc_sync(), but for tfilters.
+ *
+ * Returns: %TRUE on success.
+ */
 gboolean
 nm_platform_tfilter_sync (NMPlatform *self,
                           int ifindex,
                           GPtrArray *known_tfilters)
 {
 	gs_unref_ptrarray GPtrArray *plat_tfilters = NULL;
+	gs_unref_hashtable GHashTable *plat_claimed = NULL;
+	gs_free const NMPObject **plat_matches = NULL;
 	NMPLookup lookup;
-	guint i;
+	guint i, pass;
+	guint n_unchanged = 0;
 	gboolean success = TRUE;
-	gs_unref_hashtable GHashTable *known_tfilters_idx = NULL;
 
 	nm_assert (NM_IS_PLATFORM (self));
 	nm_assert (ifindex > 0);
 
-	known_tfilters_idx = g_hash_table_new ((GHashFunc) nmp_object_id_hash,
-	                                       (GEqualFunc) nmp_object_id_equal);
-
-	if (known_tfilters) {
-		for (i = 0; i < known_tfilters->len; i++) {
-			const NMPObject *q = g_ptr_array_index (known_tfilters, i);
-
-			g_hash_table_insert (known_tfilters_idx, (gpointer) q, (gpointer) q);
-		}
-	}
-
 	plat_tfilters = nm_platform_lookup_clone (self,
 	                                          nmp_lookup_init_object (&lookup,
 	                                                                  NMP_OBJECT_TYPE_TFILTER,
 	                                                                  ifindex),
 	                                          NULL, NULL);
 
+	/* pair the known tfilters with the ones in the platform. Those with an
+	 * explicit handle go first, so that a filter without one doesn't take
+	 * their place. */
+	plat_claimed = g_hash_table_new (nm_direct_hash, NULL);
+	if (known_tfilters) {
+		plat_matches = g_new0 (const NMPObject *, known_tfilters->len);
+		for (pass = 0; pass < 2; pass++) {
+			for (i = 0; i < known_tfilters->len; i++) {
+				const NMPlatformTfilter *known = NMP_OBJECT_CAST_TFILTER (g_ptr_array_index (known_tfilters, i));
+				const NMPObject *plat_q;
+
+				if ((pass == 0) != (known->handle != 0))
+					continue;
+
+				plat_q = _tfilter_find_plat (known, plat_tfilters, plat_claimed);
+				if (plat_q) {
+					g_hash_table_add (plat_claimed, (gpointer) plat_q);
+					plat_matches[i] = plat_q;
+				}
+			}
+		}
+	}
+
 	if (plat_tfilters) {
 		for (i = 0; i < plat_tfilters->len; i++) {
 			const NMPObject *q = g_ptr_array_index (plat_tfilters, i);
 
-			if (!g_hash_table_lookup (known_tfilters_idx, q))
+			if (!g_hash_table_contains (plat_claimed, q))
 				success &= nm_platform_object_delete (self, q);
 		}
 	}
@@ -4997,12 +5289,28 @@ nm_platform_tfilter_sync (NMPlatform *self,
 	if (known_tfilters) {
 		for (i = 0; i < known_tfilters->len; i++) {
 			const NMPObject *q = g_ptr_array_index (known_tfilters, i);
+			const NMPObject *plat_q = plat_matches[i];
+			NMPlatformTfilter tfilter;
 
-			success &= (nm_platform_tfilter_add (self, NMP_NLM_FLAG_ADD,
-			                                     NMP_OBJECT_CAST_TFILTER (q)) == NM_PLATFORM_ERROR_SUCCESS);
+			if (!plat_q) {
+				success &= (nm_platform_tfilter_add (self, NMP_NLM_FLAG_ADD,
+				                                     NMP_OBJECT_CAST_TFILTER (q)) == NM_PLATFORM_ERROR_SUCCESS);
+				continue;
+			}
+
+			if (_tfilter_is_synced (NMP_OBJECT_CAST_TFILTER (q), NMP_OBJECT_CAST_TFILTER (plat_q), &tfilter)) {
+				n_unchanged++;
+				continue;
+			}
+
+			success &= (nm_platform_tfilter_add (self, NMP_NLM_FLAG_REPLACE,
+			                                     &tfilter) == NM_PLATFORM_ERROR_SUCCESS);
 		}
 	}
 
+	if (n_unchanged > 0)
+		_LOGD ("tfilter-sync: %u tfilters on ifindex %d already up to date", n_unchanged, ifindex);
+
 	return success;
 }
 
@@ -5161,6 +5469,127 @@ nm_platform_link_to_string (const NMPlatformLink *link, char *buf, gsize len)
 	return buf;
 }
 
+const char *
+nm_platform_lnk_bond_to_string (const NMPlatformLnkBond *lnk, char *buf, gsize len)
+{
+	char str_miimon[30];
+	char str_updelay[30];
+	char str_downdelay[30];
+	char str_arp_interval[30];
+	char str_arp_validate[30];
+	char str_primary[30];
+	char str_active_slave[30];
+	char str_packets_per_slave[30];
+	char str_lacp_rate[30];
+	char str_ad_actor_sys_prio[30];
+	char str_ad_user_port_key[30];
+	char str_ad_actor_system[30];
+	char str_arp_targets[NM_BOND_MAX_ARP_TARGETS * (NM_UTILS_INET_ADDRSTRLEN + 1) + 30];
+	char str_addr[NM_UTILS_INET_ADDRSTRLEN];
+	char *b;
+	gsize l;
+	guint i;
+
+	if (!nm_utils_to_string_buffer_init_null (lnk, &buf, &len))
+		return buf;
+
+	b = str_arp_targets;
+	l = sizeof (str_arp_targets);
+	str_arp_targets[0] = '\0';
+	if (lnk->arp_ip_targets_num > 0) {
+		nm_utils_strbuf_append_str (&b, &l, " arp_ip_target");
+		for (i = 0; i < lnk->arp_ip_targets_num && i < NM_BOND_MAX_ARP_TARGETS; i++)
+			nm_utils_strbuf_append (&b, &l, "%s%s", i ? "," : " ", nm_utils_inet4_ntop (lnk->arp_ip_target[i], str_addr));
+	}
+
+	g_snprintf (buf, len,
+	            "bond"
+	            " mode %u"
+	            "%s" /* miimon */
+	            "%s" /* updelay */
+	            "%s" /* downdelay */
+	            "%s" /* use_carrier */
+	            "%s" /* arp_interval */
+	            "%s" /* arp_ip_target */
+	            "%s" /* arp_validate */
+	            " arp_all_targets %u"
+	            "%s" /* primary */
+	            "%s" /* active_slave */
+	            " primary_reselect %u"
+	            " fail_over_mac %u"
+	            " xmit_hash_policy %u"
+	            " resend_igmp %u"
+	            " num_grat_arp %u"
+	            " all_slaves_active %u"
+	            " min_links %u"
+	            " lp_interval %u"
+	            "%s" /* packets_per_slave */
+	            "%s" /* lacp_rate */
+	            " ad_select %u"
+	            "%s" /* ad_actor_sys_prio */
+	            "%s" /* ad_user_port_key */
+	            "%s" /* ad_actor_system */
+	            "%s" /* tlb_dynamic_lb */
+	            "",
+	            (guint) lnk->mode,
+	            lnk->miimon_has ? nm_sprintf_buf (str_miimon, " miimon %u", lnk->miimon) : "",
+	            lnk->updelay_has ? nm_sprintf_buf (str_updelay, " updelay %u", lnk->updelay) : "",
+	            lnk->downdelay_has ? nm_sprintf_buf (str_downdelay, " downdelay %u", lnk->downdelay) : "",
+	            lnk->use_carrier ? " use_carrier" : "",
+	            lnk->arp_interval_has ? nm_sprintf_buf (str_arp_interval, " arp_interval %u", lnk->arp_interval) : "",
+	            str_arp_targets,
+	            lnk->arp_validate_has ? nm_sprintf_buf (str_arp_validate, " arp_validate %u", lnk->arp_validate) : "",
+	            lnk->arp_all_targets,
+	            lnk->primary_has ? nm_sprintf_buf (str_primary, " primary %d", lnk->primary) : "",
+	            lnk->active_slave_has ? nm_sprintf_buf (str_active_slave, " active_slave %d", lnk->active_slave) : "",
+	            (guint) lnk->primary_reselect,
+	            (guint) lnk->fail_over_mac,
+	            (guint) lnk->xmit_hash_policy,
+	            lnk->resend_igmp,
+	            (guint) lnk->num_grat_arp,
+	            (guint) lnk->all_slaves_active,
+	            lnk->min_links,
+	            lnk->lp_interval,
+	            lnk->packets_per_slave_has ? nm_sprintf_buf (str_packets_per_slave, " packets_per_slave %u", lnk->packets_per_slave) : "",
+	            lnk->lacp_rate_has ? nm_sprintf_buf (str_lacp_rate, " lacp_rate %u", (guint) lnk->lacp_rate) : "",
+	            (guint) lnk->ad_select,
+	            lnk->ad_actor_sys_prio_has ? nm_sprintf_buf (str_ad_actor_sys_prio, " ad_actor_sys_prio %u", (guint) lnk->ad_actor_sys_prio) : "",
+	            lnk->ad_user_port_key_has ? nm_sprintf_buf (str_ad_user_port_key, " ad_user_port_key %u", (guint) lnk->ad_user_port_key) : "",
+	            lnk->ad_actor_system_has ? nm_sprintf_buf (str_ad_actor_system, " ad_actor_system %02X:%02X:%02X:%02X:%02X:%02X",
+	                                                       lnk->ad_actor_system[0], lnk->ad_actor_system[1], lnk->ad_actor_system[2],
+	                                                       lnk->ad_actor_system[3], lnk->ad_actor_system[4], lnk->ad_actor_system[5]) : "",
+	            lnk->tlb_dynamic_lb_has ? (lnk->tlb_dynamic_lb ? " tlb_dynamic_lb" : " no-tlb_dynamic_lb") : "");
+	return buf;
+}
+
+const char *
+nm_platform_lnk_bridge_to_string (const NMPlatformLnkBridge *lnk, char *buf, gsize len)
+{
+	if (!nm_utils_to_string_buffer_init_null (lnk, &buf, &len))
+		return buf;
+
+	g_snprintf (buf, len,
+	            "bridge"
+	            "%s" /* stp_state */
+	            " priority %u"
+	            " forward_delay %u"
+	            " hello_time %u"
+	            " max_age %u"
+	            " ageing_time %u"
+	            " group_fwd_mask 0x%x"
+	            "%s" /* mcast_snooping */
+	            "",
+	            lnk->stp_state ? " stp" : "",
+	            (guint) lnk->priority,
+	            lnk->forward_delay,
+	            lnk->hello_time,
+	            lnk->max_age,
+	            lnk->ageing_time,
+	            (guint) lnk->group_fwd_mask,
+	            lnk->mcast_snooping ? " mcast_snooping" : "");
+	return buf;
+}
+
 const char *
 nm_platform_lnk_gre_to_string (const NMPlatformLnkGre *lnk, char *buf, gsize len)
 {
@@ -6198,6 +6627,134 @@ nm_platform_link_cmp (const NMPlatformLink *a, const NMPlatformLink *b)
 	return 0;
 }
 
+void
+nm_platform_lnk_bond_hash_update (const NMPlatformLnkBond *obj, NMHashState *h)
+{
+	nm_hash_update_vals (h,
+	                     obj->primary,
+	                     obj->active_slave,
+	                     obj->miimon,
+	                     obj->updelay,
+	                     obj->downdelay,
+	                     obj->arp_interval,
+	                     obj->arp_validate,
+	                     obj->arp_all_targets,
+	                     obj->resend_igmp,
+	                     obj->min_links,
+	                     obj->lp_interval,
+	                     obj->packets_per_slave,
+	                     obj->ad_actor_sys_prio,
+	                     obj->ad_user_port_key,
+	                     obj->mode,
+	                     obj->primary_reselect,
+	                     obj->fail_over_mac,
+	                     obj->xmit_hash_policy,
+	                     obj->num_grat_arp,
+	                     obj->all_slaves_active);
+	nm_hash_update_vals (h,
+	                     obj->lacp_rate,
+	                     obj->ad_select,
+	                     obj->arp_ip_targets_num,
+	                     NM_HASH_COMBINE_BOOLS (guint8,
+	                                            obj->use_carrier,
+	                                            obj->tlb_dynamic_lb,
+	                                            obj->miimon_has,
+	                                            obj->updelay_has,
+	                                            obj->downdelay_has,
+	                                            obj->arp_interval_has,
+	                                            obj->arp_validate_has,
+	                                            obj->primary_has),
+	                     NM_HASH_COMBINE_BOOLS (guint8,
+	                                            obj->active_slave_has,
+	                                            obj->packets_per_slave_has,
+	                                            obj->lacp_rate_has,
+	                                            obj->tlb_dynamic_lb_has,
+	                                            obj->ad_actor_sys_prio_has,
+	                                            obj->ad_user_port_key_has,
+	                                            obj->ad_actor_system_has));
+	nm_hash_update (h, obj->ad_actor_system, sizeof (obj->ad_actor_system));
+	nm_hash_update (h, obj->arp_ip_target, sizeof (obj->arp_ip_target[0]) * MIN (obj->arp_ip_targets_num, NM_BOND_MAX_ARP_TARGETS));
+}
+
+int
+nm_platform_lnk_bond_cmp (const NMPlatformLnkBond *a, const NMPlatformLnkBond *b)
+{
+	NM_CMP_SELF (a, b);
+	NM_CMP_FIELD (a, b, mode);
+	NM_CMP_FIELD (a, b, miimon);
+	NM_CMP_FIELD (a, b, updelay);
+	NM_CMP_FIELD (a, b, downdelay);
+	NM_CMP_FIELD (a, b, arp_interval);
+	NM_CMP_FIELD (a, b, arp_ip_targets_num);
+	NM_CMP_DIRECT_MEMCMP (a->arp_ip_target,
+	                      b->arp_ip_target,
+	                      sizeof (a->arp_ip_target[0]) * MIN (a->arp_ip_targets_num, NM_BOND_MAX_ARP_TARGETS));
+	NM_CMP_FIELD (a, b, arp_validate);
+	NM_CMP_FIELD (a, b, arp_all_targets);
+	NM_CMP_FIELD (a, b, primary);
+	NM_CMP_FIELD (a, b, active_slave);
+	NM_CMP_FIELD (a, b, primary_reselect);
+	NM_CMP_FIELD (a, b, fail_over_mac);
+	NM_CMP_FIELD (a, b, xmit_hash_policy);
+	NM_CMP_FIELD (a, b, resend_igmp);
+	NM_CMP_FIELD (a, b, num_grat_arp);
+	NM_CMP_FIELD (a, b, all_slaves_active);
+	NM_CMP_FIELD (a, b, min_links);
+	NM_CMP_FIELD (a, b, lp_interval);
+	NM_CMP_FIELD (a, b, packets_per_slave);
+	NM_CMP_FIELD (a, b, lacp_rate);
+	NM_CMP_FIELD (a, b, ad_select);
+	NM_CMP_FIELD (a, b, ad_actor_sys_prio);
+	NM_CMP_FIELD (a, b, ad_user_port_key);
+	NM_CMP_FIELD_MEMCMP (a, b, ad_actor_system);
+	NM_CMP_FIELD_BOOL (a, b, use_carrier);
+	NM_CMP_FIELD_BOOL (a, b, tlb_dynamic_lb);
+	NM_CMP_FIELD_BOOL (a, b, miimon_has);
+	NM_CMP_FIELD_BOOL (a, b, updelay_has);
+	NM_CMP_FIELD_BOOL (a, b, downdelay_has);
+	NM_CMP_FIELD_BOOL (a, b, arp_interval_has);
+	NM_CMP_FIELD_BOOL (a, b, arp_validate_has);
+	NM_CMP_FIELD_BOOL (a, b, primary_has);
+	NM_CMP_FIELD_BOOL (a, b, active_slave_has);
+	NM_CMP_FIELD_BOOL (a, b, packets_per_slave_has);
+	NM_CMP_FIELD_BOOL (a, b, lacp_rate_has);
+	NM_CMP_FIELD_BOOL (a, b, tlb_dynamic_lb_has);
+	NM_CMP_FIELD_BOOL (a, b, ad_actor_sys_prio_has);
+	NM_CMP_FIELD_BOOL (a, b, ad_user_port_key_has);
+	NM_CMP_FIELD_BOOL (a, b, ad_actor_system_has);
+	return 0;
+}
+
+void
+nm_platform_lnk_bridge_hash_update (const NMPlatformLnkBridge *obj, NMHashState *h)
+{
+	nm_hash_update_vals (h,
+	                     obj->forward_delay,
+	                     obj->hello_time,
+	                     obj->max_age,
+	                     obj->ageing_time,
+	                     obj->priority,
+	                     obj->group_fwd_mask,
+	                     NM_HASH_COMBINE_BOOLS (guint8,
+	                                            obj->stp_state,
+	                                            obj->mcast_snooping));
+}
+
+int
+nm_platform_lnk_bridge_cmp (const NMPlatformLnkBridge *a, const NMPlatformLnkBridge *b)
+{
+	NM_CMP_SELF (a, b);
+	NM_CMP_FIELD (a, b, forward_delay);
+	NM_CMP_FIELD (a, b, hello_time);
+	NM_CMP_FIELD (a, b, max_age);
+	NM_CMP_FIELD (a, b, ageing_time);
+	NM_CMP_FIELD (a, b, priority);
+	NM_CMP_FIELD (a, b, group_fwd_mask);
+	NM_CMP_FIELD_BOOL (a, b, stp_state);
+	NM_CMP_FIELD_BOOL (a, b, mcast_snooping);
+	return 0;
+}
+
 void
 nm_platform_lnk_gre_hash_update (const NMPlatformLnkGre *obj, NMHashState *h)
 {
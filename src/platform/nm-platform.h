@@ -627,6 +627,66 @@ typedef struct {
 	gint8 trust;
 } NMPlatformVF;
 
+#define NM_BOND_MAX_ARP_TARGETS 16
+
+typedef struct {
+	in_addr_t arp_ip_target[NM_BOND_MAX_ARP_TARGETS];
+	int primary;
+	int active_slave;
+	guint32 miimon;
+	guint32 updelay;
+	guint32 downdelay;
+	guint32 arp_interval;
+	guint32 arp_validate;
+	guint32 arp_all_targets;
+	guint32 resend_igmp;
+	guint32 min_links;
+	guint32 lp_interval;
+	guint32 packets_per_slave;
+	guint16 ad_actor_sys_prio;
+	guint16 ad_user_port_key;
+	guint8 ad_actor_system[6]; /* ETH_ALEN */
+	guint8 mode;
+	guint8 primary_reselect;
+	guint8 fail_over_mac;
+	guint8 xmit_hash_policy;
+	guint8 num_grat_arp;
+	guint8 all_slaves_active;
+	guint8 lacp_rate;
+	guint8 ad_select;
+	guint8 arp_ip_targets_num;
+	bool use_carrier:1;
+	bool tlb_dynamic_lb:1;
+
+	/* Whether the attribute is present. Kernel only reports (and only accepts)
+	 * some of them depending on the mode. */
+	bool miimon_has:1;
+	bool updelay_has:1;
+	bool downdelay_has:1;
+	bool arp_interval_has:1;
+	bool arp_validate_has:1;
+	bool primary_has:1;
+	bool active_slave_has:1;
+	bool packets_per_slave_has:1;
+	bool lacp_rate_has:1;
+	bool tlb_dynamic_lb_has:1;
+	bool ad_actor_sys_prio_has:1;
+	bool ad_user_port_key_has:1;
+	bool ad_actor_system_has:1;
+} NMPlatformLnkBond;
+
+typedef struct {
+	/* time values are in USER_HZ, like in sysfs. */
+	guint32 forward_delay;
+	guint32 hello_time;
+	guint32 max_age;
+	guint32 ageing_time;
+	guint16 priority;
+	guint16 group_fwd_mask;
+	bool stp_state:1;
+	bool mcast_snooping:1;
+} NMPlatformLnkBridge;
+
 typedef struct {
 	in_addr_t local;
 	in_addr_t remote;
@@ -755,6 +815,8 @@ typedef struct {
 #define NMP_WIREGUARD_PUBLIC_KEY_LEN 32
 #define NMP_WIREGUARD_SYMMETRIC_KEY_LEN 32
 
+struct _NMPWireGuardPeer;
+
 typedef struct {
 	guint32 fwmark;
 	guint16 listen_port;
@@ -774,6 +836,8 @@ typedef enum {
 	NM_PLATFORM_KERNEL_SUPPORT_RTA_PREF                         = (1LL <<  2),
 } NMPlatformKernelSupportFlags;
 
+typedef void (*NMPlatformAsyncCallback) (GError *error, gpointer user_data);
+
 /*****************************************************************************/
 
 struct _NMPlatformPrivate;
@@ -825,7 +889,13 @@ typedef struct {
 	NMPlatformError (*link_set_address) (NMPlatform *, int ifindex, gconstpointer address, size_t length);
 	NMPlatformError (*link_set_mtu) (NMPlatform *, int ifindex, guint32 mtu);
 	gboolean (*link_set_name) (NMPlatform *, int ifindex, const char *name);
-	gboolean (*link_set_sriov_params) (NMPlatform *, int ifindex, guint num_vfs, int autoprobe);
+	void (*link_set_sriov_params_async) (NMPlatform *self,
+	                                     int ifindex,
+	                                     guint num_vfs,
+	                                     int autoprobe,
+	                                     GCancellable *cancellable,
+	                                     NMPlatformAsyncCallback callback,
+	                                     gpointer callback_data);
 	gboolean (*link_set_sriov_vfs) (NMPlatform *self, int ifindex, const NMPlatformVF *const *vfs);
 
 	char *   (*link_get_physical_port_id) (NMPlatform *, int ifindex);
@@ -857,6 +927,23 @@ typedef struct {
 	                              gboolean egress_reset_all,
 	                              const NMVlanQosMapping *egress_map,
 	                              gsize n_egress_map);
+	gboolean (*link_bond_change) (NMPlatform *self,
+	                              int ifindex,
+	                              const NMPlatformLnkBond *props);
+	gboolean (*link_bridge_change) (NMPlatform *self,
+	                                int ifindex,
+	                                const NMPlatformLnkBridge *props);
+	gboolean (*link_bridge_port_change) (NMPlatform *self,
+	                                     int ifindex,
+	                                     guint16 priority,
+	                                     guint32 path_cost,
+	                                     gboolean hairpin);
+	gboolean (*link_wireguard_change) (NMPlatform *self,
+	                                   int ifindex,
+	                                   const NMPlatformLnkWireGuard *lnk_wireguard,
+	                                   const struct _NMPWireGuardPeer *peers,
+	                                   guint peers_len,
+	                                   gboolean replace_peers);
 	gboolean (*link_vxlan_add) (NMPlatform *,
 	                            const char *name,
 	                            const NMPlatformLnkVxlan *props,
@@ -960,6 +1047,15 @@ typedef struct {
 	                                 int oif_ifindex,
 	                                 NMPObject **out_route);
 
+	/* routes that the platform tracks outside of its cache, because
+	 * NetworkManager didn't add them. They are only considered by
+	 * route sync. */
+	GPtrArray *(*ip_route_get_foreign) (NMPlatform *self,
+	                                    int addr_family,
+	                                    int ifindex);
+	gboolean (*ip_route_is_foreign) (NMPlatform *self,
+	                                 const NMPObject *route);
+
 	NMPlatformError (*qdisc_add)   (NMPlatform *self,
 	                                NMPNlmFlags flags,
 	                                const NMPlatformQdisc *qdisc);
@@ -1140,6 +1236,7 @@ NMPlatformError nm_platform_link_bridge_add (NMPlatform *self, const char *name,
 NMPlatformError nm_platform_link_bond_add (NMPlatform *self, const char *name, const NMPlatformLink **out_link);
 NMPlatformError nm_platform_link_team_add (NMPlatform *self, const char *name, const NMPlatformLink **out_link);
 NMPlatformError nm_platform_link_veth_add (NMPlatform *self, const char *name, const char *peer, const NMPlatformLink **out_link);
+NMPlatformError nm_platform_link_wireguard_add (NMPlatform *self, const char *name, const NMPlatformLink **out_link);
 
 gboolean nm_platform_link_delete (NMPlatform *self, int ifindex);
 
@@ -1216,7 +1313,13 @@ gboolean nm_platform_link_get_permanent_address (NMPlatform *self, int ifindex,
 NMPlatformError nm_platform_link_set_address (NMPlatform *self, int ifindex, const void *address, size_t length);
 NMPlatformError nm_platform_link_set_mtu (NMPlatform *self, int ifindex, guint32 mtu);
 gboolean nm_platform_link_set_name (NMPlatform *self, int ifindex, const char *name);
-gboolean nm_platform_link_set_sriov_params (NMPlatform *self, int ifindex, guint num_vfs, int autoprobe);
+void nm_platform_link_set_sriov_params_async (NMPlatform *self,
+                                              int ifindex,
+                                              guint num_vfs,
+                                              int autoprobe,
+                                              GCancellable *cancellable,
+                                              NMPlatformAsyncCallback callback,
+                                              gpointer callback_data);
 gboolean nm_platform_link_set_sriov_vfs (NMPlatform *self, int ifindex, const NMPlatformVF *const *vfs);
 
 char    *nm_platform_link_get_physical_port_id (NMPlatform *self, int ifindex);
@@ -1241,6 +1344,8 @@ gboolean nm_platform_sysctl_slave_set_option (NMPlatform *self, int ifindex, con
 char *nm_platform_sysctl_slave_get_option (NMPlatform *self, int ifindex, const char *option);
 
 const NMPObject *nm_platform_link_get_lnk (NMPlatform *self, int ifindex, NMLinkType link_type, const NMPlatformLink **out_link);
+const NMPlatformLnkBond *nm_platform_link_get_lnk_bond (NMPlatform *self, int ifindex, const NMPlatformLink **out_link);
+const NMPlatformLnkBridge *nm_platform_link_get_lnk_bridge (NMPlatform *self, int ifindex, const NMPlatformLink **out_link);
 const NMPlatformLnkGre *nm_platform_link_get_lnk_gre (NMPlatform *self, int ifindex, const NMPlatformLink **out_link);
 const NMPlatformLnkGre *nm_platform_link_get_lnk_gretap (NMPlatform *self, int ifindex, const NMPlatformLink **out_link);
 const NMPlatformLnkIp6Tnl *nm_platform_link_get_lnk_ip6tnl (NMPlatform *self, int ifindex, const NMPlatformLink **out_link);
@@ -1277,6 +1382,24 @@ gboolean nm_platform_link_vlan_change (NMPlatform *self,
                                        const NMVlanQosMapping *egress_map,
                                        gsize n_egress_map);
 
+gboolean nm_platform_link_bond_change (NMPlatform *self,
+                                       int ifindex,
+                                       const NMPlatformLnkBond *props);
+gboolean nm_platform_link_bridge_change (NMPlatform *self,
+                                         int ifindex,
+                                         const NMPlatformLnkBridge *props);
+gboolean nm_platform_link_bridge_port_change (NMPlatform *self,
+                                              int ifindex,
+                                              guint16 priority,
+                                              guint32 path_cost,
+                                              gboolean hairpin);
+gboolean nm_platform_link_wireguard_change (NMPlatform *self,
+                                            int ifindex,
+                                            const NMPlatformLnkWireGuard *lnk_wireguard,
+                                            const struct _NMPWireGuardPeer *peers,
+                                            guint peers_len,
+                                            gboolean replace_peers);
+
 NMPlatformError nm_platform_link_vxlan_add (NMPlatform *self,
                                             const char *name,
                                             const NMPlatformLnkVxlan *props,
@@ -1441,6 +1564,8 @@ gboolean nm_platform_tfilter_sync         (NMPlatform *self,
                                            GPtrArray *known_tfilters);
 
 const char *nm_platform_link_to_string (const NMPlatformLink *link, char *buf, gsize len);
+const char *nm_platform_lnk_bond_to_string (const NMPlatformLnkBond *lnk, char *buf, gsize len);
+const char *nm_platform_lnk_bridge_to_string (const NMPlatformLnkBridge *lnk, char *buf, gsize len);
 const char *nm_platform_lnk_gre_to_string (const NMPlatformLnkGre *lnk, char *buf, gsize len);
 const char *nm_platform_lnk_infiniband_to_string (const NMPlatformLnkInfiniband *lnk, char *buf, gsize len);
 const char *nm_platform_lnk_ip6tnl_to_string (const NMPlatformLnkIp6Tnl *lnk, char *buf, gsize len);
@@ -1466,12 +1591,13 @@ const char *nm_platform_vlan_qos_mapping_to_string (const char *name,
                                                     char *buf,
                                                     gsize len);
 
-struct _NMPWireGuardPeer;
 const char *nm_platform_wireguard_peer_to_string (const struct _NMPWireGuardPeer *peer,
                                                   char *buf,
                                                   gsize len);
 
 int nm_platform_link_cmp (const NMPlatformLink *a, const NMPlatformLink *b);
+int nm_platform_lnk_bond_cmp (const NMPlatformLnkBond *a, const NMPlatformLnkBond *b);
+int nm_platform_lnk_bridge_cmp (const NMPlatformLnkBridge *a, const NMPlatformLnkBridge *b);
 int nm_platform_lnk_gre_cmp (const NMPlatformLnkGre *a, const NMPlatformLnkGre *b);
 int nm_platform_lnk_infiniband_cmp (const NMPlatformLnkInfiniband *a, const NMPlatformLnkInfiniband *b);
 int nm_platform_lnk_ip6tnl_cmp (const NMPlatformLnkIp6Tnl *a, const NMPlatformLnkIp6Tnl *b);
@@ -1509,6 +1635,8 @@ void nm_platform_ip4_address_hash_update (const NMPlatformIP4Address *obj, NMHas
 void nm_platform_ip6_address_hash_update (const NMPlatformIP6Address *obj, NMHashState *h);
 void nm_platform_ip4_route_hash_update (const NMPlatformIP4Route *obj, NMPlatformIPRouteCmpType cmp_type, NMHashState *h);
 void nm_platform_ip6_route_hash_update (const NMPlatformIP6Route *obj, NMPlatformIPRouteCmpType cmp_type, NMHashState *h);
+void nm_platform_lnk_bond_hash_update (const NMPlatformLnkBond *obj, NMHashState *h);
+void nm_platform_lnk_bridge_hash_update (const NMPlatformLnkBridge *obj, NMHashState *h);
 void nm_platform_lnk_gre_hash_update (const NMPlatformLnkGre *obj, NMHashState *h);
 void nm_platform_lnk_infiniband_hash_update (const NMPlatformLnkInfiniband *obj, NMHashState *h);
 void nm_platform_lnk_ip6tnl_hash_update (const NMPlatformLnkIp6Tnl *obj, NMHashState *h);
@@ -584,6 +584,36 @@ _vt_cmd_obj_dispose_lnk_wireguard (NMPObject *obj)
 	_wireguard_clear (&obj->_lnk_wireguard);
 }
 
+/* NMPObject instances are allocated from one pool per object type. The platform
+ * cache can contain hundreds of thousands of routes, and objects of the same
+ * type are then close to each other in memory.
+ *
+ * Platform objects are only created and destroyed from the main thread. */
+static NMSlab _nmp_object_pools[NMP_OBJECT_TYPE_MAX];
+
+static NMSlab *
+_nmp_object_pool_get (const NMPClass *klass)
+{
+	NMSlab *pool;
+
+	nm_assert (klass);
+	nm_assert (klass->obj_type > NMP_OBJECT_TYPE_UNKNOWN && klass->obj_type <= NMP_OBJECT_TYPE_MAX);
+
+	pool = &_nmp_object_pools[klass->obj_type - 1];
+	if (G_UNLIKELY (!pool->elem_size)) {
+		nm_slab_init (pool,
+		              klass->obj_type_name,
+		              klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object));
+	}
+	return pool;
+}
+
+const NMSlabStats *
+nmp_object_get_pool_stats (NMPObjectType obj_type)
+{
+	return nm_slab_get_stats (_nmp_object_pool_get (nmp_class_from_type (obj_type)));
+}
+
 static NMPObject *
 _nmp_object_new_from_class (const NMPClass *klass)
 {
@@ -593,7 +623,7 @@ _nmp_object_new_from_class (const NMPClass *klass)
 	nm_assert (klass->sizeof_data > 0);
 	nm_assert (klass->sizeof_public > 0 && klass->sizeof_public <= klass->sizeof_data);
 
-	obj = g_slice_alloc0 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object));
+	obj = nm_slab_alloc0 (_nmp_object_pool_get (klass));
 	obj->_class = klass;
 	obj->parent._ref_count = 1;
 	return obj;
@@ -939,7 +969,6 @@ _vt_cmd_obj_hash_update_link (const NMPObject *obj, NMHashState *h)
 	nm_platform_link_hash_update (&obj->link, h);
 	nm_hash_update_vals (h,
 	                     obj->_link.netlink.is_in_netlink,
-	                     obj->_link.wireguard_family_id,
 	                     obj->_link.udev.device);
 	if (obj->_link.netlink.lnk)
 		nmp_object_hash_update (obj->_link.netlink.lnk, h);
@@ -1002,7 +1031,6 @@ _vt_cmd_obj_cmp_link (const NMPObject *obj1, const NMPObject *obj2)
 	NM_CMP_RETURN (nm_platform_link_cmp (&obj1->link, &obj2->link));
 	NM_CMP_DIRECT (obj1->_link.netlink.is_in_netlink, obj2->_link.netlink.is_in_netlink);
 	NM_CMP_RETURN (nmp_object_cmp (obj1->_link.netlink.lnk, obj2->_link.netlink.lnk));
-	NM_CMP_DIRECT (obj1->_link.wireguard_family_id, obj2->_link.wireguard_family_id);
 
 	if (obj1->_link.udev.device != obj2->_link.udev.device) {
 		if (!obj1->_link.udev.device)
@@ -1504,7 +1532,7 @@ _vt_dedup_obj_destroy (NMDedupMultiObj *obj)
 	klass = o->_class;
 	if (klass->cmd_obj_dispose)
 		klass->cmd_obj_dispose (o);
-	g_slice_free1 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object), o);
+	nm_slab_free (_nmp_object_pool_get (klass), o);
 }
 
 static const NMDedupMultiObj *
@@ -2728,6 +2756,65 @@ nmp_cache_update_link_master_connected (NMPCache *cache,
 	return NMP_CACHE_OPS_UPDATED;
 }
 
+/**
+ * nmp_cache_update_link_lnk:
+ * @cache: the platform cache
+ * @ifindex: the ifindex of the link
+ * @lnk: (allow-none): the new lnk object
+ * @out_obj_old: (allow-none) (out): the link before the update
+ * @out_obj_new: (allow-none) (out): the link after the update
+ *
+ * Replaces the lnk object of a link that is in netlink. This is for
+ * link types whose lnk data is not part of RTM_NEWLINK messages but
+ * fetched separately, like WireGuard.
+ *
+ * Returns: how the cache changed.
+ */
+NMPCacheOpsType
+nmp_cache_update_link_lnk (NMPCache *cache,
+                           int ifindex,
+                           const NMPObject *lnk,
+                           const NMPObject **out_obj_old,
+                           const NMPObject **out_obj_new)
+{
+	const NMDedupMultiEntry *entry_old;
+	const NMDedupMultiEntry *entry_new = NULL;
+	const NMPObject *obj_old;
+	nm_auto_nmpobj NMPObject *obj_new = NULL;
+
+	entry_old = nmp_cache_lookup_entry_link (cache, ifindex);
+
+	if (!entry_old) {
+		NM_SET_OUT (out_obj_old, NULL);
+		NM_SET_OUT (out_obj_new, NULL);
+		return NMP_CACHE_OPS_UNCHANGED;
+	}
+
+	obj_old = entry_old->obj;
+
+	if (   !obj_old->_link.netlink.is_in_netlink
+	    || nmp_object_equal (obj_old->_link.netlink.lnk, lnk)) {
+		NM_SET_OUT (out_obj_old, nmp_object_ref (obj_old));
+		NM_SET_OUT (out_obj_new, nmp_object_ref (obj_old));
+		return NMP_CACHE_OPS_UNCHANGED;
+	}
+
+	obj_new = nmp_object_clone (obj_old, FALSE);
+	nmp_object_unref (obj_new->_link.netlink.lnk);
+	obj_new->_link.netlink.lnk = lnk
+	                             ? nm_dedup_multi_index_obj_intern (cache->multi_idx, lnk)
+	                             : NULL;
+
+	NM_SET_OUT (out_obj_old, nmp_object_ref (obj_old));
+	_idxcache_update (cache,
+	                  entry_old,
+	                  obj_new,
+	                  FALSE,
+	                  &entry_new);
+	NM_SET_OUT (out_obj_new, nmp_object_ref (entry_new->obj));
+	return NMP_CACHE_OPS_UPDATED;
+}
+
 /*****************************************************************************/
 
 void
@@ -2924,6 +3011,28 @@ const NMPClass _nmp_classes[NMP_OBJECT_TYPE_MAX] = {
 		.cmd_plobj_hash_update              = (void (*) (const NMPlatformObject *obj, NMHashState *h)) nm_platform_tfilter_hash_update,
 		.cmd_plobj_cmp                      = (int (*) (const NMPlatformObject *obj1, const NMPlatformObject *obj2)) nm_platform_tfilter_cmp,
 	},
+	[NMP_OBJECT_TYPE_LNK_BOND - 1] = {
+		.parent                             = DEDUP_MULTI_OBJ_CLASS_INIT(),
+		.obj_type                           = NMP_OBJECT_TYPE_LNK_BOND,
+		.sizeof_data                        = sizeof (NMPObjectLnkBond),
+		.sizeof_public                      = sizeof (NMPlatformLnkBond),
+		.obj_type_name                      = "bond",
+		.lnk_link_type                      = NM_LINK_TYPE_BOND,
+		.cmd_plobj_to_string                = (const char *(*) (const NMPlatformObject *obj, char *buf, gsize len)) nm_platform_lnk_bond_to_string,
+		.cmd_plobj_hash_update              = (void (*) (const NMPlatformObject *obj, NMHashState *h)) nm_platform_lnk_bond_hash_update,
+		.cmd_plobj_cmp                      = (int (*) (const NMPlatformObject *obj1, const NMPlatformObject *obj2)) nm_platform_lnk_bond_cmp,
+	},
+	[NMP_OBJECT_TYPE_LNK_BRIDGE - 1] = {
+		.parent                             = DEDUP_MULTI_OBJ_CLASS_INIT(),
+		.obj_type                           = NMP_OBJECT_TYPE_LNK_BRIDGE,
+		.sizeof_data                        = sizeof (NMPObjectLnkBridge),
+		.sizeof_public                      = sizeof (NMPlatformLnkBridge),
+		.obj_type_name                      = "bridge",
+		.lnk_link_type                      = NM_LINK_TYPE_BRIDGE,
+		.cmd_plobj_to_string                = (const char *(*) (const NMPlatformObject *obj, char *buf, gsize len)) nm_platform_lnk_bridge_to_string,
+		.cmd_plobj_hash_update              = (void (*) (const NMPlatformObject *obj, NMHashState *h)) nm_platform_lnk_bridge_hash_update,
+		.cmd_plobj_cmp                      = (int (*) (const NMPlatformObject *obj1, const NMPlatformObject *obj2)) nm_platform_lnk_bridge_cmp,
+	},
 	[NMP_OBJECT_TYPE_LNK_GRE - 1] = {
 		.parent                             = DEDUP_MULTI_OBJ_CLASS_INIT(),
 		.obj_type                           = NMP_OBJECT_TYPE_LNK_GRE,
@@ -197,13 +197,16 @@ typedef struct {
 
 	/* Auxiliary data object for Wi-Fi and WPAN */
 	GObject *ext_data;
-
-	/* FIXME: not every NMPObjectLink should pay the price for tracking
-	 * the wireguard family id. This should be tracked via ext_data, which
-	 * would be exactly the right place. */
-	int wireguard_family_id;
 } NMPObjectLink;
 
+typedef struct {
+	NMPlatformLnkBond _public;
+} NMPObjectLnkBond;
+
+typedef struct {
+	NMPlatformLnkBridge _public;
+} NMPObjectLnkBridge;
+
 typedef struct {
 	NMPlatformLnkGre _public;
 } NMPObjectLnkGre;
@@ -294,6 +297,12 @@ struct _NMPObject {
 		NMPlatformLink          link;
 		NMPObjectLink           _link;
 
+		NMPlatformLnkBond       lnk_bond;
+		NMPObjectLnkBond        _lnk_bond;
+
+		NMPlatformLnkBridge     lnk_bridge;
+		NMPObjectLnkBridge      _lnk_bridge;
+
 		NMPlatformLnkGre        lnk_gre;
 		NMPObjectLnkGre         _lnk_gre;
 
@@ -537,6 +546,8 @@ nmp_object_unref (const NMPObject *obj)
 	})
 
 NMPObject *nmp_object_new (NMPObjectType obj_type, const NMPlatformObject *plob);
+
+const NMSlabStats *nmp_object_get_pool_stats (NMPObjectType obj_type);
 NMPObject *nmp_object_new_link (int ifindex);
 
 const NMPObject *nmp_object_stackinit (NMPObject *obj, NMPObjectType obj_type, gconstpointer plobj);
@@ -734,6 +745,11 @@ NMPCacheOpsType nmp_cache_update_link_master_connected (NMPCache *cache,
                                                         int ifindex,
                                                         const NMPObject **out_obj_old,
                                                         const NMPObject **out_obj_new);
+NMPCacheOpsType nmp_cache_update_link_lnk (NMPCache *cache,
+                                           int ifindex,
+                                           const NMPObject *lnk,
+                                           const NMPObject **out_obj_old,
+                                           const NMPObject **out_obj_new);
 
 void nmp_cache_dirty_set_all (NMPCache *cache, NMPObjectType obj_type);
 
@@ -24,6 +24,8 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <linux/if_tun.h>
+#include <linux/if_ether.h>
+#include <linux/pkt_sched.h>
 
 #include "nm-utils/nm-io-utils.h"
 #include "platform/nmp-object.h"
@@ -408,6 +410,9 @@ test_software (NMLinkType link_type, const char *link_typename)
 				value = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, "forward_delay");
 				g_assert_cmpstr (value, ==, "628");
 				g_free (value);
+				/* the option is also part of the cached lnk object. */
+				nm_platform_process_events (NM_PLATFORM_GET);
+				accept_signals (link_changed, 0, 1);
 			}
 			break;
 		case NM_LINK_TYPE_BOND:
@@ -417,6 +422,8 @@ test_software (NMLinkType link_type, const char *link_typename)
 				/* When reading back, the output looks slightly different. */
 				g_assert (g_str_has_prefix (value, "active-backup"));
 				g_free (value);
+				nm_platform_process_events (NM_PLATFORM_GET);
+				accept_signals (link_changed, 0, 1);
 			}
 			break;
 		default:
@@ -1828,6 +1835,587 @@ test_vlan_set_xgress (void)
 
 /*****************************************************************************/
 
+static void
+test_bridge_change (void)
+{
+	const NMPlatformLnkBridge props = {
+		.stp_state      = TRUE,
+		.priority       = 4096,
+		.forward_delay  = 1500,
+		.hello_time     = 300,
+		.max_age        = 2500,
+		.ageing_time    = 12000,
+		.group_fwd_mask = 0x8,
+		.mcast_snooping = FALSE,
+	};
+	const NMPlatformLnkBridge *lnk;
+	int ifindex, ifindex_slave;
+	gs_free char *value = NULL;
+
+	nmtstp_run_command_check ("ip link add %s type bridge", DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, DEVICE_NAME, NM_LINK_TYPE_BRIDGE, 100)->ifindex;
+
+	nmtstp_run_command_check ("ip link add %s type dummy", SLAVE_NAME);
+	ifindex_slave = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, SLAVE_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+	g_assert (nm_platform_link_enslave (NM_PLATFORM_GET, ifindex, ifindex_slave));
+
+	g_assert (nm_platform_link_bridge_change (NM_PLATFORM_GET, ifindex, &props));
+
+	lnk = nm_platform_link_get_lnk_bridge (NM_PLATFORM_GET, ifindex, NULL);
+	g_assert (lnk);
+	g_assert_cmpint (nm_platform_lnk_bridge_cmp (lnk, &props), ==, 0);
+
+	value = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, "forward_delay");
+	g_assert_cmpstr (value, ==, "1500");
+	nm_clear_g_free (&value);
+
+	g_assert (nm_platform_link_bridge_port_change (NM_PLATFORM_GET, ifindex_slave, 12, 47, TRUE));
+
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_slave, "priority");
+	g_assert_cmpstr (value, ==, "12");
+	nm_clear_g_free (&value);
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_slave, "path_cost");
+	g_assert_cmpstr (value, ==, "47");
+	nm_clear_g_free (&value);
+	value = nm_platform_sysctl_slave_get_option (NM_PLATFORM_GET, ifindex_slave, "hairpin_mode");
+	g_assert_cmpstr (value, ==, "1");
+	nm_clear_g_free (&value);
+
+	nmtstp_link_del (NULL, -1, ifindex_slave, SLAVE_NAME);
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+static void
+test_bond_change (void)
+{
+	NMPlatformLnkBond props = {
+		.mode              = 1, /* active-backup */
+		.miimon            = 200,
+		.miimon_has        = TRUE,
+		.updelay           = 400,
+		.updelay_has       = TRUE,
+		.downdelay         = 600,
+		.downdelay_has     = TRUE,
+		.use_carrier       = TRUE,
+		.primary_reselect  = 1, /* better */
+		.fail_over_mac     = 1, /* active */
+		.resend_igmp       = 3,
+		.num_grat_arp      = 2,
+		.min_links         = 1,
+		.lp_interval       = 2,
+		.arp_ip_targets_num = 2,
+	};
+	const NMPlatformLnkBond *lnk;
+	int ifindex, ifindex_slave;
+	gs_free char *value = NULL;
+
+	if (   !g_file_test ("/proc/1/net/bonding", G_FILE_TEST_IS_DIR)
+	    && system ("modprobe --show bonding") != 0) {
+		g_test_skip ("Skipping test for bonding: bonding module not available");
+		return;
+	}
+
+	props.arp_ip_target[0] = nmtst_inet4_from_string ("192.168.1.1");
+	props.arp_ip_target[1] = nmtst_inet4_from_string ("192.168.1.2");
+
+	nmtstp_run_command_check ("ip link add %s type bond", DEVICE_NAME);
+	ifindex = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, DEVICE_NAME, NM_LINK_TYPE_BOND, 100)->ifindex;
+
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, ifindex, &props));
+
+	lnk = nm_platform_link_get_lnk_bond (NM_PLATFORM_GET, ifindex, NULL);
+	g_assert (lnk);
+	g_assert_cmpint (lnk->mode, ==, 1);
+	g_assert_cmpint (lnk->miimon, ==, 200);
+	g_assert_cmpint (lnk->updelay, ==, 400);
+	g_assert_cmpint (lnk->downdelay, ==, 600);
+	g_assert_cmpint (lnk->primary_reselect, ==, 1);
+	g_assert_cmpint (lnk->fail_over_mac, ==, 1);
+	g_assert_cmpint (lnk->resend_igmp, ==, 3);
+	g_assert_cmpint (lnk->num_grat_arp, ==, 2);
+	g_assert_cmpint (lnk->arp_ip_targets_num, ==, 2);
+	g_assert_cmpint (lnk->arp_ip_target[1], ==, nmtst_inet4_from_string ("192.168.1.2"));
+
+	value = nm_platform_sysctl_master_get_option (NM_PLATFORM_GET, ifindex, "mode");
+	g_assert (g_str_has_prefix (value, "active-backup"));
+	nm_clear_g_free (&value);
+
+	/* clear the ARP targets again */
+	props.arp_ip_targets_num = 0;
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, ifindex, &props));
+	lnk = nm_platform_link_get_lnk_bond (NM_PLATFORM_GET, ifindex, NULL);
+	g_assert (lnk);
+	g_assert_cmpint (lnk->arp_ip_targets_num, ==, 0);
+
+	/* with a slave, kernel rejects fail_over_mac even if it doesn't change.
+	 * Changing other options must still work. */
+	nmtstp_run_command_check ("ip link add %s type dummy", SLAVE_NAME);
+	ifindex_slave = nmtstp_assert_wait_for_link (NM_PLATFORM_GET, SLAVE_NAME, NM_LINK_TYPE_DUMMY, 100)->ifindex;
+	g_assert (nm_platform_link_enslave (NM_PLATFORM_GET, ifindex, ifindex_slave));
+
+	props.miimon = 300;
+	g_assert (nm_platform_link_bond_change (NM_PLATFORM_GET, ifindex, &props));
+	lnk = nm_platform_link_get_lnk_bond (NM_PLATFORM_GET, ifindex, NULL);
+	g_assert (lnk);
+	g_assert_cmpint (lnk->miimon, ==, 300);
+	g_assert_cmpint (lnk->fail_over_mac, ==, 1);
+
+	nmtstp_link_del (NULL, -1, ifindex_slave, SLAVE_NAME);
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+/*****************************************************************************/
+
+static guint
+_tc_count (int ifindex, NMPObjectType obj_type)
+{
+	gs_unref_ptrarray GPtrArray *objs = NULL;
+	NMPLookup lookup;
+
+	objs = nm_platform_lookup_clone (NM_PLATFORM_GET,
+	                                 nmp_lookup_init_object (&lookup, obj_type, ifindex),
+	                                 NULL, NULL);
+	return objs ? objs->len : 0u;
+}
+
+static const NMPlatformTfilter *
+_tfilter_get (int ifindex)
+{
+	NMPLookup lookup;
+	const NMDedupMultiHeadEntry *head_entry;
+
+	head_entry = nm_platform_lookup (NM_PLATFORM_GET,
+	                                 nmp_lookup_init_object (&lookup, NMP_OBJECT_TYPE_TFILTER, ifindex));
+	g_assert (head_entry);
+	g_assert_cmpint (head_entry->len, ==, 1);
+	return NMP_OBJECT_CAST_TFILTER (c_list_first_entry (&head_entry->lst_entries_head, NMDedupMultiEntry, lst_entries)->obj);
+}
+
+static void
+_tfilter_removed_cb (NMPlatform *platform,
+                     int obj_type_i,
+                     int ifindex,
+                     const NMPlatformTfilter *tfilter,
+                     int change_type_i,
+                     guint *n_removed)
+{
+	if ((NMPlatformSignalChangeType) change_type_i == NM_PLATFORM_SIGNAL_REMOVED)
+		(*n_removed)++;
+}
+
+static void
+test_tc_sync (void)
+{
+	gs_unref_ptrarray GPtrArray *qdiscs = NULL;
+	gs_unref_ptrarray GPtrArray *tfilters = NULL;
+	const NMPlatformTfilter *plat_tfilter;
+	NMPObject *qdisc;
+	NMPObject *tfilter;
+	guint32 handle;
+	guint32 prio;
+	guint n_removed = 0;
+	gulong signal_id;
+	int ifindex;
+
+	ifindex = nmtstp_link_dummy_add (NULL, -1, DEVICE_NAME)->ifindex;
+
+	qdisc = nmp_object_new (NMP_OBJECT_TYPE_QDISC, NULL);
+	qdisc->qdisc.ifindex = ifindex;
+	qdisc->qdisc.kind = "ingress";
+	qdisc->qdisc.addr_family = AF_UNSPEC;
+	qdisc->qdisc.handle = TC_H_MAKE (TC_H_INGRESS, 0);
+	qdisc->qdisc.parent = TC_H_INGRESS;
+	qdiscs = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+	g_ptr_array_add (qdiscs, qdisc);
+
+	g_assert (nm_platform_qdisc_sync (NM_PLATFORM_GET, ifindex, qdiscs));
+	g_assert (nmp_cache_lookup_obj (nm_platform_get_cache (NM_PLATFORM_GET), qdisc));
+
+	/* syncing the same configuration again is a no-op. */
+	g_assert (nm_platform_qdisc_sync (NM_PLATFORM_GET, ifindex, qdiscs));
+	g_assert_cmpint (_tc_count (ifindex, NMP_OBJECT_TYPE_QDISC), ==, 1);
+
+	tfilter = nmp_object_new (NMP_OBJECT_TYPE_TFILTER, NULL);
+	tfilter->tfilter.ifindex = ifindex;
+	tfilter->tfilter.kind = "matchall";
+	tfilter->tfilter.addr_family = AF_UNSPEC;
+	/* no handle and priority, like in a profile that doesn't set them. */
+	tfilter->tfilter.handle = 0;
+	tfilter->tfilter.parent = TC_H_MAKE (TC_H_INGRESS, 0);
+	tfilter->tfilter.info = TC_H_MAKE (0, htons (ETH_P_ALL));
+	tfilter->tfilter.action.kind = NM_PLATFORM_ACTION_KIND_SIMPLE;
+	g_strlcpy (tfilter->tfilter.action.simple.sdata, "Hello", sizeof (tfilter->tfilter.action.simple.sdata));
+	tfilters = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+	g_ptr_array_add (tfilters, tfilter);
+
+	if (!nm_platform_tfilter_sync (NM_PLATFORM_GET, ifindex, tfilters)) {
+		g_test_skip ("Skipping tfilter test: matchall filter or simple action not available");
+		goto out;
+	}
+
+	plat_tfilter = _tfilter_get (ifindex);
+	g_assert_cmpint (plat_tfilter->handle, !=, 0);
+	g_assert_cmpstr (plat_tfilter->action.kind, ==, NM_PLATFORM_ACTION_KIND_SIMPLE);
+	g_assert_cmpstr (plat_tfilter->action.simple.sdata, ==, "Hello");
+	handle = plat_tfilter->handle;
+	prio = TC_H_MAJ (plat_tfilter->info);
+
+	signal_id = g_signal_connect (NM_PLATFORM_GET, NM_PLATFORM_SIGNAL_TFILTER_CHANGED, G_CALLBACK (_tfilter_removed_cb), &n_removed);
+
+	/* the filter matches the one with the handle the kernel picked,
+	 * it is neither deleted nor added again. */
+	g_assert (nm_platform_tfilter_sync (NM_PLATFORM_GET, ifindex, tfilters));
+	g_assert_cmpint (n_removed, ==, 0);
+	plat_tfilter = _tfilter_get (ifindex);
+	g_assert_cmpint (plat_tfilter->handle, ==, handle);
+
+	/* a changed filter replaces the existing one. */
+	g_strlcpy (tfilter->tfilter.action.simple.sdata, "World", sizeof (tfilter->tfilter.action.simple.sdata));
+	g_assert (nm_platform_tfilter_sync (NM_PLATFORM_GET, ifindex, tfilters));
+	g_assert_cmpint (n_removed, ==, 0);
+
+	plat_tfilter = _tfilter_get (ifindex);
+	g_assert_cmpint (plat_tfilter->handle, ==, handle);
+	g_assert_cmpint (TC_H_MAJ (plat_tfilter->info), ==, prio);
+	g_assert_cmpstr (plat_tfilter->action.simple.sdata, ==, "World");
+
+	/* unknown filters are still removed. */
+	g_assert (nm_platform_tfilter_sync (NM_PLATFORM_GET, ifindex, NULL));
+	g_assert_cmpint (n_removed, ==, 1);
+	g_assert_cmpint (_tc_count (ifindex, NMP_OBJECT_TYPE_TFILTER), ==, 0);
+
+	g_signal_handler_disconnect (NM_PLATFORM_GET, signal_id);
+
+out:
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+/*****************************************************************************/
+
+#define SRIOV_N_VFS 20
+
+typedef struct {
+	GMainLoop *loop;
+	guint n_expected;
+	guint n_done;
+	guint num_vfs[2];
+} SriovTestData;
+
+static guint
+_sriov_num_vfs (const char *ifname)
+{
+	gs_free char *path = NULL;
+	gs_free char *contents = NULL;
+
+	path = g_strdup_printf ("/sys/class/net/%s/device/sriov_numvfs", ifname);
+	g_assert (g_file_get_contents (path, &contents, NULL, NULL));
+	return _nm_utils_ascii_str_to_int64 (contents, 10, 0, G_MAXUINT, G_MAXUINT);
+}
+
+static void
+_sriov_params_cb (GError *error, gpointer user_data)
+{
+	SriovTestData *data = user_data;
+
+	g_assert_no_error (error);
+	g_assert_cmpint (data->n_done, <, G_N_ELEMENTS (data->num_vfs));
+	data->num_vfs[data->n_done] = _sriov_num_vfs (DEVICE_NAME);
+	if (++data->n_done == data->n_expected)
+		g_main_loop_quit (data->loop);
+}
+
+static void
+_sriov_set_num_vfs (SriovTestData *data, int ifindex, guint num_vfs)
+{
+	data->n_expected = 1;
+	data->n_done = 0;
+	nm_platform_link_set_sriov_params_async (NM_PLATFORM_GET, ifindex, num_vfs, -1,
+	                                         NULL, _sriov_params_cb, data);
+	g_assert (nmtst_main_loop_run (data->loop, 5000));
+	g_assert_cmpint (data->num_vfs[0], ==, num_vfs);
+}
+
+/* read the MAC address of a VF back from "ip link show". Depending on
+ * the version, iproute2 prints it after "MAC" or "link/ether". */
+static char *
+_sriov_vf_mac (const char *ifname, guint vf_index)
+{
+	gs_free char *cmd = NULL;
+	gs_free char *out = NULL;
+	gs_strfreev char **lines = NULL;
+	char prefix[32];
+	int status;
+	guint i;
+
+	cmd = g_strdup_printf ("ip link show dev %s", ifname);
+	g_assert (g_spawn_command_line_sync (cmd, &out, NULL, &status, NULL));
+	g_assert_cmpint (status, ==, 0);
+
+	nm_sprintf_buf (prefix, "vf %u ", vf_index);
+	lines = g_strsplit (out, "\n", -1);
+	for (i = 0; lines[i]; i++) {
+		const char *line = nm_str_skip_leading_spaces (lines[i]);
+		const char *mac;
+
+		if (!g_str_has_prefix (line, prefix))
+			continue;
+		mac = strstr (line, "link/ether ");
+		if (mac)
+			mac += NM_STRLEN ("link/ether ");
+		else {
+			mac = strstr (line, "MAC ");
+			g_assert (mac);
+			mac += NM_STRLEN ("MAC ");
+		}
+		g_assert (strlen (mac) >= 17);
+		return g_ascii_strdown (mac, 17);
+	}
+	g_assert_not_reached ();
+}
+
+static void
+_sriov_vfs_check (const NMPlatformVF *vfs, guint n_vfs)
+{
+	guint i;
+
+	for (i = 0; i < n_vfs; i++) {
+		gs_free char *mac = _sriov_vf_mac (DEVICE_NAME, vfs[i].index);
+
+		g_assert (nm_utils_hwaddr_matches (mac, -1, vfs[i].mac.data, vfs[i].mac.len));
+	}
+}
+
+static void
+test_sriov_netdevsim (void)
+{
+	gs_free char *path = NULL;
+	gs_free char *contents = NULL;
+	SriovTestData data = { };
+	const NMPlatformLink *plink;
+	NMPlatformVF vfs[SRIOV_N_VFS] = { };
+	const NMPlatformVF *vfs_arr[SRIOV_N_VFS + 1] = { };
+	const char *const EXT_MAC = "02:00:00:00:01:03";
+	int ifindex;
+	guint i;
+
+	if (nmtstp_run_command ("ip link add %s type netdevsim", DEVICE_NAME) != 0) {
+		g_test_skip ("Skipping SR-IOV test: netdevsim module not available");
+		return;
+	}
+	nm_platform_process_events (NM_PLATFORM_GET);
+	plink = nm_platform_link_get_by_ifname (NM_PLATFORM_GET, DEVICE_NAME);
+	g_assert (plink);
+	ifindex = plink->ifindex;
+
+	path = g_strdup_printf ("/sys/class/net/%s/device/sriov_totalvfs", DEVICE_NAME);
+	if (   !g_file_get_contents (path, &contents, NULL, NULL)
+	    || _nm_utils_ascii_str_to_int64 (contents, 10, 0, G_MAXUINT, 0) < SRIOV_N_VFS) {
+		g_test_skip ("Skipping SR-IOV test: netdevsim without enough VFs");
+		goto out;
+	}
+
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	_sriov_set_num_vfs (&data, ifindex, SRIOV_N_VFS);
+
+	/* nothing to change, still completes asynchronously. */
+	_sriov_set_num_vfs (&data, ifindex, SRIOV_N_VFS);
+
+	/* requests for the same link complete one after the other, in order. */
+	data.n_expected = 2;
+	data.n_done = 0;
+	nm_platform_link_set_sriov_params_async (NM_PLATFORM_GET, ifindex, 4, -1,
+	                                         NULL, _sriov_params_cb, &data);
+	nm_platform_link_set_sriov_params_async (NM_PLATFORM_GET, ifindex, SRIOV_N_VFS, -1,
+	                                         NULL, _sriov_params_cb, &data);
+	g_assert (nmtst_main_loop_run (data.loop, 10000));
+	g_assert_cmpint (data.num_vfs[0], ==, 4);
+	g_assert_cmpint (data.num_vfs[1], ==, SRIOV_N_VFS);
+
+	/* more VFs than fit into one message. */
+	for (i = 0; i < SRIOV_N_VFS; i++) {
+		vfs[i].index = i;
+		vfs[i].spoofchk = -1;
+		vfs[i].trust = -1;
+		vfs[i].mac.len = ETH_ALEN;
+		vfs[i].mac.data[0] = 0x02;
+		vfs[i].mac.data[5] = i + 1;
+		vfs_arr[i] = &vfs[i];
+	}
+	g_assert (nm_platform_link_set_sriov_vfs (NM_PLATFORM_GET, ifindex, vfs_arr));
+	_sriov_vfs_check (vfs, SRIOV_N_VFS);
+
+	/* the skip compares against the kernel: a change made outside is
+	 * restored when the same configuration is applied again. */
+	nmtstp_run_command_check ("ip link set %s vf 3 mac %s", DEVICE_NAME, EXT_MAC);
+	{
+		gs_free char *mac = _sriov_vf_mac (DEVICE_NAME, 3);
+
+		g_assert_cmpstr (mac, ==, EXT_MAC);
+	}
+	g_assert (nm_platform_link_set_sriov_vfs (NM_PLATFORM_GET, ifindex, vfs_arr));
+	_sriov_vfs_check (vfs, SRIOV_N_VFS);
+
+	vfs[17].mac.data[4] = 0x02;
+	g_assert (nm_platform_link_set_sriov_vfs (NM_PLATFORM_GET, ifindex, vfs_arr));
+	_sriov_vfs_check (vfs, SRIOV_N_VFS);
+
+	/* re-created VFs lose their configuration and get it back. */
+	_sriov_set_num_vfs (&data, ifindex, 0);
+	_sriov_set_num_vfs (&data, ifindex, SRIOV_N_VFS);
+	g_assert (nm_platform_link_set_sriov_vfs (NM_PLATFORM_GET, ifindex, vfs_arr));
+	_sriov_vfs_check (vfs, SRIOV_N_VFS);
+
+	_sriov_set_num_vfs (&data, ifindex, 0);
+
+	g_main_loop_unref (data.loop);
+out:
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+/*****************************************************************************/
+
+#define WG_N_PEERS        40
+#define WG_N_ALLOWED_IPS  600
+
+static void
+_wireguard_peer_init (NMPWireGuardPeer *peer, guint idx, guint16 keepalive, guint n_allowed_ips)
+{
+	NMPWireGuardAllowedIP *allowed_ips;
+	guint i;
+
+	memset (peer, 0, sizeof (*peer));
+	memset (peer->public_key, 0x42, sizeof (peer->public_key));
+	peer->public_key[0] = idx;
+	peer->endpoint_family = AF_INET;
+	peer->endpoint_addr.addr4 = nmtst_inet4_from_string ("192.0.2.1") + htonl (idx);
+	peer->endpoint_port = 51820;
+	peer->persistent_keepalive_interval = keepalive;
+
+	allowed_ips = g_new0 (NMPWireGuardAllowedIP, n_allowed_ips);
+	for (i = 0; i < n_allowed_ips; i++) {
+		allowed_ips[i].family = AF_INET;
+		allowed_ips[i].addr.addr4 = htonl ((10u << 24) | (idx << 16) | i);
+		allowed_ips[i].mask = 32;
+	}
+	peer->allowed_ips = allowed_ips;
+	peer->allowed_ips_len = n_allowed_ips;
+}
+
+static void
+_wireguard_check (int ifindex,
+                  const NMPlatformLnkWireGuard *lnk_wireguard,
+                  const NMPWireGuardPeer *peers,
+                  guint peers_len)
+{
+	const NMPObject *obj;
+	const NMPObjectLnkWireGuard *lnk;
+	guint i, j, k;
+
+	obj = nmp_cache_lookup_link (nm_platform_get_cache (NM_PLATFORM_GET), ifindex);
+	g_assert (obj);
+	g_assert (obj->_link.netlink.lnk);
+	lnk = &obj->_link.netlink.lnk->_lnk_wireguard;
+
+	g_assert_cmpint (lnk->_public.listen_port, ==, lnk_wireguard->listen_port);
+	g_assert_cmpint (lnk->_public.fwmark, ==, lnk_wireguard->fwmark);
+	g_assert (memcmp (lnk->_public.private_key, lnk_wireguard->private_key, sizeof (lnk_wireguard->private_key)) == 0);
+
+	g_assert_cmpint (lnk->peers_len, ==, peers_len);
+	for (i = 0; i < peers_len; i++) {
+		const NMPWireGuardPeer *peer = NULL;
+
+		for (j = 0; j < lnk->peers_len; j++) {
+			if (memcmp (lnk->peers[j].public_key, peers[i].public_key, sizeof (peers[i].public_key)) == 0) {
+				peer = &lnk->peers[j];
+				break;
+			}
+		}
+		g_assert (peer);
+		g_assert_cmpint (peer->endpoint_family, ==, AF_INET);
+		g_assert_cmpint (peer->endpoint_addr.addr4, ==, peers[i].endpoint_addr.addr4);
+		g_assert_cmpint (peer->endpoint_port, ==, peers[i].endpoint_port);
+		g_assert_cmpint (peer->persistent_keepalive_interval, ==, peers[i].persistent_keepalive_interval);
+
+		g_assert_cmpint (peer->allowed_ips_len, ==, peers[i].allowed_ips_len);
+		for (j = 0; j < peers[i].allowed_ips_len; j++) {
+			const NMPWireGuardAllowedIP *a = &peers[i].allowed_ips[j];
+
+			for (k = 0; k < peer->allowed_ips_len; k++) {
+				const NMPWireGuardAllowedIP *b = &peer->allowed_ips[k];
+
+				if (   a->family == b->family
+				    && a->mask == b->mask
+				    && a->addr.addr4 == b->addr.addr4)
+					break;
+			}
+			g_assert_cmpint (k, <, peer->allowed_ips_len);
+		}
+	}
+}
+
+static void
+test_wireguard_change (void)
+{
+	NMPlatformLnkWireGuard lnk_wireguard = {
+		.listen_port = 51820,
+		.fwmark = 0x42,
+	};
+	NMPWireGuardPeer peers[WG_N_PEERS];
+	const NMPlatformLink *plink = NULL;
+	int ifindex;
+	guint i;
+
+	if (nm_platform_link_wireguard_add (NM_PLATFORM_GET, DEVICE_NAME, &plink) != NM_PLATFORM_ERROR_SUCCESS) {
+		g_test_skip ("Skipping WireGuard test: wireguard module not available");
+		return;
+	}
+	g_assert (plink);
+	ifindex = plink->ifindex;
+
+	/* the kernel clamps the private key, use one that reads back unchanged. */
+	nmtst_rand_buf (NULL, lnk_wireguard.private_key, sizeof (lnk_wireguard.private_key));
+	lnk_wireguard.private_key[0] &= 248;
+	lnk_wireguard.private_key[31] &= 127;
+	lnk_wireguard.private_key[31] |= 64;
+
+	/* the first peer has more allowed IPs than fit into one netlink message
+	 * and must be split. Together with the other peers the configuration
+	 * takes several messages. */
+	_wireguard_peer_init (&peers[0], 0, 0, WG_N_ALLOWED_IPS);
+	for (i = 1; i < WG_N_PEERS; i++)
+		_wireguard_peer_init (&peers[i], i, 25, 8);
+
+	g_assert (nm_platform_link_wireguard_change (NM_PLATFORM_GET, ifindex, &lnk_wireguard, peers, WG_N_PEERS, TRUE));
+	_wireguard_check (ifindex, &lnk_wireguard, peers, WG_N_PEERS);
+
+	/* changing one peer leaves the others alone. */
+	g_free ((gpointer) peers[5].allowed_ips);
+	_wireguard_peer_init (&peers[5], 5, 60, 3);
+	g_assert (nm_platform_link_wireguard_change (NM_PLATFORM_GET, ifindex, &lnk_wireguard, peers, WG_N_PEERS, TRUE));
+	_wireguard_check (ifindex, &lnk_wireguard, peers, WG_N_PEERS);
+
+	/* the big peer still has all its allowed IPs after being re-sent. */
+	g_free ((gpointer) peers[0].allowed_ips);
+	_wireguard_peer_init (&peers[0], 0, 10, WG_N_ALLOWED_IPS);
+	g_assert (nm_platform_link_wireguard_change (NM_PLATFORM_GET, ifindex, &lnk_wireguard, peers, WG_N_PEERS, TRUE));
+	_wireguard_check (ifindex, &lnk_wireguard, peers, WG_N_PEERS);
+
+	/* replacing the peers removes the ones not passed anymore. */
+	g_assert (nm_platform_link_wireguard_change (NM_PLATFORM_GET, ifindex, &lnk_wireguard, peers, 10, TRUE));
+	_wireguard_check (ifindex, &lnk_wireguard, peers, 10);
+
+	g_assert (nm_platform_link_wireguard_change (NM_PLATFORM_GET, ifindex, &lnk_wireguard, NULL, 0, TRUE));
+	_wireguard_check (ifindex, &lnk_wireguard, NULL, 0);
+
+	for (i = 0; i < WG_N_PEERS; i++)
+		g_free ((gpointer) peers[i].allowed_ips);
+
+	nmtstp_link_del (NULL, -1, ifindex, DEVICE_NAME);
+}
+
+/*****************************************************************************/
+
 static void
 test_create_many_links_do (guint n_devices)
 {
@@ -2101,7 +2689,7 @@ _test_netns_create_platform (void)
 	netns = nmp_netns_new ();
 	g_assert (NMP_IS_NETNS (netns));
 
-	platform = nm_linux_platform_new (TRUE, TRUE);
+	platform = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	g_assert (NM_IS_LINUX_PLATFORM (platform));
 
 	nmp_netns_pop (netns);
@@ -2187,7 +2775,7 @@ test_netns_general (gpointer fixture, gconstpointer test_data)
 	if (_check_sysctl_skip ())
 		return;
 
-	platform_1 = nm_linux_platform_new (TRUE, TRUE);
+	platform_1 = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	platform_2 = _test_netns_create_platform ();
 
 	/* add some dummy devices. The "other-*" devices are there to bump the ifindex */
@@ -2287,7 +2875,7 @@ test_netns_set_netns (gpointer fixture, gconstpointer test_data)
 	if (_test_netns_check_skip ())
 		return;
 
-	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE);
+	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	platforms[1] = platform_1 = _test_netns_create_platform ();
 	platforms[2] = platform_2 = _test_netns_create_platform ();
 
@@ -2385,7 +2973,7 @@ test_netns_push (gpointer fixture, gconstpointer test_data)
 	if (_check_sysctl_skip ())
 		return;
 
-	pl[0].platform = platform_0 = nm_linux_platform_new (TRUE, TRUE);
+	pl[0].platform = platform_0 = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	pl[1].platform = platform_1 = _test_netns_create_platform ();
 	pl[2].platform = platform_2 = _test_netns_create_platform ();
 
@@ -2516,7 +3104,7 @@ test_netns_bind_to_path (gpointer fixture, gconstpointer test_data)
 	if (_test_netns_check_skip ())
 		return;
 
-	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE);
+	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	platforms[1] = platform_1 = _test_netns_create_platform ();
 	platforms[2] = platform_2 = _test_netns_create_platform ();
 
@@ -2663,7 +3251,7 @@ test_sysctl_netns_switch (void)
 	if (_test_netns_check_skip ())
 		return;
 
-	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE);
+	platforms[0] = platform_0 = nm_linux_platform_new (TRUE, TRUE, FALSE);
 	platforms[1] = platform_1 = _test_netns_create_platform ();
 	platforms[2] = platform_2 = _test_netns_create_platform ();
 	PL = platforms[nmtst_get_rand_int () % 3];
@@ -2864,6 +3452,11 @@ _nmtstp_setup_tests (void)
 		test_software_detect_add ("/link/software/detect/vxlan/1", NM_LINK_TYPE_VXLAN, 1);
 
 		g_test_add_func ("/link/software/vlan/set-xgress", test_vlan_set_xgress);
+		g_test_add_func ("/link/software/bridge/change", test_bridge_change);
+		g_test_add_func ("/link/software/bond/change", test_bond_change);
+		g_test_add_func ("/link/tc/sync", test_tc_sync);
+		g_test_add_func ("/link/sriov/netdevsim", test_sriov_netdevsim);
+		g_test_add_func ("/link/wireguard/change", test_wireguard_change);
 
 		g_test_add_data_func ("/link/create-many-links/20", GUINT_TO_POINTER (20), test_create_many_links);
 		g_test_add_data_func ("/link/create-many-links/1000", GUINT_TO_POINTER (1000), test_create_many_links);
@@ -537,6 +537,182 @@ test_cache_qdisc (void)
 
 /*****************************************************************************/
 
+static void
+_ip4_route_init (NMPlatformIP4Route *r, guint i)
+{
+	memset (r, 0, sizeof (*r));
+	r->ifindex = 1 + (i % 16);
+	r->network = htonl (0x0a000000u + (i << 8));
+	r->plen = 24;
+	r->metric = 100 + (i % 7);
+	r->gateway = htonl (0xc0000201u);
+	r->rt_source = NM_IP_CONFIG_SOURCE_USER;
+}
+
+static void
+test_dedup_intern (void)
+{
+	const guint N = 1000;
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = nm_dedup_multi_index_new ();
+	gs_unref_hashtable GHashTable *seen = g_hash_table_new (nm_direct_hash, NULL);
+	gs_free const NMPObject **interned = g_new0 (const NMPObject *, 2 * N);
+	NMPlatformIP4Route r;
+	NMPObject obj_stack;
+	guint i;
+
+	for (i = 0; i < 2 * N; i++) {
+		nm_auto_nmpobj NMPObject *obj = NULL;
+		nm_auto_nmpobj NMPObject *obj_clone = NULL;
+		NMHashState h1, h2;
+
+		_ip4_route_init (&r, i % N);
+		obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r);
+
+		/* equal objects must hash equal. */
+		obj_clone = nmp_object_clone (obj, FALSE);
+		nm_hash_init (&h1, 42);
+		nm_hash_init (&h2, 42);
+		nmp_object_hash_update (obj, &h1);
+		nmp_object_hash_update (obj_clone, &h2);
+		g_assert_cmpint (nm_hash_complete (&h1), ==, nm_hash_complete (&h2));
+		g_assert_cmpint (nmp_object_id_hash (obj), ==, nmp_object_id_hash (obj_clone));
+
+		interned[i] = nm_dedup_multi_index_obj_intern (multi_idx, obj);
+		g_assert (interned[i]);
+		g_assert (nmp_object_equal (interned[i], obj));
+		if (i < N)
+			g_assert (interned[i] == obj);
+		else
+			g_assert (interned[i] == interned[i - N]);
+		g_assert (nm_dedup_multi_index_obj_find (multi_idx, obj_clone) == interned[i]);
+		g_hash_table_add (seen, (gpointer) interned[i]);
+	}
+
+	/* every distinct object is interned exactly once. */
+	g_assert_cmpint (g_hash_table_size (seen), ==, N);
+
+	_ip4_route_init (&r, N);
+	nmp_object_stackinit (&obj_stack, NMP_OBJECT_TYPE_IP4_ROUTE, &r);
+	g_assert (!nm_dedup_multi_index_obj_find (multi_idx, &obj_stack));
+
+	for (i = 0; i < 2 * N; i++)
+		nmp_object_unref (interned[i]);
+}
+
+static void
+test_object_pool (void)
+{
+	const guint N = 5000;
+	gs_unref_ptrarray GPtrArray *objs = NULL;
+	gsize n_used_before;
+	guint i;
+
+	n_used_before = nmp_object_get_pool_stats (NMP_OBJECT_TYPE_IP4_ROUTE)->n_used;
+
+	objs = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+	for (i = 0; i < N; i++) {
+		NMPlatformIP4Route r;
+
+		_ip4_route_init (&r, i);
+		g_ptr_array_add (objs, nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r));
+	}
+	g_assert_cmpint (nmp_object_get_pool_stats (NMP_OBJECT_TYPE_IP4_ROUTE)->n_used, ==, n_used_before + N);
+	g_assert_cmpint (nmp_object_get_pool_stats (NMP_OBJECT_TYPE_IP4_ROUTE)->bytes_allocated, >, 0);
+
+	/* release every other object and allocate again, so that the
+	 * free list gets used. */
+	for (i = 0; i < N; i += 2)
+		nm_clear_pointer (&objs->pdata[i], nmp_object_unref);
+	for (i = 0; i < N; i += 2) {
+		NMPlatformIP4Route r;
+
+		_ip4_route_init (&r, i);
+		objs->pdata[i] = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r);
+		g_assert_cmpint (NMP_OBJECT_CAST_IP4_ROUTE (objs->pdata[i])->network, ==, r.network);
+		g_assert_cmpint (NMP_OBJECT_CAST_IP4_ROUTE (objs->pdata[i])->rt_source, ==, r.rt_source);
+	}
+	g_assert_cmpint (nmp_object_get_pool_stats (NMP_OBJECT_TYPE_IP4_ROUTE)->n_used, ==, n_used_before + N);
+
+	g_clear_pointer (&objs, g_ptr_array_unref);
+	g_assert_cmpint (nmp_object_get_pool_stats (NMP_OBJECT_TYPE_IP4_ROUTE)->n_used, ==, n_used_before);
+}
+
+static void
+test_hash_perf (void)
+{
+	const guint N = 10000;
+	const guint ROUNDS = 100;
+	gs_unref_ptrarray GPtrArray *objs = NULL;
+	gint64 t_start, t_id, t_full, t_siphash, t_nm_hash;
+	guint sink = 0;
+	guint i, j;
+
+	if (nmtst_test_quick ()) {
+		g_test_skip ("Skip long running test");
+		return;
+	}
+
+	objs = g_ptr_array_new_with_free_func ((GDestroyNotify) nmp_object_unref);
+	for (i = 0; i < N; i++) {
+		NMPlatformIP4Route r;
+
+		_ip4_route_init (&r, i);
+		g_ptr_array_add (objs, nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, (const NMPlatformObject *) &r));
+	}
+
+	t_start = g_get_monotonic_time ();
+	for (j = 0; j < ROUNDS; j++) {
+		for (i = 0; i < N; i++)
+			sink ^= nmp_object_id_hash (objs->pdata[i]);
+	}
+	t_id = g_get_monotonic_time () - t_start;
+
+	t_start = g_get_monotonic_time ();
+	for (j = 0; j < ROUNDS; j++) {
+		for (i = 0; i < N; i++) {
+			NMHashState h;
+
+			nm_hash_init (&h, 1);
+			nmp_object_hash_update (objs->pdata[i], &h);
+			sink ^= nm_hash_complete (&h);
+		}
+	}
+	t_full = g_get_monotonic_time () - t_start;
+
+	/* compare the configured backend against plain siphash24 on the raw
+	 * route structs. */
+	t_start = g_get_monotonic_time ();
+	for (j = 0; j < ROUNDS; j++) {
+		for (i = 0; i < N; i++) {
+			static const guint8 key[16] = { 1, };
+			const NMPObject *obj = objs->pdata[i];
+
+			sink ^= (guint) c_siphash_hash (key, (const guint8 *) &obj->ip4_route, sizeof (obj->ip4_route));
+		}
+	}
+	t_siphash = g_get_monotonic_time () - t_start;
+
+	t_start = g_get_monotonic_time ();
+	for (j = 0; j < ROUNDS; j++) {
+		for (i = 0; i < N; i++) {
+			const NMPObject *obj = objs->pdata[i];
+			NMHashState h;
+
+			nm_hash_init (&h, 1);
+			nm_hash_update (&h, &obj->ip4_route, sizeof (obj->ip4_route));
+			sink ^= nm_hash_complete (&h);
+		}
+	}
+	t_nm_hash = g_get_monotonic_time () - t_start;
+
+	g_test_message ("hash %u routes x %u (%s): id-hash %" G_GINT64_FORMAT " usec, full-hash %" G_GINT64_FORMAT " usec, "
+	                "raw siphash24 %" G_GINT64_FORMAT " usec, raw nm-hash %" G_GINT64_FORMAT " usec (%u)",
+	                N, ROUNDS, NM_HASH_FAST ? "fast" : "siphash",
+	                t_id, t_full, t_siphash, t_nm_hash, sink);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -582,6 +758,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/nmp-object/obj-base", test_obj_base);
 	g_test_add_func ("/nmp-object/cache_link", test_cache_link);
 	g_test_add_func ("/nmp-object/cache_qdisc", test_cache_qdisc);
+	g_test_add_func ("/nmp-object/dedup-intern", test_dedup_intern);
+	g_test_add_func ("/nmp-object/object-pool", test_object_pool);
+	g_test_add_func ("/nmp-object/hash-perf", test_hash_perf);
 
 	result = g_test_run ();
 
@@ -481,6 +481,105 @@ test_ip4_zero_gateway (void)
 	nmtstp_wait_for_signal (NM_PLATFORM_GET, 50);
 }
 
+static gboolean
+_routes_contain_ip4 (const GPtrArray *routes, in_addr_t network, guint8 plen)
+{
+	guint i;
+
+	for (i = 0; routes && i < routes->len; i++) {
+		const NMPlatformIP4Route *r = NMP_OBJECT_CAST_IP4_ROUTE (routes->pdata[i]);
+
+		if (   r->network == network
+		    && r->plen == plen)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static void
+test_ip4_route_compact_foreign (void)
+{
+	int ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, DEVICE_NAME);
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+	const guint32 net_static = nmtst_inet4_from_string ("1.2.3.0");
+	const guint32 net_bird = nmtst_inet4_from_string ("1.2.4.0");
+	const guint32 net_replaced = nmtst_inet4_from_string ("1.2.5.0");
+	const guint32 net_deleted = nmtst_inet4_from_string ("1.2.6.0");
+
+	nmtstp_run_command_check ("ip route add 1.2.3.0/24 dev %s proto static", DEVICE_NAME);
+	nmtstp_run_command_check ("ip route add 1.2.4.0/24 dev %s proto bird", DEVICE_NAME);
+	nmtstp_run_command_check ("ip route add 1.2.5.0/24 dev %s proto static", DEVICE_NAME);
+
+	NMTST_WAIT_ASSERT (100, {
+		nmtstp_wait_for_signal (NM_PLATFORM_GET, 10);
+		if (   nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_static, 24, 0, 0)
+		    && nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_bird, 24, 0, 0)
+		    && nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_replaced, 24, 0, 0))
+			break;
+	});
+
+	platform = nm_linux_platform_new (TRUE, TRUE, TRUE);
+
+	g_assert (nmtstp_ip4_route_get (platform, ifindex, net_static, 24, 0, 0));
+	g_assert (!nmtstp_ip4_route_get (platform, ifindex, net_bird, 24, 0, 0));
+	g_assert (nmtstp_ip4_route_get (platform, ifindex, net_replaced, 24, 0, 0));
+
+	/* a foreign route replacing a tracked one drops it from the cache. */
+	nmtstp_run_command_check ("ip route replace 1.2.5.0/24 dev %s proto bird", DEVICE_NAME);
+
+	NMTST_WAIT_ASSERT (200, {
+		nmtstp_wait_for_signal (platform, 10);
+		if (!nmtstp_ip4_route_get (platform, ifindex, net_replaced, 24, 0, 0))
+			break;
+	});
+
+	/* foreign routes added and deleted later are tracked too. */
+	nmtstp_run_command_check ("ip route add 1.2.6.0/24 dev %s proto bird", DEVICE_NAME);
+	nm_platform_process_events (platform);
+	routes_prune = nm_platform_ip_route_get_prune_list (platform,
+	                                                    AF_INET,
+	                                                    ifindex,
+	                                                    NM_IP_ROUTE_TABLE_SYNC_MODE_FULL);
+	g_assert (_routes_contain_ip4 (routes_prune, net_deleted, 24));
+	g_clear_pointer (&routes_prune, g_ptr_array_unref);
+
+	nmtstp_run_command_check ("ip route del 1.2.6.0/24 dev %s proto bird", DEVICE_NAME);
+	nm_platform_process_events (platform);
+
+	/* syncing the full route table still deletes the foreign routes. */
+	routes_prune = nm_platform_ip_route_get_prune_list (platform,
+	                                                    AF_INET,
+	                                                    ifindex,
+	                                                    NM_IP_ROUTE_TABLE_SYNC_MODE_FULL);
+	g_assert (_routes_contain_ip4 (routes_prune, net_static, 24));
+	g_assert (_routes_contain_ip4 (routes_prune, net_bird, 24));
+	g_assert (_routes_contain_ip4 (routes_prune, net_replaced, 24));
+	g_assert (!_routes_contain_ip4 (routes_prune, net_deleted, 24));
+	g_assert (nm_platform_ip_route_sync (platform, AF_INET, ifindex, NULL, routes_prune, NULL));
+
+	NMTST_WAIT_ASSERT (100, {
+		nmtstp_wait_for_signal (NM_PLATFORM_GET, 10);
+		if (   !nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_static, 24, 0, 0)
+		    && !nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_bird, 24, 0, 0)
+		    && !nmtstp_ip4_route_get (NM_PLATFORM_GET, ifindex, net_replaced, 24, 0, 0))
+			break;
+	});
+
+	nm_platform_process_events (platform);
+	g_clear_pointer (&routes_prune, g_ptr_array_unref);
+	routes_prune = nm_platform_ip_route_get_prune_list (platform,
+	                                                    AF_INET,
+	                                                    ifindex,
+	                                                    NM_IP_ROUTE_TABLE_SYNC_MODE_FULL);
+	g_assert (!_routes_contain_ip4 (routes_prune, net_bird, 24));
+	g_assert (!_routes_contain_ip4 (routes_prune, net_replaced, 24));
+
+	nmtstp_run_command_check ("ip route flush dev %s", DEVICE_NAME);
+
+	nmtstp_wait_for_signal (NM_PLATFORM_GET, 50);
+}
+
 static void
 test_ip4_route_options (gconstpointer test_data)
 {
@@ -901,5 +1000,6 @@ _nmtstp_setup_tests (void)
 		add_test_func ("/route/ip4_route_get", test_ip4_route_get);
 		add_test_func ("/route/ip6_route_get", test_ip6_route_get);
 		add_test_func ("/route/ip4_zero_gateway", test_ip4_zero_gateway);
+		add_test_func ("/route/ip4_compact_foreign", test_ip4_route_compact_foreign);
 	}
 }
@@ -43,6 +43,8 @@
 #define SETTINGS_TIMESTAMPS_FILE  NMSTATEDIR "/timestamps"
 #define SETTINGS_SEEN_BSSIDS_FILE NMSTATEDIR "/seen-bssids"
 
+#define STATE_DB_FLUSH_DELAY_SEC  5
+
 #define AUTOCONNECT_RETRIES_UNSET        -2
 #define AUTOCONNECT_RETRIES_FOREVER      -1
 #define AUTOCONNECT_RESET_RETRIES_TIMER 300
@@ -108,6 +110,10 @@ typedef struct _NMSettingsConnectionPrivate {
 
 	NMConnection *connection;
 
+	/* The reply for GetSettings(), without secrets. Cleared whenever the
+	 * connection, the timestamp or the seen BSSIDs change. */
+	GVariant *getsettings_cached;
+
 	/* Caches secrets from on-disk connections; were they not cached any
 	 * call to nm_connection_clear_secrets() wipes them out and we'd have
 	 * to re-read them from disk which defeats the purpose of having the
@@ -561,6 +567,21 @@ _emit_updated (NMSettingsConnection *self, gboolean by_user)
 	g_signal_emit (self, signals[UPDATED_INTERNAL], 0, by_user);
 }
 
+static void
+_getsettings_cached_clear (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
+	nm_clear_g_variant (&priv->getsettings_cached);
+}
+
+static void
+connection_changed_getsettings_cb (NMConnection *connection, NMSettingsConnection *self)
+{
+	/* this handler is never blocked, unlike connection_changed_cb(). */
+	_getsettings_cached_clear (self);
+}
+
 static void
 connection_changed_cb (NMConnection *connection, NMSettingsConnection *self)
 {
@@ -775,40 +796,118 @@ out:
 	return TRUE;
 }
 
+/*****************************************************************************/
+
+/* The timestamps and seen-bssids databases are shared by all connections.
+ * They are loaded once, kept in memory and written back (atomically, via
+ * g_file_set_contents()) a few seconds after the last change. */
+
+typedef enum {
+	STATE_DB_TIMESTAMPS,
+	STATE_DB_SEEN_BSSIDS,
+	_STATE_DB_NUM,
+} StateDbType;
+
+typedef struct {
+	const char *group;
+	const char *filename;
+	GKeyFile *keyfile;
+	guint flush_id;
+	bool dirty:1;
+} StateDb;
+
+static StateDb _state_dbs[_STATE_DB_NUM] = {
+	[STATE_DB_TIMESTAMPS]  = { .group = "timestamps",  .filename = SETTINGS_TIMESTAMPS_FILE,  },
+	[STATE_DB_SEEN_BSSIDS] = { .group = "seen-bssids", .filename = SETTINGS_SEEN_BSSIDS_FILE, },
+};
+
+static GKeyFile *
+_state_db_get (StateDbType type)
+{
+	StateDb *db = &_state_dbs[type];
+	gs_free_error GError *error = NULL;
+
+	if (G_UNLIKELY (!db->keyfile)) {
+		db->keyfile = g_key_file_new ();
+		g_key_file_set_list_separator (db->keyfile, ',');
+		if (!g_key_file_load_from_file (db->keyfile, db->filename, G_KEY_FILE_KEEP_COMMENTS, &error)) {
+			if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+				nm_log_warn (LOGD_SETTINGS, "settings: error parsing %s file '%s': %s",
+				             db->group, db->filename, error->message);
+			}
+		}
+	}
+	return db->keyfile;
+}
+
 static void
-remove_entry_from_db (NMSettingsConnection *self, const char* db_name)
+_state_db_flush (StateDb *db)
 {
-	GKeyFile *key_file;
-	const char *db_file;
+	gs_free_error GError *error = NULL;
+	gs_free char *data = NULL;
+	gsize len;
 
-	if (strcmp (db_name, "timestamps") == 0)
-		db_file = SETTINGS_TIMESTAMPS_FILE;
-	else if (strcmp (db_name, "seen-bssids") == 0)
-		db_file = SETTINGS_SEEN_BSSIDS_FILE;
-	else
+	nm_clear_g_source (&db->flush_id);
+
+	if (!db->dirty)
 		return;
+	db->dirty = FALSE;
+
+	data = g_key_file_to_data (db->keyfile, &len, &error);
+	if (   !data
+	    || !g_file_set_contents (db->filename, data, len, &error)) {
+		nm_log_warn (LOGD_SETTINGS, "settings: error saving %s file '%s': %s",
+		             db->group, db->filename, error->message);
+	}
+}
 
-	key_file = g_key_file_new ();
-	if (g_key_file_load_from_file (key_file, db_file, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		const char *connection_uuid;
-		char *data;
-		gsize len;
-		GError *error = NULL;
+static gboolean
+_state_db_flush_cb (gpointer user_data)
+{
+	StateDb *db = user_data;
 
-		connection_uuid = nm_settings_connection_get_uuid (self);
+	db->flush_id = 0;
+	_state_db_flush (db);
+	return G_SOURCE_REMOVE;
+}
 
-		g_key_file_remove_key (key_file, db_name, connection_uuid, NULL);
-		data = g_key_file_to_data (key_file, &len, &error);
-		if (data) {
-			g_file_set_contents (db_file, data, len, &error);
-			g_free (data);
-		}
-		if (error) {
-			_LOGW ("error writing %s file '%s': %s", db_name, db_file, error->message);
-			g_error_free (error);
-		}
+static void
+_state_db_changed (StateDbType type)
+{
+	StateDb *db = &_state_dbs[type];
+
+	nm_assert (db->keyfile);
+
+	db->dirty = TRUE;
+	if (!db->flush_id)
+		db->flush_id = g_timeout_add_seconds (STATE_DB_FLUSH_DELAY_SEC, _state_db_flush_cb, db);
+}
+
+/**
+ * nm_settings_connection_flush_state_db:
+ *
+ * Writes pending changes of the timestamps and seen-bssids databases
+ * to disk right away. Used on shutdown.
+ */
+void
+nm_settings_connection_flush_state_db (void)
+{
+	int i;
+
+	for (i = 0; i < _STATE_DB_NUM; i++) {
+		if (_state_dbs[i].keyfile)
+			_state_db_flush (&_state_dbs[i]);
 	}
-	g_key_file_free (key_file);
+}
+
+static void
+remove_entry_from_db (NMSettingsConnection *self, StateDbType type)
+{
+	if (g_key_file_remove_key (_state_db_get (type),
+	                           _state_dbs[type].group,
+	                           nm_settings_connection_get_uuid (self),
+	                           NULL))
+		_state_db_changed (type);
 }
 
 gboolean
@@ -837,10 +936,10 @@ nm_settings_connection_delete (NMSettingsConnection *self,
 	g_object_unref (for_agents);
 
 	/* Remove timestamp from timestamps database file */
-	remove_entry_from_db (self, "timestamps");
+	remove_entry_from_db (self, STATE_DB_TIMESTAMPS);
 
 	/* Remove connection from seen-bssids database file */
-	remove_entry_from_db (self, "seen-bssids");
+	remove_entry_from_db (self, STATE_DB_SEEN_BSSIDS);
 
 	nm_settings_connection_signal_remove (self);
 	return TRUE;
@@ -1565,9 +1664,14 @@ get_settings_auth_cb (NMSettingsConnection *self,
                       GError *error,
                       gpointer data)
 {
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
 	if (error)
 		g_dbus_method_invocation_return_gerror (context, error);
-	else {
+	else if (priv->getsettings_cached) {
+		g_dbus_method_invocation_return_value (context,
+		                                       g_variant_new ("(@a{sa{sv}})", priv->getsettings_cached));
+	} else {
 		gs_unref_object NMConnection *dupl_con = NULL;
 		GVariant *settings;
 		NMSettingConnection *s_con;
@@ -1602,6 +1706,8 @@ get_settings_auth_cb (NMSettingsConnection *self,
 		 * protected against leakage of secrets to unprivileged callers.
 		 */
 		settings = nm_connection_to_dbus (dupl_con, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+		if (settings)
+			priv->getsettings_cached = g_variant_ref_sink (settings);
 		g_dbus_method_invocation_return_value (context,
 		                                       g_variant_new ("(@a{sa{sv}})", settings));
 	}
@@ -2496,44 +2602,26 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
                                          gboolean flush_to_disk)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *timestamps_file;
-	char *data, *tmp;
-	gsize len;
-	GError *error = NULL;
+	char tmp[30];
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
 	/* Update timestamp in private storage */
+	if (priv->timestamp != timestamp)
+		_getsettings_cached_clear (self);
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 
 	if (flush_to_disk == FALSE)
 		return;
 
-	/* Save timestamp to timestamps database file */
-	timestamps_file = g_key_file_new ();
-	if (!g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
-			_LOGW ("error parsing timestamps file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_clear_error (&error);
-	}
-
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp = g_strdup_printf ("%" G_GUINT64_FORMAT, timestamp);
-	g_key_file_set_value (timestamps_file, "timestamps", connection_uuid, tmp);
-	g_free (tmp);
-
-	data = g_key_file_to_data (timestamps_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_TIMESTAMPS_FILE, data, len, &error);
-		g_free (data);
-	}
-	if (error) {
-		_LOGW ("error saving timestamp to file '%s': %s", SETTINGS_TIMESTAMPS_FILE, error->message);
-		g_error_free (error);
-	}
-	g_key_file_free (timestamps_file);
+	/* Save timestamp to timestamps database */
+	nm_sprintf_buf (tmp, "%" G_GUINT64_FORMAT, timestamp);
+	g_key_file_set_value (_state_db_get (STATE_DB_TIMESTAMPS),
+	                      _state_dbs[STATE_DB_TIMESTAMPS].group,
+	                      nm_settings_connection_get_uuid (self),
+	                      tmp);
+	_state_db_changed (STATE_DB_TIMESTAMPS);
 }
 
 /**
@@ -2547,22 +2635,16 @@ void
 nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	gs_unref_keyfile GKeyFile *timestamps_file = NULL;
 	gs_free_error GError *error = NULL;
 	gs_free char *tmp_str = NULL;
-	const char *connection_uuid;
 	gint64 timestamp;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
-	timestamps_file = g_key_file_new ();
-	if (!g_key_file_load_from_file (timestamps_file, SETTINGS_TIMESTAMPS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		_LOGD ("failed to read connection timestamp: %s", error->message);
-		return;
-	}
-
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	tmp_str = g_key_file_get_value (timestamps_file, "timestamps", connection_uuid, &error);
+	tmp_str = g_key_file_get_value (_state_db_get (STATE_DB_TIMESTAMPS),
+	                                _state_dbs[STATE_DB_TIMESTAMPS].group,
+	                                nm_settings_connection_get_uuid (self),
+	                                &error);
 	if (!tmp_str) {
 		_LOGD ("failed to read connection timestamp: %s", error->message);
 		return;
@@ -2574,6 +2656,7 @@ nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 		return;
 	}
 
+	_getsettings_cached_clear (self);
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 }
@@ -2638,12 +2721,8 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
                                        const char *seen_bssid)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
-	char *data, *bssid_str;
-	const char **list;
-	gsize len;
-	GError *error = NULL;
+	gs_free const char **list = NULL;
+	char *bssid_str;
 	GHashTableIter iter;
 	guint n;
 
@@ -2655,41 +2734,21 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	/* Add the new BSSID; let the hash take ownership of the allocated BSSID string */
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
+	_getsettings_cached_clear (self);
 
 	/* Build up a list of all the BSSIDs in string form */
 	n = 0;
-	list = g_malloc0 (g_hash_table_size (priv->seen_bssids) * sizeof (char *));
+	list = g_new (const char *, g_hash_table_size (priv->seen_bssids));
 	g_hash_table_iter_init (&iter, priv->seen_bssids);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &bssid_str))
 		list[n++] = bssid_str;
 
-	/* Save BSSID to seen-bssids file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (!g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, &error)) {
-		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
-			_LOGW ("error parsing seen-bssids file '%s': %s",
-			       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		}
-		g_clear_error (&error);
-	}
-
-	connection_uuid = nm_settings_connection_get_uuid (self);
-	g_key_file_set_string_list (seen_bssids_file, "seen-bssids", connection_uuid, list, n);
-	g_free (list);
-
-	data = g_key_file_to_data (seen_bssids_file, &len, &error);
-	if (data) {
-		g_file_set_contents (SETTINGS_SEEN_BSSIDS_FILE, data, len, &error);
-		g_free (data);
-	}
-	g_key_file_free (seen_bssids_file);
-
-	if (error) {
-		_LOGW ("error saving seen-bssids to file '%s': %s",
-		       SETTINGS_SEEN_BSSIDS_FILE, error->message);
-		g_error_free (error);
-	}
+	/* Save BSSID to seen-bssids database */
+	g_key_file_set_string_list (_state_db_get (STATE_DB_SEEN_BSSIDS),
+	                            _state_dbs[STATE_DB_SEEN_BSSIDS].group,
+	                            nm_settings_connection_get_uuid (self),
+	                            list, n);
+	_state_db_changed (STATE_DB_SEEN_BSSIDS);
 }
 
 /**
@@ -2703,20 +2762,17 @@ void
 nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self)
 {
 	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-	const char *connection_uuid;
-	GKeyFile *seen_bssids_file;
 	char **tmp_strv = NULL;
 	gsize i, len = 0;
 	NMSettingWireless *s_wifi;
 
-	/* Get seen BSSIDs from database file */
-	seen_bssids_file = g_key_file_new ();
-	g_key_file_set_list_separator (seen_bssids_file, ',');
-	if (g_key_file_load_from_file (seen_bssids_file, SETTINGS_SEEN_BSSIDS_FILE, G_KEY_FILE_KEEP_COMMENTS, NULL)) {
-		connection_uuid = nm_settings_connection_get_uuid (self);
-		tmp_strv = g_key_file_get_string_list (seen_bssids_file, "seen-bssids", connection_uuid, &len, NULL);
-	}
-	g_key_file_free (seen_bssids_file);
+	/* Get seen BSSIDs from database */
+	tmp_strv = g_key_file_get_string_list (_state_db_get (STATE_DB_SEEN_BSSIDS),
+	                                       _state_dbs[STATE_DB_SEEN_BSSIDS].group,
+	                                       nm_settings_connection_get_uuid (self),
+	                                       &len, NULL);
+
+	_getsettings_cached_clear (self);
 
 	/* Update connection's seen-bssids */
 	if (tmp_strv) {
@@ -3008,6 +3064,7 @@ nm_settings_connection_init (NMSettingsConnection *self)
 
 	g_signal_connect (priv->connection, NM_CONNECTION_SECRETS_CLEARED, G_CALLBACK (secrets_cleared_cb), self);
 	g_signal_connect (priv->connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_cb), self);
+	g_signal_connect (priv->connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed_getsettings_cb), self);
 }
 
 static void
@@ -3047,6 +3104,7 @@ dispose (GObject *object)
 		 */
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (secrets_cleared_cb), self);
 		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (connection_changed_cb), self);
+		g_signal_handlers_disconnect_by_func (priv->connection, G_CALLBACK (connection_changed_getsettings_cb), self);
 
 		/* FIXME(copy-on-write-connection): avoid modifying NMConnection instances and share them via copy-on-write. */
 		nm_connection_clear_secrets (priv->connection);
@@ -3054,6 +3112,7 @@ dispose (GObject *object)
 
 	g_clear_object (&priv->system_secrets);
 	g_clear_object (&priv->agent_secrets);
+	nm_clear_g_variant (&priv->getsettings_cached);
 
 	g_clear_pointer (&priv->seen_bssids, g_hash_table_destroy);
 
@@ -0,0 +1,354 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <unistd.h>
+
+#include "nm-auth-manager.h"
+#include "nm-auth-subject.h"
+
+#include "nm-test-utils-core.h"
+
+#define POLKIT_SERVICE     "org.freedesktop.PolicyKit1"
+#define POLKIT_OBJECT_PATH "/org/freedesktop/PolicyKit1/Authority"
+#define POLKIT_INTERFACE   "org.freedesktop.PolicyKit1.Authority"
+
+#define ACTION_YES       "org.freedesktop.NetworkManager.network-control"
+#define ACTION_CHALLENGE "org.freedesktop.NetworkManager.settings.modify.system"
+#define ACTION_RETAINED  "org.freedesktop.NetworkManager.settings.modify.own"
+
+/*****************************************************************************/
+
+/* A minimal polkit authority on a private bus. It answers CheckAuthorization
+ * requests from a table and counts how often it was asked. A "retained"
+ * result is a grant that polkit keeps after an authentication. */
+typedef struct {
+	GDBusConnection *connection;
+	GHashTable *results;
+	guint registration_id;
+	guint n_calls;
+} StubPolkit;
+
+static const char *stub_polkit_xml =
+	"<node>"
+	"  <interface name='"POLKIT_INTERFACE"'>"
+	"    <method name='CheckAuthorization'>"
+	"      <arg type='(sa{sv})' name='subject' direction='in'/>"
+	"      <arg type='s' name='action_id' direction='in'/>"
+	"      <arg type='a{ss}' name='details' direction='in'/>"
+	"      <arg type='u' name='flags' direction='in'/>"
+	"      <arg type='s' name='cancellation_id' direction='in'/>"
+	"      <arg type='(bba{ss})' name='result' direction='out'/>"
+	"    </method>"
+	"    <method name='CancelCheckAuthorization'>"
+	"      <arg type='s' name='cancellation_id' direction='in'/>"
+	"    </method>"
+	"    <signal name='Changed'/>"
+	"  </interface>"
+	"</node>";
+
+static void
+_stub_polkit_method_call (GDBusConnection *connection,
+                          const char *sender,
+                          const char *object_path,
+                          const char *interface_name,
+                          const char *method_name,
+                          GVariant *parameters,
+                          GDBusMethodInvocation *invocation,
+                          gpointer user_data)
+{
+	StubPolkit *stub = user_data;
+	GVariantBuilder details;
+	const char *action_id;
+	const char *result;
+
+	if (nm_streq (method_name, "CancelCheckAuthorization")) {
+		g_dbus_method_invocation_return_value (invocation, NULL);
+		return;
+	}
+
+	g_assert_cmpstr (method_name, ==, "CheckAuthorization");
+
+	stub->n_calls++;
+
+	g_variant_get (parameters, "(@(sa{sv})&s@a{ss}u&s)", NULL, &action_id, NULL, NULL, NULL);
+	result = g_hash_table_lookup (stub->results, action_id) ?: "no";
+
+	g_variant_builder_init (&details, G_VARIANT_TYPE ("a{ss}"));
+	if (nm_streq (result, "retained"))
+		g_variant_builder_add (&details, "{ss}", "polkit.retains_authorization_after_challenge", "1");
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("((bba{ss}))",
+	                                                      NM_IN_STRSET (result, "yes", "retained"),
+	                                                      nm_streq (result, "challenge"),
+	                                                      &details));
+}
+
+static void
+stub_polkit_init (StubPolkit *stub, const char *address)
+{
+	static const GDBusInterfaceVTable vtable = {
+		.method_call = _stub_polkit_method_call,
+	};
+	GDBusNodeInfo *info;
+	gs_unref_variant GVariant *ret = NULL;
+	GError *error = NULL;
+
+	memset (stub, 0, sizeof (*stub));
+
+	stub->results = g_hash_table_new (nm_str_hash, g_str_equal);
+	stub->connection = g_dbus_connection_new_for_address_sync (address,
+	                                                           G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT
+	                                                           | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+	                                                           NULL, NULL, &error);
+	nmtst_assert_success (stub->connection, error);
+
+	info = g_dbus_node_info_new_for_xml (stub_polkit_xml, &error);
+	nmtst_assert_success (info, error);
+
+	stub->registration_id = g_dbus_connection_register_object (stub->connection,
+	                                                           POLKIT_OBJECT_PATH,
+	                                                           info->interfaces[0],
+	                                                           &vtable,
+	                                                           stub,
+	                                                           NULL,
+	                                                           &error);
+	nmtst_assert_success (stub->registration_id, error);
+	g_dbus_node_info_unref (info);
+
+	ret = g_dbus_connection_call_sync (stub->connection,
+	                                   "org.freedesktop.DBus",
+	                                   "/org/freedesktop/DBus",
+	                                   "org.freedesktop.DBus",
+	                                   "RequestName",
+	                                   g_variant_new ("(su)", POLKIT_SERVICE, 0u),
+	                                   G_VARIANT_TYPE ("(u)"),
+	                                   G_DBUS_CALL_FLAGS_NONE,
+	                                   -1, NULL, &error);
+	nmtst_assert_success (ret, error);
+}
+
+static void
+stub_polkit_emit_changed (StubPolkit *stub)
+{
+	gboolean success;
+	GError *error = NULL;
+
+	success = g_dbus_connection_emit_signal (stub->connection,
+	                                         NULL,
+	                                         POLKIT_OBJECT_PATH,
+	                                         POLKIT_INTERFACE,
+	                                         "Changed",
+	                                         NULL,
+	                                         &error);
+	nmtst_assert_success (success, error);
+}
+
+static void
+stub_polkit_clear (StubPolkit *stub)
+{
+	g_dbus_connection_unregister_object (stub->connection, stub->registration_id);
+	g_dbus_connection_close_sync (stub->connection, NULL, NULL);
+	g_clear_object (&stub->connection);
+	g_clear_pointer (&stub->results, g_hash_table_unref);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	gboolean completed;
+	gboolean is_authorized;
+	gboolean is_challenge;
+} CheckData;
+
+static void
+_check_cb (NMAuthManager *auth_manager,
+           NMAuthManagerCallId *call_id,
+           gboolean is_authorized,
+           gboolean is_challenge,
+           GError *error,
+           gpointer user_data)
+{
+	CheckData *data = user_data;
+
+	g_assert_no_error (error);
+	g_assert (!data->completed);
+
+	data->completed = TRUE;
+	data->is_authorized = is_authorized;
+	data->is_challenge = is_challenge;
+	g_main_loop_quit (data->loop);
+}
+
+static NMAuthCallResult
+_check (NMAuthManager *auth_manager,
+        NMAuthSubject *subject,
+        const char *action_id,
+        gboolean allow_user_interaction)
+{
+	CheckData data = {
+		.loop = g_main_loop_new (NULL, FALSE),
+	};
+
+	nm_auth_manager_check_authorization (auth_manager,
+	                                     subject,
+	                                     action_id,
+	                                     allow_user_interaction,
+	                                     _check_cb,
+	                                     &data);
+
+	/* the callback is never invoked synchronously. */
+	g_assert (!data.completed);
+
+	if (!nmtst_main_loop_run (data.loop, 5000))
+		g_assert_not_reached ();
+	g_assert (data.completed);
+	g_main_loop_unref (data.loop);
+
+	return nm_auth_call_result_eval (data.is_authorized, data.is_challenge, NULL);
+}
+
+static void
+_assert_stats (NMAuthManager *auth_manager, guint64 hits, guint64 misses)
+{
+	guint64 h, m;
+
+	nm_auth_manager_get_cache_stats (auth_manager, &h, &m);
+	g_assert_cmpint (h, ==, hits);
+	g_assert_cmpint (m, ==, misses);
+}
+
+static void
+_wait_for_changed (NMAuthManager *auth_manager)
+{
+	GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+	gulong id;
+
+	id = g_signal_connect_swapped (auth_manager,
+	                               NM_AUTH_MANAGER_SIGNAL_CHANGED,
+	                               G_CALLBACK (g_main_loop_quit),
+	                               loop);
+	if (!nmtst_main_loop_run (loop, 5000))
+		g_assert_not_reached ();
+	g_signal_handler_disconnect (auth_manager, id);
+	g_main_loop_unref (loop);
+}
+
+static void
+test_cache (void)
+{
+	gs_free char *dbus_daemon = NULL;
+	GTestDBus *bus;
+	StubPolkit stub;
+	gs_unref_object NMAuthManager *auth_manager = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+
+	dbus_daemon = g_find_program_in_path ("dbus-daemon");
+	if (!dbus_daemon) {
+		g_test_skip ("dbus-daemon not available");
+		return;
+	}
+
+	bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (bus);
+
+	/* NMAuthManager talks to polkit on the system bus. */
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", g_test_dbus_get_bus_address (bus), TRUE);
+
+	stub_polkit_init (&stub, g_test_dbus_get_bus_address (bus));
+	g_hash_table_insert (stub.results, (char *) ACTION_YES, (char *) "yes");
+	g_hash_table_insert (stub.results, (char *) ACTION_CHALLENGE, (char *) "challenge");
+	g_hash_table_insert (stub.results, (char *) ACTION_RETAINED, (char *) "retained");
+
+	auth_manager = g_object_new (NM_TYPE_AUTH_MANAGER,
+	                             NM_AUTH_MANAGER_POLKIT_ENABLED, TRUE,
+	                             NULL);
+
+	/* the manager emits "changed" once the polkit proxy is ready. */
+	_wait_for_changed (auth_manager);
+
+	subject = g_object_new (NM_TYPE_AUTH_SUBJECT,
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_DBUS_SENDER, ":1.4242",
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_PID, (gulong) getpid (),
+	                        NM_AUTH_SUBJECT_UNIX_PROCESS_UID, (gulong) 4242,
+	                        NULL);
+	g_assert (nm_auth_subject_is_unix_process (subject));
+
+	/* the second request for the same action is answered from the cache. */
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (stub.n_calls, ==, 1);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (stub.n_calls, ==, 1);
+	_assert_stats (auth_manager, 1, 1);
+
+	/* challenges are never cached. */
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_CHALLENGE, FALSE), ==, NM_AUTH_CALL_RESULT_AUTH);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_CHALLENGE, FALSE), ==, NM_AUTH_CALL_RESULT_AUTH);
+	g_assert_cmpint (stub.n_calls, ==, 3);
+	_assert_stats (auth_manager, 1, 3);
+
+	/* with user interaction allowed, polkit might have granted the request
+	 * only after prompting. Such a grant is not reused, and it doesn't
+	 * answer requests without user interaction either. */
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (stub.n_calls, ==, 5);
+	_assert_stats (auth_manager, 1, 5);
+
+	/* ... unless polkit retains the authorization. */
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_RETAINED, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_RETAINED, TRUE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (stub.n_calls, ==, 6);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_RETAINED, FALSE), ==, NM_AUTH_CALL_RESULT_YES);
+	g_assert_cmpint (stub.n_calls, ==, 7);
+	_assert_stats (auth_manager, 2, 7);
+
+	/* after the "Changed" signal, polkit is asked again. */
+	g_hash_table_insert (stub.results, (char *) ACTION_YES, (char *) "no");
+	stub_polkit_emit_changed (&stub);
+	_wait_for_changed (auth_manager);
+
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	g_assert_cmpint (stub.n_calls, ==, 8);
+	g_assert_cmpint (_check (auth_manager, subject, ACTION_YES, FALSE), ==, NM_AUTH_CALL_RESULT_NO);
+	g_assert_cmpint (stub.n_calls, ==, 8);
+	_assert_stats (auth_manager, 3, 8);
+
+	g_clear_object (&auth_manager);
+	stub_polkit_clear (&stub);
+	g_test_dbus_down (bus);
+	g_object_unref (bus);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/auth-manager/cache", test_cache);
+
+	return g_test_run ();
+}
@@ -0,0 +1,357 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ *
+ */
+
+#include "nm-default.h"
+
+#include <unistd.h>
+
+#include "nm-config.h"
+#include "nm-connectivity.h"
+
+#include "nm-test-utils-core.h"
+
+#define RESPONSE_ONLINE NM_CONFIG_DEFAULT_CONNECTIVITY_RESPONSE "\n"
+#define RESPONSE_PORTAL "<html><body>Please log in to use this network.</body></html>\n"
+
+/*****************************************************************************/
+
+/* A minimal HTTP server on the loopback interface. It answers every
+ * request on a connection with @body and keeps the connection open,
+ * counting accepted connections and requests. */
+typedef struct {
+	GSocketService *service;
+	GCancellable *cancellable;
+	const char *body;
+	guint16 port;
+	guint n_open;
+	guint n_connections;
+	guint n_requests;
+} HttpStub;
+
+typedef struct {
+	HttpStub *stub;
+	GSocketConnection *connection;
+	GString *request;
+	char buf[1024];
+} HttpStubConn;
+
+static void _http_stub_read (HttpStubConn *conn);
+
+static void
+_http_stub_conn_free (HttpStubConn *conn)
+{
+	conn->stub->n_open--;
+	g_io_stream_close (G_IO_STREAM (conn->connection), NULL, NULL);
+	g_object_unref (conn->connection);
+	g_string_free (conn->request, TRUE);
+	g_slice_free (HttpStubConn, conn);
+}
+
+static void
+_http_stub_read_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	HttpStubConn *conn = user_data;
+	GOutputStream *out;
+	gssize n;
+	const char *end;
+
+	n = g_input_stream_read_finish (G_INPUT_STREAM (source), result, NULL);
+	if (n <= 0) {
+		_http_stub_conn_free (conn);
+		return;
+	}
+
+	g_string_append_len (conn->request, conn->buf, n);
+
+	out = g_io_stream_get_output_stream (G_IO_STREAM (conn->connection));
+	while ((end = strstr (conn->request->str, "\r\n\r\n"))) {
+		gs_free char *response = NULL;
+
+		g_string_erase (conn->request, 0, (end + 4) - conn->request->str);
+		conn->stub->n_requests++;
+
+		/* send the response with one write, so that the client sees
+		 * the complete response at once. */
+		response = g_strdup_printf ("HTTP/1.1 200 OK\r\n"
+		                            "Content-Type: text/plain\r\n"
+		                            "Content-Length: %u\r\n"
+		                            "\r\n"
+		                            "%s",
+		                            (guint) strlen (conn->stub->body),
+		                            conn->stub->body);
+		if (!g_output_stream_write_all (out, response, strlen (response), NULL, NULL, NULL)) {
+			_http_stub_conn_free (conn);
+			return;
+		}
+	}
+
+	_http_stub_read (conn);
+}
+
+static void
+_http_stub_read (HttpStubConn *conn)
+{
+	g_input_stream_read_async (g_io_stream_get_input_stream (G_IO_STREAM (conn->connection)),
+	                           conn->buf,
+	                           sizeof (conn->buf),
+	                           G_PRIORITY_DEFAULT,
+	                           conn->stub->cancellable,
+	                           _http_stub_read_cb,
+	                           conn);
+}
+
+static gboolean
+_http_stub_incoming_cb (GSocketService *service,
+                        GSocketConnection *connection,
+                        GObject *source_object,
+                        gpointer user_data)
+{
+	HttpStub *stub = user_data;
+	HttpStubConn *conn;
+
+	conn = g_slice_new0 (HttpStubConn);
+	conn->stub = stub;
+	conn->connection = g_object_ref (connection);
+	conn->request = g_string_new (NULL);
+
+	stub->n_open++;
+	stub->n_connections++;
+	_http_stub_read (conn);
+	return TRUE;
+}
+
+static void
+http_stub_init (HttpStub *stub)
+{
+	GError *error = NULL;
+
+	memset (stub, 0, sizeof (*stub));
+	stub->body = RESPONSE_ONLINE;
+	stub->cancellable = g_cancellable_new ();
+	stub->service = g_socket_service_new ();
+
+	stub->port = g_socket_listener_add_any_inet_port (G_SOCKET_LISTENER (stub->service), NULL, &error);
+	g_assert_no_error (error);
+	g_assert (stub->port);
+
+	g_signal_connect (stub->service, "incoming", G_CALLBACK (_http_stub_incoming_cb), stub);
+	g_socket_service_start (stub->service);
+}
+
+static void
+http_stub_clear (HttpStub *stub)
+{
+	g_socket_service_stop (stub->service);
+	g_socket_listener_close (G_SOCKET_LISTENER (stub->service));
+	g_cancellable_cancel (stub->cancellable);
+	while (stub->n_open)
+		g_main_context_iteration (NULL, TRUE);
+	g_clear_object (&stub->service);
+	g_clear_object (&stub->cancellable);
+}
+
+/*****************************************************************************/
+
+static void
+_write_config (const char *config_file, const char *uri)
+{
+	gs_free char *contents = NULL;
+	GError *error = NULL;
+
+	contents = g_strdup_printf ("[connectivity]\n"
+	                            "uri=%s\n"
+	                            "interval=600\n",
+	                            uri);
+	g_file_set_contents (config_file, contents, -1, &error);
+	g_assert_no_error (error);
+}
+
+static NMConfig *
+_setup_config (const char *config_dir, const char *config_file)
+{
+	gs_free char *no_auto_default_file = g_build_filename (config_dir, "no-auto-default.state", NULL);
+	char *args[] = {
+		"test-connectivity",
+		"--config", (char *) config_file,
+		"--config-dir", (char *) config_dir,
+		"--system-config-dir", "",
+		"--intern-config", "",
+		"--state-file", "",
+		"--no-auto-default", no_auto_default_file,
+	};
+	char **argv = args;
+	int argc = G_N_ELEMENTS (args);
+	NMConfigCmdLineOptions *cli;
+	GOptionContext *context;
+	NMConfig *config;
+	GError *error = NULL;
+
+	cli = nm_config_cmd_line_options_new (FALSE);
+
+	context = g_option_context_new (NULL);
+	nm_config_cmd_line_options_add_to_entries (cli, context);
+	g_assert (g_option_context_parse (context, &argc, &argv, NULL));
+	g_option_context_free (context);
+
+	config = nm_config_setup (cli, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (config);
+
+	nm_config_cmd_line_options_free (cli);
+	return config;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	GMainLoop *loop;
+	NMConnectivityState state;
+} CheckData;
+
+static void
+_check_cb (NMConnectivity *self,
+           NMConnectivityCheckHandle *handle,
+           NMConnectivityState state,
+           GError *error,
+           gpointer user_data)
+{
+	CheckData *data = user_data;
+
+	data->state = state;
+	g_main_loop_quit (data->loop);
+}
+
+static NMConnectivityState
+_check (NMConnectivity *connectivity)
+{
+	CheckData data = {
+		.loop = g_main_loop_new (NULL, FALSE),
+		.state = NM_CONNECTIVITY_UNKNOWN,
+	};
+
+	/* the stub sends each response at once, so that the transfer is
+	 * complete when the result gets reported. */
+	nm_connectivity_check_start (connectivity, "lo", _check_cb, &data);
+	if (!nmtst_main_loop_run (data.loop, 5000))
+		g_assert_not_reached ();
+
+	g_main_loop_unref (data.loop);
+	return data.state;
+}
+
+static void
+test_reuse_and_pin (void)
+{
+	HttpStub stub;
+	gs_free char *config_dir = NULL;
+	gs_free char *config_file = NULL;
+	gs_free char *uri = NULL;
+	NMConfig *config;
+	NMConnectivity *connectivity;
+	NMConnectivityState state;
+	const char *connect_to;
+	gboolean can_pin;
+	GError *error = NULL;
+
+	http_stub_init (&stub);
+
+	config_dir = g_dir_make_tmp ("nm-test-connectivity-XXXXXX", &error);
+	g_assert_no_error (error);
+	config_file = g_build_filename (config_dir, "NetworkManager.conf", NULL);
+
+	/* with an address literal, there is nothing to pin. */
+	uri = g_strdup_printf ("http://127.0.0.1:%u/", stub.port);
+	_write_config (config_file, uri);
+
+	config = _setup_config (config_dir, config_file);
+	connectivity = nm_connectivity_get ();
+
+	if (!nm_connectivity_check_enabled (connectivity)) {
+		g_test_skip ("connectivity checking is not supported");
+		goto out;
+	}
+
+	state = _check (connectivity);
+	if (   state == NM_CONNECTIVITY_LIMITED
+	    && geteuid () != 0) {
+		/* older kernels require privileges to bind a socket to "lo". */
+		g_test_skip ("cannot bind to the loopback interface");
+		goto out;
+	}
+	g_assert_cmpint (state, ==, NM_CONNECTIVITY_FULL);
+	g_assert_cmpint (stub.n_connections, ==, 1);
+
+	/* consecutive checks reuse the connection. */
+	g_assert_cmpint (_check (connectivity), ==, NM_CONNECTIVITY_FULL);
+	g_assert_cmpint (_check (connectivity), ==, NM_CONNECTIVITY_FULL);
+	g_assert_cmpint (stub.n_requests, ==, 3);
+	g_assert_cmpint (stub.n_connections, ==, 1);
+
+	can_pin = _nm_connectivity_get_pinned_address (connectivity, "lo", &connect_to);
+	g_assert (!connect_to);
+
+	/* with a host name, the address of a host that gave the expected
+	 * response gets pinned. The one of a portal doesn't. */
+	nm_clear_g_free (&uri);
+	uri = g_strdup_printf ("http://localhost:%u/", stub.port);
+	_write_config (config_file, uri);
+	nm_config_reload (config, NM_CONFIG_CHANGE_CAUSE_SIGHUP);
+
+	stub.body = RESPONSE_PORTAL;
+	g_assert_cmpint (_check (connectivity), ==, NM_CONNECTIVITY_PORTAL);
+	_nm_connectivity_get_pinned_address (connectivity, "lo", &connect_to);
+	g_assert (!connect_to);
+
+	stub.body = RESPONSE_ONLINE;
+	g_assert_cmpint (_check (connectivity), ==, NM_CONNECTIVITY_FULL);
+	_nm_connectivity_get_pinned_address (connectivity, "lo", &connect_to);
+	if (can_pin) {
+		gs_free char *prefix = g_strdup_printf ("localhost:%u:", stub.port);
+
+		g_assert (connect_to);
+		g_assert (g_str_has_prefix (connect_to, prefix));
+	} else
+		g_assert (!connect_to);
+
+	/* a portal showing up drops the pinned address. */
+	stub.body = RESPONSE_PORTAL;
+	g_assert_cmpint (_check (connectivity), ==, NM_CONNECTIVITY_PORTAL);
+	_nm_connectivity_get_pinned_address (connectivity, "lo", &connect_to);
+	g_assert (!connect_to);
+
+out:
+	http_stub_clear (&stub);
+	unlink (config_file);
+	rmdir (config_dir);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/connectivity/reuse-and-pin", test_reuse_and_pin);
+
+	return g_test_run ();
+}